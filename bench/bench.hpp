@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace QMark::bench {
+
+    // Corps d'un benchmark : exécuté par chaque thread pour `iterations` tours
+    using Body = std::function<void(size_t thread_index, uint64_t iterations)>;
+
+    struct Result {
+        std::string name;
+        size_t threads = 1;
+        uint64_t operations = 0;
+        double seconds = 0.0;
+        double ns_per_op = 0.0;
+        double ops_per_sec = 0.0;
+    };
+
+    // Lance `body` sur `threads` threads synchronisés et agrège le débit
+    Result measure(const std::string& name, size_t threads, uint64_t iterations, const Body& body);
+
+    // Une ligne JSON par résultat sur stdout (format lisible par machine)
+    void report(const Result& result);
+
+    // Enregistrement statique des suites de benchmarks
+    struct Registration {
+        Registration(const char* name, void (*run)());
+    };
+
+    struct Suite {
+        const char* name;
+        void (*run)();
+    };
+
+    std::vector<Suite>& registry();
+
+    // Empêche le compilateur d'éliminer un calcul dont le résultat est ignoré
+    template<typename T>
+    inline void doNotOptimize(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+}
+
+#define QMARK_BENCH(name) \
+    static void qmark_bench_##name(); \
+    static QMark::bench::Registration qmark_bench_##name##_registration(#name, qmark_bench_##name); \
+    static void qmark_bench_##name()
@@ -0,0 +1,77 @@
+#include "bench.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace QMark::bench {
+
+std::vector<Suite>& registry() {
+    static std::vector<Suite> suites;
+    return suites;
+}
+
+Registration::Registration(const char* name, void (*run)()) {
+    registry().push_back(Suite{name, run});
+}
+
+Result measure(const std::string& name, size_t threads, uint64_t iterations, const Body& body) {
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            ready++;
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            body(t, iterations);
+        });
+    }
+
+    while (ready.load() < threads) {
+        std::this_thread::yield();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    Result result;
+    result.name = name;
+    result.threads = threads;
+    result.operations = iterations * threads;
+    result.seconds = std::chrono::duration<double>(elapsed).count();
+    result.ns_per_op = result.seconds * 1e9 * static_cast<double>(threads) / static_cast<double>(result.operations);
+    result.ops_per_sec = static_cast<double>(result.operations) / result.seconds;
+    return result;
+}
+
+void report(const Result& result) {
+    std::printf("{\"benchmark\":\"%s\",\"threads\":%zu,\"operations\":%llu,"
+                "\"seconds\":%.6f,\"ns_per_op\":%.2f,\"ops_per_sec\":%.0f}\n",
+                result.name.c_str(), result.threads,
+                static_cast<unsigned long long>(result.operations),
+                result.seconds, result.ns_per_op, result.ops_per_sec);
+    std::fflush(stdout);
+}
+
+} // namespace QMark::bench
+
+int main(int argc, char** argv) {
+    // Usage: qmark-bench [filter]  (runs suites whose name contains filter)
+    const char* filter = argc > 1 ? argv[1] : "";
+
+    for (const auto& suite : QMark::bench::registry()) {
+        if (std::strstr(suite.name, filter)) {
+            suite.run();
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include "bench.hpp"
+#include "database/database_manager.hpp"
+#include "utils/logger.hpp"
+#include <filesystem>
+#include <fstream>
+
+using namespace QMark;
+
+namespace {
+
+constexpr int USERS = 1000;
+constexpr uint64_t LEAD_BATCHES = 100;
+constexpr size_t LEADS_PER_BATCH = 50;
+
+std::vector<qmark::Lead> leadBatch(qmark::UserId user_id, uint64_t batch) {
+    std::vector<qmark::Lead> leads(LEADS_PER_BATCH);
+    for (size_t i = 0; i < leads.size(); i++) {
+        leads[i].user_id = user_id;
+        leads[i].name = "Lead " + std::to_string(batch) + "-" + std::to_string(i);
+        leads[i].email = "lead" + std::to_string(batch) + "." + std::to_string(i) + "@example.com";
+        leads[i].source = "bench";
+    }
+    return leads;
+}
+
+// Concurrent lead batches from writers on distinct users: one file serializes
+// them. Writer t uses a user placed on shard t of a 4-shard layout.
+void leadWriters(const std::string& label) {
+    DatabaseManager& db = DatabaseManager::getInstance();
+    std::vector<qmark::UserId> users;
+    for (qmark::UserId user = 1; users.size() < 4; user++) {
+        if (DatabaseManager::shardOf(user, 4) == users.size()) {
+            users.push_back(user);
+        }
+    }
+
+    for (size_t threads : {size_t{1}, size_t{4}}) {
+        bench::report(bench::measure("database/write_leads_50/" + label + "/" + std::to_string(threads) + "_threads",
+            threads, LEAD_BATCHES,
+            [&](size_t thread, uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                    auto leads = leadBatch(users[thread], i);
+                    bench::doNotOptimize(db.writeLeads(leads, {}));
+                }
+            }));
+    }
+}
+
+} // namespace
+
+// DatabaseManager on a scratch file: user insert and lookup (single
+// connection, so lookups contend on its lock), session batches, lead
+// batches, then the same lead writers against a 4-shard layout
+QMARK_BENCH(database) {
+    auto directory = std::filesystem::temp_directory_path() / "qmark-database-bench";
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    std::string path = (directory / "qmark.db").string();
+
+    LoggerOptions options;
+    options.console_output = false;
+    Logger::getInstance().init((directory / "bench.log").string(), options);
+
+    DatabaseManager& db = DatabaseManager::getInstance();
+    db.init(path);
+
+    bench::report(bench::measure("database/insert_user", 1, USERS,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                std::string name = "user" + std::to_string(i);
+                bench::doNotOptimize(db.insertUser(name, name + "@example.com", "hash"));
+            }
+        }));
+
+    for (size_t threads : {size_t{1}, size_t{4}}) {
+        bench::report(bench::measure("database/find_user/" + std::to_string(threads) + "_threads", threads, 20000,
+            [&](size_t thread, uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                    bench::doNotOptimize(db.findUser("user" + std::to_string((i * 7 + thread) % USERS)));
+                }
+            }));
+    }
+
+    bench::report(bench::measure("database/save_sessions_100", 1, 100,
+        [&](size_t, uint64_t iterations) {
+            std::vector<SessionRecord> sessions(100);
+            for (uint64_t i = 0; i < iterations; i++) {
+                for (size_t s = 0; s < sessions.size(); s++) {
+                    sessions[s] = SessionRecord{"session-" + std::to_string(s), static_cast<int64_t>(1 + s), "{}",
+                                                4000000000 + static_cast<int64_t>(i)};
+                }
+                bench::doNotOptimize(db.saveSessions(sessions));
+            }
+        }));
+
+    leadWriters("1_file");
+
+    bench::report(bench::measure("database/query_leads", 1, 1000,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(db.query("SELECT id, name, email FROM leads WHERE user_id = " +
+                                              std::to_string(1 + i % 4) + " LIMIT 50;"));
+            }
+        }));
+
+    // Same writers once the tenant tables are spread over 4 files
+    db.execute("INSERT INTO shard_layout (shard_count, id_floor) VALUES (4, 0);");
+    db.close();
+    for (size_t i = 0; i < 4; i++) {
+        std::ofstream(DatabaseManager::shardPath(path, i));
+    }
+    db.init(path);
+    leadWriters("4_shards");
+
+    bench::report(bench::measure("database/count_leads_fan_out", 1, 100,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(db.countLeads());
+            }
+        }));
+
+    db.close();
+    std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,83 @@
+#include "bench.hpp"
+#include "security/encryption.hpp"
+#include <string>
+
+using namespace QMark;
+
+namespace {
+
+constexpr uint64_t ITERATIONS = 200000;
+
+// AES-256 key as the refresher gets it from ENCRYPTION_KEY, and an OAuth token of typical length
+const std::string KEY(32, 'k');
+const std::string TOKEN =
+    "ya29.a0AfB_byC3x9kQm2Lr7TnVd8ZpWq4Ys1Hj6Ue0Ig5Ko3Mb2Nc7Xa9Rt1Sv4Fw8Dh2Jl6Pq0Gz5Ey3Bu7Ci9Ak1Om4Tn8Lr2Vd6Zp"
+    "Wq0Ys3Hj7Ue1Ig5Ko9Mb4Nc2Xa6Rt8Sv0Fw3Dh7Jl1Pq5Gz9Ey2Bu6Ci0Ak4Om8Tn";
+
+} // namespace
+
+// Token encryption as the OAuth paths use it, webhook signature primitives,
+// hex conversions and the deliberately slow password hash
+QMARK_BENCH(encryption) {
+    std::string ciphertext = Encryption::encrypt(TOKEN, KEY);
+
+    bench::report(bench::measure("encryption/encrypt_token", 1, ITERATIONS,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(Encryption::encrypt(TOKEN, KEY));
+            }
+        }));
+
+    bench::report(bench::measure("encryption/decrypt_token", 1, ITERATIONS,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(Encryption::decrypt(ciphertext, KEY));
+            }
+        }));
+
+    bench::report(bench::measure("encryption/decrypt_token/4_threads", 4, ITERATIONS / 4,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(Encryption::decrypt(ciphertext, KEY));
+            }
+        }));
+
+    std::string body(2048, 'x');
+    bench::report(bench::measure("encryption/hmac_sha256_2k", 1, ITERATIONS,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(Encryption::hmacSha256(KEY, body));
+            }
+        }));
+
+    bench::report(bench::measure("encryption/sha256_hex_2k", 1, ITERATIONS,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(Encryption::sha256Hex(body));
+            }
+        }));
+
+    std::vector<unsigned char> bytes(TOKEN.begin(), TOKEN.end());
+    std::string hex = Encryption::bytesToHex(bytes);
+    bench::report(bench::measure("encryption/bytes_to_hex", 1, ITERATIONS,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(Encryption::bytesToHex(bytes));
+            }
+        }));
+
+    bench::report(bench::measure("encryption/hex_to_bytes", 1, ITERATIONS,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(Encryption::hexToBytes(hex));
+            }
+        }));
+
+    std::string salt = Encryption::generateSalt();
+    bench::report(bench::measure("encryption/hash_password", 1, 20,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(Encryption::hashPassword("correct horse battery staple", salt));
+            }
+        }));
+}
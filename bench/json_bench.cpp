@@ -0,0 +1,211 @@
+#include "bench.hpp"
+#include "qmark_json.hpp"
+#include "utils/json_reader.hpp"
+#include <nlohmann/json.hpp>
+#include <cstdio>
+
+using json = nlohmann::json;
+using namespace QMark;
+
+namespace {
+
+constexpr uint64_t ITERATIONS = 200000;
+constexpr size_t LIST_SIZE = 1000;
+
+qmark::User sampleUser(uint64_t id) {
+    qmark::User user;
+    user.id = id;
+    user.username = "user" + std::to_string(id);
+    user.email = "user" + std::to_string(id) + "@example.com";
+    user.display_name = "Sample \"Quoted\" User\n";
+    user.avatar_url = "https://cdn.example.com/avatars/" + std::to_string(id) + ".png";
+    user.replit_user_id = "r-" + std::to_string(id * 7919);
+    user.created_at = std::chrono::system_clock::now();
+    user.updated_at = user.created_at;
+    user.is_premium = id % 2 == 0;
+    return user;
+}
+
+// The previous path: one DOM node per field, then dump() into a fresh string
+json userToDom(const qmark::User& user) {
+    return json{
+        {"id", user.id},
+        {"username", user.username},
+        {"email", user.email},
+        {"display_name", user.display_name},
+        {"avatar_url", user.avatar_url},
+        {"replit_user_id", user.replit_user_id},
+        {"created_at", std::chrono::duration_cast<std::chrono::seconds>(user.created_at.time_since_epoch()).count()},
+        {"updated_at", std::chrono::duration_cast<std::chrono::seconds>(user.updated_at.time_since_epoch()).count()},
+        {"is_premium", user.is_premium}
+    };
+}
+
+// Lead-import style payload: an array of flat objects with mixed field types
+std::string leadImportPayload(size_t leads) {
+    std::string out;
+    JsonWriter writer(out);
+    writer.beginObject().field("source", "csv-import");
+    writer.key("leads").beginArray();
+    for (size_t i = 0; i < leads; i++) {
+        writer.beginObject()
+            .field("email", "lead" + std::to_string(i) + "@example.com")
+            .field("first_name", "Jean-Frédéric")
+            .field("last_name", "O'Connor \"JF\"")
+            .field("company", "Société Générale des Exemples")
+            .field("score", static_cast<int64_t>(i % 100))
+            .field("conversion_probability", 0.125 * static_cast<double>(i % 8))
+            .field("subscribed", i % 3 == 0);
+        writer.key("tags").beginArray().value("imported").value("b2b").endArray();
+        writer.endObject();
+    }
+    writer.endArray().endObject();
+    return out;
+}
+
+} // namespace
+
+// DOM + dump() versus the streaming writer, single object and 1000-item list
+QMARK_BENCH(json) {
+    const qmark::User user = sampleUser(42);
+    std::vector<qmark::User> users;
+    for (size_t i = 0; i < LIST_SIZE; i++) {
+        users.push_back(sampleUser(i));
+    }
+
+    bench::report(bench::measure("json/user_nlohmann_dom", 1, ITERATIONS,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(userToDom(user).dump());
+            }
+        }));
+
+    bench::report(bench::measure("json/user_writer", 1, ITERATIONS,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                std::string& buffer = JsonWriter::threadBuffer();
+                JsonWriter writer(buffer);
+                json_utils::write_user(writer, user);
+                bench::doNotOptimize(buffer.data());
+            }
+        }));
+
+    bench::report(bench::measure("json/user_list_nlohmann_dom", 1, ITERATIONS / LIST_SIZE * 10,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                json list = json::array();
+                for (const auto& u : users) {
+                    list.push_back(userToDom(u));
+                }
+                bench::doNotOptimize(list.dump());
+            }
+        }));
+
+    bench::report(bench::measure("json/user_list_writer", 1, ITERATIONS / LIST_SIZE * 10,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                std::string& buffer = JsonWriter::threadBuffer();
+                JsonWriter writer(buffer);
+                writer.beginArray();
+                for (const auto& u : users) {
+                    json_utils::write_user(writer, u);
+                }
+                writer.endArray();
+                bench::doNotOptimize(buffer.data());
+            }
+        }));
+}
+
+// Request body parsing: DOM versus structural indexing + on-demand walk
+QMARK_BENCH(json_parse) {
+    const std::string payload = leadImportPayload(20000);
+    constexpr uint64_t PARSES = 20;
+
+    auto throughput = [&](bench::Result result) {
+        bench::report(result);
+        double mb_per_sec = static_cast<double>(payload.size()) / (result.ns_per_op / 1e9) / 1e6;
+        std::printf("{\"benchmark\":\"%s\",\"payload_bytes\":%zu,\"mb_per_sec\":%.1f}\n",
+                    result.name.c_str(), payload.size(), mb_per_sec);
+    };
+
+    throughput(bench::measure("json_parse/nlohmann_dom", 1, PARSES,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                json document = json::parse(payload);
+                bench::doNotOptimize(document.size());
+            }
+        }));
+
+    throughput(bench::measure("json_parse/structural_index", 1, PARSES,
+        [&](size_t, uint64_t iterations) {
+            std::vector<uint32_t> structurals;
+            size_t count = 0;
+            std::string error;
+            for (uint64_t i = 0; i < iterations; i++) {
+                JsonReader::indexStructurals(payload, structurals, count, error);
+                bench::doNotOptimize(count);
+            }
+        }));
+
+    throughput(bench::measure("json_parse/reader_validate", 1, PARSES,
+        [&](size_t, uint64_t iterations) {
+            JsonReader reader;
+            for (uint64_t i = 0; i < iterations; i++) {
+                reader.parse(payload);
+                bench::doNotOptimize(reader.fields().size());
+            }
+        }));
+
+    throughput(bench::measure("json_parse/reader_validate_and_extract", 1, PARSES,
+        [&](size_t, uint64_t iterations) {
+            JsonReader reader;
+            std::string email;
+            for (uint64_t i = 0; i < iterations; i++) {
+                reader.parse(payload);
+                int64_t score_total = 0;
+                reader.forEachElement(*reader.find("leads"), [&](const JsonReader::Value& lead) {
+                    reader.forEachMember(lead, [&](std::string_view key, const JsonReader::Value& value) {
+                        int64_t score;
+                        if (key == "email") {
+                            JsonReader::getString(value, email);
+                        } else if (key == "score" && JsonReader::getInt64(value, score)) {
+                            score_total += score;
+                        }
+                    });
+                });
+                bench::doNotOptimize(score_total);
+            }
+        }));
+}
+
+// Typed decoding of a User document: DOM lookups versus the generated codec
+QMARK_BENCH(json_codec) {
+    const std::string document = json_utils::serialize_user(sampleUser(42));
+
+    bench::report(bench::measure("json_codec/parse_user_nlohmann_dom", 1, ITERATIONS,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                json j = json::parse(document);
+                qmark::User user;
+                user.id = j.at("id").get<uint64_t>();
+                user.username = j.at("username").get<std::string>();
+                user.email = j.at("email").get<std::string>();
+                user.display_name = j.at("display_name").get<std::string>();
+                user.avatar_url = j.at("avatar_url").get<std::string>();
+                user.replit_user_id = j.at("replit_user_id").get<std::string>();
+                user.created_at = qmark::Timestamp(std::chrono::seconds(j.at("created_at").get<int64_t>()));
+                user.updated_at = qmark::Timestamp(std::chrono::seconds(j.at("updated_at").get<int64_t>()));
+                user.is_premium = j.at("is_premium").get<bool>();
+                bench::doNotOptimize(user.id);
+            }
+        }));
+
+    bench::report(bench::measure("json_codec/parse_user_reflected", 1, ITERATIONS,
+        [&](size_t, uint64_t iterations) {
+            qmark::User user;
+            for (uint64_t i = 0; i < iterations; i++) {
+                json_utils::parse_user(document, user);
+                bench::doNotOptimize(user.id);
+            }
+        }));
+}
@@ -0,0 +1,125 @@
+#include "bench.hpp"
+#include "leads/lead_index.hpp"
+#include <chrono>
+#include <cstdio>
+
+using namespace QMark;
+
+namespace {
+
+constexpr uint64_t LEADS = 10000000;
+constexpr uint64_t USERS = 2000;
+constexpr size_t QUERIES = 1 << 20;
+
+const char* const FIRST_NAMES[] = {"Jean", "Marie", "Lucas", "Emma", "Hugo", "Lea", "Louis", "Chloe"};
+const char* const DOMAINS[] = {"gmail.com", "yahoo.fr", "orange.fr", "hotmail.com", "free.fr", "outlook.com"};
+
+// Lead n as it would arrive from a form: mixed case, spacing and number formats
+std::string emailOf(uint64_t n) {
+    return std::string(FIRST_NAMES[n % 8]) + ".Martin" + std::to_string(n) + "@" + DOMAINS[n % 6];
+}
+
+std::string phoneOf(uint64_t n) {
+    uint64_t subscriber = 10000000 + (n * 2654435761u) % 90000000;
+    std::string digits = std::to_string(subscriber);
+    return n % 2 ? "06 " + digits.substr(0, 2) + " " + digits.substr(2, 2) + " " + digits.substr(4, 2) + " " + digits.substr(6)
+                 : "+337" + digits;
+}
+
+qmark::UserId userOf(uint64_t n) {
+    return 1 + n % USERS;
+}
+
+struct Query {
+    qmark::UserId user_id;
+    std::string email;
+    std::string phone;
+};
+
+} // namespace
+
+// Deduplication index at 10M leads: build time, footprint, lookups per second
+// for known leads (hit) and new ones (miss, mostly answered by the filter)
+QMARK_BENCH(lead_index) {
+    LeadIndex& index = LeadIndex::getInstance();
+    LeadIndexConfig config;
+    config.load_from_database = false;
+    index.start(config);
+
+    auto started = std::chrono::steady_clock::now();
+    for (uint64_t n = 1; n <= LEADS; n++) {
+        index.add(userOf(n), n, emailOf(n), phoneOf(n));
+    }
+    double build_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    LeadIndex::Stats stats = index.stats();
+    std::printf("{\"benchmark\":\"lead_index/build\",\"leads\":%llu,\"users\":%zu,\"keys\":%zu,"
+                "\"seconds\":%.3f,\"memory_bytes\":%zu,\"bytes_per_lead\":%.1f}\n",
+                static_cast<unsigned long long>(LEADS), stats.users, stats.keys, build_seconds,
+                stats.memory_bytes, static_cast<double>(stats.memory_bytes) / static_cast<double>(LEADS));
+
+    std::vector<Query> hits;
+    std::vector<Query> misses;
+    hits.reserve(QUERIES);
+    misses.reserve(QUERIES);
+    for (uint64_t i = 0; i < QUERIES; i++) {
+        uint64_t n = 1 + (i * 11400714819323198485ull) % LEADS;
+        hits.push_back({userOf(n), emailOf(n), phoneOf(n)});
+        uint64_t fresh = LEADS + 1 + i;
+        misses.push_back({userOf(n), emailOf(fresh), phoneOf(fresh) + "9"});
+    }
+
+    for (size_t threads : {size_t{1}, size_t{4}}) {
+        bench::report(bench::measure("lead_index/find_hit/" + std::to_string(threads) + "_threads", threads, 2000000,
+            [&](size_t thread, uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                    const Query& query = hits[(i + thread * 7919) & (QUERIES - 1)];
+                    bench::doNotOptimize(index.find(query.user_id, query.email, query.phone).lead_id);
+                }
+            }));
+        bench::report(bench::measure("lead_index/find_miss/" + std::to_string(threads) + "_threads", threads, 2000000,
+            [&](size_t thread, uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                    const Query& query = misses[(i + thread * 7919) & (QUERIES - 1)];
+                    bench::doNotOptimize(index.find(query.user_id, query.email, query.phone).lead_id);
+                }
+            }));
+    }
+
+    // Bulk import in batches of 1000, half of them already known; the write is a stub
+    qmark::LeadId next_id = LEADS + QUERIES + 1;
+    config.write = [&](std::vector<qmark::Lead>& inserts, const std::vector<qmark::Lead>&) {
+        for (auto& lead : inserts) {
+            lead.id = next_id++;
+        }
+        return true;
+    };
+    index.start(config);
+    for (uint64_t n = 1; n <= LEADS; n++) {
+        index.add(userOf(n), n, emailOf(n), phoneOf(n));
+    }
+
+    size_t merged = 0;
+    bench::report(bench::measure("lead_index/upsert_batch_1000", 1, 200,
+        [&](size_t, uint64_t iterations) {
+            std::vector<qmark::Lead> batch;
+            for (uint64_t round = 0; round < iterations; round++) {
+                batch.clear();
+                for (uint64_t i = 0; i < 1000; i++) {
+                    uint64_t n = i % 2 ? USERS * (1 + (round * 1000 + i) % (LEADS / USERS)) : LEADS * 2 + round * 1000 + i;
+                    qmark::Lead& lead = batch.emplace_back();
+                    lead.name = "Lead " + std::to_string(n);
+                    lead.email = emailOf(n);
+                    lead.phone = phoneOf(n);
+                    lead.source = "facebook";
+                }
+                auto result = index.upsert(1, batch);
+                merged += result ? result->merged : 0;
+            }
+        }));
+    std::printf("{\"benchmark\":\"lead_index/upsert_batch_1000\",\"merged\":%zu}\n", merged);
+
+    // Leave an empty index behind for the next suite
+    config.write = nullptr;
+    index.start(config);
+}
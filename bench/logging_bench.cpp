@@ -0,0 +1,50 @@
+#include "bench.hpp"
+#include "utils/binary_log.hpp"
+#include "utils/logger.hpp"
+#include <filesystem>
+
+using namespace QMark;
+
+namespace {
+
+const size_t THREAD_COUNTS[] = {1, 4, 16};
+constexpr uint64_t ITERATIONS = 100000;
+
+} // namespace
+
+// Text logger throughput under contention (async ring, file output only)
+QMARK_BENCH(logger) {
+    auto dir = std::filesystem::temp_directory_path() / "qmark-bench";
+    LoggerOptions options;
+    options.console_output = false;
+    Logger::getInstance().init((dir / "bench.log").string(), options);
+
+    for (size_t threads : THREAD_COUNTS) {
+        bench::report(bench::measure("logger/text_info", threads, ITERATIONS,
+            [](size_t thread, uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                    Logger::info("HTTP GET /api/data -> 200 thread " + std::to_string(thread));
+                }
+            }));
+        Logger::getInstance().flush();
+    }
+}
+
+// Structured binary log: cost of the call site only, decoding is offline
+QMARK_BENCH(binary_log) {
+    auto dir = std::filesystem::temp_directory_path() / "qmark-bench";
+    BinaryLog::getInstance().open((dir / "bench.blog").string());
+
+    for (size_t threads : THREAD_COUNTS) {
+        bench::report(bench::measure("binary_log/qlog_info", threads, ITERATIONS,
+            [](size_t thread, uint64_t iterations) {
+                const std::string method = "GET";
+                const std::string path = "/api/data";
+                for (uint64_t i = 0; i < iterations; i++) {
+                    QLOG_INFO("HTTP {} {} -> {} thread {}", method, path, 200, thread);
+                }
+            }));
+    }
+
+    BinaryLog::getInstance().close();
+}
@@ -0,0 +1,32 @@
+#include "bench.hpp"
+#include "utils/metrics.hpp"
+
+using namespace QMark;
+
+namespace {
+
+const size_t THREAD_COUNTS[] = {1, 4, 16};
+constexpr uint64_t ITERATIONS = 1000000;
+
+} // namespace
+
+// Request-path cost of recording one request (per-thread shard, no shared writes)
+QMARK_BENCH(metrics) {
+    for (size_t threads : THREAD_COUNTS) {
+        bench::report(bench::measure("metrics/record_request", threads, ITERATIONS,
+            [](size_t thread, uint64_t iterations) {
+                const std::string method = "GET";
+                const std::string route = "/api/data";
+                for (uint64_t i = 0; i < iterations; i++) {
+                    MetricsRegistry::getInstance().recordRequest(method, route, 200, (i + thread) & 0xFFFF);
+                }
+            }));
+    }
+
+    bench::report(bench::measure("metrics/render_prometheus", 1, 1000,
+        [](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(MetricsRegistry::getInstance().renderPrometheus());
+            }
+        }));
+}
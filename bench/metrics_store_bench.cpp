@@ -0,0 +1,93 @@
+#include "bench.hpp"
+#include "analytics/metrics_store.hpp"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <random>
+
+using namespace QMark;
+
+namespace {
+
+constexpr qmark::UserId USERS = 1000;
+constexpr int32_t DAYS = 3650;
+constexpr int32_t FIRST_DAY = 16071;        // 2014-01-01
+constexpr uint64_t QUERIES = 200000;
+
+} // namespace
+
+// Ten years of daily counters for 1000 users, then the dashboard queries:
+// totals/min/max over random ranges (one slice scan per column) and monthly
+// charts; plus the cost of the snapshot that replaces a full SQLite reload
+QMARK_BENCH(metrics_store) {
+    std::string snapshot = (std::filesystem::temp_directory_path() / "qmark-metrics-bench.snapshot").string();
+    std::filesystem::remove(snapshot);
+
+    MetricsStoreConfig config;
+    config.snapshot_path = snapshot;
+    config.load_from_database = false;
+    config.flush_interval = std::chrono::hours(1);
+    config.persist = [](const std::vector<qmark::DailyMetrics>&) { return true; };
+
+    MetricsStore& store = MetricsStore::getInstance();
+    store.start(config);
+
+    auto load_start = std::chrono::steady_clock::now();
+    std::mt19937_64 rng(42);
+    for (qmark::UserId user = 1; user <= USERS; user++) {
+        for (int32_t day = FIRST_DAY; day < FIRST_DAY + DAYS; day++) {
+            MetricsStore::Delta delta;
+            delta.leads = static_cast<int32_t>(rng() % 50);
+            delta.conversions = static_cast<int32_t>(rng() % 10);
+            delta.automations = static_cast<int32_t>(rng() % 20);
+            delta.revenue_cents = static_cast<int64_t>(rng() % 100000);
+            store.record(user, day, delta);
+        }
+    }
+    double load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+    store.flush();
+
+    MetricsStore::Stats stats = store.stats();
+    std::printf("{\"benchmark\":\"metrics_store/load\",\"users\":%zu,\"days\":%zu,\"ms\":%.1f,\"memory_bytes\":%zu}\n",
+                stats.users, stats.days, load_ms, stats.memory_bytes);
+
+    for (int32_t span : {31, 365, DAYS}) {
+        for (size_t threads : {size_t{1}, size_t{4}}) {
+            bench::report(bench::measure("metrics_store/summarize_" + std::to_string(span) + "d/" +
+                                         std::to_string(threads) + "_threads", threads, QUERIES / threads,
+                [&](size_t thread, uint64_t iterations) {
+                    std::mt19937_64 queries(thread);
+                    for (uint64_t i = 0; i < iterations; i++) {
+                        qmark::UserId user = 1 + static_cast<qmark::UserId>(queries() % USERS);
+                        int32_t from = FIRST_DAY + static_cast<int32_t>(queries() % (DAYS - span + 1));
+                        bench::doNotOptimize(store.summarize(user, from, from + span - 1));
+                    }
+                }));
+        }
+    }
+
+    bench::report(bench::measure("metrics_store/series_monthly_10y", 1, QUERIES / 10,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                qmark::UserId user = 1 + static_cast<qmark::UserId>(i % USERS);
+                bench::doNotOptimize(store.series(user, FIRST_DAY, FIRST_DAY + DAYS - 1,
+                                                  MetricsStore::Granularity::MONTH));
+            }
+        }));
+
+    auto save_start = std::chrono::steady_clock::now();
+    bool saved = store.saveSnapshot();
+    double save_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - save_start).count();
+    store.stop();
+
+    auto restore_start = std::chrono::steady_clock::now();
+    store.start(config);
+    double restore_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - restore_start).count();
+    std::printf("{\"benchmark\":\"metrics_store/snapshot\",\"saved\":%s,\"bytes\":%llu,\"save_ms\":%.1f,\"restore_ms\":%.1f,\"restored_days\":%zu}\n",
+                saved ? "true" : "false",
+                static_cast<unsigned long long>(std::filesystem::file_size(snapshot)),
+                save_ms, restore_ms, store.stats().days);
+
+    store.stop();
+    std::filesystem::remove(snapshot);
+}
@@ -0,0 +1,134 @@
+#include "bench.hpp"
+#include "outbound/http_client.hpp"
+#include <httplib.h>
+#include <openssl/evp.h>
+#include <openssl/x509.h>
+#include <cstdio>
+#include <thread>
+
+using namespace QMark;
+
+namespace {
+
+constexpr int HTTP_PORT = 18931;
+constexpr int HTTPS_PORT = 18932;
+
+// Throwaway self-signed certificate for the local stand-in provider
+struct SelfSigned {
+    EVP_PKEY* key = nullptr;
+    X509* cert = nullptr;
+
+    SelfSigned() {
+        key = EVP_RSA_gen(2048);
+        cert = X509_new();
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+        X509_set_pubkey(cert, key);
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+        X509_sign(cert, key, EVP_sha256());
+    }
+
+    ~SelfSigned() {
+        X509_free(cert);
+        EVP_PKEY_free(key);
+    }
+};
+
+template<typename Server>
+void serveToken(Server& server) {
+    // Headers and body go out in two writes: without TCP_NODELAY each kept-alive
+    // response waits for the client's delayed ACK
+    server.set_tcp_nodelay(true);
+    server.Get("/oauth/token", [](const httplib::Request&, httplib::Response& res) {
+        res.set_content("{\"access_token\":\"EAAB\",\"token_type\":\"bearer\",\"expires_in\":5183944}", "application/json");
+    });
+}
+
+} // namespace
+
+// Round trip to a local stand-in provider: a client built per call (new
+// socket and full TLS handshake) against the pooled keep-alive client
+QMARK_BENCH(outbound) {
+    SelfSigned identity;
+    httplib::Server http;
+    httplib::SSLServer https(identity.cert, identity.key);
+    serveToken(http);
+    serveToken(https);
+
+    std::thread http_thread([&]() { http.listen("127.0.0.1", HTTP_PORT); });
+    std::thread https_thread([&]() { https.listen("127.0.0.1", HTTPS_PORT); });
+    http.wait_until_ready();
+    https.wait_until_ready();
+
+    const struct {
+        const char* scheme;
+        std::string origin;
+        uint64_t iterations;
+    } targets[] = {
+        {"http", "http://127.0.0.1:" + std::to_string(HTTP_PORT), 2000},
+        {"https", "https://127.0.0.1:" + std::to_string(HTTPS_PORT), 300}
+    };
+
+    OutboundHostConfig config;
+    config.verify_certificates = false;
+
+    for (const auto& target : targets) {
+        bench::report(bench::measure(std::string("outbound/fresh_client/") + target.scheme, 1, target.iterations,
+            [&](size_t, uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                    httplib::Client client(target.origin);
+                    client.enable_server_certificate_verification(false);
+                    auto result = client.Get("/oauth/token");
+                    bench::doNotOptimize(result ? result->status : 0);
+                }
+            }));
+
+        OutboundClient::getInstance().configureHost(target.origin, config);
+        bench::report(bench::measure(std::string("outbound/pooled/") + target.scheme, 1, target.iterations * 5,
+            [&](size_t, uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                    auto response = OutboundClient::getInstance().get(target.origin, "/oauth/token");
+                    bench::doNotOptimize(response.status);
+                }
+            }));
+
+        // New connections only, so every handshake can resume the cached session
+        OutboundHostConfig no_reuse = config;
+        no_reuse.idle_timeout = std::chrono::seconds(0);
+        OutboundClient::getInstance().configureHost(target.origin, no_reuse);
+        bench::report(bench::measure(std::string("outbound/new_connection/") + target.scheme, 1, target.iterations,
+            [&](size_t, uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                    auto response = OutboundClient::getInstance().get(target.origin, "/oauth/token");
+                    bench::doNotOptimize(response.status);
+                }
+            }));
+
+        auto stats = OutboundClient::getInstance().hostStats(target.origin);
+        std::printf("{\"benchmark\":\"outbound/new_connection/%s\",\"tls_handshakes\":%llu,\"tls_resumed\":%llu}\n",
+                    target.scheme, static_cast<unsigned long long>(stats.tls_handshakes),
+                    static_cast<unsigned long long>(stats.tls_resumed));
+    }
+
+    // Concurrent identical GETs: one upstream request per flight
+    OutboundClient::getInstance().configureHost(targets[0].origin, config);
+    bench::report(bench::measure("outbound/pooled/http/8_threads", 8, 2000,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                auto response = OutboundClient::getInstance().get(targets[0].origin, "/oauth/token");
+                bench::doNotOptimize(response.status);
+            }
+        }));
+    auto stats = OutboundClient::getInstance().hostStats(targets[0].origin);
+    std::printf("{\"benchmark\":\"outbound/pooled/http/8_threads\",\"upstream_requests\":%llu,\"coalesced\":%llu}\n",
+                static_cast<unsigned long long>(stats.requests), static_cast<unsigned long long>(stats.coalesced));
+
+    OutboundClient::getInstance().shutdown();
+    http.stop();
+    https.stop();
+    http_thread.join();
+    https_thread.join();
+}
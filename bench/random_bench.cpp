@@ -0,0 +1,42 @@
+#include "bench.hpp"
+#include "security/random.hpp"
+#include <openssl/rand.h>
+#include <array>
+
+using namespace QMark;
+
+namespace {
+
+const size_t THREAD_COUNTS[] = {1, 8, 32};
+constexpr uint64_t ITERATIONS = 200000;
+
+template<size_t N>
+void runBoth(const std::string& label) {
+    for (size_t threads : THREAD_COUNTS) {
+        bench::report(bench::measure("random/openssl_rand_bytes/" + label, threads, ITERATIONS,
+            [](size_t, uint64_t iterations) {
+                std::array<unsigned char, N> out;
+                for (uint64_t i = 0; i < iterations; i++) {
+                    RAND_bytes(out.data(), static_cast<int>(out.size()));
+                    bench::doNotOptimize(out);
+                }
+            }));
+
+        bench::report(bench::measure("random/secure_random/" + label, threads, ITERATIONS,
+            [](size_t, uint64_t iterations) {
+                std::array<unsigned char, N> out;
+                for (uint64_t i = 0; i < iterations; i++) {
+                    SecureRandom::fill(out.data(), out.size());
+                    bench::doNotOptimize(out);
+                }
+            }));
+    }
+}
+
+} // namespace
+
+// Sizes match the call sites: IV/salt (16 bytes), session id and CSRF token (32 bytes)
+QMARK_BENCH(random) {
+    runBoth<16>("16B");
+    runBoth<32>("32B");
+}
@@ -0,0 +1,94 @@
+#include "bench.hpp"
+#include "automation/automation_scheduler.hpp"
+#include <chrono>
+#include <cstdio>
+
+using namespace QMark;
+
+namespace {
+
+constexpr uint64_t AUTOMATIONS = 1000000;
+constexpr uint64_t USERS = 20000;
+constexpr int64_t START_MS = int64_t{1716480000} * 1000;
+constexpr int64_t HOUR_MS = 3600 * 1000;
+
+const int64_t INTERVALS[] = {300, 900, 3600, 6 * 3600, 24 * 3600};
+
+qmark::Automation makeAutomation(uint64_t id) {
+    qmark::Automation automation;
+    automation.id = id;
+    automation.user_id = 1 + id % USERS;
+    automation.name = "Relance #" + std::to_string(id);
+    automation.type = "sequence";
+    int64_t interval = INTERVALS[id % 5];
+    automation.config = "{\"interval_seconds\":" + std::to_string(interval) + "}";
+    // Last runs scattered over the previous interval: steady state, no startup backlog
+    int64_t last_run_ms = START_MS - static_cast<int64_t>((id * 2654435761u) % static_cast<uint64_t>(interval * 1000));
+    automation.last_run = qmark::Timestamp(std::chrono::milliseconds(last_run_ms));
+    return automation;
+}
+
+struct Simulation {
+    double load_seconds = 0.0;
+    double advance_seconds = 0.0;
+    size_t runs = 0;
+    size_t persisted = 0;
+    size_t batches = 0;
+    uint64_t checksum = 0;
+};
+
+// One simulated hour over AUTOMATIONS automations; handlers run inline
+Simulation simulate() {
+    Simulation result;
+
+    AutomationSchedulerConfig config;
+    config.simulated_clock = true;
+    config.simulated_start_ms = START_MS;
+    config.load_from_database = false;
+    config.queue_capacity = 1 << 16;
+    config.persist_runs = [&](const std::vector<AutomationRunRecord>& runs) {
+        result.persisted += runs.size();
+        result.batches++;
+        return true;
+    };
+
+    auto& scheduler = AutomationScheduler::getInstance();
+    scheduler.start(config);
+
+    // The order of execution feeds the checksum: two runs must agree
+    scheduler.registerHandler("sequence", [&](const qmark::Automation& automation, std::string&) {
+        result.checksum = result.checksum * 1099511628211u + automation.id;
+        return true;
+    });
+
+    auto started = std::chrono::steady_clock::now();
+    for (uint64_t id = 1; id <= AUTOMATIONS; id++) {
+        scheduler.upsert(makeAutomation(id));
+    }
+    auto loaded = std::chrono::steady_clock::now();
+    result.runs = scheduler.advanceTo(START_MS + HOUR_MS);
+    auto finished = std::chrono::steady_clock::now();
+
+    scheduler.stop();
+
+    result.load_seconds = std::chrono::duration<double>(loaded - started).count();
+    result.advance_seconds = std::chrono::duration<double>(finished - loaded).count();
+    return result;
+}
+
+} // namespace
+
+// Simulated-clock scheduling: load cost, dispatch throughput and determinism
+QMARK_BENCH(scheduler) {
+    Simulation first = simulate();
+    Simulation second = simulate();
+
+    std::printf("{\"benchmark\":\"scheduler/load_1m\",\"seconds\":%.3f,\"ns_per_op\":%.1f}\n",
+                first.load_seconds, first.load_seconds * 1e9 / static_cast<double>(AUTOMATIONS));
+    std::printf("{\"benchmark\":\"scheduler/simulated_hour\",\"runs\":%zu,\"seconds\":%.3f,\"ns_per_run\":%.1f,"
+                "\"persisted\":%zu,\"batches\":%zu,\"deterministic\":%s}\n",
+                first.runs, first.advance_seconds,
+                first.advance_seconds * 1e9 / static_cast<double>(first.runs ? first.runs : 1),
+                first.persisted, first.batches,
+                first.checksum == second.checksum && first.runs == second.runs ? "true" : "false");
+}
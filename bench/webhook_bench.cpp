@@ -0,0 +1,71 @@
+#include "bench.hpp"
+#include "ingest/webhook_ingest.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <thread>
+
+using namespace QMark;
+
+namespace {
+
+constexpr uint64_t DELIVERIES = 20000;
+
+const std::string BODY =
+    "{\"user_id\":42,\"leads\":[{\"name\":\"Jean Martin\",\"email\":\"jean.martin@gmail.com\","
+    "\"phone\":\"06 12 34 56 78\",\"source\":\"facebook\"}]}";
+
+} // namespace
+
+// Acknowledgement throughput of the journal (one fdatasync per group commit)
+// while every handler takes 20 ms, as a slow database would: acks must not
+// follow handler latency, the backlog absorbs it and drains after
+QMARK_BENCH(webhook) {
+    std::string directory = (std::filesystem::temp_directory_path() / "qmark-webhook-bench").string();
+    std::filesystem::remove_all(directory);
+
+    std::atomic<uint64_t> handled{0};
+    WebhookIngestConfig config;
+    config.directory = directory;
+    config.consumers = 4;
+    config.memory_limit_bytes = 1024 * 1024;
+    WebhookSource source;
+    source.handler = [&handled](const WebhookEvent&) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        handled.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    };
+    config.sources["leads"] = source;
+
+    WebhookIngest& ingest = WebhookIngest::getInstance();
+    ingest.start(config);
+
+    std::atomic<uint64_t> next_delivery{0};
+    for (size_t threads : {size_t{1}, size_t{16}}) {
+        bench::report(bench::measure("webhook/append_ack/" + std::to_string(threads) + "_threads", threads,
+            DELIVERIES / threads,
+            [&](size_t, uint64_t iterations) {
+                for (uint64_t i = 0; i < iterations; i++) {
+                    std::string delivery = std::to_string(next_delivery.fetch_add(1, std::memory_order_relaxed));
+                    bench::doNotOptimize(ingest.append("leads", delivery, BODY));
+                }
+            }));
+    }
+
+    bench::report(bench::measure("webhook/append_duplicate", 1, DELIVERIES,
+        [&](size_t, uint64_t iterations) {
+            for (uint64_t i = 0; i < iterations; i++) {
+                bench::doNotOptimize(ingest.append("leads", std::to_string(i), BODY));
+            }
+        }));
+
+    WebhookIngest::Stats stats = ingest.stats();
+    std::printf("{\"benchmark\":\"webhook/backlog\",\"received\":%llu,\"handled\":%llu,\"backlog\":%llu,\"spilled\":%s}\n",
+                static_cast<unsigned long long>(stats.received),
+                static_cast<unsigned long long>(handled.load()),
+                static_cast<unsigned long long>(stats.backlog), stats.spilled ? "true" : "false");
+
+    ingest.stop();
+    std::filesystem::remove_all(directory);
+}
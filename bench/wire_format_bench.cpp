@@ -0,0 +1,133 @@
+#include "bench.hpp"
+#include "qmark_json.hpp"
+#include "utils/json_reader.hpp"
+#include "utils/wire_format.hpp"
+#include <cstdio>
+#include <functional>
+
+using namespace QMark;
+
+namespace {
+
+const WireFormat FORMATS[] = {WireFormat::JSON, WireFormat::MSGPACK, WireFormat::CBOR};
+
+struct Payload {
+    const char* name;
+    uint64_t iterations;
+    std::function<void(JsonWriter&)> write;
+};
+
+void writeUser(JsonWriter& writer) {
+    qmark::User user;
+    user.id = 42;
+    user.username = "jdupont";
+    user.email = "jean.dupont@example.com";
+    user.display_name = "Jean Dupont";
+    user.avatar_url = "https://cdn.example.com/avatars/42.png";
+    user.replit_user_id = "r-332598";
+    user.created_at = qmark::Timestamp(std::chrono::seconds(1716480000));
+    user.updated_at = user.created_at;
+    user.is_premium = true;
+    json_utils::write_user(writer, user);
+}
+
+// Lead list page: strings dominate, a few small integers, doubles and flags
+void writeLeads(JsonWriter& writer) {
+    writer.beginObject().field("total", 1000);
+    writer.key("leads").beginArray();
+    for (int i = 0; i < 1000; i++) {
+        writer.beginObject()
+            .field("id", 100000 + i)
+            .field("email", "lead" + std::to_string(i) + "@example.com")
+            .field("first_name", "Jean-Frédéric")
+            .field("last_name", "Dupont")
+            .field("company", "Société Générale des Exemples")
+            .field("score", i % 100)
+            .field("conversion_probability", 0.125 * (i % 8) + 0.01)
+            .field("subscribed", i % 3 == 0);
+        writer.key("tags").beginArray().value("imported").value("b2b").endArray();
+        writer.endObject();
+    }
+    writer.endArray().endObject();
+}
+
+// Metrics time series: numbers dominate
+void writeMetricsSeries(JsonWriter& writer) {
+    writer.beginObject().field("interval_seconds", 60);
+    writer.key("points").beginArray();
+    for (int i = 0; i < 1440; i++) {
+        qmark::DashboardMetrics metrics;
+        metrics.total_leads = 50000 + static_cast<uint64_t>(i) * 7;
+        metrics.total_connections = 12;
+        metrics.active_automations = 3 + static_cast<uint64_t>(i % 5);
+        metrics.conversion_rate = 0.0312 + 0.0001 * (i % 17);
+        metrics.messages_sent_today = static_cast<uint64_t>(i) * 41;
+        writer.beginArray().value(int64_t{1716480000} + i * 60);
+        json_utils::write_dashboard_metrics(writer, metrics);
+        writer.endArray();
+    }
+    writer.endArray().endObject();
+}
+
+std::string encode(const Payload& payload, WireFormat format) {
+    std::string out;
+    JsonWriter writer(out, format);
+    payload.write(writer);
+    return out;
+}
+
+std::string benchName(const char* step, const Payload& payload, WireFormat format) {
+    return std::string("wire_format/") + step + "/" + payload.name + "/" + wire::formatName(format);
+}
+
+} // namespace
+
+// Encoded size, encode cost and request-path decode cost per payload and format
+QMARK_BENCH(wire_format) {
+    const Payload payloads[] = {
+        {"user", 200000, writeUser},
+        {"leads_1000", 200, writeLeads},
+        {"metrics_1440", 200, writeMetricsSeries}
+    };
+
+    for (const auto& payload : payloads) {
+        size_t json_size = encode(payload, WireFormat::JSON).size();
+
+        for (WireFormat format : FORMATS) {
+            const std::string document = encode(payload, format);
+            std::printf("{\"benchmark\":\"%s\",\"bytes\":%zu,\"ratio_to_json\":%.3f}\n",
+                        benchName("size", payload, format).c_str(), document.size(),
+                        static_cast<double>(document.size()) / static_cast<double>(json_size));
+
+            bench::report(bench::measure(benchName("encode", payload, format), 1, payload.iterations,
+                [&](size_t, uint64_t iterations) {
+                    for (uint64_t i = 0; i < iterations; i++) {
+                        std::string& buffer = JsonWriter::threadBuffer();
+                        JsonWriter writer(buffer, format);
+                        payload.write(writer);
+                        bench::doNotOptimize(buffer.data());
+                    }
+                }));
+
+            // What a request body costs before the handler sees it: binary
+            // bodies are transcoded to JSON, then indexed by JsonReader
+            bench::report(bench::measure(benchName("decode", payload, format), 1, payload.iterations,
+                [&](size_t, uint64_t iterations) {
+                    JsonReader reader;
+                    std::string transcoded;
+                    std::string error;
+                    for (uint64_t i = 0; i < iterations; i++) {
+                        std::string_view body = document;
+                        if (format != WireFormat::JSON) {
+                            transcoded.clear();
+                            JsonWriter writer(transcoded);
+                            wire::transcode(format, document, writer, error);
+                            body = transcoded;
+                        }
+                        reader.parse(body);
+                        bench::doNotOptimize(reader.root().raw.data());
+                    }
+                }));
+        }
+    }
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "qmark.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace QMark {
+
+    struct MetricsStoreConfig {
+        std::string snapshot_path = "data/metrics.snapshot";
+        std::chrono::milliseconds flush_interval{5000};         // journées modifiées -> SQLite
+        std::chrono::seconds snapshot_interval{std::chrono::minutes(10)};
+        bool load_from_database = true;
+
+        // Réécriture groupée (par défaut DatabaseManager::saveMetrics)
+        std::function<bool(const std::vector<qmark::DailyMetrics>&)> persist;
+    };
+
+    // Métriques journalières en colonnes, par utilisateur : un tableau
+    // contigu par compteur, indexé par jour depuis le premier jour connu
+    // (les jours sans activité valent zéro). Une plage de dates devient une
+    // tranche d'indices, agrégée par des noyaux AVX2 (somme, min, max) ;
+    // semaines et mois sont des tranches consécutives. SQLite reste la
+    // source durable ; un instantané binaire évite de la relire en entier
+    // au démarrage (seules les révisions postérieures sont rejouées).
+    class MetricsStore {
+    public:
+        enum class Granularity {
+            DAY,
+            WEEK,       // semaines ISO, du lundi
+            MONTH
+        };
+
+        // Sur une plage : somme, minimum et maximum journaliers
+        struct ColumnStats {
+            int64_t sum = 0;
+            int64_t min = 0;
+            int64_t max = 0;
+        };
+
+        struct Summary {
+            int32_t days = 0;
+            ColumnStats leads;
+            ColumnStats conversions;
+            ColumnStats automations;
+            ColumnStats revenue_cents;
+            double conversion_rate = 0.0;   // conversions / prospects, en %
+        };
+
+        struct Bucket {
+            int32_t start_day = 0;          // jours depuis le 1970-01-01
+            int32_t days = 0;
+            int64_t leads = 0;
+            int64_t conversions = 0;
+            int64_t automations = 0;
+            int64_t revenue_cents = 0;
+            double conversion_rate = 0.0;
+        };
+
+        struct Delta {
+            int32_t leads = 0;
+            int32_t conversions = 0;
+            int32_t automations = 0;
+            int64_t revenue_cents = 0;
+        };
+
+        struct Stats {
+            size_t users = 0;
+            size_t days = 0;                // cases de toutes les séries
+            size_t memory_bytes = 0;
+            size_t dirty_days = 0;
+            uint64_t revision = 0;
+        };
+
+    private:
+        // Série d'un utilisateur ; case i = jour first_day + i
+        struct Series {
+            mutable std::shared_mutex mutex;
+            int32_t first_day = 0;
+            std::vector<uint32_t> leads;
+            std::vector<uint32_t> conversions;
+            std::vector<uint32_t> automations;
+            std::vector<int64_t> revenue_cents;
+            std::set<int32_t> dirty;        // jours à réécrire dans SQLite
+        };
+
+        MetricsStoreConfig config_;
+
+        mutable std::shared_mutex users_mutex_;
+        std::unordered_map<qmark::UserId, std::unique_ptr<Series>> users_;
+
+        std::mutex flush_mutex_;            // un seul vidage ou instantané à la fois
+        std::atomic<uint64_t> revision_{0}; // dernière révision écrite (modifiée sous flush_mutex_)
+
+        std::mutex wake_mutex_;
+        std::condition_variable wake_cv_;
+        std::thread flusher_thread_;
+        std::atomic<bool> running_;
+
+        MetricsStore();
+
+        Series* findSeries(qmark::UserId user_id) const;
+        Series& seriesFor(qmark::UserId user_id);
+
+        // Appelées avec le verrou de la série tenu
+        static size_t slot(Series& series, int32_t day);
+        static void setDay(Series& series, const qmark::DailyMetrics& day);
+
+        bool loadSnapshot(uint64_t& revision);
+        void flusherLoop();
+
+    public:
+        static MetricsStore& getInstance();
+        ~MetricsStore();
+
+        MetricsStore(const MetricsStore&) = delete;
+        MetricsStore& operator=(const MetricsStore&) = delete;
+
+        // Instantané puis révisions plus récentes de SQLite ; démarre le vidage périodique
+        bool start(const MetricsStoreConfig& config = MetricsStoreConfig{});
+        void stop();
+
+        static int32_t dayOf(qmark::Timestamp time);
+        static int32_t today();
+
+        // Ajoute aux compteurs du jour (prospect reçu, automatisation exécutée...)
+        void record(qmark::UserId user_id, int32_t day, const Delta& delta);
+        // Remplace une journée (import)
+        void set(const qmark::DailyMetrics& day);
+
+        // Agrégats sur [from_day, to_day], jours inclus
+        Summary summarize(qmark::UserId user_id, int32_t from_day, int32_t to_day) const;
+        std::vector<Bucket> series(qmark::UserId user_id, int32_t from_day, int32_t to_day, Granularity granularity) const;
+
+        // Journées modifiées -> SQLite ; faux si l'écriture échoue (gardées pour le prochain essai)
+        bool flush();
+        // Écrit l'état complet (après un vidage) ; remplacement atomique du fichier
+        bool saveSnapshot();
+
+        Stats stats() const;
+    };
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "qmark.hpp"
+#include "database/database_manager.hpp"
+#include "utils/timing_wheel.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace QMark {
+
+    struct AutomationSchedulerConfig {
+        std::chrono::milliseconds tick{1000};           // résolution de la roue
+        size_t worker_threads = 4;
+        size_t queue_capacity = 4096;                   // exécutions en attente d'un worker
+        size_t per_user_concurrency = 2;                // exécutions simultanées par utilisateur
+        std::chrono::seconds default_interval{std::chrono::hours(1)};
+        std::chrono::seconds min_interval{60};
+        // Les automatisations en retard au démarrage sont étalées sur cette fenêtre
+        std::chrono::seconds startup_spread{60};
+        std::chrono::milliseconds flush_interval{2000};
+        size_t flush_batch_size = 512;
+        bool load_from_database = true;
+
+        // Horloge simulée : aucun thread, le temps n'avance que par advanceTo()
+        // et les exécutions ont lieu en ligne, dans un ordre déterministe
+        bool simulated_clock = false;
+        int64_t simulated_start_ms = 0;
+
+        // Écriture des lots d'exécutions (par défaut DatabaseManager::recordAutomationRuns)
+        std::function<bool(const std::vector<AutomationRunRecord>&)> persist_runs;
+    };
+
+    // Exécute les automatisations actives : une roue temporelle hiérarchique
+    // donne les échéances, un pool borné les exécute (plafond par utilisateur),
+    // last_run/run_count et le fil d'activité sont écrits par lots.
+    class AutomationScheduler {
+    public:
+        // false en cas d'échec ; `detail` alimente la ligne d'activité
+        using Handler = std::function<bool(const qmark::Automation& automation, std::string& detail)>;
+
+        struct Stats {
+            size_t scheduled = 0;
+            size_t queued = 0;
+            size_t running = 0;
+            uint64_t runs = 0;
+            uint64_t failures = 0;
+            uint64_t deferred = 0;
+        };
+
+    private:
+        struct Job {
+            qmark::Automation automation;
+            int64_t interval_ms = 0;
+            int64_t next_run_ms = 0;
+            uint32_t generation = 0;
+            bool in_flight = false;     // en attente ou en cours : jamais deux exécutions simultanées
+        };
+
+        // Entrée de la roue, périmée dès que la génération du job change
+        struct WheelEntry {
+            qmark::AutomationId id;
+            uint32_t generation;
+        };
+
+        struct UserState {
+            size_t active = 0;
+            std::deque<qmark::AutomationId> waiting;
+        };
+
+        AutomationSchedulerConfig config_;
+        int64_t tick_ms_ = 1000;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<qmark::AutomationId, Job> jobs_;
+        TimingWheel<WheelEntry> wheel_;
+        std::unordered_map<qmark::UserId, UserState> users_;
+        std::unordered_map<std::string, Handler> handlers_;
+        std::unordered_set<std::string> missing_handlers_;
+        std::deque<qmark::AutomationId> ready_;
+        size_t running_jobs_ = 0;
+        int64_t simulated_now_ms_ = 0;
+        int64_t driver_wake_ms_ = 0;    // réveil prévu du thread de pilotage (0 : éveillé)
+
+        std::condition_variable ready_cv_;
+        std::condition_variable driver_cv_;
+        std::vector<std::thread> workers_;
+        std::thread driver_thread_;
+        std::atomic<bool> running_;
+
+        std::vector<AutomationRunRecord> pending_runs_;
+        std::mutex pending_mutex_;
+        int64_t last_flush_ms_ = 0;
+
+        std::atomic<uint64_t> runs_;
+        std::atomic<uint64_t> failures_;
+        std::atomic<uint64_t> deferred_;
+
+        // Identifiants des compteurs de métriques
+        uint32_t run_counter_ = 0;
+        uint32_t failure_counter_ = 0;
+        uint32_t deferred_counter_ = 0;
+
+        AutomationScheduler();
+
+        int64_t nowMillis() const;
+        uint64_t tickFor(int64_t ms) const { return static_cast<uint64_t>((ms + tick_ms_ - 1) / tick_ms_); }
+        int64_t intervalFor(const qmark::Automation& automation) const;
+
+        // Appelées avec mutex_ tenu
+        void arm(qmark::AutomationId id, Job& job);
+        void admit(qmark::AutomationId id, Job& job, int64_t now_ms);
+        void collectDue(uint64_t tick, std::vector<qmark::AutomationId>& due);
+        void releaseUser(qmark::UserId user_id, int64_t now_ms);
+
+        // Retire la prochaine exécution de la file (mutex_ tenu)
+        bool takeReady(qmark::Automation& automation, Handler& handler);
+
+        // Exécute une automatisation (hors verrou) puis replanifie
+        void execute(const qmark::Automation& automation, const Handler& handler, int64_t scheduled_ms);
+        void complete(const qmark::Automation& automation, bool success, std::string detail, int64_t finished_ms);
+
+        void warmLoad();
+        void driverLoop();
+        void workerLoop();
+        void maybeFlush(int64_t now_ms, bool force);
+
+    public:
+        static AutomationScheduler& getInstance();
+        ~AutomationScheduler();
+
+        AutomationScheduler(const AutomationScheduler&) = delete;
+        AutomationScheduler& operator=(const AutomationScheduler&) = delete;
+
+        bool start(const AutomationSchedulerConfig& config = AutomationSchedulerConfig{});
+        void stop();
+
+        // Un type sans gestionnaire est ignoré (journalisé une fois) et replanifié
+        void registerHandler(const std::string& type, Handler handler);
+
+        // Ajout ou modification ; une automatisation inactive est retirée
+        void upsert(const qmark::Automation& automation);
+        void remove(qmark::AutomationId id);
+
+        // Horloge simulée uniquement : exécute tout ce qui échoit jusqu'à now_ms
+        size_t advanceTo(int64_t now_ms);
+        void flush();
+
+        Stats stats() const;
+    };
+}
@@ -1,80 +1,197 @@
-
 #pragma once
 
 #include "qmark.hpp"
 #include <sqlite3.h>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
 #include <mutex>
-#include <thread>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace QMark {
+
+    // Ligne de la table sessions (expires_at en secondes Unix)
+    struct SessionRecord {
+        std::string id;
+        int64_t user_id = 0;
+        std::string data;
+        int64_t expires_at = 0;
+    };
+
+    // Exécution terminée d'une automatisation (horodatages en secondes Unix)
+    struct AutomationRunRecord {
+        uint64_t automation_id = 0;
+        int64_t user_id = 0;
+        int64_t finished_at = 0;
+        bool success = true;
+        std::string title;          // ligne du fil d'activité
+        std::string detail;
+    };
+
+    // Export d'un utilisateur, lu par pages (ordre de clé stable, reprise après
+    // la dernière ligne rendue) : le verrou du fichier n'est tenu que le temps
+    // d'une page, jamais pendant l'envoi au client
+    enum class ExportTable { LEADS, ACTIVITIES };
+
+    struct ExportCursor {
+        int64_t after_created_at = 0;   // activités seulement
+        int64_t after_id = 0;
+        bool done = false;
+    };
+
+    // Valeur d'une colonne ; text pointe dans la ligne SQLite courante
+    struct ExportValue {
+        enum class Type : uint8_t { NUL, INTEGER, REAL, TEXT };
+        Type type = Type::NUL;
+        int64_t integer = 0;
+        double real = 0;
+        std::string_view text;
+    };
 
-namespace qmark::database {
-    
+    // Disposition partitionnée (facultative, créée par qmark-reshard) : le
+    // catalogue garde les utilisateurs et les données globales ; les tables
+    // propres à un utilisateur (sessions, connexions OAuth, automatisations,
+    // activités, prospects, métriques) sont réparties sur N fichiers selon un
+    // hachage stable de UserId, chacun avec sa connexion et son écrivain.
+    // Sans partition, tout reste dans le catalogue, comme avant.
+    //
+    // Les id de prospects, connexions et automatisations restent uniques sur
+    // l'ensemble : chaque fichier attribue les siens dans sa classe modulo N,
+    // au-dessus du plafond laissé par le dernier repartitionnement. Un lot qui
+    // touche plusieurs fichiers est validé fichier par fichier.
     class DatabaseManager {
     private:
-        sqlite3* db_;
-        mutable std::mutex db_mutex_;
-        std::string db_path_;
-        bool is_initialized_;
-        
-        // Méthodes privées pour l'initialisation
-        bool create_tables();
-        bool create_indexes();
-        bool execute_sql(const std::string& sql);
-        sqlite3_stmt* prepare_statement(const std::string& sql);
-        void finalize_statement(sqlite3_stmt* stmt);
-        
+        // Fichier SQLite : une connexion, un seul écrivain à la fois
+        struct Shard {
+            size_t index = 0;
+            std::string path;
+            sqlite3* db = nullptr;
+            std::mutex mutex;
+            std::atomic<int> users{0};                  // titulaire + threads en attente
+            std::map<std::string, int64_t> last_ids;    // dernier id attribué, par table (partitionné)
+        };
+
+        // Verrou d'une connexion, compté pour les métriques du pool
+        struct ConnectionLease {
+            std::atomic<int>& users;
+            std::lock_guard<std::mutex> lock;
+
+            explicit ConnectionLease(Shard& shard)
+                : users((shard.users.fetch_add(1, std::memory_order_relaxed), shard.users)), lock(shard.mutex) {}
+            ~ConnectionLease() { users.fetch_sub(1, std::memory_order_relaxed); }
+        };
+
+        Shard catalog_;
+        std::vector<std::unique_ptr<Shard>> shards_;    // vide : tables des utilisateurs dans le catalogue
+        int64_t id_floor_ = 0;
+
+        DatabaseManager();
+
+        bool openFile(Shard& shard, bool foreign_keys);
+        static bool execute(sqlite3* db, const std::string& sql);
+
+        // Routage des tables propres à un utilisateur
+        Shard& tenantShard(qmark::UserId user_id);
+        std::vector<Shard*> tenantShards();
+
+        // Lignes d'un lot regroupées par fichier (indices dans le lot)
+        template<typename T, typename UserOf>
+        std::vector<std::pair<Shard*, std::vector<size_t>>> groupByShard(const std::vector<T>& rows, UserOf user_of);
+
+        // Exécute fn sur chaque fichier, en parallèle
+        template<typename Fn>
+        void forEachShard(Fn&& fn);
+
+        // Id explicite en disposition partitionnée (0 sans partition : AUTOINCREMENT) ; verrou du fichier tenu
+        int64_t allocateId(Shard& shard, const char* table);
+
+        std::optional<int64_t> sumOverShards(const char* sql);
+
     public:
-        explicit DatabaseManager(const std::string& db_path = DEFAULT_DATABASE_PATH);
+        static DatabaseManager& getInstance();
         ~DatabaseManager();
-        
-        // Initialisation
-        bool initialize();
-        bool is_connected() const;
+
+        DatabaseManager(const DatabaseManager&) = delete;
+        DatabaseManager& operator=(const DatabaseManager&) = delete;
+
+        // Initialisation (ouvre aussi les partitions déclarées par le catalogue)
+        bool init(const std::string& db_path = DEFAULT_DATABASE_PATH);
         void close();
-        
+
+        // Disposition
+        size_t shardCount() const { return shards_.empty() ? 1 : shards_.size(); }
+        static size_t shardOf(qmark::UserId user_id, size_t shard_count);
+        static std::string shardPath(const std::string& catalog_path, size_t index);
+        // Schéma complet (idempotent), partagé avec qmark-reshard
+        static bool createTables(sqlite3* db);
+
+        // Occupation des connexions (une par fichier)
+        size_t poolSize() const { return 1 + shards_.size(); }
+        size_t connectionsInUse() const;
+        size_t connectionWaiters() const;
+
+        // Exécution SQL (catalogue)
+        bool execute(const std::string& sql);
+        std::vector<std::map<std::string, std::string>> query(const std::string& sql);
+
+        // Agrégats d'administration, calculés en parallèle sur les partitions
+        std::optional<int64_t> countUsers();
+        std::optional<int64_t> countActiveConnections();
+        std::optional<int64_t> countLeads();
+
         // Gestion des utilisateurs
-        std::optional<User> create_user(const std::string& username, 
-                                       const std::string& email,
-                                       const std::string& display_name = "",
-                                       const std::string& avatar_url = "",
-                                       const std::string& replit_user_id = "");
-        std::optional<User> get_user_by_id(UserId user_id);
-        std::optional<User> get_user_by_username(const std::string& username);
-        std::optional<User> get_user_by_replit_id(const std::string& replit_user_id);
-        bool update_user(const User& user);
-        bool delete_user(UserId user_id);
-        
-        // Gestion des connexions OAuth
-        std::optional<OAuthConnection> create_oauth_connection(const OAuthConnection& connection);
-        std::vector<OAuthConnection> get_user_connections(UserId user_id);
-        std::optional<OAuthConnection> get_connection_by_provider(UserId user_id, const std::string& provider);
-        bool update_oauth_connection(const OAuthConnection& connection);
-        bool delete_oauth_connection(ConnectionId connection_id);
-        
-        // Métriques et statistiques
-        DashboardMetrics get_dashboard_metrics(UserId user_id);
-        uint64_t count_users();
-        uint64_t count_active_connections();
-        
-        // Utilitaires
-        bool backup_database(const std::string& backup_path);
-        bool vacuum_database();
-        std::string get_database_version();
-        
-        // Thread safety
-        void begin_transaction();
-        void commit_transaction();
-        void rollback_transaction();
-    };
-    
-    // Singleton pour l'accès global
-    class DatabaseManagerSingleton {
-    private:
-        static std::unique_ptr<DatabaseManager> instance_;
-        static std::mutex instance_mutex_;
-        
-    public:
-        static DatabaseManager& get_instance();
-        static void initialize(const std::string& db_path = DEFAULT_DATABASE_PATH);
-        static void shutdown();
+        bool insertUser(const std::string& username, const std::string& email, const std::string& password_hash);
+        std::optional<std::map<std::string, std::string>> getUserByUsername(const std::string& username);
+        std::optional<qmark::User> findUser(const std::string& username);
+
+        // Connexions OAuth (id attribué à l'insertion si nul)
+        bool saveOAuthConnection(qmark::OAuthConnection& connection);
+        std::vector<qmark::OAuthConnection> getOAuthConnections(qmark::UserId user_id);
+        std::vector<qmark::OAuthConnection> loadActiveOAuthConnections();
+        // Jetons rafraîchis, réécrits par lots (une transaction par fichier)
+        bool saveOAuthConnections(const std::vector<qmark::OAuthConnection>& connections);
+        // Demande de suppression d'un fournisseur : id des connexions effacées
+        std::optional<std::vector<qmark::ConnectionId>> deleteOAuthConnections(const std::string& provider,
+                                                                               const std::string& provider_user_id);
+
+        // Automatisations : chargement des actives, puis exécutions écrites par lots
+        // (last_run/run_count et lignes d'activité, une transaction par fichier)
+        bool saveAutomation(qmark::Automation& automation);
+        std::vector<qmark::Automation> loadActiveAutomations();
+        bool recordAutomationRuns(const std::vector<AutomationRunRecord>& runs);
+
+        // Prospects : clés de déduplication lues en flux au démarrage, puis
+        // insertions et fusions d'un lot, une transaction par fichier (id attribués)
+        bool loadLeadKeys(const std::function<void(qmark::LeadId, qmark::UserId, std::string_view email, std::string_view phone)>& visit);
+        bool writeLeads(std::vector<qmark::Lead>& inserts, const std::vector<qmark::Lead>& merges);
+
+        // Métriques journalières : lignes de révision > after_revision lues en flux,
+        // journées modifiées réécrites par lots
+        bool loadMetrics(uint64_t after_revision, const std::function<void(const qmark::DailyMetrics&)>& visit);
+        bool saveMetrics(const std::vector<qmark::DailyMetrics>& days);
+
+        // Export : colonnes de la table, puis une page d'au plus limit lignes
+        // après le curseur (avancé, done en fin de table). visit rend faux pour
+        // arrêter la page plus tôt (la suivante reprend après la dernière vue)
+        static std::span<const std::string_view> exportColumns(ExportTable table);
+        bool exportPage(ExportTable table, qmark::UserId user_id, ExportCursor& cursor, size_t limit,
+                        const std::function<bool(std::span<const ExportValue>)>& visit);
+
+        // Gestion des sessions (écritures groupées en une transaction)
+        std::vector<SessionRecord> loadSessions(int64_t not_expired_after);
+        bool saveSessions(const std::vector<SessionRecord>& sessions);
+        bool updateSessionExpiry(const std::vector<std::pair<std::string, int64_t>>& expiries);
+        bool deleteSessions(const std::vector<std::string>& session_ids);
+        bool purgeExpiredSessions(int64_t now);
+
+        // Instantanés des caches : jeton noté à l'arrêt, repris (et effacé)
+        // au démarrage ; nullopt si aucun jeton n'attend
+        bool saveSnapshotToken(const std::string& name, uint64_t token);
+        std::optional<uint64_t> takeSnapshotToken(const std::string& name);
     };
 }
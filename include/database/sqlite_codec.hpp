@@ -0,0 +1,216 @@
+#pragma once
+
+#include "utils/reflection.hpp"
+#include <sqlite3.h>
+#include <array>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+namespace QMark {
+
+    namespace sqlite_codec {
+
+        namespace detail {
+            // Écrit la requête dans `out`, ou se contente de la mesurer si `out` est nul
+            class SqlBuilder {
+            private:
+                char* out_;
+                size_t size_ = 0;
+
+            public:
+                constexpr explicit SqlBuilder(char* out) : out_(out) {}
+
+                constexpr void put(std::string_view text) {
+                    for (char c : text) {
+                        if (out_) {
+                            out_[size_] = c;
+                        }
+                        size_++;
+                    }
+                }
+
+                constexpr size_t size() const { return size_; }
+            };
+
+            template<reflect::Described T>
+            constexpr void putColumns(SqlBuilder& sql) {
+                bool first = true;
+                reflect::forEachField<T>([&](const auto& field, auto) {
+                    if (field.stored()) {
+                        sql.put(first ? "" : ", ");
+                        sql.put(field.name);
+                        first = false;
+                    }
+                });
+            }
+
+            template<reflect::Stored T>
+            constexpr size_t buildUpsert(char* out) {
+                SqlBuilder sql(out);
+                sql.put("INSERT OR REPLACE INTO ");
+                sql.put(reflect::Describe<T>::table);
+                sql.put(" (");
+                putColumns<T>(sql);
+                sql.put(") VALUES (");
+                bool first = true;
+                reflect::forEachField<T>([&](const auto& field, auto) {
+                    if (field.stored()) {
+                        sql.put(first ? "?" : ", ?");
+                        first = false;
+                    }
+                });
+                sql.put(");");
+                return sql.size();
+            }
+
+            template<reflect::Stored T>
+            constexpr size_t buildSelect(char* out) {
+                SqlBuilder sql(out);
+                sql.put("SELECT ");
+                putColumns<T>(sql);
+                sql.put(" FROM ");
+                sql.put(reflect::Describe<T>::table);
+                return sql.size();
+            }
+
+            template<size_t N>
+            struct SqlText {
+                std::array<char, N + 1> text{};
+                constexpr std::string_view view() const { return {text.data(), N}; }
+                constexpr const char* c_str() const { return text.data(); }
+            };
+
+            template<reflect::Stored T>
+            constexpr auto makeUpsert() {
+                SqlText<buildUpsert<T>(nullptr)> sql;
+                buildUpsert<T>(sql.text.data());
+                return sql;
+            }
+
+            template<reflect::Stored T>
+            constexpr auto makeSelect() {
+                SqlText<buildSelect<T>(nullptr)> sql;
+                buildSelect<T>(sql.text.data());
+                return sql;
+            }
+
+            // "YYYY-MM-DD HH:MM:SS" (CURRENT_TIMESTAMP, UTC)
+            inline qmark::Timestamp parseDatetime(const char* text) {
+                int year, month, day, hour = 0, minute = 0, second = 0;
+                if (!text || std::sscanf(text, "%d-%d-%d %d:%d:%d", &year, &month, &day, &hour, &minute, &second) < 3) {
+                    return qmark::Timestamp{};
+                }
+                auto date = std::chrono::year(year) / std::chrono::month(static_cast<unsigned>(month))
+                            / std::chrono::day(static_cast<unsigned>(day));
+                return std::chrono::sys_days(date) + std::chrono::hours(hour)
+                       + std::chrono::minutes(minute) + std::chrono::seconds(second);
+            }
+        }
+
+        // Requêtes générées à la compilation depuis le descripteur
+        template<reflect::Stored T>
+        inline constexpr auto UPSERT_SQL = detail::makeUpsert<T>();
+
+        template<reflect::Stored T>
+        inline constexpr auto SELECT_SQL = detail::makeSelect<T>();
+
+        template<typename V>
+        int bindValue(sqlite3_stmt* stmt, int index, const V& value) {
+            if constexpr (std::is_same_v<V, std::string>) {
+                return sqlite3_bind_text(stmt, index, value.data(), static_cast<int>(value.size()), SQLITE_STATIC);
+            } else if constexpr (std::is_floating_point_v<V>) {
+                return sqlite3_bind_double(stmt, index, static_cast<double>(value));
+            } else if constexpr (std::is_integral_v<V>) {
+                return sqlite3_bind_int64(stmt, index, static_cast<sqlite3_int64>(value));
+            } else if constexpr (std::is_same_v<V, qmark::Timestamp>) {
+                return sqlite3_bind_int64(stmt, index, reflect::toUnixSeconds(value));
+            } else {
+                static_assert(reflect::UNSUPPORTED_TYPE<V>, "no SQLite mapping for this member type");
+            }
+        }
+
+        template<typename V>
+        void readColumn(sqlite3_stmt* stmt, int column, V& out) {
+            if constexpr (std::is_same_v<V, std::string>) {
+                const char* text = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+                if (text) {
+                    out.assign(text, static_cast<size_t>(sqlite3_column_bytes(stmt, column)));
+                } else {
+                    out.clear();
+                }
+            } else if constexpr (std::is_same_v<V, bool>) {
+                out = sqlite3_column_int64(stmt, column) != 0;
+            } else if constexpr (std::is_floating_point_v<V>) {
+                out = static_cast<V>(sqlite3_column_double(stmt, column));
+            } else if constexpr (std::is_integral_v<V>) {
+                out = static_cast<V>(sqlite3_column_int64(stmt, column));
+            } else if constexpr (std::is_same_v<V, qmark::Timestamp>) {
+                // Colonnes récentes en secondes Unix, anciennes en DATETIME texte
+                switch (sqlite3_column_type(stmt, column)) {
+                    case SQLITE_INTEGER:
+                        out = reflect::fromUnixSeconds(sqlite3_column_int64(stmt, column));
+                        break;
+                    case SQLITE_TEXT:
+                        out = detail::parseDatetime(reinterpret_cast<const char*>(sqlite3_column_text(stmt, column)));
+                        break;
+                    default:
+                        out = qmark::Timestamp{};
+                        break;
+                }
+            } else {
+                static_assert(reflect::UNSUPPORTED_TYPE<V>, "no SQLite mapping for this member type");
+            }
+        }
+
+        // Lie les champs stockés dans l'ordre de UPSERT_SQL ; renvoie le prochain indice libre
+        template<reflect::Stored T>
+        int bindFields(sqlite3_stmt* stmt, const T& object, int first_index = 1) {
+            int index = first_index;
+            reflect::forEachField<T>([&](const auto& field, auto) {
+                if (!field.stored()) {
+                    return;
+                }
+                using Member = typename std::remove_cvref_t<decltype(field)>::member_type;
+                if constexpr (std::is_integral_v<Member>) {
+                    if (field.primaryKey() && field.get(object) == 0) {
+                        sqlite3_bind_null(stmt, index++);
+                        return;
+                    }
+                }
+                bindValue(stmt, index++, field.get(object));
+            });
+            return index;
+        }
+
+        // Correspondance colonnes -> champs résolue une fois par requête préparée,
+        // puis décodage des lignes sans recherche par nom
+        template<reflect::Described T>
+        class ColumnMap {
+        private:
+            std::array<int, reflect::fieldCount<T>()> columns_;
+
+        public:
+            explicit ColumnMap(sqlite3_stmt* stmt) {
+                columns_.fill(-1);
+                int column_count = sqlite3_column_count(stmt);
+                for (int column = 0; column < column_count; column++) {
+                    std::string_view name = sqlite3_column_name(stmt, column);
+                    reflect::forEachField<T>([&](const auto& field, auto index) {
+                        if (field.stored() && name == field.name) {
+                            columns_[index] = column;
+                        }
+                    });
+                }
+            }
+
+            void read(sqlite3_stmt* stmt, T& out) const {
+                reflect::forEachField<T>([&](const auto& field, auto index) {
+                    if (columns_[index] >= 0) {
+                        readColumn(stmt, columns_[index], field.get(out));
+                    }
+                });
+            }
+        };
+    }
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include "ingest/webhook_ingest.hpp"
+
+namespace QMark {
+
+    // Traitements des webhooks journalisés ; faux = échec transitoire, réessayé.
+    // Une charge invalide est écartée (vrai) : la rejouer ne la corrigerait pas.
+
+    // Formulaire relayé : {"user_id": 42, "leads": [{"name", "email", "phone", "source", "notes"}]},
+    // dédoublonné par LeadIndex puis poussé aux tableaux de bord ouverts
+    bool handleLeadWebhook(const WebhookEvent& event);
+
+    // Rappel de suppression de données Facebook (charge signed_request décodée) :
+    // connexions OAuth de l'utilisateur effacées
+    bool handleFacebookDeletion(const WebhookEvent& event);
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace QMark {
+
+    // Webhook reçu, tel qu'écrit dans le journal
+    struct WebhookEvent {
+        uint64_t seq = 0;
+        std::string source;
+        std::string delivery_id;
+        int64_t received_at_ms = 0;
+        std::string body;
+    };
+
+    enum class WebhookSignature : uint8_t {
+        HUB_SIGNATURE_256,      // en-tête "sha256=<hex>" : HMAC-SHA256 du corps (Meta, GitHub)
+        SIGNED_REQUEST          // champ "<signature>.<charge>" en base64url (suppression de données Facebook)
+    };
+
+    struct WebhookSource {
+        std::string secret;
+        WebhookSignature signature = WebhookSignature::HUB_SIGNATURE_256;
+        std::string signature_header = "X-Hub-Signature-256";
+        std::string delivery_header;        // vide : empreinte SHA-256 du corps
+        std::string verify_token;           // défi GET hub.challenge à l'abonnement
+        std::string status_url;             // renvoyée avec le code de confirmation
+
+        // Traitement asynchrone ; faux (ou exception) = échec transitoire, réessayé
+        std::function<bool(const WebhookEvent&)> handler;
+    };
+
+    struct WebhookIngestConfig {
+        std::string directory = "data/webhooks";
+        size_t segment_bytes = 64 * 1024 * 1024;
+        size_t max_body_bytes = 1024 * 1024;
+        size_t consumers = 4;
+        size_t memory_limit_bytes = 16 * 1024 * 1024;   // au-delà, les événements sont relus du disque
+        std::chrono::seconds dedupe_ttl{std::chrono::hours(24)};
+        size_t dedupe_capacity = 1000000;
+        uint32_t max_attempts = 5;
+        std::chrono::milliseconds retry_backoff{500};   // multiplié par le numéro d'essai
+        std::chrono::milliseconds checkpoint_interval{1000};
+        bool sync = true;                               // fdatasync avant l'acquittement
+        std::unordered_map<std::string, WebhookSource> sources;
+    };
+
+    // Réception des webhooks : l'acquittement ne dépend que du disque local.
+    // Chaque livraison est dédoublonnée (identifiant, TTL), ajoutée au
+    // journal par écritures groupées (un fdatasync par lot), puis traitée
+    // par un pool de consommateurs. Au-delà de la mémoire allouée, ou après
+    // un redémarrage, les événements sont relus depuis les segments ; un
+    // point de reprise écrit périodiquement borne ce qui est rejoué, et les
+    // segments traités restent le temps du TTL pour reconstruire le cache.
+    // Livraison au moins une fois : les traitements doivent être idempotents.
+    class WebhookIngest {
+    public:
+        enum class Status {
+            ACCEPTED,
+            DUPLICATE,
+            FAILED          // arrêté ou écriture impossible : la plateforme réessaiera
+        };
+
+        struct Stats {
+            uint64_t received = 0;
+            uint64_t duplicates = 0;
+            uint64_t processed = 0;
+            uint64_t failed = 0;        // abandonnés après max_attempts
+            uint64_t backlog = 0;       // journalisés, pas encore traités
+            bool spilled = false;       // file en mémoire saturée, lecture depuis le disque
+        };
+
+    private:
+        struct PendingAppend {
+            std::shared_ptr<WebhookEvent> event;
+            bool done = false;
+            bool ok = false;
+        };
+
+        // Conservé tant qu'il reste à traiter ou que ses livraisons comptent pour le dédoublonnage
+        struct Segment {
+            std::string path;
+            uint64_t last_seq = 0;
+            int64_t last_received_ms = 0;
+        };
+
+        struct Delivery {
+            int64_t expires_ms = 0;
+            uint64_t seq = 0;
+        };
+
+        enum class ReadResult {
+            OK,
+            END,
+            CORRUPT
+        };
+
+        WebhookIngestConfig config_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable append_cv_;         // lot à écrire
+        std::condition_variable committed_cv_;      // lot écrit
+        std::condition_variable work_cv_;           // événements à traiter
+
+        // Écriture (protégés par mutex_)
+        std::vector<std::shared_ptr<PendingAppend>> append_queue_;
+        uint64_t next_seq_ = 1;
+        uint64_t durable_seq_ = 0;
+        std::map<uint64_t, Segment> segments_;      // par premier numéro
+
+        // Dédoublonnage : clé "source\nidentifiant" ; ordre d'expiration
+        std::unordered_map<std::string, Delivery> deliveries_;
+        std::deque<std::pair<int64_t, std::string>> delivery_order_;
+
+        // Distribution (protégés par mutex_)
+        std::deque<std::shared_ptr<WebhookEvent>> pending_;
+        size_t pending_bytes_ = 0;
+        bool spilled_ = false;
+        bool reading_ = false;
+        uint64_t next_read_seq_ = 1;
+        uint64_t read_segment_ = 0;                 // curseur de relecture
+        uint64_t read_offset_ = 0;
+        uint64_t dispatched_seq_ = 0;
+        std::set<uint64_t> in_flight_;
+        uint64_t checkpoint_seq_ = 0;
+
+        // Thread d'écriture uniquement
+        int active_fd_ = -1;
+        uint64_t active_first_seq_ = 0;
+        uint64_t active_bytes_ = 0;
+        uint64_t written_checkpoint_ = 0;
+
+        std::thread writer_thread_;
+        std::vector<std::thread> consumer_threads_;
+        std::atomic<bool> running_;
+
+        std::atomic<uint64_t> received_;
+        std::atomic<uint64_t> duplicates_;
+        std::atomic<uint64_t> processed_;
+        std::atomic<uint64_t> failed_;
+
+        // Identifiants des compteurs de métriques
+        uint32_t received_counter_ = 0;
+        uint32_t duplicate_counter_ = 0;
+        uint32_t processed_counter_ = 0;
+        uint32_t failed_counter_ = 0;
+
+        WebhookIngest();
+
+        static int64_t nowMillis();
+        static void encodeRecord(const WebhookEvent& event, std::string& out);
+        static ReadResult readRecord(std::FILE* file, WebhookEvent& event, uint64_t& length);
+
+        bool recover();
+        bool openSegment(uint64_t first_seq);
+        bool writeBatch(const std::string& buffer, uint64_t first_seq);
+        void writerLoop();
+        void checkpoint();
+
+        void consumerLoop();
+        void readSpilled();
+        bool process(const WebhookEvent& event);
+
+        // Appelées avec mutex_ tenu
+        void rememberDelivery(const std::string& key, int64_t expires_ms, uint64_t seq);
+        void expireDeliveries(int64_t now_ms);
+
+    public:
+        static WebhookIngest& getInstance();
+        ~WebhookIngest();
+
+        WebhookIngest(const WebhookIngest&) = delete;
+        WebhookIngest& operator=(const WebhookIngest&) = delete;
+
+        // Relit les segments (dédoublonnage et reprise) puis démarre les threads
+        bool start(const WebhookIngestConfig& config);
+        void stop();
+        bool isRunning() const { return running_; }
+
+        const WebhookSource* source(const std::string& name) const;
+        size_t maxBodyBytes() const { return config_.max_body_bytes; }
+
+        // Bloque jusqu'à l'écriture durable du lot qui contient la livraison
+        Status append(const std::string& source, const std::string& delivery_id, std::string body);
+
+        // Vérification des signatures des plateformes
+        static bool verifyHubSignature(const std::string& secret, std::string_view body, std::string_view header);
+        // Vérifie "<signature>.<charge>" et décode la charge JSON
+        static bool decodeSignedRequest(const std::string& secret, std::string_view signed_request, std::string& payload);
+
+        Stats stats() const;
+    };
+}
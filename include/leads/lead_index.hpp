@@ -0,0 +1,124 @@
+#pragma once
+
+#include "qmark.hpp"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace QMark {
+
+    struct LeadIndexConfig {
+        std::string default_country_code = "33";   // numéros nationaux sans indicatif
+        double max_load = 0.8;                      // taux de remplissage avant doublement
+        size_t filter_bits_per_key = 8;
+        bool load_from_database = true;
+        // Tables écrites par saveSnapshot() à l'arrêt, reprises au démarrage
+        // au lieu de tout réindexer ; vide : désactivé
+        std::string snapshot_path = "data/leads.snapshot";
+
+        // Écriture d'un lot (par défaut DatabaseManager::writeLeads) ; attribue les id insérés
+        std::function<bool(std::vector<qmark::Lead>& inserts, const std::vector<qmark::Lead>& merges)> write;
+    };
+
+    // Index de déduplication des prospects, par utilisateur : e-mail et
+    // téléphone E.164 normalisés, hachés sur 64 bits dans une table à
+    // adressage ouvert (sondage linéaire), précédée d'un filtre de Bloom
+    // bloqué par mot qui écarte la plupart des clés absentes sans sonder.
+    // Reconstruit depuis SQLite au démarrage ; les décisions d'insertion ou
+    // de fusion d'un lot sont prises ici, avant l'écriture en base.
+    class LeadIndex {
+    public:
+        struct Match {
+            qmark::LeadId lead_id = 0;
+            bool by_email = false;
+            bool by_phone = false;
+
+            explicit operator bool() const { return lead_id != 0; }
+        };
+
+        struct UpsertResult {
+            size_t inserted = 0;
+            size_t merged = 0;
+            std::vector<qmark::LeadId> ids;     // prospect retenu pour chaque entrée du lot
+        };
+
+        struct Stats {
+            size_t users = 0;
+            size_t keys = 0;
+            size_t memory_bytes = 0;        // tables et filtres
+        };
+
+    private:
+        enum class KeyKind : uint8_t {
+            EMAIL = 1,
+            PHONE = 2
+        };
+
+        // Table d'un utilisateur ; hash nul = case vide
+        struct UserIndex {
+            mutable std::shared_mutex mutex;
+            std::vector<uint64_t> hashes;
+            std::vector<qmark::LeadId> lead_ids;
+            std::vector<uint64_t> filter;
+            size_t size = 0;
+        };
+
+        LeadIndexConfig config_;
+
+        mutable std::shared_mutex users_mutex_;
+        std::unordered_map<qmark::UserId, std::unique_ptr<UserIndex>> users_;
+
+        LeadIndex();
+
+        static uint64_t hashKey(KeyKind kind, std::string_view key);
+
+        UserIndex* findUser(qmark::UserId user_id) const;
+        UserIndex& userFor(qmark::UserId user_id);
+
+        // Appelées avec le verrou de l'utilisateur tenu
+        qmark::LeadId probe(const UserIndex& index, uint64_t hash) const;
+        void insertKey(UserIndex& index, uint64_t hash, qmark::LeadId lead_id);
+        void eraseKey(UserIndex& index, uint64_t hash, qmark::LeadId lead_id);
+        void grow(UserIndex& index);
+        static void addToFilter(UserIndex& index, uint64_t hash);
+
+        void addLocked(UserIndex& index, qmark::LeadId lead_id, std::string_view email, std::string_view phone);
+
+        bool loadSnapshot();
+
+    public:
+        static LeadIndex& getInstance();
+
+        LeadIndex(const LeadIndex&) = delete;
+        LeadIndex& operator=(const LeadIndex&) = delete;
+
+        // Vide l'index puis le reprend de l'instantané (s'il est valide) ou
+        // le reconstruit depuis la table leads
+        bool start(const LeadIndexConfig& config = LeadIndexConfig{});
+        // À l'arrêt, une fois les écritures de prospects terminées
+        bool saveSnapshot();
+
+        // "Jean.Dupont+fb@GoogleMail.com " -> "jeandupont@gmail.com" ; vide si invalide
+        static std::string normalizeEmail(std::string_view email);
+        // "06 12 34 56 78" -> "+33612345678" (E.164) ; vide si invalide
+        static std::string normalizePhone(std::string_view phone, std::string_view default_country_code);
+
+        // Prospect déjà enregistré (valeurs brutes, normalisées ici)
+        void add(qmark::UserId user_id, qmark::LeadId lead_id, std::string_view email, std::string_view phone);
+        void remove(qmark::UserId user_id, qmark::LeadId lead_id, std::string_view email, std::string_view phone);
+        Match find(qmark::UserId user_id, std::string_view email, std::string_view phone) const;
+
+        // Dédoublonne le lot (contre l'index et en son sein), écrit insertions
+        // et fusions en une fois puis indexe les nouvelles clés ; nullopt si
+        // l'écriture échoue (index inchangé)
+        std::optional<UpsertResult> upsert(qmark::UserId user_id, std::vector<qmark::Lead>& leads);
+
+        Stats stats() const;
+    };
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace QMark {
+
+    struct CircuitBreakerConfig {
+        size_t failure_threshold = 5;                   // échecs consécutifs avant ouverture
+        std::chrono::milliseconds open_duration{10000}; // refus immédiat avant la première sonde
+        std::chrono::milliseconds max_open_duration{120000};
+        size_t half_open_probes = 1;                    // appels d'essai simultanés
+    };
+
+    // Disjoncteur d'un fournisseur : fermé, ouvert (échec immédiat), puis
+    // semi-ouvert pour quelques sondes. Une sonde en échec rouvre le circuit
+    // pour une durée doublée, bornée par max_open_duration.
+    // Chaque allow() accepté doit être suivi de onSuccess(), onFailure() ou onAbandon().
+    class CircuitBreaker {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        enum class State : uint8_t {
+            CLOSED,
+            OPEN,
+            HALF_OPEN
+        };
+
+    private:
+        CircuitBreakerConfig config_;
+        mutable std::mutex mutex_;
+        State state_;
+        size_t consecutive_failures_;
+        size_t probes_in_flight_;
+        std::chrono::milliseconds current_open_duration_;
+        Clock::time_point open_until_;
+        uint64_t rejected_;
+
+        void open(Clock::time_point now);
+
+    public:
+        explicit CircuitBreaker(const CircuitBreakerConfig& config = CircuitBreakerConfig{});
+
+        bool allow(Clock::time_point now = Clock::now());
+        void onSuccess();
+        void onFailure(Clock::time_point now = Clock::now());
+        // Appel accepté mais jamais émis (pool saturé) : libère la sonde sans verdict
+        void onAbandon();
+
+        State state() const;
+        uint64_t rejected() const;
+        static const char* stateName(State state);
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "outbound/circuit_breaker.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace QMark {
+
+    using OutboundHeaders = std::vector<std::pair<std::string, std::string>>;
+
+    struct OutboundHostConfig {
+        size_t max_connections = 8;                         // requêtes simultanées vers l'hôte
+        std::chrono::milliseconds connect_timeout{3000};
+        std::chrono::milliseconds read_timeout{10000};
+        std::chrono::milliseconds write_timeout{10000};
+        std::chrono::milliseconds acquire_timeout{2000};    // attente d'une connexion du pool
+        std::chrono::seconds idle_timeout{60};              // connexion inutilisée fermée au-delà
+        bool verify_certificates = true;
+        std::string ca_cert_path;                           // vide : magasin du système
+        CircuitBreakerConfig breaker;
+    };
+
+    struct OutboundRequest {
+        std::string method = "GET";
+        std::string origin;             // "https://graph.facebook.com", "http://127.0.0.1:9000"
+        std::string path;               // chemin et query string
+        OutboundHeaders headers;
+        std::string body;
+        std::string content_type;
+    };
+
+    struct OutboundResponse {
+        int status = 0;                 // 0 : pas de réponse, voir error
+        std::string body;
+        OutboundHeaders headers;
+        std::string error;              // transport, circuit ouvert, pool saturé
+        bool coalesced = false;         // résultat partagé d'un GET identique déjà en vol
+
+        bool ok() const { return status >= 200 && status < 300; }
+        std::string header(const std::string& name) const;
+    };
+
+    // Client HTTP sortant (OAuth, Graph API...) : pool de connexions
+    // keep-alive par hôte, reprise de session TLS, fusion des GET identiques
+    // simultanés, plafond de concurrence et disjoncteur par hôte.
+    class OutboundClient {
+    public:
+        struct HostStats {
+            size_t idle = 0;
+            size_t leased = 0;
+            size_t waiting = 0;
+            uint64_t requests = 0;
+            uint64_t failures = 0;
+            uint64_t connections_opened = 0;
+            uint64_t tls_handshakes = 0;
+            uint64_t tls_resumed = 0;
+            uint64_t coalesced = 0;
+            uint64_t rejected = 0;
+            CircuitBreaker::State circuit = CircuitBreaker::State::CLOSED;
+        };
+
+    private:
+        struct Connection;
+        struct HostPool;
+
+        using Flight = std::shared_future<OutboundResponse>;
+
+        mutable std::mutex mutex_;
+        OutboundHostConfig default_config_;
+        std::unordered_map<std::string, OutboundHostConfig> host_configs_;
+        std::unordered_map<std::string, std::shared_ptr<HostPool>> pools_;
+
+        // Identifiants des compteurs de métriques
+        uint32_t request_counter_ = 0;
+        uint32_t failure_counter_ = 0;
+        uint32_t coalesced_counter_ = 0;
+        uint32_t rejected_counter_ = 0;
+        uint32_t connection_counter_ = 0;
+        uint32_t resumed_counter_ = 0;
+
+        OutboundClient();
+
+        std::shared_ptr<HostPool> poolFor(const std::string& origin);
+
+        std::unique_ptr<Connection> acquire(HostPool& pool, std::string& error);
+        void release(HostPool& pool, std::unique_ptr<Connection> connection);
+        OutboundResponse perform(HostPool& pool, const OutboundRequest& request);
+        OutboundResponse coalesce(HostPool& pool, const OutboundRequest& request);
+
+    public:
+        static OutboundClient& getInstance();
+        ~OutboundClient();
+
+        OutboundClient(const OutboundClient&) = delete;
+        OutboundClient& operator=(const OutboundClient&) = delete;
+
+        // Réglages d'un hôte ; s'applique aux connexions ouvertes ensuite
+        void configureHost(const std::string& origin, const OutboundHostConfig& config);
+        void setDefaultConfig(const OutboundHostConfig& config);
+
+        OutboundResponse send(const OutboundRequest& request);
+        OutboundResponse get(const std::string& origin, const std::string& path,
+                             const OutboundHeaders& headers = {});
+        OutboundResponse post(const std::string& origin, const std::string& path, const std::string& body,
+                              const std::string& content_type, const OutboundHeaders& headers = {});
+
+        HostStats hostStats(const std::string& origin) const;
+
+        // Ferme les connexions inactives au-delà d'idle_timeout
+        void closeIdle();
+        void shutdown();
+    };
+}
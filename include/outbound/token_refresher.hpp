@@ -0,0 +1,140 @@
+#pragma once
+
+#include "qmark.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace QMark {
+
+    // Point de jeton d'un fournisseur (grant_type=refresh_token, formulaire POST)
+    struct OAuthProviderConfig {
+        std::string token_origin;           // "https://oauth2.googleapis.com"
+        std::string token_path;             // "/token"
+        std::string client_id;
+        std::string client_secret;
+    };
+
+    struct TokenRefresherConfig {
+        std::chrono::seconds refresh_ahead{std::chrono::minutes(10)};  // marge avant expiration
+        std::chrono::seconds min_validity{60};      // accessToken() rafraîchit en ligne en deçà
+        size_t batch_size = 16;                     // rafraîchissements simultanés par lot
+        std::chrono::milliseconds batch_interval{1000};     // au plus un lot par intervalle
+        std::chrono::seconds retry_initial{60};     // reprise après échec, doublée à chaque fois
+        std::chrono::seconds retry_max{std::chrono::hours(1)};
+        std::string encryption_key;                 // clé AES-256 brute (32 octets)
+        std::unordered_map<std::string, OAuthProviderConfig> providers;
+        bool load_from_database = true;
+
+        // Réécriture groupée (par défaut DatabaseManager::saveOAuthConnections)
+        std::function<bool(const std::vector<qmark::OAuthConnection>&)> persist;
+    };
+
+    // Rafraîchit les jetons OAuth avant leur expiration : tas-min sur
+    // expires_at, lots à débit borné, un seul rafraîchissement en vol par
+    // connexion (les appels concurrents attendent le même résultat), jetons
+    // rechiffrés réécrits en transactions groupées.
+    class TokenRefresher {
+    public:
+        struct Stats {
+            size_t tracked = 0;
+            size_t in_flight = 0;
+            uint64_t refreshed = 0;
+            uint64_t failures = 0;
+            uint64_t joined = 0;        // appels rattachés à un rafraîchissement en cours
+            uint64_t revoked = 0;       // invalid_grant : connexion désactivée
+        };
+
+    private:
+        struct Tracked {
+            qmark::OAuthConnection connection;
+            uint32_t generation = 0;
+            uint32_t failures = 0;
+            std::optional<std::shared_future<bool>> in_flight;
+        };
+
+        // Entrée du tas, périmée dès que la génération de la connexion change
+        struct HeapEntry {
+            int64_t due_ms;
+            qmark::ConnectionId id;
+            uint32_t generation;
+
+            bool operator>(const HeapEntry& other) const { return due_ms > other.due_ms; }
+        };
+
+        struct Outcome {
+            bool success = false;
+            bool revoked = false;
+            std::string encrypted_access_token;
+            std::string encrypted_refresh_token;    // vide : le fournisseur garde l'ancien
+            int64_t expires_in = 0;
+            std::string error;
+        };
+
+        TokenRefresherConfig config_;
+
+        mutable std::mutex mutex_;
+        std::condition_variable wake_cv_;
+        std::unordered_map<qmark::ConnectionId, Tracked> connections_;
+        std::priority_queue<HeapEntry, std::vector<HeapEntry>, std::greater<HeapEntry>> heap_;
+        std::vector<qmark::OAuthConnection> pending_writes_;
+        int64_t flush_retry_ms_ = 0;    // après un échec d'écriture, pas de nouvel essai avant
+        size_t in_flight_ = 0;
+
+        std::thread refresher_thread_;
+        std::atomic<bool> running_;
+
+        std::atomic<uint64_t> refreshed_;
+        std::atomic<uint64_t> failures_;
+        std::atomic<uint64_t> joined_;
+        std::atomic<uint64_t> revoked_;
+
+        // Identifiants des compteurs de métriques
+        uint32_t refresh_counter_ = 0;
+        uint32_t failure_counter_ = 0;
+        uint32_t joined_counter_ = 0;
+
+        TokenRefresher();
+
+        static int64_t nowMillis();
+
+        // Appelées avec mutex_ tenu
+        void schedule(qmark::ConnectionId id, Tracked& tracked, int64_t due_ms);
+        void scheduleFromExpiry(qmark::ConnectionId id, Tracked& tracked);
+
+        std::shared_future<bool> refresh(qmark::ConnectionId id);
+        Outcome requestTokens(const qmark::OAuthConnection& connection);
+        void refresherLoop();
+        void flushWrites();
+
+    public:
+        static TokenRefresher& getInstance();
+        ~TokenRefresher();
+
+        TokenRefresher(const TokenRefresher&) = delete;
+        TokenRefresher& operator=(const TokenRefresher&) = delete;
+
+        bool start(const TokenRefresherConfig& config);
+        void stop();
+
+        // Nouvelle connexion ou jetons remplacés (callback OAuth)
+        void track(const qmark::OAuthConnection& connection);
+        void untrack(qmark::ConnectionId id);
+
+        // Jeton d'accès déchiffré, rafraîchi d'abord s'il expire bientôt
+        std::optional<std::string> accessToken(qmark::ConnectionId id);
+
+        // Rafraîchissement immédiat (rejoint celui déjà en vol)
+        bool refreshNow(qmark::ConnectionId id);
+
+        Stats stats() const;
+    };
+}
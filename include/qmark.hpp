@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <memory_resource>
 #include <unordered_map>
 #include <functional>
 #include <chrono>
@@ -23,24 +24,41 @@
 namespace qmark {
     using UserId = uint64_t;
     using ConnectionId = uint64_t;
+    using AutomationId = uint64_t;
+    using LeadId = uint64_t;
     using Timestamp = std::chrono::system_clock::time_point;
 
-    // Structure pour les réponses JSON
+    // Structure pour les réponses JSON. Tout son contenu vient de l'allocateur
+    // donné : construite sur RequestArena::resource(), elle ne coûte aucun
+    // appel à l'allocateur global et disparaît avec la requête.
     struct JsonResponse {
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+
         int status_code = 200;
-        std::string content_type = "application/json";
-        std::string body;
-        std::unordered_map<std::string, std::string> headers;
+        std::pmr::string content_type;
+        std::pmr::string body;
+        std::pmr::unordered_map<std::pmr::string, std::pmr::string> headers;
+
+        JsonResponse() : JsonResponse(allocator_type{}) {}
+        explicit JsonResponse(const allocator_type& allocator)
+            : content_type("application/json", allocator), body(allocator), headers(allocator) {}
     };
 
-    // Structure pour les requêtes HTTP
+    // Structure pour les requêtes HTTP (même allocateur pour tous les champs)
     struct HttpRequest {
-        std::string method;
-        std::string path;
-        std::unordered_map<std::string, std::string> headers;
-        std::unordered_map<std::string, std::string> params;
-        std::string body;
-        std::string remote_addr;
+        using allocator_type = std::pmr::polymorphic_allocator<>;
+
+        std::pmr::string method;
+        std::pmr::string path;
+        std::pmr::unordered_map<std::pmr::string, std::pmr::string> headers;
+        std::pmr::unordered_map<std::pmr::string, std::pmr::string> params;
+        std::pmr::string body;
+        std::pmr::string remote_addr;
+
+        HttpRequest() : HttpRequest(allocator_type{}) {}
+        explicit HttpRequest(const allocator_type& allocator)
+            : method(allocator), path(allocator), headers(allocator), params(allocator),
+              body(allocator), remote_addr(allocator) {}
     };
 
     // Structure utilisateur
@@ -70,6 +88,47 @@ namespace qmark {
         bool is_active = true;
     };
 
+    // Automatisation planifiée (config : document JSON, dont interval_seconds)
+    struct Automation {
+        AutomationId id = 0;
+        UserId user_id = 0;
+        std::string name;
+        std::string description;
+        std::string type;
+        std::string config;
+        bool is_active = true;
+        Timestamp last_run;
+        uint64_t run_count = 0;
+        Timestamp created_at;
+        Timestamp updated_at;
+    };
+
+    // Prospect capté (source : facebook, instagram, whatsapp...)
+    struct Lead {
+        LeadId id = 0;
+        UserId user_id = 0;
+        std::string name;
+        std::string email;
+        std::string phone;
+        std::string source;
+        std::string status = "new";
+        std::string notes;
+        std::string metadata = "{}";
+        Timestamp created_at;
+        Timestamp updated_at;
+    };
+
+    // Compteurs d'une journée (date : minuit UTC), table metrics
+    struct DailyMetrics {
+        UserId user_id = 0;
+        Timestamp date;
+        uint32_t leads_count = 0;
+        uint32_t conversions_count = 0;
+        uint32_t automations_count = 0;
+        double revenue = 0.0;
+        uint64_t revision = 0;      // lot d'écriture, pour reprendre après un instantané
+    };
+
     // Métriques dashboard
     struct DashboardMetrics {
         uint64_t total_leads = 0;
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "qmark.hpp"
+#include "utils/json_writer.hpp"
+#include <map>
+#include <string>
+#include <string_view>
+
+namespace QMark {
+
+    // Réponses génériques de l'API
+    namespace JSON {
+        std::string serialize(const std::map<std::string, std::string>& data);
+        std::map<std::string, std::string> deserialize(const std::string& json_str);
+
+        // `data_json` est un fragment JSON déjà sérialisé
+        std::string createResponse(const std::string& status, const std::string& message,
+                                   std::string_view data_json = "null");
+        std::string createErrorResponse(const std::string& error, int code);
+    }
+
+    // Fonctions utilitaires pour JSON
+    namespace json_utils {
+        // Écriture dans un document en cours (listes, flux chunked)
+        void write_user(JsonWriter& writer, const qmark::User& user);
+        void write_oauth_connection(JsonWriter& writer, const qmark::OAuthConnection& connection);
+        void write_dashboard_metrics(JsonWriter& writer, const qmark::DashboardMetrics& metrics);
+
+        std::string serialize_user(const qmark::User& user);
+        std::string serialize_oauth_connection(const qmark::OAuthConnection& connection);
+        std::string serialize_dashboard_metrics(const qmark::DashboardMetrics& metrics);
+        std::string serialize_error(const std::string& message, int code = 400);
+        std::string serialize_success(const std::string& message = "OK");
+
+        // Clés inconnues ignorées, champs absents inchangés ; false si JSON invalide ou type incompatible
+        bool parse_user(const std::string& json, qmark::User& user);
+        bool parse_oauth_connection(const std::string& json, qmark::OAuthConnection& connection);
+    }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "qmark.hpp"
+#include "utils/reflection.hpp"
+
+// Source unique des listes de champs : codecs JSON (json_codec.hpp)
+// et liaison SQLite (sqlite_codec.hpp) en sont générés à la compilation
+namespace QMark {
+
+    namespace reflect {
+
+        template<>
+        struct Describe<qmark::User> {
+            static constexpr auto fields = std::make_tuple(
+                field("id", &qmark::User::id, PRIMARY_KEY),
+                field("username", &qmark::User::username),
+                field("email", &qmark::User::email),
+                field("display_name", &qmark::User::display_name),
+                field("avatar_url", &qmark::User::avatar_url),
+                field("replit_user_id", &qmark::User::replit_user_id),
+                field("created_at", &qmark::User::created_at),
+                field("updated_at", &qmark::User::updated_at),
+                field("is_premium", &qmark::User::is_premium)
+            );
+        };
+
+        template<>
+        struct Describe<qmark::OAuthConnection> {
+            static constexpr std::string_view table = "oauth_connections";
+            static constexpr auto fields = std::make_tuple(
+                field("id", &qmark::OAuthConnection::id, PRIMARY_KEY),
+                field("user_id", &qmark::OAuthConnection::user_id),
+                field("provider", &qmark::OAuthConnection::provider),
+                field("provider_user_id", &qmark::OAuthConnection::provider_user_id),
+                field("encrypted_access_token", &qmark::OAuthConnection::encrypted_access_token, NOT_JSON),
+                field("encrypted_refresh_token", &qmark::OAuthConnection::encrypted_refresh_token, NOT_JSON),
+                field("expires_at", &qmark::OAuthConnection::expires_at),
+                field("created_at", &qmark::OAuthConnection::created_at),
+                field("updated_at", &qmark::OAuthConnection::updated_at),
+                field("is_active", &qmark::OAuthConnection::is_active)
+            );
+        };
+
+        template<>
+        struct Describe<qmark::Automation> {
+            static constexpr std::string_view table = "automations";
+            static constexpr auto fields = std::make_tuple(
+                field("id", &qmark::Automation::id, PRIMARY_KEY),
+                field("user_id", &qmark::Automation::user_id),
+                field("name", &qmark::Automation::name),
+                field("description", &qmark::Automation::description),
+                field("type", &qmark::Automation::type),
+                field("config", &qmark::Automation::config),
+                field("is_active", &qmark::Automation::is_active),
+                field("last_run", &qmark::Automation::last_run),
+                field("run_count", &qmark::Automation::run_count),
+                field("created_at", &qmark::Automation::created_at),
+                field("updated_at", &qmark::Automation::updated_at)
+            );
+        };
+
+        template<>
+        struct Describe<qmark::Lead> {
+            static constexpr std::string_view table = "leads";
+            static constexpr auto fields = std::make_tuple(
+                field("id", &qmark::Lead::id, PRIMARY_KEY),
+                field("user_id", &qmark::Lead::user_id),
+                field("name", &qmark::Lead::name),
+                field("email", &qmark::Lead::email),
+                field("phone", &qmark::Lead::phone),
+                field("source", &qmark::Lead::source),
+                field("status", &qmark::Lead::status),
+                field("notes", &qmark::Lead::notes),
+                field("metadata", &qmark::Lead::metadata),
+                field("created_at", &qmark::Lead::created_at),
+                field("updated_at", &qmark::Lead::updated_at)
+            );
+        };
+
+        // Clé primaire (user_id, date) : INSERT OR REPLACE remplace la journée
+        template<>
+        struct Describe<qmark::DailyMetrics> {
+            static constexpr std::string_view table = "metrics";
+            static constexpr auto fields = std::make_tuple(
+                field("user_id", &qmark::DailyMetrics::user_id),
+                field("date", &qmark::DailyMetrics::date),
+                field("leads_count", &qmark::DailyMetrics::leads_count),
+                field("conversions_count", &qmark::DailyMetrics::conversions_count),
+                field("automations_count", &qmark::DailyMetrics::automations_count),
+                field("revenue", &qmark::DailyMetrics::revenue),
+                field("revision", &qmark::DailyMetrics::revision, NOT_JSON)
+            );
+        };
+
+        // Calculées à la volée, jamais stockées
+        template<>
+        struct Describe<qmark::DashboardMetrics> {
+            static constexpr auto fields = std::make_tuple(
+                field("total_leads", &qmark::DashboardMetrics::total_leads),
+                field("total_connections", &qmark::DashboardMetrics::total_connections),
+                field("active_automations", &qmark::DashboardMetrics::active_automations),
+                field("conversion_rate", &qmark::DashboardMetrics::conversion_rate),
+                field("messages_sent_today", &qmark::DashboardMetrics::messages_sent_today)
+            );
+        };
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace QMark {
+
+    // Générateur aléatoire cryptographique par thread.
+    //
+    // Chaque thread possède son propre DRBG ChaCha20 à effacement rapide de
+    // clé : la clé est réensemencée depuis le noyau (getrandom) tous les
+    // RESEED_INTERVAL octets et après chaque fork, et les octets sont servis
+    // depuis un tampon local rempli par blocs. Aucun verrou partagé.
+    class SecureRandom {
+    public:
+        static constexpr size_t BUFFER_SIZE = 4096;
+        static constexpr size_t RESEED_INTERVAL = 1024 * 1024;
+
+        static void fill(unsigned char* out, size_t length);
+        static std::vector<unsigned char> bytes(size_t length);
+        static std::string hex(size_t length);
+
+        // Force le réensemencement du DRBG du thread appelant
+        static void reseed();
+    };
+}
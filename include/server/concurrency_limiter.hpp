@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace QMark {
+
+    // Ordre d'abandon sous charge : BULK d'abord, CRITICAL en dernier
+    enum class RequestPriority {
+        CRITICAL,       // santé, supervision, authentification, administration
+        NORMAL,
+        BULK            // webhooks en masse (les plateformes réessaient)
+    };
+
+    struct ConcurrencyLimiterConfig {
+        size_t initial_limit = 16;
+        size_t min_limit = 4;
+        size_t max_limit = 1000;
+        // Part de la limite accessible à NORMAL et BULK ; le reste est réservé aux classes supérieures
+        double normal_share = 0.9;
+        double bulk_share = 0.5;
+        // Latence récente tolérée par rapport à la latence de référence avant de réduire
+        double tolerance = 1.5;
+        double smoothing = 0.2;                         // poids d'une nouvelle estimation
+        std::chrono::milliseconds window{100};          // une estimation par fenêtre...
+        size_t window_min_samples = 10;                 // ... d'au moins autant de requêtes
+        size_t baseline_windows = 200;                  // ~20 s pour admettre une latence de référence plus haute
+        std::chrono::seconds retry_after{1};            // annoncé aux requêtes refusées
+    };
+
+    // Limite adaptative du nombre de requêtes en cours (gradient de latence,
+    // à la Vegas) : la latence moyenne de chaque fenêtre est comparée à la
+    // latence à vide (la plus basse observée, qui ne remonte que lentement) ;
+    // si elle monte (file d'attente, SQLite ralentit), la limite baisse
+    // d'autant, sinon elle croît d'une marge en racine carrée. Les requêtes
+    // au-delà de la part de leur classe sont refusées avant tout traitement.
+    class ConcurrencyLimiter {
+    public:
+        struct Stats {
+            size_t limit = 0;
+            size_t in_flight = 0;
+            double recent_latency_ms = 0.0;
+            double baseline_latency_ms = 0.0;
+            uint64_t admitted = 0;
+            uint64_t rejected[3] = {0, 0, 0};           // par RequestPriority
+        };
+
+    private:
+        ConcurrencyLimiterConfig config_;
+
+        std::atomic<size_t> limit_;
+        std::atomic<size_t> in_flight_;
+        std::atomic<uint64_t> admitted_;
+        std::atomic<uint64_t> rejected_[3];
+        std::atomic<size_t> window_peak_in_flight_;
+
+        // Fenêtre en cours et estimations (sous mutex_)
+        mutable std::mutex mutex_;
+        std::chrono::steady_clock::time_point window_start_;
+        uint64_t window_latency_us_ = 0;
+        size_t window_samples_ = 0;
+        double estimated_limit_ = 0.0;
+        double recent_us_ = 0.0;
+        double baseline_us_ = 0.0;
+
+        // Appelée avec mutex_ tenu, en fin de fenêtre
+        void updateLimit();
+
+    public:
+        explicit ConcurrencyLimiter(const ConcurrencyLimiterConfig& config = ConcurrencyLimiterConfig{});
+
+        // Faux : la requête doit être refusée (503), rien à libérer
+        bool tryAcquire(RequestPriority priority);
+        // Fin d'une requête admise ; la latence alimente l'estimation
+        void release(std::chrono::microseconds latency);
+        // Fin sans mesure (connexion perdue avant la réponse)
+        void release();
+
+        size_t limit() const { return limit_.load(std::memory_order_relaxed); }
+        size_t inFlight() const { return in_flight_.load(std::memory_order_relaxed); }
+        std::chrono::seconds retryAfter() const { return config_.retry_after; }
+        Stats stats() const;
+    };
+}
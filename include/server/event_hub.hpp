@@ -0,0 +1,115 @@
+#pragma once
+
+#include "qmark.hpp"
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace QMark {
+
+    struct EventHubConfig {
+        size_t max_subscribers = 50000;
+        size_t queue_limit = 256;                       // événements en attente par abonné
+        size_t max_buffered_bytes = 256 * 1024;         // non acquittés par le socket
+        std::chrono::milliseconds flush_interval{100};  // fenêtre de regroupement des mises à jour
+        std::chrono::seconds heartbeat{15};             // commentaire envoyé aux flux inactifs
+        std::chrono::milliseconds retry{3000};          // délai de reconnexion annoncé au navigateur
+    };
+
+    // Canal Server-Sent Events du tableau de bord. Les sockets adoptés sont
+    // servis par un seul thread epoll : aucun thread par abonné. Chaque abonné
+    // a une file bornée ; les deltas de métriques s'additionnent tant qu'ils
+    // ne sont pas partis, un abonné qui ne lit plus est déconnecté.
+    class EventHub {
+    public:
+        struct Stats {
+            size_t subscribers = 0;
+            uint64_t published = 0;
+            uint64_t coalesced = 0;     // deltas fusionnés avant envoi
+            uint64_t dropped = 0;       // abonnés lents déconnectés
+        };
+
+    private:
+        struct Subscriber {
+            int fd = -1;
+            int64_t user_id = 0;
+
+            // Protégés par mutex_
+            std::deque<std::string> events;
+            std::map<std::string, int64_t, std::less<>> deltas;
+            bool dirty = false;
+            bool closing = false;
+
+            // Thread epoll uniquement
+            std::string out;
+            size_t out_offset = 0;
+            bool want_write = false;
+            int64_t last_write_ms = 0;
+        };
+
+        EventHubConfig config_;
+
+        mutable std::mutex mutex_;
+        std::unordered_map<int, std::unique_ptr<Subscriber>> subscribers_;
+        std::unordered_map<int64_t, std::vector<Subscriber*>> by_user_;
+        std::vector<Subscriber*> dirty_;
+
+        int epoll_fd_ = -1;
+        int wake_fd_ = -1;
+        std::thread loop_thread_;
+        std::atomic<bool> running_;
+
+        std::atomic<uint64_t> published_;
+        std::atomic<uint64_t> coalesced_;
+        std::atomic<uint64_t> dropped_;
+
+        // Identifiants des compteurs de métriques
+        uint32_t published_counter_ = 0;
+        uint32_t dropped_counter_ = 0;
+
+        EventHub();
+
+        static int64_t nowMillis();
+
+        // Appelée avec mutex_ tenu ; vrai si le thread epoll doit être réveillé
+        bool markDirty(Subscriber& subscriber);
+
+        void wake();
+        void eventLoop();
+        void flushDirty(int64_t now);
+        bool writeOut(Subscriber& subscriber, int64_t now);
+        void heartbeat(int64_t now);
+        void close(const std::vector<Subscriber*>& subscribers);
+
+    public:
+        static EventHub& getInstance();
+        ~EventHub();
+
+        EventHub(const EventHub&) = delete;
+        EventHub& operator=(const EventHub&) = delete;
+
+        bool start(const EventHubConfig& config = EventHubConfig{});
+        void stop();
+        bool isRunning() const { return running_; }
+        bool isFull() const;
+
+        // Prend possession d'un socket dont l'en-tête HTTP (chunked) est déjà envoyé
+        bool adopt(int fd, int64_t user_id);
+
+        // Événement discret (ex. nouvelle activité), `data` en JSON sur une ligne
+        void publish(int64_t user_id, std::string_view event, std::string_view data);
+
+        // Delta de compteur, additionné aux deltas encore en attente
+        void publishDelta(int64_t user_id, std::string_view metric, int64_t delta);
+
+        Stats stats() const;
+    };
+}
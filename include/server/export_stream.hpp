@@ -0,0 +1,97 @@
+#pragma once
+
+#include "qmark.hpp"
+#include "database/database_manager.hpp"
+#include "utils/json_writer.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <zlib.h>
+
+namespace QMark {
+
+    enum class ExportFormat : uint8_t {
+        CSV,            // RFC 4180, ligne d'en-tête
+        NDJSON          // un objet JSON par ligne
+    };
+
+    struct ExportConfig {
+        size_t page_rows = 500;             // lignes lues par passage sous le verrou du fichier
+        size_t page_bytes = 256 * 1024;     // page écourtée au-delà (notes, métadonnées volumineuses)
+        size_t max_per_user = 2;            // exports simultanés d'un même utilisateur
+        size_t max_total = 4;               // chacun occupe un thread du serveur jusqu'à la fin
+        int gzip_level = 6;
+        std::chrono::seconds retry_after{5};
+    };
+
+    // Sérialise les lignes d'un export dans un tampon borné, compressé en gzip
+    // au fil de l'eau si demandé ; drain() le vide vers le puits. Le puits
+    // (DataSink::write) bloque tant que le socket n'accepte rien : un client
+    // lent ralentit la lecture des pages au lieu de faire grossir la mémoire.
+    class ExportEncoder {
+    public:
+        using Sink = std::function<bool(const char* data, size_t length)>;
+
+    private:
+        ExportFormat format_;
+        std::span<const std::string_view> columns_;
+        std::string text_;                  // lignes sérialisées, pas encore envoyées
+        JsonWriter json_;
+        bool gzip_;
+        z_stream zstream_{};
+        std::string compressed_;            // sortie de deflate (taille fixe)
+        uint64_t rows_ = 0;
+        uint64_t bytes_sent_ = 0;
+
+        bool deflateTo(const Sink& sink, int flush);
+        void appendCsvField(const ExportValue& value);
+
+    public:
+        ExportEncoder(ExportFormat format, std::span<const std::string_view> columns, bool gzip, int gzip_level);
+        ~ExportEncoder();
+
+        ExportEncoder(const ExportEncoder&) = delete;
+        ExportEncoder& operator=(const ExportEncoder&) = delete;
+
+        // Ligne d'en-tête CSV (rien en NDJSON)
+        void header();
+        void row(std::span<const ExportValue> values);
+        size_t pending() const { return text_.size(); }
+
+        // Faux si le client est parti
+        bool drain(const Sink& sink);
+        // drain() puis fin du flux gzip
+        bool finish(const Sink& sink);
+
+        // Faux si deflate n'a pas pu être initialisé : export envoyé non compressé
+        bool gzip() const { return gzip_; }
+        uint64_t rows() const { return rows_; }
+        uint64_t bytesSent() const { return bytes_sent_; }
+    };
+
+    // Exports en cours, par utilisateur et au total
+    class ExportLimiter {
+    private:
+        size_t max_per_user_;
+        size_t max_total_;
+        mutable std::mutex mutex_;
+        std::unordered_map<qmark::UserId, size_t> active_;
+        size_t total_ = 0;
+
+        void release(qmark::UserId user_id);
+
+    public:
+        ExportLimiter(size_t max_per_user, size_t max_total);
+
+        // Place rendue à la destruction du jeton ; nullptr au-delà des limites (429)
+        std::shared_ptr<void> tryAcquire(qmark::UserId user_id);
+        size_t active() const;
+    };
+}
@@ -1,91 +1,84 @@
-
 #pragma once
 
 #include "qmark.hpp"
+#include "qmark_json.hpp"
+#include "server/session_store.hpp"
+#include "server/concurrency_limiter.hpp"
+#include "server/tls_context.hpp"
+#include "server/export_stream.hpp"
 #include <httplib.h>
 #include <functional>
+#include <optional>
 #include <thread>
 #include <atomic>
 
-namespace qmark::server {
-    
-    using RouteHandler = std::function<JsonResponse(const HttpRequest&)>;
-    using MiddlewareHandler = std::function<bool(const HttpRequest&, JsonResponse&)>;
-    
+namespace QMark {
+
     class HttpServer {
     private:
         std::unique_ptr<httplib::Server> server_;
-        ServerConfig config_;
-        std::vector<MiddlewareHandler> middlewares_;
-        std::atomic<bool> is_running_;
+        std::string host_;
+        int port_ = DEFAULT_PORT;
         std::thread server_thread_;
-        
+
+        // Connexions acceptées : en file d'attente / en cours de traitement
+        std::atomic<size_t> queued_connections_;
+        std::atomic<size_t> active_connections_;
+
+        // Requêtes en cours : limite adaptative, refus (503) au-delà
+        ConcurrencyLimiter limiter_;
+
+        // Exports (CSV/NDJSON en flux) : limités par utilisateur et au total
+        ExportConfig export_config_;
+        ExportLimiter exports_;
+
+        // Terminaison TLS (nullptr : HTTP en clair)
+        std::unique_ptr<TlsContext> tls_;
+
         // Méthodes privées
-        void setup_routes();
-        void setup_middlewares();
-        void setup_cors();
-        void setup_error_handlers();
-        HttpRequest convert_request(const httplib::Request& req);
-        void send_response(httplib::Response& res, const JsonResponse& json_response);
-        
+        void setupMiddleware();
+        void setupMetrics();
+
         // Handlers d'API
-        JsonResponse handle_auth_user(const HttpRequest& req);
-        JsonResponse handle_auth_logout(const HttpRequest& req);
-        JsonResponse handle_dashboard_stats(const HttpRequest& req);
-        JsonResponse handle_oauth_connections(const HttpRequest& req);
-        JsonResponse handle_oauth_connect(const HttpRequest& req);
-        JsonResponse handle_oauth_disconnect(const HttpRequest& req);
-        JsonResponse handle_system_health(const HttpRequest& req);
-        JsonResponse handle_system_complete(const HttpRequest& req);
-        
-        // Middleware handlers
-        bool cors_middleware(const HttpRequest& req, JsonResponse& res);
-        bool auth_middleware(const HttpRequest& req, JsonResponse& res);
-        bool rate_limit_middleware(const HttpRequest& req, JsonResponse& res);
-        bool logging_middleware(const HttpRequest& req, JsonResponse& res);
-        
+        void handleGetData(const httplib::Request& req, httplib::Response& res);
+        void handlePostData(const httplib::Request& req, httplib::Response& res);
+        void handleAuthUser(const httplib::Request& req, httplib::Response& res);
+        void handleAuthLogout(const httplib::Request& req, httplib::Response& res);
+        void handleEvents(const httplib::Request& req, httplib::Response& res);
+        void handleMetrics(const httplib::Request& req, httplib::Response& res);
+        void handleExport(const httplib::Request& req, httplib::Response& res, ExportTable table);
+        void handleWebhook(const httplib::Request& req, httplib::Response& res);
+        void handleWebhookChallenge(const httplib::Request& req, httplib::Response& res);
+        static void handleStatic(const httplib::Request& req, httplib::Response& res);
+
+        // Endpoints d'administration réservés à la boucle locale
+        static bool isLoopback(const httplib::Request& req);
+
+        // Sessions
+        static std::string extractSessionId(const httplib::Request& req);
+        std::optional<SessionStore::Session> currentSession(const httplib::Request& req);
+
     public:
-        explicit HttpServer(const ServerConfig& config = ServerConfig{});
+        explicit HttpServer(const ConcurrencyLimiterConfig& limits = ConcurrencyLimiterConfig{});
         ~HttpServer();
-        
-        // Configuration
-        void set_config(const ServerConfig& config);
-        const ServerConfig& get_config() const;
-        
-        // Middleware
-        void add_middleware(MiddlewareHandler middleware);
-        void clear_middlewares();
-        
-        // Routes personnalisées
-        void add_route(const std::string& method, 
-                      const std::string& path, 
-                      RouteHandler handler);
-        
+
+        // Avant start() : toutes les connexions passent en TLS ; faux si le
+        // certificat ou la clé ne se chargent pas
+        bool enableTls(const TlsConfig& config);
+
+        // Configuration des routes
+        void setupRoutes();
+
         // Contrôle du serveur
-        bool start();
+        bool start(const std::string& host, int port);
         void stop();
-        bool is_running() const;
-        void wait_for_shutdown();
-        
+        void waitForStop();
+
         // Statistiques
         size_t get_active_connections() const;
         uint64_t get_requests_count() const;
-        
+
         // Utilitaires
-        static std::string get_client_ip(const HttpRequest& req);
         static std::string generate_session_id();
-        static bool validate_json(const std::string& json_str);
     };
-    
-    // Fonctions utilitaires pour JSON
-    namespace json_utils {
-        std::string serialize_user(const User& user);
-        std::string serialize_oauth_connection(const OAuthConnection& connection);
-        std::string serialize_dashboard_metrics(const DashboardMetrics& metrics);
-        std::string serialize_error(const std::string& message, int code = 400);
-        std::string serialize_success(const std::string& message = "OK");
-        
-        bool parse_user(const std::string& json, User& user);
-        bool parse_oauth_connection(const std::string& json, OAuthConnection& connection);
-    }
 }
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "qmark.hpp"
+#include "database/database_manager.hpp"
+#include "utils/timing_wheel.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace QMark {
+
+    struct SessionStoreConfig {
+        size_t shard_count = 16;
+        std::chrono::seconds ttl{std::chrono::hours(24)};
+        // Une prolongation plus courte que ce délai n'est pas réécrite sur disque
+        std::chrono::seconds persist_slack{std::chrono::minutes(5)};
+        std::chrono::milliseconds flush_interval{500};
+        size_t flush_batch_size = 512;
+        // Passes d'écriture consécutives en échec avant d'abandonner le lot en attente
+        size_t flush_max_attempts = 20;
+        // Écrit à l'arrêt, relu au démarrage à la place de la table ; vide : désactivé
+        std::string snapshot_path = "data/sessions.snapshot";
+    };
+
+    // Sessions en mémoire, partitionnées, avec expiration glissante.
+    // La table sessions n'est qu'une copie durable : lecture au démarrage,
+    // écritures groupées par le thread de fond, jamais lue sur le chemin chaud.
+    // Après un arrêt propre, le démarrage suivant repart de l'instantané
+    // écrit par stop() si son jeton est celui noté en base.
+    class SessionStore {
+    public:
+        struct Session {
+            std::string id;
+            int64_t user_id = 0;
+            std::string data;
+            int64_t expires_at = 0;
+        };
+
+    private:
+        struct Entry {
+            int64_t user_id;
+            std::string data;
+            std::atomic<int64_t> expires_at;
+            std::atomic<int64_t> persisted_expires_at;
+
+            Entry(int64_t user, std::string payload, int64_t expiry)
+                : user_id(user), data(std::move(payload)),
+                  expires_at(expiry), persisted_expires_at(expiry) {}
+        };
+
+        struct Shard {
+            mutable std::shared_mutex mutex;
+            std::unordered_map<std::string, Entry> sessions;
+            TimingWheel<std::string> wheel;
+        };
+
+        struct PendingWrites {
+            std::vector<SessionRecord> upserts;
+            std::vector<std::pair<std::string, int64_t>> expiries;
+            std::vector<std::string> deletes;
+
+            size_t size() const { return upserts.size() + expiries.size() + deletes.size(); }
+        };
+
+        SessionStoreConfig config_;
+        std::vector<std::unique_ptr<Shard>> shards_;
+        std::atomic<size_t> size_;
+
+        PendingWrites pending_;
+        std::mutex pending_mutex_;
+        std::condition_variable pending_cv_;
+
+        // Lot en échec, rejoué avant les nouvelles écritures (thread d'écriture seulement)
+        PendingWrites failed_;
+        size_t failed_attempts_ = 0;
+
+        std::thread flusher_thread_;
+        std::atomic<bool> running_;
+
+        // Identifiants des compteurs de métriques
+        uint32_t hit_counter_ = 0;
+        uint32_t miss_counter_ = 0;
+
+        SessionStore();
+
+        Shard& shardFor(const std::string& session_id);
+        void warmLoad();
+        bool loadSnapshot();
+        bool saveSnapshot();
+        void flusherLoop();
+        void expireDue(int64_t now);
+        void flushPending();
+        void enqueueUpsert(SessionRecord record);
+        void enqueueExpiry(const std::string& session_id, int64_t expires_at);
+        void enqueueDelete(const std::string& session_id);
+
+        static int64_t nowSeconds();
+
+    public:
+        static SessionStore& getInstance();
+        ~SessionStore();
+
+        SessionStore(const SessionStore&) = delete;
+        SessionStore& operator=(const SessionStore&) = delete;
+
+        // Cycle de vie : chargement à chaud puis thread d'écriture/expiration
+        bool start(const SessionStoreConfig& config = SessionStoreConfig{});
+        void stop();
+
+        // Opérations sur les sessions (aucun accès SQLite)
+        std::string create(int64_t user_id, const std::string& data = "{}");
+        std::optional<Session> find(const std::string& session_id);
+        bool update(const std::string& session_id, const std::string& data);
+        bool destroy(const std::string& session_id);
+
+        size_t size() const;
+    };
+}
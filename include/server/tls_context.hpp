@@ -0,0 +1,102 @@
+#pragma once
+
+#include <openssl/ssl.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+namespace QMark {
+
+    struct TlsConfig {
+        std::string cert_path;                          // chaîne PEM (certificat puis intermédiaires)
+        std::string key_path;
+        // Réponse OCSP DER, renouvelée par un outil externe ; relue quand le fichier change
+        std::string ocsp_response_path;
+        std::chrono::seconds ocsp_check_interval{60};
+
+        size_t session_cache_size = 20480;              // sessions TLS 1.2 par identifiant
+        std::chrono::seconds session_timeout{std::chrono::hours(2)};
+        // Clés de tickets : une nouvelle à chaque intervalle, la précédente reste acceptée
+        std::chrono::seconds ticket_key_rotation{std::chrono::hours(12)};
+
+        bool kernel_tls = true;                         // kTLS après la poignée de main si le noyau l'offre
+    };
+
+    // Terminaison TLS du serveur : un SSL_CTX partagé par toutes les
+    // connexions, donc un seul cache de sessions ; clés de tickets tournantes
+    // tenues en mémoire (chiffrement AES-256-CBC + HMAC-SHA256) ; agrafage
+    // OCSP depuis un fichier local ; kTLS demandé à OpenSSL, qui le pose sur
+    // le socket quand le module tls du noyau et la suite le permettent
+    // (les corps de fichiers partent alors par sendfile).
+    class TlsContext {
+    public:
+        struct Stats {
+            uint64_t handshakes = 0;
+            uint64_t resumed = 0;
+            uint64_t kernel_tls = 0;                    // connexions avec émission par le noyau
+            bool ocsp_loaded = false;
+        };
+
+    private:
+        struct TicketKey {
+            std::array<unsigned char, 16> name{};
+            std::array<unsigned char, 32> aes_key{};
+            std::array<unsigned char, 32> hmac_key{};
+            std::chrono::steady_clock::time_point created;
+        };
+
+        TlsConfig config_;
+        SSL_CTX* ctx_ = nullptr;
+
+        // [0] : clé courante, [1] : précédente (déchiffrement seulement)
+        std::shared_mutex ticket_mutex_;
+        std::array<TicketKey, 2> ticket_keys_{};
+        size_t ticket_key_count_ = 0;
+
+        mutable std::mutex ocsp_mutex_;
+        std::shared_ptr<const std::string> ocsp_response_;
+        std::time_t ocsp_mtime_ = 0;
+        std::chrono::steady_clock::time_point ocsp_checked_;
+        std::time_t ocsp_next_update_ = 0;              // 0 : pas de date de fin annoncée
+
+        std::atomic<uint64_t> handshakes_;
+        std::atomic<uint64_t> resumed_;
+        std::atomic<uint64_t> kernel_tls_;
+
+        bool ticketKeyDue() const;                      // sous ticket_mutex_
+        // only_if_due : revérifié sous le verrou exclusif, une seule rotation par intervalle
+        bool rotateTicketKey(bool only_if_due);
+        void reloadOcspResponse(bool force);
+        std::shared_ptr<const std::string> ocspResponse();
+
+        static int ticketKeyCallback(SSL* ssl, unsigned char* key_name, unsigned char* iv,
+                                     EVP_CIPHER_CTX* cipher, EVP_MAC_CTX* mac, int encrypt);
+        static int ocspStatusCallback(SSL* ssl, void* arg);
+
+    public:
+        TlsContext();
+        ~TlsContext();
+
+        TlsContext(const TlsContext&) = delete;
+        TlsContext& operator=(const TlsContext&) = delete;
+
+        // Faux si le certificat, la clé ou leur correspondance pose problème
+        bool init(const TlsConfig& config);
+
+        SSL_CTX* context() const { return ctx_; }
+
+        // Après la poignée de main : compteurs (reprise de session, kTLS)
+        void onHandshake(SSL* ssl);
+
+        // Le noyau chiffre les écritures sur le socket lui-même
+        static bool kernelSend(SSL* ssl);
+
+        Stats stats() const;
+    };
+}
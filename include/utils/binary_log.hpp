@@ -0,0 +1,290 @@
+#pragma once
+
+#include "utils/logger.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace QMark {
+
+    // Journal binaire structuré : aucun formatage sur le chemin chaud.
+    //
+    // Chaque site d'appel QLOG_* décrit (niveau, format, fichier, ligne,
+    // types des arguments) est enregistré une seule fois et reçoit un
+    // identifiant ; un appel ne copie ensuite que l'identifiant, le compteur
+    // TSC, le thread et les arguments bruts dans un anneau propre au thread.
+    // Le rendu texte/JSON est fait hors ligne par qmark-logdecode.
+    namespace binlog {
+
+        // Format de fichier (petit-boutiste)
+        inline constexpr char FILE_MAGIC[8] = {'Q', 'M', 'K', 'B', 'L', 'O', 'G', '1'};
+        inline constexpr uint32_t FILE_VERSION = 1;
+
+        enum RecordKind : uint8_t {
+            RECORD_SITE = 1,     // id u32, level u8, line u32, file (u16+octets), format (u16+octets), argc u8, types
+            RECORD_EVENT = 2,    // id u32, tsc u64, thread u32, payload_len u32, payload
+            RECORD_SYNC = 3,     // tsc u64, unix_ns i64
+            RECORD_DROPPED = 4   // thread u32, count u64
+        };
+
+        enum ArgType : uint8_t {
+            ARG_INT64 = 1,
+            ARG_UINT64 = 2,
+            ARG_DOUBLE = 3,
+            ARG_BOOL = 4,
+            ARG_CHAR = 5,
+            ARG_STRING = 6       // u32 longueur + octets
+        };
+
+        // En-tête de fichier
+        struct FileHeader {
+            char magic[8];
+            uint32_t version;
+            uint32_t reserved;
+            double tsc_ticks_per_ns;
+            int64_t anchor_unix_ns;
+            uint64_t anchor_tsc;
+        };
+
+        constexpr size_t EVENT_HEADER_SIZE = 1 + 4 + 8 + 4 + 4;
+
+        inline uint64_t readTsc() {
+#if defined(__x86_64__) || defined(__i386__)
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+        }
+
+        template<typename T>
+        constexpr ArgType argType() {
+            using U = std::remove_cv_t<std::remove_reference_t<T>>;
+            if constexpr (std::is_same_v<U, bool>) {
+                return ARG_BOOL;
+            } else if constexpr (std::is_same_v<U, char>) {
+                return ARG_CHAR;
+            } else if constexpr (std::is_integral_v<U> || std::is_enum_v<U>) {
+                return std::is_signed_v<U> ? ARG_INT64 : ARG_UINT64;
+            } else if constexpr (std::is_floating_point_v<U>) {
+                return ARG_DOUBLE;
+            } else {
+                static_assert(std::is_convertible_v<const U&, std::string_view>,
+                              "QLOG arguments must be integers, floating point, bool, char or strings");
+                return ARG_STRING;
+            }
+        }
+
+        constexpr size_t countPlaceholders(std::string_view format) {
+            size_t count = 0;
+            for (size_t i = 0; i + 1 < format.size(); i++) {
+                if (format[i] == '{' && format[i + 1] == '}') {
+                    count++;
+                    i++;
+                }
+            }
+            return count;
+        }
+
+        template<typename... Args>
+        constexpr std::integral_constant<size_t, sizeof...(Args)> arity(const Args&...) { return {}; }
+
+        // Description statique d'un site d'appel
+        struct Site {
+            LogLevel level;
+            const char* format;
+            const char* file;
+            uint32_t line;
+            std::atomic<uint32_t> id{0};
+        };
+
+        // Anneau d'octets SPSC par thread producteur
+        struct ThreadBuffer {
+            static constexpr size_t CAPACITY = size_t{1} << 20;
+
+            std::unique_ptr<uint8_t[]> data;
+            alignas(64) std::atomic<size_t> write_pos{0};
+            size_t cached_read_pos = 0;
+            alignas(64) std::atomic<size_t> read_pos{0};
+            std::atomic<uint64_t> dropped{0};
+            std::atomic<bool> retired{false};
+            uint32_t thread_id = 0;
+            uint64_t reported_dropped = 0;
+
+            ThreadBuffer() : data(std::make_unique<uint8_t[]>(CAPACITY)) {}
+
+            // Réserve, copie et publie un enregistrement complet ; abandonne si plein
+            bool push(const uint8_t* record, size_t length) {
+                size_t write = write_pos.load(std::memory_order_relaxed);
+                if (write - cached_read_pos + length > CAPACITY) {
+                    cached_read_pos = read_pos.load(std::memory_order_acquire);
+                    if (write - cached_read_pos + length > CAPACITY) {
+                        dropped.fetch_add(1, std::memory_order_relaxed);
+                        return false;
+                    }
+                }
+
+                size_t offset = write & (CAPACITY - 1);
+                size_t first = std::min(length, CAPACITY - offset);
+                std::memcpy(data.get() + offset, record, first);
+                std::memcpy(data.get(), record + first, length - first);
+                write_pos.store(write + length, std::memory_order_release);
+                return true;
+            }
+        };
+
+        ThreadBuffer& threadBuffer();
+        uint32_t registerSite(Site& site, const uint8_t* types, size_t count);
+
+        template<typename T>
+        size_t encodedSize(const T& value) {
+            constexpr ArgType type = argType<T>();
+            if constexpr (type == ARG_STRING) {
+                return 4 + std::string_view(value).size();
+            } else if constexpr (type == ARG_BOOL || type == ARG_CHAR) {
+                return 1;
+            } else {
+                (void)value;
+                return 8;
+            }
+        }
+
+        template<typename T>
+        uint8_t* encode(uint8_t* out, const T& value) {
+            constexpr ArgType type = argType<T>();
+            if constexpr (type == ARG_STRING) {
+                std::string_view view(value);
+                uint32_t length = static_cast<uint32_t>(view.size());
+                std::memcpy(out, &length, 4);
+                std::memcpy(out + 4, view.data(), view.size());
+                return out + 4 + view.size();
+            } else if constexpr (type == ARG_BOOL || type == ARG_CHAR) {
+                *out = static_cast<uint8_t>(value);
+                return out + 1;
+            } else if constexpr (type == ARG_DOUBLE) {
+                double v = static_cast<double>(value);
+                std::memcpy(out, &v, 8);
+                return out + 8;
+            } else if constexpr (type == ARG_INT64) {
+                int64_t v = static_cast<int64_t>(value);
+                std::memcpy(out, &v, 8);
+                return out + 8;
+            } else {
+                uint64_t v = static_cast<uint64_t>(value);
+                std::memcpy(out, &v, 8);
+                return out + 8;
+            }
+        }
+
+        template<typename... Args>
+        void write(Site& site, const Args&... args) {
+            static constexpr uint8_t types[sizeof...(Args) + 1] = {argType<Args>()..., 0};
+
+            uint32_t id = site.id.load(std::memory_order_acquire);
+            if (id == 0) {
+                id = registerSite(site, types, sizeof...(Args));
+            }
+
+            ThreadBuffer& buffer = threadBuffer();
+            uint32_t payload = static_cast<uint32_t>((size_t{0} + ... + encodedSize(args)));
+            size_t total = EVENT_HEADER_SIZE + payload;
+
+            uint8_t stack[256];
+            std::unique_ptr<uint8_t[]> heap;
+            uint8_t* record = stack;
+            if (total > sizeof(stack)) {
+                heap = std::make_unique<uint8_t[]>(total);
+                record = heap.get();
+            }
+
+            uint64_t tsc = readTsc();
+            record[0] = RECORD_EVENT;
+            std::memcpy(record + 1, &id, 4);
+            std::memcpy(record + 5, &tsc, 8);
+            std::memcpy(record + 13, &buffer.thread_id, 4);
+            std::memcpy(record + 17, &payload, 4);
+
+            uint8_t* out = record + EVENT_HEADER_SIZE;
+            ((out = encode(out, args)), ...);
+            (void)out;
+
+            buffer.push(record, total);
+        }
+    }
+
+    // Rotation et rétention, comme pour le journal texte. Chaque démarrage
+    // retire aussi le fichier de l'exécution précédente en segment horodaté.
+    struct BinaryLogOptions {
+        uint64_t max_file_bytes = 0;                    // 0 = pas de limite de taille
+        std::chrono::seconds rotate_interval{0};        // 0 = désactivée
+        LogRetention retention;
+    };
+
+    class BinaryLog {
+    private:
+        struct State;
+        std::unique_ptr<State> state_;
+        std::atomic<bool> open_;
+        std::atomic<LogLevel> min_level_;
+
+        BinaryLog();
+        void workerLoop();
+        bool drainOnce();
+        // Sous State::mutex
+        bool openSegment();
+        bool retireActiveFile();
+
+    public:
+        static BinaryLog& getInstance();
+        ~BinaryLog();
+
+        BinaryLog(const BinaryLog&) = delete;
+        BinaryLog& operator=(const BinaryLog&) = delete;
+
+        // Ouvre le fichier binaire et démarre le thread d'écriture
+        bool open(const std::string& path, const BinaryLogOptions& options = BinaryLogOptions{});
+        void close();
+
+        bool isOpen() const { return open_.load(std::memory_order_relaxed); }
+        bool enabled(LogLevel level) const { return level >= min_level_.load(std::memory_order_relaxed); }
+        void setLogLevel(LogLevel level) { min_level_.store(level, std::memory_order_relaxed); }
+
+        // Nouveaux sites à écrire (appelé par binlog::registerSite)
+        void addSite(uint32_t id, const binlog::Site& site, const uint8_t* types, size_t count);
+        void addThread(const std::shared_ptr<binlog::ThreadBuffer>& buffer);
+    };
+}
+
+// Journal structuré : binaire si BinaryLog est ouvert, texte via Logger sinon
+#define QLOG(level, format, ...) \
+    do { \
+        static_assert(QMark::binlog::countPlaceholders(format) == \
+                      decltype(QMark::binlog::arity(__VA_ARGS__))::value, \
+                      "QLOG placeholder count does not match argument count"); \
+        auto& qmark_binlog = QMark::BinaryLog::getInstance(); \
+        if (qmark_binlog.enabled(level)) { \
+            if (qmark_binlog.isOpen()) { \
+                static QMark::binlog::Site qmark_binlog_site{level, format, __FILE__, __LINE__}; \
+                QMark::binlog::write(qmark_binlog_site __VA_OPT__(,) __VA_ARGS__); \
+            } else { \
+                QMark::Logger::getInstance().log_formatted(level, format __VA_OPT__(,) __VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define QLOG_TRACE(format, ...) QLOG(QMark::LogLevel::TRACE, format __VA_OPT__(,) __VA_ARGS__)
+#define QLOG_DEBUG(format, ...) QLOG(QMark::LogLevel::DEBUG, format __VA_OPT__(,) __VA_ARGS__)
+#define QLOG_INFO(format, ...) QLOG(QMark::LogLevel::INFO, format __VA_OPT__(,) __VA_ARGS__)
+#define QLOG_WARN(format, ...) QLOG(QMark::LogLevel::WARN, format __VA_OPT__(,) __VA_ARGS__)
+#define QLOG_ERROR(format, ...) QLOG(QMark::LogLevel::ERROR, format __VA_OPT__(,) __VA_ARGS__)
+#define QLOG_FATAL(format, ...) QLOG(QMark::LogLevel::FATAL, format __VA_OPT__(,) __VA_ARGS__)
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "utils/json_reader.hpp"
+#include "utils/json_writer.hpp"
+#include "utils/reflection.hpp"
+#include <charconv>
+#include <string>
+#include <string_view>
+
+namespace QMark {
+
+    namespace json_codec {
+
+        template<typename V>
+        void writeValue(JsonWriter& writer, const V& value) {
+            if constexpr (std::is_same_v<V, qmark::Timestamp>) {
+                writer.value(reflect::toUnixSeconds(value));
+            } else {
+                writer.value(value);
+            }
+        }
+
+        // Conversion stricte : false si le type JSON ne correspond pas au membre
+        template<typename V>
+        bool readValue(const JsonReader::Value& value, V& out) {
+            if constexpr (std::is_same_v<V, bool>) {
+                return JsonReader::getBool(value, out);
+            } else if constexpr (std::is_same_v<V, std::string>) {
+                return JsonReader::getString(value, out);
+            } else if constexpr (std::is_floating_point_v<V>) {
+                double number;
+                if (!JsonReader::getDouble(value, number)) {
+                    return false;
+                }
+                out = static_cast<V>(number);
+                return true;
+            } else if constexpr (std::is_integral_v<V>) {
+                if (value.type != JsonType::INTEGER) {
+                    return false;
+                }
+                const char* end = value.raw.data() + value.raw.size();
+                auto result = std::from_chars(value.raw.data(), end, out);
+                return result.ec == std::errc() && result.ptr == end;
+            } else if constexpr (std::is_same_v<V, qmark::Timestamp>) {
+                int64_t seconds;
+                if (!JsonReader::getInt64(value, seconds)) {
+                    return false;
+                }
+                out = reflect::fromUnixSeconds(seconds);
+                return true;
+            } else {
+                static_assert(reflect::UNSUPPORTED_TYPE<V>, "no JSON mapping for this member type");
+            }
+        }
+
+        // Objet JSON des champs exposés, dans l'ordre de déclaration
+        template<reflect::Described T>
+        void write(JsonWriter& writer, const T& object) {
+            writer.beginObject();
+            reflect::forEachField<T>([&](const auto& field, auto) {
+                if (field.inJson()) {
+                    writer.key(field.name);
+                    writeValue(writer, field.get(object));
+                }
+            });
+            writer.endObject();
+        }
+
+        // Remplit `out` depuis un objet du document : clés inconnues ignorées,
+        // champs absents laissés intacts, false au premier type incompatible
+        template<reflect::Described T>
+        bool read(const JsonReader& reader, const JsonReader::Value& object, T& out) {
+            if (object.type != JsonType::OBJECT) {
+                return false;
+            }
+
+            bool ok = true;
+            std::string decoded_key;
+
+            reader.forEachMember(object, [&](std::string_view raw_key, const JsonReader::Value& value) {
+                if (!ok) {
+                    return;
+                }
+
+                std::string_view key = raw_key;
+                if (raw_key.find('\\') != std::string_view::npos) {
+                    decoded_key.clear();
+                    JsonReader::unescape(raw_key, decoded_key);
+                    key = decoded_key;
+                }
+
+                // Comparaisons déroulées sur les noms connus à la compilation
+                bool matched = false;
+                reflect::forEachField<T>([&](const auto& field, auto) {
+                    if (!matched && field.inJson() && key == field.name) {
+                        matched = true;
+                        ok = readValue(value, field.get(out));
+                    }
+                });
+            });
+
+            return ok;
+        }
+    }
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace QMark {
+
+    enum class JsonType : uint8_t {
+        NULL_VALUE = 1,
+        BOOLEAN = 2,
+        INTEGER = 4,
+        NUMBER = 8,         // nombre avec partie décimale ou exposant
+        STRING = 16,
+        ARRAY = 32,
+        OBJECT = 64
+    };
+
+    const char* jsonTypeName(JsonType type);
+
+    // Lecture JSON à la demande, façon simdjson : une passe SIMD indexe les
+    // caractères structurels (hors chaînes) et valide chaînes et UTF-8, une
+    // passe scalaire itérative sur cet index valide la grammaire et note où se
+    // ferme chaque conteneur, pour que les parcours sautent les sous-arbres.
+    // Aucun DOM : les valeurs restent des vues sur le texte d'origine,
+    // décodées seulement si demandé.
+    class JsonReader {
+    public:
+        static constexpr size_t MAX_DEPTH = 512;
+
+        struct Value {
+            JsonType type = JsonType::NULL_VALUE;
+            std::string_view raw;       // texte brut (chaînes : guillemets inclus)
+            uint32_t index = 0;         // indice structurel d'ouverture (objets, tableaux)
+        };
+
+        struct Member {
+            std::string_view key;       // clé brute, sans guillemets, non décodée
+            Value value;
+        };
+
+    private:
+        std::string_view input_;
+        std::vector<uint32_t> structurals_;     // positions ; au-delà de structural_count_, espace de travail
+        size_t structural_count_ = 0;
+        std::vector<uint32_t> closes_;          // indice structurel fermant de chaque conteneur, par indice ouvrant
+        std::vector<Member> fields_;
+        Value root_;
+        std::string error_;
+
+        bool fail(const std::string& message, size_t position);
+
+        static bool isWhitespace(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+        size_t skipWhitespace(size_t cursor) const {
+            while (cursor < input_.size() && isWhitespace(input_[cursor])) {
+                cursor++;
+            }
+            return cursor;
+        }
+
+        // [begin, end) sans le contrôle de bornes de substr : positions issues de l'index
+        std::string_view view(size_t begin, size_t end) const {
+            return std::string_view(input_.data() + begin, end - begin);
+        }
+
+        // Passe 2 : validation itérative (profondeur bornée) ; cursor finit après la racine
+        bool validateDocument(size_t& cursor);
+        // Parcours d'une valeur déjà validée, dans l'en-tête pour être intégré aux boucles des appelants
+        Value readValue(size_t& cursor, size_t& k) const;
+
+        template<typename OnItem>
+        void walkContainer(const Value& container, OnItem&& on_item) const;
+
+    public:
+        // Passe 1 exposée pour les benchmarks ; `out` ne fait que grandir, seuls
+        // les `count` premiers indices sont valides
+        static bool indexStructurals(std::string_view input, std::vector<uint32_t>& out, size_t& count,
+                                     std::string& error);
+
+        bool parse(std::string_view input);
+        const std::string& error() const { return error_; }
+
+        const Value& root() const { return root_; }
+
+        // Champs de premier niveau d'une racine objet, relevés pendant la validation
+        const std::vector<Member>& fields() const { return fields_; }
+        const Value* find(std::string_view key) const;
+
+        // Parcours à la demande d'un tableau ou d'un objet de ce document
+        template<typename Fn>
+        void forEachElement(const Value& array, Fn&& fn) const {
+            walkContainer(array, [&](std::string_view, const Value& value) { fn(value); });
+        }
+
+        template<typename Fn>
+        void forEachMember(const Value& object, Fn&& fn) const {
+            walkContainer(object, std::forward<Fn>(fn));
+        }
+
+        size_t elementCount(const Value& array) const;
+
+        // Conversions (false si le type ne correspond pas)
+        static bool getString(const Value& value, std::string& out);
+        static bool getInt64(const Value& value, int64_t& out);
+        static bool getDouble(const Value& value, double& out);
+        static bool getBool(const Value& value, bool& out);
+
+        // Décodage d'un contenu de chaîne validé (échappements, \u et paires de substitution)
+        static void unescape(std::string_view content, std::string& out);
+        static size_t codePointCount(const Value& string_value);
+        static bool keyEquals(std::string_view raw_key, std::string_view key);
+    };
+
+    inline JsonReader::Value JsonReader::readValue(size_t& cursor, size_t& k) const {
+        char c = input_[cursor];
+
+        if (c == '{' || c == '[') {
+            // Déjà validé : saut direct à l'indice fermant relevé par parse()
+            uint32_t open_index = static_cast<uint32_t>(k);
+            size_t start = cursor;
+            k = closes_[k] + 1;
+            cursor = structurals_[k - 1] + 1;
+            return Value{c == '{' ? JsonType::OBJECT : JsonType::ARRAY, view(start, cursor), open_index};
+        }
+
+        if (c == '"') {
+            size_t close = structurals_[k + 1];
+            k += 2;
+            Value value{JsonType::STRING, view(cursor, close + 1), 0};
+            cursor = close + 1;
+            return value;
+        }
+
+        // Scalaire : jusqu'au prochain caractère structurel, qui reste à l'indice k
+        size_t stop = k < structural_count_ ? structurals_[k] : input_.size();
+        while (stop > cursor && isWhitespace(input_[stop - 1])) {
+            stop--;
+        }
+        std::string_view text = view(cursor, stop);
+        cursor = stop;
+
+        if (c == 't' || c == 'f') {
+            return Value{JsonType::BOOLEAN, text, 0};
+        }
+        if (c == 'n') {
+            return Value{JsonType::NULL_VALUE, text, 0};
+        }
+        bool is_integer = true;
+        for (char digit : text) {
+            if (digit == '.' || digit == 'e' || digit == 'E') {
+                is_integer = false;
+                break;
+            }
+        }
+        return Value{is_integer ? JsonType::INTEGER : JsonType::NUMBER, text, 0};
+    }
+
+    template<typename OnItem>
+    void JsonReader::walkContainer(const Value& container, OnItem&& on_item) const {
+        if (container.type != JsonType::ARRAY && container.type != JsonType::OBJECT) {
+            return;
+        }
+
+        bool is_object = container.type == JsonType::OBJECT;
+        size_t k = container.index + 1;
+        if (k == closes_[container.index]) {
+            return;
+        }
+        size_t cursor = skipWhitespace(structurals_[container.index] + 1);
+
+        for (;;) {
+            std::string_view key;
+            if (is_object) {
+                size_t open = structurals_[k];
+                key = view(open + 1, structurals_[k + 1]);
+                cursor = skipWhitespace(structurals_[k + 2] + 1);
+                k += 3;     // guillemets de la clé et ':'
+            }
+
+            Value value = readValue(cursor, k);
+            on_item(key, value);
+
+            // k désigne maintenant la ',' ou le crochet fermant qui suit la valeur
+            size_t separator = structurals_[k];
+            if (input_[separator] != ',') {
+                return;
+            }
+            cursor = skipWhitespace(separator + 1);
+            k++;
+        }
+    }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "utils/json_reader.hpp"
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace QMark {
+
+    // Masques de types acceptés par une règle
+    namespace json_types {
+        constexpr uint32_t NULL_VALUE = static_cast<uint32_t>(JsonType::NULL_VALUE);
+        constexpr uint32_t BOOLEAN = static_cast<uint32_t>(JsonType::BOOLEAN);
+        constexpr uint32_t INTEGER = static_cast<uint32_t>(JsonType::INTEGER);
+        constexpr uint32_t NUMBER = static_cast<uint32_t>(JsonType::NUMBER) | INTEGER;
+        constexpr uint32_t STRING = static_cast<uint32_t>(JsonType::STRING);
+        constexpr uint32_t ARRAY = static_cast<uint32_t>(JsonType::ARRAY);
+        constexpr uint32_t OBJECT = static_cast<uint32_t>(JsonType::OBJECT);
+        constexpr uint32_t ANY = NULL_VALUE | BOOLEAN | NUMBER | STRING | ARRAY | OBJECT;
+    }
+
+    struct JsonFieldRule {
+        std::string name;
+        uint32_t types = json_types::ANY;
+        bool required = true;
+        size_t max_length = 0;      // chaînes : points de code, tableaux : éléments (0 = illimité)
+    };
+
+    // Schéma déclaratif d'un corps de requête objet, vérifié sur les champs
+    // relevés par JsonReader pendant sa passe de validation
+    class JsonSchema {
+    private:
+        std::vector<JsonFieldRule> rules_;
+        bool allow_unknown_fields_;
+
+    public:
+        JsonSchema(std::initializer_list<JsonFieldRule> rules, bool allow_unknown_fields = true);
+
+        // Une entrée par violation, ex. "name: expected string, got integer"
+        bool validate(const JsonReader& reader, std::vector<std::string>& errors) const;
+
+        const std::vector<JsonFieldRule>& rules() const { return rules_; }
+    };
+}
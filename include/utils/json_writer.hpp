@@ -0,0 +1,209 @@
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace QMark {
+
+    // Encodage de sortie : même modèle de données, texte ou binaire
+    enum class WireFormat : uint8_t {
+        JSON,
+        MSGPACK,
+        CBOR
+    };
+
+    // Écriture JSON en flux, sans DOM : directement dans un tampon réutilisable
+    // ou, au-delà de flush_bytes, vers un puits (réponse HTTP chunked).
+    // Les mêmes appels produisent du MessagePack ou du CBOR selon `format`.
+    class JsonWriter {
+    public:
+        using Sink = std::function<bool(const char* data, size_t length)>;
+        static constexpr size_t MAX_DEPTH = 64;
+
+    private:
+        std::string& out_;
+        Sink sink_;
+        size_t flush_bytes_;
+        WireFormat format_;
+        bool sink_failed_ = false;
+        bool after_key_ = false;
+        uint32_t depth_ = 0;
+        std::array<uint32_t, MAX_DEPTH> items_{};       // éléments (ou paires) écrits par conteneur ouvert
+        std::array<size_t, MAX_DEPTH> header_at_{};     // MessagePack : en-tête à compléter à la fermeture
+
+        void separator() {
+            if (after_key_) {
+                after_key_ = false;
+                return;
+            }
+            if (depth_ > 0 && items_[depth_ - 1]++ != 0 && format_ == WireFormat::JSON) {
+                out_ += ',';
+            }
+        }
+
+        void open(bool object) {
+            separator();
+            if (depth_ >= MAX_DEPTH) {
+                throw std::runtime_error("JSON nesting too deep");
+            }
+            if (format_ == WireFormat::JSON) {
+                out_ += object ? '{' : '[';
+            } else {
+                openBinary(object);
+            }
+            items_[depth_++] = 0;
+        }
+
+        void close(bool object) {
+            depth_--;
+            if (format_ == WireFormat::JSON) {
+                out_ += object ? '}' : ']';
+            } else {
+                closeBinary(object);
+            }
+            if (sink_ && out_.size() >= flush_bytes_) {
+                flush();
+            }
+        }
+
+        void writeEscaped(std::string_view text);
+
+        // Encodages binaires (json_writer.cpp)
+        void openBinary(bool object);
+        void closeBinary(bool object);
+        void writeBinaryString(std::string_view text);
+        void writeBinaryBool(bool flag);
+        void writeBinaryNull();
+        void writeBinaryInt(int64_t number);
+        void writeBinaryUint(uint64_t number);
+        void writeBinaryDouble(double number);
+        void writeTranscoded(std::string_view json);
+
+    public:
+        explicit JsonWriter(std::string& out, WireFormat format = WireFormat::JSON);
+        JsonWriter(std::string& out, Sink sink, size_t flush_bytes = 16 * 1024,
+                   WireFormat format = WireFormat::JSON);
+
+        // Tampon du thread, vidé mais avec sa capacité conservée
+        static std::string& threadBuffer();
+
+        WireFormat format() const { return format_; }
+
+        // Structure
+        JsonWriter& beginObject() { open(true); return *this; }
+        JsonWriter& endObject() { close(true); return *this; }
+        JsonWriter& beginArray() { open(false); return *this; }
+        JsonWriter& endArray() { close(false); return *this; }
+
+        JsonWriter& key(std::string_view name) {
+            separator();
+            if (format_ == WireFormat::JSON) {
+                writeEscaped(name);
+                out_ += ':';
+            } else {
+                writeBinaryString(name);
+            }
+            after_key_ = true;
+            return *this;
+        }
+
+        // Valeurs
+        JsonWriter& value(std::string_view text) {
+            separator();
+            if (format_ == WireFormat::JSON) {
+                writeEscaped(text);
+            } else {
+                writeBinaryString(text);
+            }
+            return *this;
+        }
+        JsonWriter& value(const char* text) { return value(std::string_view(text)); }
+        JsonWriter& value(const std::string& text) { return value(std::string_view(text)); }
+
+        JsonWriter& value(bool flag) {
+            separator();
+            if (format_ == WireFormat::JSON) {
+                out_ += flag ? "true" : "false";
+            } else {
+                writeBinaryBool(flag);
+            }
+            return *this;
+        }
+
+        template<typename T>
+            requires (std::is_integral_v<T> && !std::is_same_v<T, bool>)
+        JsonWriter& value(T number) {
+            separator();
+            if (format_ != WireFormat::JSON) {
+                if constexpr (std::is_signed_v<T>) {
+                    writeBinaryInt(static_cast<int64_t>(number));
+                } else {
+                    writeBinaryUint(static_cast<uint64_t>(number));
+                }
+                return *this;
+            }
+            char buffer[24];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+            out_.append(buffer, static_cast<size_t>(result.ptr - buffer));
+            return *this;
+        }
+
+        template<typename T>
+            requires std::is_floating_point_v<T>
+        JsonWriter& value(T number) {
+            if (!std::isfinite(number)) {
+                return null();
+            }
+            separator();
+            if (format_ != WireFormat::JSON) {
+                writeBinaryDouble(static_cast<double>(number));
+                return *this;
+            }
+            // Shortest representation that round-trips
+            char buffer[32];
+            auto result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+            out_.append(buffer, static_cast<size_t>(result.ptr - buffer));
+            return *this;
+        }
+
+        JsonWriter& null() {
+            separator();
+            if (format_ == WireFormat::JSON) {
+                out_ += "null";
+            } else {
+                writeBinaryNull();
+            }
+            return *this;
+        }
+
+        // Fragment JSON déjà sérialisé : inséré tel quel, ou transcodé en binaire
+        JsonWriter& raw(std::string_view json) {
+            if (format_ != WireFormat::JSON) {
+                writeTranscoded(json);
+                return *this;
+            }
+            separator();
+            out_.append(json);
+            return *this;
+        }
+
+        template<typename T>
+        JsonWriter& field(std::string_view name, const T& v) {
+            key(name);
+            return value(v);
+        }
+
+        // Envoie le contenu du tampon au puits (sans effet sans puits, ni en
+        // MessagePack tant qu'un conteneur attend son nombre d'éléments)
+        void flush();
+        bool ok() const { return !sink_failed_; }
+        const std::string& str() const { return out_; }
+    };
+}
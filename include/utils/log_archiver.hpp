@@ -0,0 +1,53 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace QMark {
+
+    struct LogRetention {
+        size_t max_files = 10;                                    // 0 = illimité
+        std::chrono::hours max_age{std::chrono::hours(24 * 14)};  // 0 = illimité
+        bool compress = true;
+    };
+
+    // Compression gzip et rétention des segments de journal retirés, sur un
+    // thread de basse priorité : le thread d'écriture du Logger ne fait que
+    // renommer le fichier et lui confier le segment.
+    class LogArchiver {
+    private:
+        std::string active_path_;
+        LogRetention retention_;
+        std::deque<std::string> pending_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::thread worker_thread_;
+        bool should_stop_;
+
+        void workerLoop();
+        bool compress(const std::string& segment_path);
+        void applyRetention();
+
+    public:
+        LogArchiver();
+        ~LogArchiver();
+
+        LogArchiver(const LogArchiver&) = delete;
+        LogArchiver& operator=(const LogArchiver&) = delete;
+
+        void configure(const std::string& active_path, const LogRetention& retention);
+        void submit(const std::string& segment_path);
+        void stop();
+
+        // Nom libre « <actif>.AAAAMMJJ-HHMMSS[-n] » pour le segment retiré
+        static std::string segmentPath(const std::string& active_path);
+        // Prochain multiple de l'intervalle sur l'horloge locale : les fichiers
+        // quotidiens basculent à minuit quelle que soit l'heure de démarrage
+        static std::chrono::system_clock::time_point nextBoundary(std::chrono::system_clock::time_point now,
+                                                                  std::chrono::seconds interval);
+    };
+}
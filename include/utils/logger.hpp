@@ -1,4 +1,3 @@
-
 #pragma once
 
 #include <string>
@@ -8,11 +7,12 @@
 #include <sstream>
 #include <chrono>
 #include <thread>
-#include <queue>
+#include <atomic>
 #include <condition_variable>
+#include "utils/log_archiver.hpp"
+
+namespace QMark {
 
-namespace qmark::utils {
-    
     enum class LogLevel {
         TRACE = 0,
         DEBUG = 1,
@@ -21,134 +21,143 @@ namespace qmark::utils {
         ERROR = 4,
         FATAL = 5
     };
-    
-    struct LogEntry {
-        LogLevel level;
-        std::chrono::system_clock::time_point timestamp;
-        std::thread::id thread_id;
-        std::string file;
-        int line;
-        std::string function;
-        std::string message;
+
+    // Comportement quand l'anneau est plein
+    enum class OverflowPolicy {
+        BLOCK,   // le producteur attend qu'une case se libère
+        DROP,    // le message est compté puis abandonné
+        SAMPLE   // un message sur sample_every est conservé (en attendant), les autres abandonnés
     };
-    
+
+    struct LoggerOptions {
+        OverflowPolicy overflow_policy = OverflowPolicy::BLOCK;
+        uint64_t sample_every = 100;
+        bool console_output = true;
+        size_t batch_bytes = 64 * 1024;
+
+        // Rotation faite par le thread d'écriture (0 = désactivée)
+        uint64_t max_file_bytes = 0;
+        std::chrono::seconds rotate_interval{0};       // aligné sur l'horloge locale : 24 h bascule à minuit
+        LogRetention retention;
+    };
+
+    // Journal asynchrone : les producteurs réservent sans verrou une case
+    // d'un anneau borné (file MPSC de Vyukov), un unique thread consommateur
+    // formate et écrit par gros lots dans un fichier gardé ouvert.
     class Logger {
+    public:
+        static constexpr size_t QUEUE_CAPACITY = 8192;  // puissance de 2
+
     private:
-        LogLevel min_level_;
-        bool console_output_;
-        bool file_output_;
-        std::string log_file_path_;
+        struct Slot {
+            std::atomic<size_t> sequence;
+            LogLevel level;
+            std::chrono::system_clock::time_point timestamp;
+            std::string message;
+        };
+
+        std::atomic<LogLevel> log_level_;
+        LoggerOptions options_;                         // sous mutex_ (thread consommateur, init)
+        // Lus par les producteurs sans verrou : publiés à part par init()
+        std::atomic<OverflowPolicy> overflow_policy_;
+        std::atomic<uint64_t> sample_every_;
+        std::string log_file_;
         std::unique_ptr<std::ofstream> file_stream_;
-        mutable std::mutex log_mutex_;
-        
-        // Threading pour logging asynchrone
+        mutable std::mutex mutex_;
+
+        // Rotation (thread consommateur uniquement)
+        uint64_t current_file_bytes_;
+        std::chrono::system_clock::time_point next_rotation_;
+        LogArchiver archiver_;
+
+        // Anneau borné
+        std::unique_ptr<Slot[]> ring_;
+        alignas(64) std::atomic<size_t> enqueue_pos_;
+        alignas(64) std::atomic<size_t> dequeue_pos_;
+        alignas(64) std::atomic<uint64_t> dropped_;
+        std::atomic<uint64_t> overflow_count_;
+        uint64_t reported_dropped_;
+
+        // Thread consommateur
         std::thread worker_thread_;
-        std::queue<LogEntry> log_queue_;
         std::mutex queue_mutex_;
         std::condition_variable queue_cv_;
+        std::condition_variable flushed_cv_;
+        std::atomic<bool> consumer_waiting_;
         std::atomic<bool> should_stop_;
-        
+        std::atomic<size_t> written_pos_;
+
+        Logger();
+
         // Méthodes privées
-        void worker_loop();
-        void write_entry(const LogEntry& entry);
-        std::string format_entry(const LogEntry& entry);
-        std::string level_to_string(LogLevel level);
-        std::string format_timestamp(const std::chrono::system_clock::time_point& tp);
-        
+        bool tryEnqueue(LogLevel level, std::chrono::system_clock::time_point timestamp, const std::string& message);
+        void enqueue(LogLevel level, const std::string& message);
+        void writeDirect(LogLevel level, std::chrono::system_clock::time_point timestamp, const std::string& message);
+        void workerLoop();
+        size_t drain();
+        bool rotationDue(size_t pending_bytes) const;
+        void rotateFile();
+        static std::string levelToString(LogLevel level);
+
     public:
-        Logger();
-        explicit Logger(LogLevel min_level);
+        static Logger& getInstance();
         ~Logger();
-        
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
         // Configuration
-        void set_min_level(LogLevel level);
-        LogLevel get_min_level() const;
-        void enable_console_output(bool enable = true);
-        void enable_file_output(const std::string& file_path);
-        void disable_file_output();
-        
+        void init(const std::string& log_file, const LoggerOptions& options = LoggerOptions{});
+        void setLogLevel(LogLevel level);
+        LogLevel getLogLevel() const;
+
         // Logging principal
-        void log(LogLevel level, 
-                const std::string& file,
-                int line,
-                const std::string& function,
-                const std::string& message);
-        
+        void log(LogLevel level, const std::string& message);
+
         template<typename... Args>
-        void log_formatted(LogLevel level,
-                          const std::string& file,
-                          int line, 
-                          const std::string& function,
-                          const std::string& format,
-                          Args&&... args) {
-            if (level < min_level_) return;
-            
+        void log_formatted(LogLevel level, const std::string& format, Args&&... args) {
+            if (level < log_level_.load(std::memory_order_relaxed)) return;
+
             std::ostringstream oss;
             format_message(oss, format, std::forward<Args>(args)...);
-            log(level, file, line, function, oss.str());
+            log(level, oss.str());
         }
-        
+
         // Méthodes de convenance
-        void trace(const std::string& message);
-        void debug(const std::string& message);
-        void info(const std::string& message);
-        void warn(const std::string& message);
-        void error(const std::string& message);
-        void fatal(const std::string& message);
-        
+        static void trace(const std::string& message);
+        static void debug(const std::string& message);
+        static void info(const std::string& message);
+        static void warn(const std::string& message);
+        static void error(const std::string& message);
+        static void fatal(const std::string& message);
+
         // Contrôle
         void flush();
         void shutdown();
-        
+        uint64_t getDroppedCount() const;
+
     private:
-        template<typename T>
-        void format_message(std::ostringstream& oss, const std::string& format, T&& value) {
-            size_t pos = format.find("{}");
-            if (pos != std::string::npos) {
-                oss << format.substr(0, pos) << std::forward<T>(value) << format.substr(pos + 2);
-            } else {
-                oss << format;
-            }
+        void format_message(std::ostringstream& oss, const std::string& format) {
+            oss << format;
         }
-        
+
         template<typename T, typename... Args>
         void format_message(std::ostringstream& oss, const std::string& format, T&& value, Args&&... args) {
             size_t pos = format.find("{}");
             if (pos != std::string::npos) {
-                std::string remaining = format.substr(0, pos) + std::to_string(value) + format.substr(pos + 2);
-                format_message(oss, remaining, std::forward<Args>(args)...);
+                oss << format.substr(0, pos) << std::forward<T>(value);
+                format_message(oss, format.substr(pos + 2), std::forward<Args>(args)...);
             } else {
                 oss << format;
             }
         }
     };
-    
-    // Singleton global
-    class GlobalLogger {
-    private:
-        static std::unique_ptr<Logger> instance_;
-        static std::mutex instance_mutex_;
-        
-    public:
-        static Logger& get_instance();
-        static void initialize(LogLevel min_level = LogLevel::INFO, 
-                             bool console = true,
-                             const std::string& file_path = "");
-        static void shutdown();
-    };
 }
 
 // Macros pour faciliter l'utilisation
-#define LOG_TRACE(msg) qmark::utils::GlobalLogger::get_instance().log(qmark::utils::LogLevel::TRACE, __FILE__, __LINE__, __FUNCTION__, msg)
-#define LOG_DEBUG(msg) qmark::utils::GlobalLogger::get_instance().log(qmark::utils::LogLevel::DEBUG, __FILE__, __LINE__, __FUNCTION__, msg)
-#define LOG_INFO(msg) qmark::utils::GlobalLogger::get_instance().log(qmark::utils::LogLevel::INFO, __FILE__, __LINE__, __FUNCTION__, msg)
-#define LOG_WARN(msg) qmark::utils::GlobalLogger::get_instance().log(qmark::utils::LogLevel::WARN, __FILE__, __LINE__, __FUNCTION__, msg)
-#define LOG_ERROR(msg) qmark::utils::GlobalLogger::get_instance().log(qmark::utils::LogLevel::ERROR, __FILE__, __LINE__, __FUNCTION__, msg)
-#define LOG_FATAL(msg) qmark::utils::GlobalLogger::get_instance().log(qmark::utils::LogLevel::FATAL, __FILE__, __LINE__, __FUNCTION__, msg)
-
-#define LOG_TRACE_F(fmt, ...) qmark::utils::GlobalLogger::get_instance().log_formatted(qmark::utils::LogLevel::TRACE, __FILE__, __LINE__, __FUNCTION__, fmt, __VA_ARGS__)
-#define LOG_DEBUG_F(fmt, ...) qmark::utils::GlobalLogger::get_instance().log_formatted(qmark::utils::LogLevel::DEBUG, __FILE__, __LINE__, __FUNCTION__, fmt, __VA_ARGS__)
-#define LOG_INFO_F(fmt, ...) qmark::utils::GlobalLogger::get_instance().log_formatted(qmark::utils::LogLevel::INFO, __FILE__, __LINE__, __FUNCTION__, fmt, __VA_ARGS__)
-#define LOG_WARN_F(fmt, ...) qmark::utils::GlobalLogger::get_instance().log_formatted(qmark::utils::LogLevel::WARN, __FILE__, __LINE__, __FUNCTION__, fmt, __VA_ARGS__)
-#define LOG_ERROR_F(fmt, ...) qmark::utils::GlobalLogger::get_instance().log_formatted(qmark::utils::LogLevel::ERROR, __FILE__, __LINE__, __FUNCTION__, fmt, __VA_ARGS__)
-#define LOG_FATAL_F(fmt, ...) qmark::utils::GlobalLogger::get_instance().log_formatted(qmark::utils::LogLevel::FATAL, __FILE__, __LINE__, __FUNCTION__, fmt, __VA_ARGS__)
+#define LOG_TRACE_F(fmt, ...) QMark::Logger::getInstance().log_formatted(QMark::LogLevel::TRACE, fmt, __VA_ARGS__)
+#define LOG_DEBUG_F(fmt, ...) QMark::Logger::getInstance().log_formatted(QMark::LogLevel::DEBUG, fmt, __VA_ARGS__)
+#define LOG_INFO_F(fmt, ...) QMark::Logger::getInstance().log_formatted(QMark::LogLevel::INFO, fmt, __VA_ARGS__)
+#define LOG_WARN_F(fmt, ...) QMark::Logger::getInstance().log_formatted(QMark::LogLevel::WARN, fmt, __VA_ARGS__)
+#define LOG_ERROR_F(fmt, ...) QMark::Logger::getInstance().log_formatted(QMark::LogLevel::ERROR, fmt, __VA_ARGS__)
+#define LOG_FATAL_F(fmt, ...) QMark::Logger::getInstance().log_formatted(QMark::LogLevel::FATAL, fmt, __VA_ARGS__)
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace QMark {
+
+    namespace metrics {
+        constexpr size_t MAX_ROUTES = 64;       // route 0 = "other" (débordement)
+        constexpr size_t MAX_COUNTERS = 64;
+        constexpr size_t STATUS_CLASSES = 5;    // 1xx .. 5xx
+
+        // Histogramme log-linéaire façon HDR : 8 sous-intervalles par puissance
+        // de 2 (erreur relative <= 12,5 %), en microsecondes, de 1 µs à ~2^33 µs
+        constexpr unsigned SUB_BUCKET_BITS = 3;
+        constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;
+        constexpr size_t MAGNITUDES = 32;
+        constexpr size_t HISTOGRAM_BUCKETS = MAGNITUDES * SUB_BUCKETS;
+
+        size_t bucketIndex(uint64_t micros);
+        uint64_t bucketUpperBound(size_t index);    // borne exclusive, en µs
+
+        // Un seul écrivain (le thread propriétaire) : load + store relâchés,
+        // sans instruction verrouillée sur le chemin des requêtes
+        inline void bump(std::atomic<uint64_t>& cell, uint64_t delta = 1) {
+            cell.store(cell.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+        }
+
+        struct RouteStats {
+            std::array<std::atomic<uint64_t>, STATUS_CLASSES> requests{};
+            std::atomic<uint64_t> latency_sum_us{0};
+            std::array<std::atomic<uint64_t>, HISTOGRAM_BUCKETS> buckets{};
+        };
+
+        // Compteurs d'un thread, fusionnés uniquement au moment du scrape
+        struct ThreadShard {
+            std::array<std::atomic<RouteStats*>, MAX_ROUTES> routes{};
+            std::array<std::atomic<uint64_t>, MAX_COUNTERS> counters{};
+            std::unordered_map<std::string, uint32_t> route_cache;   // thread propriétaire uniquement
+            std::string route_key;                                    // tampon de la clé, réutilisé
+
+            ~ThreadShard();
+            RouteStats& route(uint32_t id);
+        };
+
+        ThreadShard& threadShard();
+    }
+
+    enum class MetricType {
+        COUNTER,
+        GAUGE
+    };
+
+    // Registre des métriques exposées au format texte Prometheus
+    class MetricsRegistry {
+    private:
+        struct CounterInfo {
+            std::string name;
+            std::string help;
+        };
+
+        struct RouteInfo {
+            std::string method;
+            std::string pattern;
+        };
+
+        struct CallbackInfo {
+            std::string name;
+            std::string help;
+            MetricType type;
+            std::function<double()> read;
+        };
+
+        mutable std::mutex mutex_;
+        std::vector<metrics::ThreadShard*> shards_;
+        std::unique_ptr<metrics::ThreadShard> retired_;     // totaux des threads terminés
+        std::vector<CounterInfo> counters_;
+        std::vector<RouteInfo> routes_;
+        std::unordered_map<std::string, uint32_t> route_ids_;
+        std::vector<CallbackInfo> callbacks_;
+
+        MetricsRegistry();
+
+        uint32_t resolveRoute(const std::string& key, const std::string& method, const std::string& pattern);
+
+    public:
+        static MetricsRegistry& getInstance();
+        ~MetricsRegistry();
+
+        MetricsRegistry(const MetricsRegistry&) = delete;
+        MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+        // Enregistrement (idempotent par nom)
+        uint32_t registerCounter(const std::string& name, const std::string& help);
+        void registerCallback(const std::string& name, const std::string& help, MetricType type,
+                              std::function<double()> read);
+        void removeCallback(const std::string& name);
+
+        // Chemin chaud : aucun verrou partagé une fois la route connue du thread
+        void increment(uint32_t counter_id, uint64_t delta = 1);
+        void recordRequest(const std::string& method, const std::string& route, int status, uint64_t micros);
+
+        // Cycle de vie des shards par thread
+        void addShard(metrics::ThreadShard* shard);
+        void retireShard(metrics::ThreadShard* shard);
+
+        // Scrape
+        uint64_t requestsTotal() const;
+        std::string renderPrometheus() const;
+    };
+}
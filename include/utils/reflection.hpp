@@ -0,0 +1,83 @@
+#pragma once
+
+#include "qmark.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace QMark {
+
+    namespace reflect {
+
+        enum FieldFlags : uint8_t {
+            NONE = 0,
+            NOT_JSON = 1,       // jamais exposé ni lu en JSON (secrets)
+            NOT_STORED = 2,     // pas de colonne SQLite correspondante
+            PRIMARY_KEY = 4     // clé auto-incrémentée : NULL à l'insertion tant qu'elle vaut 0
+        };
+
+        // Descripteur constexpr d'un membre : nom (clé JSON et colonne SQLite) et pointeur
+        template<typename Class, typename Member>
+        struct Field {
+            using class_type = Class;
+            using member_type = Member;
+
+            std::string_view name;
+            Member Class::* pointer;
+            uint8_t flags = NONE;
+
+            constexpr bool inJson() const { return (flags & NOT_JSON) == 0; }
+            constexpr bool stored() const { return (flags & NOT_STORED) == 0; }
+            constexpr bool primaryKey() const { return (flags & PRIMARY_KEY) != 0; }
+
+            constexpr const Member& get(const Class& object) const { return object.*pointer; }
+            constexpr Member& get(Class& object) const { return object.*pointer; }
+        };
+
+        template<typename Class, typename Member>
+        constexpr Field<Class, Member> field(std::string_view name, Member Class::* pointer, uint8_t flags = NONE) {
+            return {name, pointer, flags};
+        }
+
+        // Spécialisée pour chaque structure décrite :
+        //   static constexpr auto fields = std::make_tuple(field(...), ...);
+        //   static constexpr std::string_view table = "...";   (optionnel, table SQLite)
+        template<typename T>
+        struct Describe;
+
+        template<typename T>
+        concept Described = requires { Describe<T>::fields; };
+
+        template<typename T>
+        concept Stored = Described<T> && requires { Describe<T>::table; };
+
+        template<Described T>
+        constexpr size_t fieldCount() {
+            return std::tuple_size_v<std::remove_cvref_t<decltype(Describe<T>::fields)>>;
+        }
+
+        // fn(field, index) pour chaque champ, dans l'ordre de déclaration, déroulé à la compilation
+        template<Described T, typename Fn>
+        constexpr void forEachField(Fn&& fn) {
+            [&]<size_t... I>(std::index_sequence<I...>) {
+                (fn(std::get<I>(Describe<T>::fields), std::integral_constant<size_t, I>{}), ...);
+            }(std::make_index_sequence<fieldCount<T>()>{});
+        }
+
+        // Les horodatages voyagent en secondes Unix (JSON comme SQLite)
+        inline int64_t toUnixSeconds(const qmark::Timestamp& timestamp) {
+            return std::chrono::duration_cast<std::chrono::seconds>(timestamp.time_since_epoch()).count();
+        }
+
+        inline qmark::Timestamp fromUnixSeconds(int64_t seconds) {
+            return qmark::Timestamp(std::chrono::seconds(seconds));
+        }
+
+        template<typename>
+        inline constexpr bool UNSUPPORTED_TYPE = false;
+    }
+}
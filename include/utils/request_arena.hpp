@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+namespace QMark {
+
+    // Mémoire d'une requête : un bloc monotone par thread de travail, libéré
+    // d'un coup en fin de requête et réutilisé par la suivante. Les objets
+    // temporaires de la requête (en-têtes de réponse, noms, chaînes pmr) y
+    // sont découpés sans appel à l'allocateur global. Un dépassement passe
+    // par l'allocateur global puis agrandit le bloc (jusqu'à MAX_BLOCK_BYTES)
+    // pour les requêtes suivantes. Rien d'alloué ici ne survit à reset().
+    class RequestArena {
+    public:
+        static constexpr size_t INITIAL_BLOCK_BYTES = 16 * 1024;
+        static constexpr size_t MAX_BLOCK_BYTES = 1024 * 1024;
+
+    private:
+        // Allocateur global, en comptant ce qui déborde du bloc
+        class OverflowResource final : public std::pmr::memory_resource {
+        public:
+            size_t bytes = 0;
+
+        private:
+            void* do_allocate(size_t size, size_t alignment) override;
+            void do_deallocate(void* pointer, size_t size, size_t alignment) override;
+            bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+        };
+
+        std::unique_ptr<std::byte[]> block_;
+        size_t block_bytes_ = 0;
+        OverflowResource overflow_;
+        std::optional<std::pmr::monotonic_buffer_resource> resource_;
+
+        RequestArena();
+
+    public:
+        // Arène du thread appelant
+        static RequestArena& local();
+        static std::pmr::memory_resource* resource() { return &*local().resource_; }
+
+        // Fin de requête : tout ce qui a été alloué depuis le précédent reset() est rendu
+        void reset();
+
+        size_t blockBytes() const { return block_bytes_; }
+    };
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <zlib.h>
+
+namespace QMark {
+
+    // Instantané binaire d'un cache en mémoire : en-tête fixe (magie, type
+    // sur 4 octets, version du format, jeton, date d'écriture, taille et
+    // crc32 du corps) suivi du corps. Écrit dans un fichier temporaire puis
+    // renommé ; relu par mmap et vérifié en entier avant usage. Un type, une
+    // version ou un crc inattendus rendent l'instantané inutilisable : le
+    // cache repart alors de SQLite.
+    struct SnapshotInfo {
+        uint32_t version = 0;
+        uint64_t token = 0;             // propre au cache (0 : aucun)
+        int64_t written_at = 0;         // secondes Unix
+        size_t body_bytes = 0;
+    };
+
+    class SnapshotWriter {
+    private:
+        std::string path_;
+        std::string temporary_;
+        std::FILE* file_ = nullptr;
+        char kind_[4];
+        uint32_t version_;
+        uint64_t token_;
+        uint64_t body_bytes_ = 0;
+        uLong crc_;
+        bool ok_ = true;
+        bool committed_ = false;
+
+    public:
+        // kind : quatre caractères, ex. "SESS"
+        SnapshotWriter(std::string path, const char* kind, uint32_t version, uint64_t token = 0);
+        ~SnapshotWriter();
+
+        SnapshotWriter(const SnapshotWriter&) = delete;
+        SnapshotWriter& operator=(const SnapshotWriter&) = delete;
+
+        bool ok() const { return ok_; }
+
+        void write(const void* data, size_t length);
+
+        template<typename T>
+        void put(const T& value) {
+            write(&value, sizeof(T));
+        }
+
+        // u32 longueur puis octets
+        void putString(std::string_view value);
+
+        // En-tête complété, fdatasync puis renommage atomique ; faux en cas d'erreur
+        bool commit();
+        size_t bytes() const { return static_cast<size_t>(body_bytes_); }
+    };
+
+    class SnapshotReader {
+    private:
+        void* mapping_ = nullptr;
+        size_t mapped_bytes_ = 0;
+        SnapshotInfo info_;
+        const char* cursor_ = nullptr;
+        const char* end_ = nullptr;
+
+    public:
+        SnapshotReader() = default;
+        ~SnapshotReader();
+
+        SnapshotReader(const SnapshotReader&) = delete;
+        SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+        // Faux (avec un avertissement) si le fichier manque, n'est pas du
+        // type ou de la version attendus, ou si le crc ne correspond pas
+        bool open(const std::string& path, const char* kind, uint32_t version);
+
+        const SnapshotInfo& info() const { return info_; }
+        size_t remaining() const { return static_cast<size_t>(end_ - cursor_); }
+
+        bool take(void* out, size_t length);
+
+        template<typename T>
+        bool get(T& value) {
+            return take(&value, sizeof(T));
+        }
+
+        bool getString(std::string& value);
+
+        // Octets lus en place dans la projection (valides jusqu'à la destruction)
+        const char* view(size_t length);
+    };
+}
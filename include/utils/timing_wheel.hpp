@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace QMark {
+
+    // Roue temporelle hiérarchique (Varghese & Lauck) : insertion et
+    // expiration en O(1) amorti. Le temps est exprimé en ticks abstraits,
+    // l'appelant choisit la résolution (1 s pour les sessions, etc.).
+    //
+    // Les annulations sont paresseuses : l'appelant vérifie au déclenchement
+    // que l'élément est toujours valide (génération, échéance réelle...).
+    template<typename T>
+    class TimingWheel {
+    private:
+        static constexpr unsigned LEVEL_BITS = 6;
+        static constexpr size_t SLOTS = size_t{1} << LEVEL_BITS;
+        static constexpr uint64_t SLOT_MASK = SLOTS - 1;
+        static constexpr size_t LEVELS = 4;
+        static constexpr uint64_t SPAN = uint64_t{1} << (LEVEL_BITS * LEVELS);
+
+        struct Entry {
+            uint64_t deadline;
+            T value;
+        };
+
+        using Slot = std::vector<Entry>;
+
+        std::array<std::array<Slot, SLOTS>, LEVELS> levels_;
+        std::vector<Entry> overflow_;
+        uint64_t current_tick_;
+        size_t size_;
+
+        // earliest : current_tick_ + 1 pour une insertion (le tick courant est
+        // déjà traité), current_tick_ pendant une cascade (son emplacement de
+        // niveau 0 va l'être juste après)
+        void place(Entry&& entry, uint64_t earliest) {
+            if (entry.deadline < earliest) {
+                entry.deadline = earliest;
+            }
+
+            uint64_t delta = entry.deadline - current_tick_;
+            for (size_t level = 0; level < LEVELS; ++level) {
+                if (delta < (uint64_t{1} << (LEVEL_BITS * (level + 1)))) {
+                    size_t slot = (entry.deadline >> (LEVEL_BITS * level)) & SLOT_MASK;
+                    levels_[level][slot].push_back(std::move(entry));
+                    return;
+                }
+            }
+
+            overflow_.push_back(std::move(entry));
+        }
+
+        void cascade(size_t level, size_t slot) {
+            Slot pending;
+            pending.swap(levels_[level][slot]);
+            for (auto& entry : pending) {
+                place(std::move(entry), current_tick_);
+            }
+        }
+
+    public:
+        explicit TimingWheel(uint64_t start_tick = 0)
+            : current_tick_(start_tick), size_(0) {}
+
+        uint64_t current_tick() const { return current_tick_; }
+        size_t size() const { return size_; }
+        bool empty() const { return size_ == 0; }
+
+        void schedule(T value, uint64_t deadline_tick) {
+            place(Entry{deadline_tick, std::move(value)}, current_tick_ + 1);
+            ++size_;
+        }
+
+        // Premier tick où advance() peut avoir du travail : la plus proche
+        // entre l'échéance exacte au niveau 0 et la prochaine cascade d'un
+        // emplacement non vide (borne inférieure). UINT64_MAX si la roue est vide. Permet de dormir entre
+        // deux échéances au lieu de réveiller le thread à chaque tick.
+        uint64_t nextWakeTick() const {
+            if (size_ == 0) {
+                return UINT64_MAX;
+            }
+
+            uint64_t wake = UINT64_MAX;
+            for (uint64_t tick = current_tick_ + 1; tick <= current_tick_ + SLOTS; ++tick) {
+                if (!levels_[0][tick & SLOT_MASK].empty()) {
+                    wake = tick;
+                    break;
+                }
+            }
+
+            for (size_t level = 1; level < LEVELS; ++level) {
+                unsigned shift = static_cast<unsigned>(LEVEL_BITS * level);
+                uint64_t unit = (current_tick_ >> shift) + 1;
+                for (uint64_t k = 0; k < SLOTS; ++k) {
+                    if (!levels_[level][(unit + k) & SLOT_MASK].empty()) {
+                        wake = std::min(wake, (unit + k) << shift);
+                        break;
+                    }
+                }
+            }
+            if (!overflow_.empty()) {
+                wake = std::min(wake, ((current_tick_ / SPAN) + 1) * SPAN);
+            }
+            return wake;
+        }
+
+        // Avance jusqu'à now_tick en appelant on_expire(T&&) pour chaque
+        // élément échu. Le callback peut replanifier via schedule().
+        template<typename Callback>
+        size_t advance(uint64_t now_tick, Callback&& on_expire) {
+            size_t fired = 0;
+
+            while (current_tick_ < now_tick) {
+                ++current_tick_;
+
+                if ((current_tick_ & (SPAN - 1)) == 0 && !overflow_.empty()) {
+                    std::vector<Entry> pending;
+                    pending.swap(overflow_);
+                    for (auto& entry : pending) {
+                        place(std::move(entry), current_tick_);
+                    }
+                }
+
+                for (size_t level = LEVELS - 1; level > 0; --level) {
+                    uint64_t mask = (uint64_t{1} << (LEVEL_BITS * level)) - 1;
+                    if ((current_tick_ & mask) == 0) {
+                        cascade(level, (current_tick_ >> (LEVEL_BITS * level)) & SLOT_MASK);
+                    }
+                }
+
+                Slot due;
+                due.swap(levels_[0][current_tick_ & SLOT_MASK]);
+                size_ -= due.size();
+                fired += due.size();
+                for (auto& entry : due) {
+                    on_expire(std::move(entry.value));
+                }
+            }
+
+            return fired;
+        }
+
+        void clear() {
+            for (auto& level : levels_) {
+                for (auto& slot : level) {
+                    slot.clear();
+                }
+            }
+            overflow_.clear();
+            size_ = 0;
+        }
+    };
+
+} // namespace QMark
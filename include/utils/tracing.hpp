@@ -0,0 +1,144 @@
+#pragma once
+
+#include "utils/binary_log.hpp"
+#include "utils/json_writer.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace QMark {
+
+    struct TracingConfig {
+        uint32_t sample_every = 0;                          // 1 requête sur N (0 = aucune)
+        std::chrono::milliseconds slow_threshold{250};      // capture systématique au-delà (0 = désactivé)
+        size_t max_traces = 256;                            // traces conservées pour /admin/traces
+    };
+
+    namespace tracing {
+        constexpr size_t RING_CAPACITY = 1024;   // spans par thread, puissance de 2
+
+        struct SpanRecord {
+            const char* category;
+            const char* name;
+            uint64_t start_tsc;
+            uint64_t end_tsc;       // 0 = span encore ouvert
+            uint32_t depth;
+        };
+
+        // Anneau du thread : les spans de la requête en cours sont dans
+        // [trace_start, head), les plus anciens étant écrasés en cas de débordement
+        struct ThreadRing {
+            std::array<SpanRecord, RING_CAPACITY> spans{};
+            uint64_t head = 0;
+            uint64_t trace_start = 0;
+            uint64_t request_start_tsc = 0;
+            uint64_t requests = 0;
+            uint32_t depth = 0;
+            uint32_t thread_id = 0;
+            bool active = false;
+        };
+
+        ThreadRing& threadRing();
+    }
+
+    // Span RAII : deux lectures TSC et une écriture dans l'anneau du thread,
+    // rien du tout si aucune requête n'est tracée sur ce thread
+    class TraceSpan {
+    private:
+        tracing::ThreadRing* ring_;
+        uint64_t index_;
+
+    public:
+        TraceSpan(const char* category, const char* name) : ring_(nullptr), index_(0) {
+            tracing::ThreadRing& ring = tracing::threadRing();
+            if (!ring.active) {
+                return;
+            }
+            ring_ = &ring;
+            index_ = ring.head++;
+            ring.spans[index_ & (tracing::RING_CAPACITY - 1)] =
+                tracing::SpanRecord{category, name, binlog::readTsc(), 0, ++ring.depth};
+        }
+
+        ~TraceSpan() {
+            if (!ring_) {
+                return;
+            }
+            ring_->depth--;
+            // Slot already reused by a later span of an oversized request
+            if (ring_->head - index_ <= tracing::RING_CAPACITY) {
+                ring_->spans[index_ & (tracing::RING_CAPACITY - 1)].end_tsc = binlog::readTsc();
+            }
+        }
+
+        TraceSpan(const TraceSpan&) = delete;
+        TraceSpan& operator=(const TraceSpan&) = delete;
+    };
+
+    // Traces de requêtes : échantillonnage en fin de requête (1 sur N, ou
+    // toute requête plus lente que le seuil), export Chrome/Perfetto
+    class Tracer {
+    public:
+        struct Span {
+            std::string category;
+            std::string name;
+            int64_t start_us;       // relatif au début de la requête
+            int64_t duration_us;
+            uint32_t depth;
+        };
+
+        struct Trace {
+            uint64_t id = 0;
+            std::string name;
+            int status = 0;
+            uint32_t thread_id = 0;
+            int64_t start_unix_us = 0;
+            int64_t duration_us = 0;
+            bool slow = false;
+            bool truncated = false;
+            std::vector<Span> spans;
+        };
+
+    private:
+        TracingConfig config_;
+        std::atomic<bool> enabled_;
+        std::atomic<uint64_t> next_trace_id_;
+
+        // Calibration TSC -> temps réel
+        double ticks_per_us_;
+        uint64_t anchor_tsc_;
+        int64_t anchor_unix_us_;
+
+        mutable std::mutex traces_mutex_;
+        std::deque<Trace> traces_;
+
+        Tracer();
+
+        int64_t ticksToMicros(uint64_t ticks) const;
+
+    public:
+        static Tracer& getInstance();
+
+        Tracer(const Tracer&) = delete;
+        Tracer& operator=(const Tracer&) = delete;
+
+        void configure(const TracingConfig& config);
+        bool enabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+        // Bornes d'une requête, sur le thread qui la traite
+        void beginRequest();
+        void endRequest(std::string_view name, int status);
+
+        // Sélection : une trace précise, ou les plus récentes au-delà d'une durée
+        std::vector<Trace> select(std::optional<uint64_t> id, std::chrono::microseconds min_duration,
+                                  size_t limit) const;
+        static void writeChromeTrace(JsonWriter& writer, const std::vector<Trace>& traces);
+    };
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include "utils/json_writer.hpp"
+#include <string>
+#include <string_view>
+
+namespace QMark {
+
+    namespace wire {
+
+        const char* contentType(WireFormat format);
+        const char* formatName(WireFormat format);
+
+        // Format de réponse d'après l'en-tête Accept (valeurs q respectées, JSON par défaut)
+        WireFormat negotiate(std::string_view accept);
+
+        // Codage de contenu accepté d'après Accept-Encoding (nom ou *, q > 0)
+        bool acceptsEncoding(std::string_view accept_encoding, std::string_view coding);
+
+        // Format d'un corps de requête d'après Content-Type (JSON par défaut)
+        WireFormat fromContentType(std::string_view content_type);
+
+        // Décode un document MessagePack ou CBOR en appels sur `writer`, quel que
+        // soit son format de sortie. Refuse ce que JSON ne sait pas représenter
+        // (données binaires, clés non textuelles, extensions).
+        bool transcode(WireFormat from, std::string_view input, JsonWriter& writer, std::string& error);
+    }
+}
@@ -0,0 +1,637 @@
+#include "analytics/metrics_store.hpp"
+#include "database/database_manager.hpp"
+#include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+#include "utils/snapshot_file.hpp"
+#include "utils/tracing.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace QMark {
+
+namespace {
+
+// Snapshot body: u64 revision, u64 user count, then per user
+//   i64 user_id, i32 first_day, u32 days, leads[days] u32, conversions[days] u32,
+//   automations[days] u32, revenue_cents[days] i64
+// (version 1 was a standalone file with its own magic)
+constexpr char SNAPSHOT_KIND[] = "MTRS";
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+using ColumnStats = MetricsStore::ColumnStats;
+
+#if defined(__AVX2__)
+
+inline int64_t horizontalSum(__m256i v) {
+    alignas(32) int64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// Eight days per step; counts are widened to 64-bit lanes before summing
+ColumnStats scanU32(const uint32_t* values, size_t count) {
+    uint64_t sum = 0;
+    uint32_t min = std::numeric_limits<uint32_t>::max();
+    uint32_t max = 0;
+    size_t i = 0;
+
+    if (count >= 8) {
+        __m256i sum_lo = _mm256_setzero_si256();
+        __m256i sum_hi = _mm256_setzero_si256();
+        __m256i vmin = _mm256_set1_epi32(-1);
+        __m256i vmax = _mm256_setzero_si256();
+        for (; i + 8 <= count; i += 8) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+            sum_lo = _mm256_add_epi64(sum_lo, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+            sum_hi = _mm256_add_epi64(sum_hi, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+            vmin = _mm256_min_epu32(vmin, v);
+            vmax = _mm256_max_epu32(vmax, v);
+        }
+        sum = static_cast<uint64_t>(horizontalSum(_mm256_add_epi64(sum_lo, sum_hi)));
+
+        alignas(32) uint32_t lanes[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), vmin);
+        min = *std::min_element(lanes, lanes + 8);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), vmax);
+        max = *std::max_element(lanes, lanes + 8);
+    }
+
+    for (; i < count; i++) {
+        sum += values[i];
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+    return ColumnStats{static_cast<int64_t>(sum), count ? int64_t{min} : 0, int64_t{max}};
+}
+
+ColumnStats scanI64(const int64_t* values, size_t count) {
+    int64_t sum = 0;
+    int64_t min = std::numeric_limits<int64_t>::max();
+    int64_t max = std::numeric_limits<int64_t>::min();
+    size_t i = 0;
+
+    if (count >= 4) {
+        __m256i vsum = _mm256_setzero_si256();
+        __m256i vmin = _mm256_set1_epi64x(min);
+        __m256i vmax = _mm256_set1_epi64x(max);
+        for (; i + 4 <= count; i += 4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+            vsum = _mm256_add_epi64(vsum, v);
+            // No 64-bit min/max before AVX-512: compare and blend
+            vmin = _mm256_blendv_epi8(vmin, v, _mm256_cmpgt_epi64(vmin, v));
+            vmax = _mm256_blendv_epi8(vmax, v, _mm256_cmpgt_epi64(v, vmax));
+        }
+        sum = horizontalSum(vsum);
+
+        alignas(32) int64_t lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), vmin);
+        min = *std::min_element(lanes, lanes + 4);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), vmax);
+        max = *std::max_element(lanes, lanes + 4);
+    }
+
+    for (; i < count; i++) {
+        sum += values[i];
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+    return count ? ColumnStats{sum, min, max} : ColumnStats{};
+}
+
+// Bucket sums: no min/max, two accumulators to hide the add latency
+int64_t sumU32(const uint32_t* values, size_t count) {
+    size_t i = 0;
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        acc0 = _mm256_add_epi64(acc0, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(v)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(v, 1)));
+    }
+    int64_t sum = horizontalSum(_mm256_add_epi64(acc0, acc1));
+    for (; i < count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+int64_t sumI64(const int64_t* values, size_t count) {
+    size_t i = 0;
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm256_add_epi64(acc0, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i)));
+        acc1 = _mm256_add_epi64(acc1, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i + 4)));
+    }
+    int64_t sum = horizontalSum(_mm256_add_epi64(acc0, acc1));
+    for (; i < count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+#else
+
+template<typename T>
+ColumnStats scanColumn(const T* values, size_t count) {
+    if (count == 0) {
+        return ColumnStats{};
+    }
+    ColumnStats stats{0, static_cast<int64_t>(values[0]), static_cast<int64_t>(values[0])};
+    for (size_t i = 0; i < count; i++) {
+        int64_t value = static_cast<int64_t>(values[i]);
+        stats.sum += value;
+        stats.min = std::min(stats.min, value);
+        stats.max = std::max(stats.max, value);
+    }
+    return stats;
+}
+
+ColumnStats scanU32(const uint32_t* values, size_t count) {
+    return scanColumn(values, count);
+}
+
+ColumnStats scanI64(const int64_t* values, size_t count) {
+    return scanColumn(values, count);
+}
+
+int64_t sumU32(const uint32_t* values, size_t count) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+int64_t sumI64(const int64_t* values, size_t count) {
+    int64_t sum = 0;
+    for (size_t i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    return sum;
+}
+
+#endif
+
+double conversionRate(int64_t conversions, int64_t leads) {
+    return leads > 0 ? static_cast<double>(conversions) * 100.0 / static_cast<double>(leads) : 0.0;
+}
+
+// Last day of the bucket that starts at `day`
+int32_t bucketEnd(int32_t day, MetricsStore::Granularity granularity) {
+    switch (granularity) {
+        case MetricsStore::Granularity::WEEK: {
+            // 1970-01-01 was a Thursday: Monday-based weekday, floored for days before it
+            int32_t weekday = ((day + 3) % 7 + 7) % 7;
+            return day - weekday + 6;
+        }
+        case MetricsStore::Granularity::MONTH: {
+            std::chrono::year_month_day date{std::chrono::sys_days(std::chrono::days(day))};
+            std::chrono::year_month_day_last last{date.year(), std::chrono::month_day_last(date.month())};
+            return static_cast<int32_t>(std::chrono::sys_days(last).time_since_epoch().count());
+        }
+        case MetricsStore::Granularity::DAY:
+        default:
+            return day;
+    }
+}
+
+void uncovered(ColumnStats& stats) {
+    // Days outside the stored span count as zero
+    stats.min = std::min<int64_t>(stats.min, 0);
+    stats.max = std::max<int64_t>(stats.max, 0);
+}
+
+} // namespace
+
+MetricsStore& MetricsStore::getInstance() {
+    static MetricsStore instance;
+    return instance;
+}
+
+MetricsStore::MetricsStore() : running_(false) {
+    MetricsRegistry::getInstance().registerCallback("qmark_metrics_store_bytes",
+        "Memory held by the columnar daily metrics store.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(stats().memory_bytes); });
+}
+
+MetricsStore::~MetricsStore() {
+    stop();
+}
+
+int32_t MetricsStore::dayOf(qmark::Timestamp time) {
+    return static_cast<int32_t>(std::chrono::floor<std::chrono::days>(time).time_since_epoch().count());
+}
+
+int32_t MetricsStore::today() {
+    return dayOf(std::chrono::system_clock::now());
+}
+
+bool MetricsStore::start(const MetricsStoreConfig& config) {
+    if (running_) {
+        return true;
+    }
+
+    TraceSpan span("metrics", "MetricsStore::start");
+    auto started = std::chrono::steady_clock::now();
+
+    config_ = config;
+    if (!config_.persist) {
+        config_.persist = [](const std::vector<qmark::DailyMetrics>& days) {
+            return DatabaseManager::getInstance().saveMetrics(days);
+        };
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(users_mutex_);
+        users_.clear();
+    }
+
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    revision_ = 0;
+
+    uint64_t snapshot_revision = 0;
+    bool from_snapshot = !config_.snapshot_path.empty() && loadSnapshot(snapshot_revision);
+    if (!from_snapshot) {
+        std::unique_lock<std::shared_mutex> lock(users_mutex_);
+        users_.clear();
+        snapshot_revision = 0;
+    }
+    revision_ = snapshot_revision;
+
+    // Rows rewritten since the snapshot carry a later revision and replace its days
+    size_t replayed = 0;
+    if (config_.load_from_database) {
+        bool ok = DatabaseManager::getInstance().loadMetrics(snapshot_revision, [&](const qmark::DailyMetrics& day) {
+            Series& series = seriesFor(day.user_id);
+            std::unique_lock<std::shared_mutex> lock(series.mutex);
+            setDay(series, day);
+            revision_ = std::max(revision_.load(), day.revision);
+            replayed++;
+        });
+        if (!ok) {
+            return false;
+        }
+    }
+
+    running_ = true;
+    flusher_thread_ = std::thread([this]() {
+        flusherLoop();
+    });
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger::info("Metrics store loaded " + std::string(from_snapshot ? "from snapshot" : "without snapshot") +
+                 " (revision " + std::to_string(snapshot_revision) + ") plus " + std::to_string(replayed) +
+                 " days from SQLite in " + std::to_string(elapsed.count()) + " ms");
+    return true;
+}
+
+void MetricsStore::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+    }
+    wake_cv_.notify_all();
+    if (flusher_thread_.joinable()) {
+        flusher_thread_.join();
+    }
+
+    if (flush() && !config_.snapshot_path.empty()) {
+        saveSnapshot();
+    }
+    Logger::info("Metrics store stopped");
+}
+
+MetricsStore::Series* MetricsStore::findSeries(qmark::UserId user_id) const {
+    std::shared_lock<std::shared_mutex> lock(users_mutex_);
+    auto it = users_.find(user_id);
+    return it == users_.end() ? nullptr : it->second.get();
+}
+
+MetricsStore::Series& MetricsStore::seriesFor(qmark::UserId user_id) {
+    if (Series* series = findSeries(user_id)) {
+        return *series;
+    }
+    std::unique_lock<std::shared_mutex> lock(users_mutex_);
+    auto& series = users_[user_id];
+    if (!series) {
+        series = std::make_unique<Series>();
+    }
+    return *series;
+}
+
+size_t MetricsStore::slot(Series& series, int32_t day) {
+    if (series.leads.empty()) {
+        series.first_day = day;
+    } else if (day < series.first_day) {
+        // History arriving before the first known day: rare, shifts the columns once
+        size_t shift = static_cast<size_t>(series.first_day - day);
+        series.leads.insert(series.leads.begin(), shift, 0);
+        series.conversions.insert(series.conversions.begin(), shift, 0);
+        series.automations.insert(series.automations.begin(), shift, 0);
+        series.revenue_cents.insert(series.revenue_cents.begin(), shift, 0);
+        series.first_day = day;
+    }
+
+    size_t index = static_cast<size_t>(day - series.first_day);
+    if (index >= series.leads.size()) {
+        series.leads.resize(index + 1);
+        series.conversions.resize(index + 1);
+        series.automations.resize(index + 1);
+        series.revenue_cents.resize(index + 1);
+    }
+    return index;
+}
+
+void MetricsStore::setDay(Series& series, const qmark::DailyMetrics& day) {
+    size_t index = slot(series, dayOf(day.date));
+    series.leads[index] = day.leads_count;
+    series.conversions[index] = day.conversions_count;
+    series.automations[index] = day.automations_count;
+    series.revenue_cents[index] = std::llround(day.revenue * 100.0);
+}
+
+void MetricsStore::record(qmark::UserId user_id, int32_t day, const Delta& delta) {
+    Series& series = seriesFor(user_id);
+    std::unique_lock<std::shared_mutex> lock(series.mutex);
+    size_t index = slot(series, day);
+
+    // Corrections may be negative; counters never go below zero
+    auto add = [](uint32_t& counter, int32_t value) {
+        int64_t updated = int64_t{counter} + value;
+        counter = static_cast<uint32_t>(std::clamp<int64_t>(updated, 0, std::numeric_limits<uint32_t>::max()));
+    };
+    add(series.leads[index], delta.leads);
+    add(series.conversions[index], delta.conversions);
+    add(series.automations[index], delta.automations);
+    series.revenue_cents[index] += delta.revenue_cents;
+    series.dirty.insert(day);
+}
+
+void MetricsStore::set(const qmark::DailyMetrics& day) {
+    Series& series = seriesFor(day.user_id);
+    std::unique_lock<std::shared_mutex> lock(series.mutex);
+    setDay(series, day);
+    series.dirty.insert(dayOf(day.date));
+}
+
+MetricsStore::Summary MetricsStore::summarize(qmark::UserId user_id, int32_t from_day, int32_t to_day) const {
+    TraceSpan span("metrics", "MetricsStore::summarize");
+
+    Summary summary;
+    if (to_day < from_day) {
+        return summary;
+    }
+    summary.days = to_day - from_day + 1;
+
+    Series* series = findSeries(user_id);
+    if (!series) {
+        return summary;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(series->mutex);
+    int32_t last_day = series->first_day + static_cast<int32_t>(series->leads.size()) - 1;
+    int32_t from = std::max(from_day, series->first_day);
+    int32_t to = std::min(to_day, last_day);
+    if (series->leads.empty() || from > to) {
+        return summary;
+    }
+
+    size_t offset = static_cast<size_t>(from - series->first_day);
+    size_t count = static_cast<size_t>(to - from + 1);
+    summary.leads = scanU32(series->leads.data() + offset, count);
+    summary.conversions = scanU32(series->conversions.data() + offset, count);
+    summary.automations = scanU32(series->automations.data() + offset, count);
+    summary.revenue_cents = scanI64(series->revenue_cents.data() + offset, count);
+
+    if (from > from_day || to < to_day) {
+        uncovered(summary.leads);
+        uncovered(summary.conversions);
+        uncovered(summary.automations);
+        uncovered(summary.revenue_cents);
+    }
+    summary.conversion_rate = conversionRate(summary.conversions.sum, summary.leads.sum);
+    return summary;
+}
+
+std::vector<MetricsStore::Bucket> MetricsStore::series(qmark::UserId user_id, int32_t from_day, int32_t to_day,
+                                                       Granularity granularity) const {
+    TraceSpan span("metrics", "MetricsStore::series");
+
+    std::vector<Bucket> buckets;
+    if (to_day < from_day) {
+        return buckets;
+    }
+
+    // First and last buckets are clipped to the requested range
+    for (int32_t start = from_day; start <= to_day;) {
+        int32_t end = std::min(bucketEnd(start, granularity), to_day);
+        Bucket& bucket = buckets.emplace_back();
+        bucket.start_day = start;
+        bucket.days = end - start + 1;
+        start = end + 1;
+    }
+
+    Series* user_series = findSeries(user_id);
+    if (!user_series) {
+        return buckets;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(user_series->mutex);
+    const Series& series = *user_series;
+    int32_t last_day = series.first_day + static_cast<int32_t>(series.leads.size()) - 1;
+    for (Bucket& bucket : buckets) {
+        int32_t from = std::max(bucket.start_day, series.first_day);
+        int32_t to = std::min(bucket.start_day + bucket.days - 1, last_day);
+        if (series.leads.empty() || from > to) {
+            continue;
+        }
+        size_t offset = static_cast<size_t>(from - series.first_day);
+        size_t count = static_cast<size_t>(to - from + 1);
+        bucket.leads = sumU32(series.leads.data() + offset, count);
+        bucket.conversions = sumU32(series.conversions.data() + offset, count);
+        bucket.automations = sumU32(series.automations.data() + offset, count);
+        bucket.revenue_cents = sumI64(series.revenue_cents.data() + offset, count);
+        bucket.conversion_rate = conversionRate(bucket.conversions, bucket.leads);
+    }
+    return buckets;
+}
+
+bool MetricsStore::flush() {
+    TraceSpan span("metrics", "MetricsStore::flush");
+
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    uint64_t revision = revision_ + 1;
+
+    std::vector<qmark::DailyMetrics> rows;
+    std::vector<std::pair<Series*, std::set<int32_t>>> taken;
+    {
+        std::shared_lock<std::shared_mutex> users_lock(users_mutex_);
+        for (auto& [user_id, series] : users_) {
+            std::unique_lock<std::shared_mutex> lock(series->mutex);
+            if (series->dirty.empty()) {
+                continue;
+            }
+            for (int32_t day : series->dirty) {
+                size_t index = static_cast<size_t>(day - series->first_day);
+                qmark::DailyMetrics& row = rows.emplace_back();
+                row.user_id = user_id;
+                row.date = qmark::Timestamp(std::chrono::sys_days(std::chrono::days(day)));
+                row.leads_count = series->leads[index];
+                row.conversions_count = series->conversions[index];
+                row.automations_count = series->automations[index];
+                row.revenue = static_cast<double>(series->revenue_cents[index]) / 100.0;
+                row.revision = revision;
+            }
+            taken.emplace_back(series.get(), std::move(series->dirty));
+            series->dirty.clear();
+        }
+    }
+
+    if (rows.empty()) {
+        return true;
+    }
+
+    if (!config_.persist(rows)) {
+        // Kept dirty: the current values are written on the next attempt
+        for (auto& [series, days] : taken) {
+            std::unique_lock<std::shared_mutex> lock(series->mutex);
+            series->dirty.merge(days);
+        }
+        Logger::error("Failed to write " + std::to_string(rows.size()) + " metrics days");
+        return false;
+    }
+
+    revision_ = revision;
+    return true;
+}
+
+bool MetricsStore::saveSnapshot() {
+    TraceSpan span("metrics", "MetricsStore::saveSnapshot");
+
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    auto started = std::chrono::steady_clock::now();
+
+    std::vector<std::pair<qmark::UserId, Series*>> users;
+    {
+        std::shared_lock<std::shared_mutex> lock(users_mutex_);
+        users.reserve(users_.size());
+        for (auto& [user_id, series] : users_) {
+            users.emplace_back(user_id, series.get());
+        }
+    }
+
+    // Days recorded after the last flush may be captured too: the next flush
+    // writes them with a later revision, which replaces them on load
+    SnapshotWriter writer(config_.snapshot_path, SNAPSHOT_KIND, SNAPSHOT_VERSION);
+    writer.put(revision_.load());
+    writer.put(static_cast<uint64_t>(users.size()));
+    for (const auto& [user_id, series] : users) {
+        std::shared_lock<std::shared_mutex> lock(series->mutex);
+        uint32_t days = static_cast<uint32_t>(series->leads.size());
+        writer.put(static_cast<int64_t>(user_id));
+        writer.put(series->first_day);
+        writer.put(days);
+        writer.write(series->leads.data(), days * sizeof(uint32_t));
+        writer.write(series->conversions.data(), days * sizeof(uint32_t));
+        writer.write(series->automations.data(), days * sizeof(uint32_t));
+        writer.write(series->revenue_cents.data(), days * sizeof(int64_t));
+    }
+    if (!writer.commit()) {
+        return false;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger::info("Metrics snapshot written: " + std::to_string(users.size()) + " users at revision " +
+                 std::to_string(revision_.load()) + " in " + std::to_string(elapsed.count()) + " ms");
+    return true;
+}
+
+bool MetricsStore::loadSnapshot(uint64_t& revision) {
+    TraceSpan span("metrics", "MetricsStore::loadSnapshot");
+
+    // Checked whole before anything is applied: a bad snapshot falls back to SQLite
+    SnapshotReader reader;
+    if (!reader.open(config_.snapshot_path, SNAPSHOT_KIND, SNAPSHOT_VERSION)) {
+        return false;
+    }
+
+    uint64_t user_count = 0;
+    if (!reader.get(revision) || !reader.get(user_count)) {
+        return false;
+    }
+
+    std::unique_lock<std::shared_mutex> users_lock(users_mutex_);
+    for (uint64_t i = 0; i < user_count; i++) {
+        int64_t user_id;
+        int32_t first_day;
+        uint32_t days;
+        if (!reader.get(user_id) || !reader.get(first_day) || !reader.get(days) ||
+            reader.remaining() < size_t{days} * (3 * sizeof(uint32_t) + sizeof(int64_t))) {
+            Logger::warn("Truncated metrics snapshot: " + config_.snapshot_path);
+            return false;
+        }
+
+        auto series = std::make_unique<Series>();
+        series->first_day = first_day;
+        series->leads.resize(days);
+        series->conversions.resize(days);
+        series->automations.resize(days);
+        series->revenue_cents.resize(days);
+        reader.take(series->leads.data(), days * sizeof(uint32_t));
+        reader.take(series->conversions.data(), days * sizeof(uint32_t));
+        reader.take(series->automations.data(), days * sizeof(uint32_t));
+        reader.take(series->revenue_cents.data(), days * sizeof(int64_t));
+        users_[static_cast<qmark::UserId>(user_id)] = std::move(series);
+    }
+    return true;
+}
+
+void MetricsStore::flusherLoop() {
+    auto last_snapshot = std::chrono::steady_clock::now();
+
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(wake_mutex_);
+            wake_cv_.wait_for(lock, config_.flush_interval, [this]() { return !running_; });
+        }
+        if (!running_) {
+            break;
+        }
+
+        bool flushed = flush();
+        auto now = std::chrono::steady_clock::now();
+        if (flushed && !config_.snapshot_path.empty() && now - last_snapshot >= config_.snapshot_interval) {
+            saveSnapshot();
+            last_snapshot = now;
+        }
+    }
+}
+
+MetricsStore::Stats MetricsStore::stats() const {
+    Stats stats;
+    std::shared_lock<std::shared_mutex> users_lock(users_mutex_);
+    stats.users = users_.size();
+    for (const auto& [user_id, series] : users_) {
+        std::shared_lock<std::shared_mutex> lock(series->mutex);
+        stats.days += series->leads.size();
+        stats.memory_bytes += sizeof(Series) + series->leads.capacity() * sizeof(uint32_t) +
+                              series->conversions.capacity() * sizeof(uint32_t) +
+                              series->automations.capacity() * sizeof(uint32_t) +
+                              series->revenue_cents.capacity() * sizeof(int64_t);
+        stats.dirty_days += series->dirty.size();
+    }
+    stats.revision = revision_;
+    return stats;
+}
+
+} // namespace QMark
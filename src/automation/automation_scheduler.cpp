@@ -0,0 +1,535 @@
+#include "automation/automation_scheduler.hpp"
+#include "utils/json_reader.hpp"
+#include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+#include <algorithm>
+
+namespace QMark {
+
+AutomationScheduler& AutomationScheduler::getInstance() {
+    static AutomationScheduler instance;
+    return instance;
+}
+
+AutomationScheduler::AutomationScheduler() : running_(false), runs_(0), failures_(0), deferred_(0) {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    run_counter_ = metrics.registerCounter("qmark_automation_runs_total", "Automation runs completed.");
+    failure_counter_ = metrics.registerCounter("qmark_automation_failures_total", "Automation runs whose handler reported a failure.");
+    deferred_counter_ = metrics.registerCounter("qmark_automation_deferred_total", "Due automation runs pushed back one tick because the run queue was full.");
+    metrics.registerCallback("qmark_automations_scheduled", "Active automations held by the scheduler.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(stats().scheduled); });
+    metrics.registerCallback("qmark_automation_queue_depth", "Due automation runs waiting for a worker thread.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(stats().queued); });
+}
+
+AutomationScheduler::~AutomationScheduler() {
+    stop();
+}
+
+int64_t AutomationScheduler::nowMillis() const {
+    if (config_.simulated_clock) {
+        return simulated_now_ms_;
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int64_t AutomationScheduler::intervalFor(const qmark::Automation& automation) const {
+    int64_t seconds = config_.default_interval.count();
+
+    // The interval lives in the automation's free-form config
+    if (!automation.config.empty()) {
+        thread_local JsonReader reader;
+        if (reader.parse(automation.config)) {
+            int64_t configured = 0;
+            const JsonReader::Value* value = reader.find("interval_seconds");
+            if (value && JsonReader::getInt64(*value, configured) && configured > 0) {
+                seconds = configured;
+            }
+        }
+    }
+
+    seconds = std::max<int64_t>(seconds, config_.min_interval.count());
+    return seconds * 1000;
+}
+
+bool AutomationScheduler::start(const AutomationSchedulerConfig& config) {
+    if (running_) {
+        return true;
+    }
+
+    config_ = config;
+    if (config_.tick.count() <= 0) {
+        config_.tick = std::chrono::milliseconds(1000);
+    }
+    if (config_.per_user_concurrency == 0) {
+        config_.per_user_concurrency = 1;
+    }
+    if (config_.queue_capacity == 0) {
+        config_.queue_capacity = 1;
+    }
+    if (!config_.persist_runs) {
+        config_.persist_runs = [](const std::vector<AutomationRunRecord>& runs) {
+            return DatabaseManager::getInstance().recordAutomationRuns(runs);
+        };
+    }
+    tick_ms_ = config_.tick.count();
+    simulated_now_ms_ = config_.simulated_start_ms;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        jobs_.clear();
+        users_.clear();
+        ready_.clear();
+        running_jobs_ = 0;
+        wheel_ = TimingWheel<WheelEntry>(static_cast<uint64_t>(nowMillis() / tick_ms_));
+        driver_wake_ms_ = 0;
+    }
+    last_flush_ms_ = nowMillis();
+
+    if (config_.load_from_database) {
+        warmLoad();
+    }
+
+    running_ = true;
+    if (!config_.simulated_clock) {
+        size_t worker_count = std::max<size_t>(config_.worker_threads, 1);
+        for (size_t i = 0; i < worker_count; i++) {
+            workers_.emplace_back([this]() {
+                workerLoop();
+            });
+        }
+        driver_thread_ = std::thread([this]() {
+            driverLoop();
+        });
+    }
+
+    Logger::info("Automation scheduler started with " + std::to_string(stats().scheduled) + " automations" +
+                 (config_.simulated_clock ? " (simulated clock)" : ""));
+    return true;
+}
+
+void AutomationScheduler::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    // Taking the lock orders the flag before any waiter's predicate check
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    driver_cv_.notify_all();
+    ready_cv_.notify_all();
+    if (driver_thread_.joinable()) {
+        driver_thread_.join();
+    }
+    for (auto& worker : workers_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers_.clear();
+
+    // Runs finished by the workers are written before returning
+    maybeFlush(nowMillis(), true);
+    Logger::info("Automation scheduler stopped");
+}
+
+void AutomationScheduler::warmLoad() {
+    auto automations = DatabaseManager::getInstance().loadActiveAutomations();
+    for (const auto& automation : automations) {
+        upsert(automation);
+    }
+}
+
+void AutomationScheduler::registerHandler(const std::string& type, Handler handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    handlers_[type] = std::move(handler);
+    missing_handlers_.erase(type);
+}
+
+void AutomationScheduler::arm(qmark::AutomationId id, Job& job) {
+    job.generation++;
+    wheel_.schedule(WheelEntry{id, job.generation}, tickFor(job.next_run_ms));
+
+    // The driver sleeps until its planned wake-up: an earlier deadline must cut it short
+    if (job.next_run_ms < driver_wake_ms_) {
+        driver_wake_ms_ = job.next_run_ms;
+        driver_cv_.notify_one();
+    }
+}
+
+void AutomationScheduler::upsert(const qmark::Automation& automation) {
+    if (!automation.is_active) {
+        remove(automation.id);
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t now = nowMillis();
+
+    Job& job = jobs_[automation.id];
+    job.automation = automation;
+    job.interval_ms = intervalFor(automation);
+
+    // Never-run or overdue automations are spread over the startup window
+    // so a restart does not make every user's backlog due on the same tick
+    int64_t last_run = std::chrono::duration_cast<std::chrono::milliseconds>(
+        automation.last_run.time_since_epoch()).count();
+    int64_t next_run = last_run > 0 ? last_run + job.interval_ms : now;
+    if (next_run <= now) {
+        int64_t spread = std::min<int64_t>(config_.startup_spread.count() * 1000, job.interval_ms);
+        next_run = now + (spread > 0 ? static_cast<int64_t>(automation.id % static_cast<uint64_t>(spread)) : 0);
+    }
+
+    // A run in flight reschedules itself from the new settings when it completes
+    if (!job.in_flight) {
+        job.next_run_ms = next_run;
+        arm(automation.id, job);
+    }
+}
+
+void AutomationScheduler::remove(qmark::AutomationId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Wheel entries go stale with the job; a queued or running instance
+    // finds the job gone on completion and is not rescheduled
+    auto it = jobs_.find(id);
+    if (it == jobs_.end()) {
+        return;
+    }
+    if (it->second.in_flight) {
+        UserState& user = users_[it->second.automation.user_id];
+        auto waiting = std::find(user.waiting.begin(), user.waiting.end(), id);
+        if (waiting != user.waiting.end()) {
+            user.waiting.erase(waiting);
+        }
+        auto queued = std::find(ready_.begin(), ready_.end(), id);
+        if (queued != ready_.end()) {
+            ready_.erase(queued);
+            user.active--;
+        }
+    }
+    jobs_.erase(it);
+}
+
+void AutomationScheduler::collectDue(uint64_t tick, std::vector<qmark::AutomationId>& due) {
+    wheel_.advance(tick, [&](WheelEntry&& entry) {
+        auto it = jobs_.find(entry.id);
+        if (it != jobs_.end() && it->second.generation == entry.generation && !it->second.in_flight) {
+            due.push_back(entry.id);
+        }
+    });
+
+    // Bucket order depends on insertion history; sort so that runs, and the
+    // per-user queues they fill, are reproducible under the simulated clock
+    std::sort(due.begin(), due.end());
+}
+
+void AutomationScheduler::admit(qmark::AutomationId id, Job& job, int64_t now_ms) {
+    UserState& user = users_[job.automation.user_id];
+    job.in_flight = true;
+
+    if (user.active >= config_.per_user_concurrency) {
+        user.waiting.push_back(id);
+        return;
+    }
+
+    if (ready_.size() >= config_.queue_capacity) {
+        job.in_flight = false;
+        job.next_run_ms = now_ms + tick_ms_;
+        arm(id, job);
+        deferred_++;
+        MetricsRegistry::getInstance().increment(deferred_counter_);
+        return;
+    }
+
+    user.active++;
+    ready_.push_back(id);
+    ready_cv_.notify_one();
+}
+
+void AutomationScheduler::releaseUser(qmark::UserId user_id, int64_t now_ms) {
+    auto it = users_.find(user_id);
+    if (it == users_.end()) {
+        return;
+    }
+
+    UserState& user = it->second;
+    if (user.active > 0) {
+        user.active--;
+    }
+
+    // The oldest waiting run of this user takes the freed slot
+    while (!user.waiting.empty() && user.active < config_.per_user_concurrency) {
+        qmark::AutomationId next = user.waiting.front();
+        user.waiting.pop_front();
+
+        auto job = jobs_.find(next);
+        if (job == jobs_.end()) {
+            continue;
+        }
+        job->second.in_flight = false;
+        admit(next, job->second, now_ms);
+    }
+
+    if (user.active == 0 && user.waiting.empty()) {
+        users_.erase(it);
+    }
+}
+
+bool AutomationScheduler::takeReady(qmark::Automation& automation, Handler& handler) {
+    if (ready_.empty()) {
+        return false;
+    }
+
+    // remove() takes queued ids out of ready_, so the job is always present
+    const Job& job = jobs_.at(ready_.front());
+    ready_.pop_front();
+    automation = job.automation;
+
+    auto found = handlers_.find(automation.type);
+    if (found != handlers_.end()) {
+        handler = found->second;
+    } else {
+        handler = nullptr;
+        if (missing_handlers_.insert(automation.type).second) {
+            Logger::warn("No automation handler registered for type '" + automation.type + "'");
+        }
+    }
+    return true;
+}
+
+void AutomationScheduler::execute(const qmark::Automation& automation, const Handler& handler, int64_t scheduled_ms) {
+    if (!handler) {
+        // Skipped rather than failed: nothing is persisted for this run
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(automation.id);
+        if (it != jobs_.end()) {
+            Job& job = it->second;
+            job.in_flight = false;
+            job.next_run_ms = std::max(scheduled_ms, nowMillis()) + job.interval_ms;
+            arm(automation.id, job);
+        }
+        releaseUser(automation.user_id, nowMillis());
+        return;
+    }
+
+    bool success;
+    std::string detail;
+    try {
+        success = handler(automation, detail);
+    } catch (const std::exception& e) {
+        success = false;
+        detail = e.what();
+    }
+
+    complete(automation, success, std::move(detail), config_.simulated_clock ? scheduled_ms : nowMillis());
+}
+
+void AutomationScheduler::complete(const qmark::Automation& automation, bool success, std::string detail,
+                                   int64_t finished_ms) {
+    AutomationRunRecord record;
+    record.automation_id = automation.id;
+    record.user_id = static_cast<int64_t>(automation.user_id);
+    record.finished_at = finished_ms / 1000;
+    record.success = success;
+    record.title = automation.name;
+    record.detail = std::move(detail);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Removed while running: the run still happened and is recorded
+        auto it = jobs_.find(automation.id);
+        if (it != jobs_.end()) {
+            Job& job = it->second;
+            job.in_flight = false;
+            job.automation.last_run = qmark::Timestamp(std::chrono::milliseconds(finished_ms));
+            job.automation.run_count++;
+
+            // Fixed rate: the next slot after now, missed slots are not replayed
+            int64_t next_run = job.next_run_ms + job.interval_ms;
+            if (next_run <= finished_ms) {
+                next_run += ((finished_ms - next_run) / job.interval_ms + 1) * job.interval_ms;
+            }
+            job.next_run_ms = next_run;
+            arm(automation.id, job);
+        }
+
+        releaseUser(automation.user_id, finished_ms);
+    }
+
+    runs_++;
+    MetricsRegistry::getInstance().increment(run_counter_);
+    if (!success) {
+        failures_++;
+        MetricsRegistry::getInstance().increment(failure_counter_);
+    }
+
+    size_t pending;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_runs_.push_back(std::move(record));
+        pending = pending_runs_.size();
+    }
+    // First record arms the flush deadline, a full batch is written at once
+    if ((pending == 1 || pending >= config_.flush_batch_size) && !config_.simulated_clock) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        driver_cv_.notify_one();
+    }
+}
+
+void AutomationScheduler::maybeFlush(int64_t now_ms, bool force) {
+    std::vector<AutomationRunRecord> batch;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (pending_runs_.empty()) {
+            last_flush_ms_ = now_ms;
+            return;
+        }
+        bool due = now_ms - last_flush_ms_ >= config_.flush_interval.count() ||
+                   pending_runs_.size() >= config_.flush_batch_size;
+        if (!force && !due) {
+            return;
+        }
+        batch.swap(pending_runs_);
+        last_flush_ms_ = now_ms;
+    }
+
+    if (!config_.persist_runs(batch)) {
+        Logger::error("Failed to persist " + std::to_string(batch.size()) + " automation runs");
+    }
+}
+
+void AutomationScheduler::flush() {
+    maybeFlush(nowMillis(), true);
+}
+
+void AutomationScheduler::driverLoop() {
+    std::vector<qmark::AutomationId> due;
+
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            int64_t now = nowMillis();
+
+            due.clear();
+            collectDue(static_cast<uint64_t>(now / tick_ms_), due);
+            for (qmark::AutomationId id : due) {
+                admit(id, jobs_.at(id), now);
+            }
+
+            // Sleep until the wheel has work or a pending batch is due; an
+            // idle scheduler stays parked instead of waking every tick
+            int64_t wake_ms = INT64_MAX;
+            {
+                std::lock_guard<std::mutex> pending_lock(pending_mutex_);
+                if (!pending_runs_.empty()) {
+                    wake_ms = last_flush_ms_ + config_.flush_interval.count();
+                }
+            }
+            uint64_t wake_tick = wheel_.nextWakeTick();
+            if (wake_tick != UINT64_MAX) {
+                wake_ms = std::min<int64_t>(wake_ms, static_cast<int64_t>(wake_tick) * tick_ms_);
+            }
+
+            driver_wake_ms_ = wake_ms;
+            if (running_ && wake_ms == INT64_MAX) {
+                driver_cv_.wait(lock);
+            } else if (running_ && wake_ms > now) {
+                driver_cv_.wait_for(lock, std::chrono::milliseconds(wake_ms - now));
+            }
+            driver_wake_ms_ = 0;
+        }
+
+        maybeFlush(nowMillis(), false);
+    }
+}
+
+void AutomationScheduler::workerLoop() {
+    while (true) {
+        qmark::Automation automation;
+        Handler handler;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_cv_.wait(lock, [this]() { return !running_ || !ready_.empty(); });
+            if (!takeReady(automation, handler)) {
+                return;
+            }
+            running_jobs_++;
+        }
+
+        execute(automation, handler, nowMillis());
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_jobs_--;
+    }
+}
+
+size_t AutomationScheduler::advanceTo(int64_t now_ms) {
+    if (!config_.simulated_clock) {
+        return 0;
+    }
+
+    size_t executed = 0;
+    std::vector<qmark::AutomationId> due;
+
+    // One wheel wake-up at a time, jumping over empty stretches; handlers run
+    // inline outside the lock so they may call back into the scheduler
+    while (true) {
+        uint64_t tick;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            uint64_t target = static_cast<uint64_t>(now_ms / tick_ms_);
+            uint64_t wake = wheel_.nextWakeTick();
+            if (wake > target) {
+                wheel_.advance(target, [](WheelEntry&&) {});
+                simulated_now_ms_ = now_ms;
+                break;
+            }
+
+            tick = wake;
+            simulated_now_ms_ = static_cast<int64_t>(tick) * tick_ms_;
+            due.clear();
+            collectDue(tick, due);
+            for (qmark::AutomationId id : due) {
+                admit(id, jobs_.at(id), simulated_now_ms_);
+            }
+        }
+
+        while (true) {
+            qmark::Automation automation;
+            Handler handler;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!takeReady(automation, handler)) {
+                    break;
+                }
+            }
+            execute(automation, handler, static_cast<int64_t>(tick) * tick_ms_);
+            executed++;
+        }
+
+        maybeFlush(simulated_now_ms_, false);
+    }
+
+    maybeFlush(simulated_now_ms_, false);
+    return executed;
+}
+
+AutomationScheduler::Stats AutomationScheduler::stats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.scheduled = jobs_.size();
+        stats.queued = ready_.size();
+        stats.running = running_jobs_;
+    }
+    stats.runs = runs_.load();
+    stats.failures = failures_.load();
+    stats.deferred = deferred_.load();
+    return stats;
+}
+
+} // namespace QMark
@@ -1,6 +1,11 @@
 #include "database/database_manager.hpp"
+#include "database/sqlite_codec.hpp"
+#include "qmark_reflection.hpp"
 #include "utils/logger.hpp"
+#include "utils/tracing.hpp"
+#include <algorithm>
 #include <filesystem>
+#include <thread>
 
 namespace QMark {
 
@@ -9,39 +14,55 @@ DatabaseManager& DatabaseManager::getInstance() {
     return instance;
 }
 
-DatabaseManager::DatabaseManager() : db_(nullptr) {}
+DatabaseManager::DatabaseManager() {}
 
 DatabaseManager::~DatabaseManager() {
     close();
 }
 
 bool DatabaseManager::init(const std::string& db_path) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
     try {
         // Create database directory if it doesn't exist
         std::filesystem::path path(db_path);
         std::filesystem::create_directories(path.parent_path());
 
-        // Open database
-        int result = sqlite3_open(db_path.c_str(), &db_);
-        if (result != SQLITE_OK) {
-            Logger::error("Failed to open database: " + std::string(sqlite3_errmsg(db_)));
-            return false;
+        {
+            ConnectionLease lease(catalog_);
+            catalog_.path = db_path;
+            if (!openFile(catalog_, true)) {
+                return false;
+            }
         }
 
-        db_path_ = db_path;
-
-        // Enable foreign keys
-        execute("PRAGMA foreign_keys = ON;");
-
-        // Create tables
-        if (!createTables()) {
-            Logger::error("Failed to create database tables");
-            return false;
+        // The layout is written by qmark-reshard only; no row means a single file
+        size_t shard_count = 1;
+        for (const auto& row : query("SELECT shard_count, id_floor FROM shard_layout LIMIT 1;")) {
+            shard_count = static_cast<size_t>(std::stoull(row.at("shard_count")));
+            id_floor_ = std::stoll(row.at("id_floor"));
         }
 
-        Logger::info("Database initialized successfully: " + db_path);
+        if (shard_count > 1) {
+            for (size_t i = 0; i < shard_count; i++) {
+                auto shard = std::make_unique<Shard>();
+                shard->index = i;
+                shard->path = shardPath(db_path, i);
+                if (!std::filesystem::exists(shard->path)) {
+                    Logger::error("Missing database shard " + shard->path + " (layout declares " +
+                                  std::to_string(shard_count) + ")");
+                    return false;
+                }
+                // Users live in the catalog: no foreign keys to enforce inside a shard
+                ConnectionLease lease(*shard);
+                if (!openFile(*shard, false)) {
+                    return false;
+                }
+                shards_.push_back(std::move(shard));
+            }
+            Logger::info("Database initialized successfully: " + db_path + " with " +
+                         std::to_string(shard_count) + " shards");
+        } else {
+            Logger::info("Database initialized successfully: " + db_path);
+        }
         return true;
 
     } catch (const std::exception& e) {
@@ -50,24 +71,193 @@ bool DatabaseManager::init(const std::string& db_path) {
     }
 }
 
+bool DatabaseManager::openFile(Shard& shard, bool foreign_keys) {
+    // Open database
+    int result = sqlite3_open(shard.path.c_str(), &shard.db);
+    if (result != SQLITE_OK) {
+        Logger::error("Failed to open database " + shard.path + ": " + std::string(sqlite3_errmsg(shard.db)));
+        sqlite3_close(shard.db);
+        shard.db = nullptr;
+        return false;
+    }
+
+    // Enable foreign keys
+    if (foreign_keys) {
+        execute(shard.db, "PRAGMA foreign_keys = ON;");
+    }
+
+    // Create tables
+    if (!createTables(shard.db)) {
+        Logger::error("Failed to create database tables in " + shard.path);
+        return false;
+    }
+    return true;
+}
+
 void DatabaseManager::close() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& shard : shards_) {
+        ConnectionLease lease(*shard);
+        sqlite3_close(shard->db);
+        shard->db = nullptr;
+    }
+    shards_.clear();
 
-    if (db_) {
-        sqlite3_close(db_);
-        db_ = nullptr;
+    ConnectionLease lease(catalog_);
+
+    if (catalog_.db) {
+        sqlite3_close(catalog_.db);
+        catalog_.db = nullptr;
         Logger::info("Database connection closed");
     }
 }
 
+size_t DatabaseManager::shardOf(qmark::UserId user_id, size_t shard_count) {
+    // splitmix64 finalizer, then jump consistent hash (Lamping & Veach): growing
+    // from N to N+1 shards moves only 1/(N+1) of the users. Fixed constants, so
+    // the placement never depends on the build or the platform.
+    uint64_t key = static_cast<uint64_t>(user_id);
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+
+    int64_t bucket = -1;
+    int64_t next = 0;
+    while (next < static_cast<int64_t>(shard_count)) {
+        bucket = next;
+        key = key * 2862933555777941757ULL + 1;
+        next = static_cast<int64_t>(static_cast<double>(bucket + 1) *
+                                    (static_cast<double>(1LL << 31) / static_cast<double>((key >> 33) + 1)));
+    }
+    return static_cast<size_t>(bucket);
+}
+
+std::string DatabaseManager::shardPath(const std::string& catalog_path, size_t index) {
+    // ./qmark.db -> ./qmark.shard3.db
+    std::filesystem::path path(catalog_path);
+    std::string name = path.stem().string() + ".shard" + std::to_string(index) + path.extension().string();
+    return (path.parent_path() / name).string();
+}
+
+DatabaseManager::Shard& DatabaseManager::tenantShard(qmark::UserId user_id) {
+    return shards_.empty() ? catalog_ : *shards_[shardOf(user_id, shards_.size())];
+}
+
+std::vector<DatabaseManager::Shard*> DatabaseManager::tenantShards() {
+    std::vector<Shard*> shards;
+    if (shards_.empty()) {
+        shards.push_back(&catalog_);
+    }
+    for (auto& shard : shards_) {
+        shards.push_back(shard.get());
+    }
+    return shards;
+}
+
+template<typename T, typename UserOf>
+std::vector<std::pair<DatabaseManager::Shard*, std::vector<size_t>>> DatabaseManager::groupByShard(
+    const std::vector<T>& rows, UserOf user_of) {
+    std::vector<std::pair<Shard*, std::vector<size_t>>> groups;
+    if (shards_.empty()) {
+        std::vector<size_t> all(rows.size());
+        for (size_t i = 0; i < rows.size(); i++) {
+            all[i] = i;
+        }
+        groups.emplace_back(&catalog_, std::move(all));
+        return groups;
+    }
+
+    std::vector<std::vector<size_t>> indices(shards_.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        indices[shardOf(user_of(rows[i]), shards_.size())].push_back(i);
+    }
+    for (size_t shard = 0; shard < indices.size(); shard++) {
+        if (!indices[shard].empty()) {
+            groups.emplace_back(shards_[shard].get(), std::move(indices[shard]));
+        }
+    }
+    return groups;
+}
+
+template<typename Fn>
+void DatabaseManager::forEachShard(Fn&& fn) {
+    std::vector<Shard*> shards = tenantShards();
+    std::vector<std::thread> workers;
+    workers.reserve(shards.size() - 1);
+    for (size_t i = 1; i < shards.size(); i++) {
+        workers.emplace_back([&fn, shard = shards[i]]() {
+            fn(*shard);
+        });
+    }
+    fn(*shards[0]);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int64_t DatabaseManager::allocateId(Shard& shard, const char* table) {
+    if (shards_.empty()) {
+        return 0;
+    }
+
+    auto it = shard.last_ids.find(table);
+    if (it == shard.last_ids.end()) {
+        int64_t max_id = 0;
+        sqlite3_stmt* stmt;
+        std::string sql = std::string("SELECT COALESCE(MAX(id), 0) FROM ") + table + ";";
+        if (sqlite3_prepare_v2(shard.db, sql.c_str(), -1, &stmt, nullptr) == SQLITE_OK) {
+            if (sqlite3_step(stmt) == SQLITE_ROW) {
+                max_id = sqlite3_column_int64(stmt, 0);
+            }
+            sqlite3_finalize(stmt);
+        }
+        it = shard.last_ids.emplace(table, max_id).first;
+    }
+
+    // Next id above everything this shard or the previous layout handed out,
+    // in this shard's residue class: no two shards can pick the same id
+    int64_t count = static_cast<int64_t>(shards_.size());
+    int64_t id = std::max(it->second, id_floor_) + 1;
+    id += (static_cast<int64_t>(shard.index) - id % count + count) % count;
+    it->second = id;
+    return id;
+}
+
+size_t DatabaseManager::connectionsInUse() const {
+    size_t in_use = catalog_.users.load(std::memory_order_relaxed) > 0 ? 1 : 0;
+    for (const auto& shard : shards_) {
+        in_use += shard->users.load(std::memory_order_relaxed) > 0 ? 1 : 0;
+    }
+    return in_use;
+}
+
+size_t DatabaseManager::connectionWaiters() const {
+    auto waiters = [](const Shard& shard) {
+        int users = shard.users.load(std::memory_order_relaxed);
+        return users > 1 ? static_cast<size_t>(users - 1) : 0;
+    };
+    size_t total = waiters(catalog_);
+    for (const auto& shard : shards_) {
+        total += waiters(*shard);
+    }
+    return total;
+}
+
 bool DatabaseManager::execute(const std::string& sql) {
-    if (!db_) {
+    return execute(catalog_.db, sql);
+}
+
+bool DatabaseManager::execute(sqlite3* db, const std::string& sql) {
+    TraceSpan span("db", "DatabaseManager::execute");
+
+    if (!db) {
         Logger::error("Database not initialized");
         return false;
     }
 
     char* error_msg = nullptr;
-    int result = sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &error_msg);
+    int result = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &error_msg);
 
     if (result != SQLITE_OK) {
         std::string error = error_msg ? error_msg : "Unknown error";
@@ -82,18 +272,20 @@ bool DatabaseManager::execute(const std::string& sql) {
 }
 
 std::vector<std::map<std::string, std::string>> DatabaseManager::query(const std::string& sql) {
+    TraceSpan span("db", "DatabaseManager::query");
+
     std::vector<std::map<std::string, std::string>> results;
 
-    if (!db_) {
+    if (!catalog_.db) {
         Logger::error("Database not initialized");
         return results;
     }
 
     sqlite3_stmt* stmt;
-    int result = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(catalog_.db, sql.c_str(), -1, &stmt, nullptr);
 
     if (result != SQLITE_OK) {
-        Logger::error("SQL prepare failed: " + std::string(sqlite3_errmsg(db_)));
+        Logger::error("SQL prepare failed: " + std::string(sqlite3_errmsg(catalog_.db)));
         return results;
     }
 
@@ -116,7 +308,7 @@ std::vector<std::map<std::string, std::string>> DatabaseManager::query(const std
     return results;
 }
 
-bool DatabaseManager::createTables() {
+bool DatabaseManager::createTables(sqlite3* db) {
     // Users table
     std::string users_sql = R"(
         CREATE TABLE IF NOT EXISTS users (
@@ -154,17 +346,138 @@ bool DatabaseManager::createTables() {
         );
     )";
 
-    return execute(users_sql) && execute(sessions_sql) && execute(data_sql);
+    std::string sessions_index_sql =
+        "CREATE INDEX IF NOT EXISTS idx_sessions_expires_at ON sessions(expires_at);";
+
+    // OAuth connections table (columns mirror qmark::OAuthConnection, timestamps in Unix seconds)
+    std::string oauth_sql = R"(
+        CREATE TABLE IF NOT EXISTS oauth_connections (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            user_id INTEGER NOT NULL,
+            provider TEXT NOT NULL,
+            provider_user_id TEXT NOT NULL,
+            encrypted_access_token TEXT NOT NULL DEFAULT '',
+            encrypted_refresh_token TEXT NOT NULL DEFAULT '',
+            expires_at INTEGER NOT NULL DEFAULT 0,
+            created_at INTEGER NOT NULL DEFAULT 0,
+            updated_at INTEGER NOT NULL DEFAULT 0,
+            is_active INTEGER NOT NULL DEFAULT 1,
+            UNIQUE (provider, provider_user_id),
+            FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE
+        );
+    )";
+
+    std::string oauth_index_sql =
+        "CREATE INDEX IF NOT EXISTS idx_oauth_connections_user_id ON oauth_connections(user_id);";
+
+    // Automations and the activity feed they write to (timestamps in Unix seconds)
+    std::string automations_sql = R"(
+        CREATE TABLE IF NOT EXISTS automations (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            user_id INTEGER NOT NULL,
+            name TEXT NOT NULL,
+            description TEXT NOT NULL DEFAULT '',
+            type TEXT NOT NULL,
+            config TEXT NOT NULL DEFAULT '{}',
+            is_active INTEGER NOT NULL DEFAULT 1,
+            last_run INTEGER NOT NULL DEFAULT 0,
+            run_count INTEGER NOT NULL DEFAULT 0,
+            created_at INTEGER NOT NULL DEFAULT 0,
+            updated_at INTEGER NOT NULL DEFAULT 0,
+            FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE
+        );
+    )";
+
+    std::string activities_sql = R"(
+        CREATE TABLE IF NOT EXISTS activities (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            user_id INTEGER NOT NULL,
+            type TEXT NOT NULL,
+            title TEXT NOT NULL,
+            description TEXT NOT NULL DEFAULT '',
+            metadata TEXT NOT NULL DEFAULT '{}',
+            created_at INTEGER NOT NULL DEFAULT 0,
+            FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE
+        );
+    )";
+
+    std::string automation_indexes_sql =
+        "CREATE INDEX IF NOT EXISTS idx_automations_active ON automations(is_active);"
+        "CREATE INDEX IF NOT EXISTS idx_activities_user_created ON activities(user_id, created_at);";
+
+    // Leads (columns mirror qmark::Lead, timestamps in Unix seconds)
+    std::string leads_sql = R"(
+        CREATE TABLE IF NOT EXISTS leads (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            user_id INTEGER NOT NULL,
+            name TEXT NOT NULL DEFAULT '',
+            email TEXT NOT NULL DEFAULT '',
+            phone TEXT NOT NULL DEFAULT '',
+            source TEXT NOT NULL DEFAULT '',
+            status TEXT NOT NULL DEFAULT 'new',
+            notes TEXT NOT NULL DEFAULT '',
+            metadata TEXT NOT NULL DEFAULT '{}',
+            created_at INTEGER NOT NULL DEFAULT 0,
+            updated_at INTEGER NOT NULL DEFAULT 0,
+            FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE
+        );
+    )";
+
+    std::string leads_index_sql =
+        "CREATE INDEX IF NOT EXISTS idx_leads_user_id ON leads(user_id);";
+
+    std::string metrics_sql = R"(
+        CREATE TABLE IF NOT EXISTS metrics (
+            user_id INTEGER NOT NULL,
+            date INTEGER NOT NULL,
+            leads_count INTEGER NOT NULL DEFAULT 0,
+            conversions_count INTEGER NOT NULL DEFAULT 0,
+            automations_count INTEGER NOT NULL DEFAULT 0,
+            revenue REAL NOT NULL DEFAULT 0,
+            revision INTEGER NOT NULL DEFAULT 0,
+            PRIMARY KEY (user_id, date),
+            FOREIGN KEY (user_id) REFERENCES users(id) ON DELETE CASCADE
+        );
+    )";
+
+    std::string metrics_index_sql =
+        "CREATE INDEX IF NOT EXISTS idx_metrics_revision ON metrics(revision);";
+
+    // Shard count and id floor, one row written by qmark-reshard
+    std::string layout_sql = R"(
+        CREATE TABLE IF NOT EXISTS shard_layout (
+            shard_count INTEGER NOT NULL,
+            id_floor INTEGER NOT NULL DEFAULT 0
+        );
+    )";
+
+    // Token of each cache snapshot written at shutdown, taken back at startup
+    std::string snapshots_sql = R"(
+        CREATE TABLE IF NOT EXISTS cache_snapshots (
+            name TEXT PRIMARY KEY,
+            token INTEGER NOT NULL,
+            written_at DATETIME DEFAULT CURRENT_TIMESTAMP
+        );
+    )";
+
+    return execute(db, users_sql) && execute(db, sessions_sql) && execute(db, sessions_index_sql) && execute(db, data_sql)
+        && execute(db, oauth_sql) && execute(db, oauth_index_sql)
+        && execute(db, automations_sql) && execute(db, activities_sql) && execute(db, automation_indexes_sql)
+        && execute(db, leads_sql) && execute(db, leads_index_sql)
+        && execute(db, metrics_sql) && execute(db, metrics_index_sql)
+        && execute(db, layout_sql) && execute(db, snapshots_sql);
 }
 
 bool DatabaseManager::insertUser(const std::string& username, const std::string& email, const std::string& password_hash) {
+    TraceSpan span("db", "DatabaseManager::insertUser");
+
     std::string sql = "INSERT INTO users (username, email, password_hash) VALUES (?, ?, ?);";
 
     sqlite3_stmt* stmt;
-    int result = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(catalog_.db, sql.c_str(), -1, &stmt, nullptr);
 
     if (result != SQLITE_OK) {
-        Logger::error("Failed to prepare insert user statement: " + std::string(sqlite3_errmsg(db_)));
+        Logger::error("Failed to prepare insert user statement: " + std::string(sqlite3_errmsg(catalog_.db)));
         return false;
     }
 
@@ -176,7 +489,7 @@ bool DatabaseManager::insertUser(const std::string& username, const std::string&
     sqlite3_finalize(stmt);
 
     if (result != SQLITE_DONE) {
-        Logger::error("Failed to insert user: " + std::string(sqlite3_errmsg(db_)));
+        Logger::error("Failed to insert user: " + std::string(sqlite3_errmsg(catalog_.db)));
         return false;
     }
 
@@ -185,13 +498,15 @@ bool DatabaseManager::insertUser(const std::string& username, const std::string&
 }
 
 std::optional<std::map<std::string, std::string>> DatabaseManager::getUserByUsername(const std::string& username) {
+    TraceSpan span("db", "DatabaseManager::getUserByUsername");
+
     std::string sql = "SELECT * FROM users WHERE username = ? LIMIT 1;";
 
     sqlite3_stmt* stmt;
-    int result = sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr);
+    int result = sqlite3_prepare_v2(catalog_.db, sql.c_str(), -1, &stmt, nullptr);
 
     if (result != SQLITE_OK) {
-        Logger::error("Failed to prepare get user statement: " + std::string(sqlite3_errmsg(db_)));
+        Logger::error("Failed to prepare get user statement: " + std::string(sqlite3_errmsg(catalog_.db)));
         return std::nullopt;
     }
 
@@ -216,4 +531,1059 @@ std::optional<std::map<std::string, std::string>> DatabaseManager::getUserByUser
     return std::nullopt;
 }
 
-} // namespace QMark
\ No newline at end of file
+std::optional<qmark::User> DatabaseManager::findUser(const std::string& username) {
+    TraceSpan span("db", "DatabaseManager::findUser");
+
+    ConnectionLease lease(catalog_);
+
+    if (!catalog_.db) {
+        Logger::error("Database not initialized");
+        return std::nullopt;
+    }
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(catalog_.db, "SELECT * FROM users WHERE username = ? LIMIT 1;", -1, &stmt, nullptr) != SQLITE_OK) {
+        Logger::error("Failed to prepare find user statement: " + std::string(sqlite3_errmsg(catalog_.db)));
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_STATIC);
+
+    std::optional<qmark::User> user;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        // Columns the users table does not have yet keep their defaults
+        sqlite_codec::ColumnMap<qmark::User> columns(stmt);
+        columns.read(stmt, user.emplace());
+    }
+
+    sqlite3_finalize(stmt);
+    return user;
+}
+
+std::optional<int64_t> DatabaseManager::countUsers() {
+    TraceSpan span("db", "DatabaseManager::countUsers");
+
+    ConnectionLease lease(catalog_);
+
+    if (!catalog_.db) {
+        Logger::error("Database not initialized");
+        return std::nullopt;
+    }
+
+    // Users are not sharded: the catalog holds all of them
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(catalog_.db, "SELECT COUNT(*) FROM users;", -1, &stmt, nullptr) != SQLITE_OK) {
+        Logger::error("Failed to prepare count users statement: " + std::string(sqlite3_errmsg(catalog_.db)));
+        return std::nullopt;
+    }
+
+    std::optional<int64_t> count;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+std::optional<int64_t> DatabaseManager::countActiveConnections() {
+    TraceSpan span("db", "DatabaseManager::countActiveConnections");
+    return sumOverShards("SELECT COUNT(*) FROM oauth_connections WHERE is_active = 1;");
+}
+
+std::optional<int64_t> DatabaseManager::countLeads() {
+    TraceSpan span("db", "DatabaseManager::countLeads");
+    return sumOverShards("SELECT COUNT(*) FROM leads;");
+}
+
+std::optional<int64_t> DatabaseManager::sumOverShards(const char* sql) {
+    // One scalar per shard, queried concurrently and added up
+    std::atomic<int64_t> total{0};
+    std::atomic<bool> ok{true};
+    forEachShard([&](Shard& shard) {
+        ConnectionLease lease(shard);
+
+        sqlite3_stmt* stmt;
+        if (!shard.db || sqlite3_prepare_v2(shard.db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare aggregate on " + shard.path);
+            ok = false;
+            return;
+        }
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            total += sqlite3_column_int64(stmt, 0);
+        } else {
+            Logger::error("Failed to aggregate on " + shard.path + ": " + std::string(sqlite3_errmsg(shard.db)));
+            ok = false;
+        }
+        sqlite3_finalize(stmt);
+    });
+
+    if (!ok) {
+        return std::nullopt;
+    }
+    return total.load();
+}
+
+bool DatabaseManager::saveOAuthConnection(qmark::OAuthConnection& connection) {
+    TraceSpan span("db", "DatabaseManager::saveOAuthConnection");
+
+    Shard& shard = tenantShard(connection.user_id);
+    ConnectionLease lease(shard);
+
+    if (!shard.db) {
+        Logger::error("Database not initialized");
+        return false;
+    }
+
+    constexpr auto& sql = sqlite_codec::UPSERT_SQL<qmark::OAuthConnection>;
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(shard.db, sql.c_str(), static_cast<int>(sql.view().size()), &stmt, nullptr) != SQLITE_OK) {
+        Logger::error("Failed to prepare save OAuth connection statement: " + std::string(sqlite3_errmsg(shard.db)));
+        return false;
+    }
+
+    qmark::OAuthConnection row = connection;
+    if (row.id == 0) {
+        row.id = static_cast<qmark::ConnectionId>(allocateId(shard, "oauth_connections"));
+    }
+    sqlite_codec::bindFields(stmt, row);
+
+    int result = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+
+    if (result != SQLITE_DONE) {
+        Logger::error("Failed to save OAuth connection: " + std::string(sqlite3_errmsg(shard.db)));
+        return false;
+    }
+
+    if (connection.id == 0) {
+        connection.id = row.id != 0 ? row.id : static_cast<qmark::ConnectionId>(sqlite3_last_insert_rowid(shard.db));
+    }
+    return true;
+}
+
+std::vector<qmark::OAuthConnection> DatabaseManager::getOAuthConnections(qmark::UserId user_id) {
+    TraceSpan span("db", "DatabaseManager::getOAuthConnections");
+
+    Shard& shard = tenantShard(user_id);
+    ConnectionLease lease(shard);
+    std::vector<qmark::OAuthConnection> connections;
+
+    if (!shard.db) {
+        Logger::error("Database not initialized");
+        return connections;
+    }
+
+    static const std::string sql =
+        std::string(sqlite_codec::SELECT_SQL<qmark::OAuthConnection>.view()) + " WHERE user_id = ?;";
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(shard.db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        Logger::error("Failed to prepare get OAuth connections statement: " + std::string(sqlite3_errmsg(shard.db)));
+        return connections;
+    }
+
+    sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(user_id));
+
+    sqlite_codec::ColumnMap<qmark::OAuthConnection> columns(stmt);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        columns.read(stmt, connections.emplace_back());
+    }
+
+    sqlite3_finalize(stmt);
+    return connections;
+}
+
+std::vector<qmark::OAuthConnection> DatabaseManager::loadActiveOAuthConnections() {
+    TraceSpan span("db", "DatabaseManager::loadActiveOAuthConnections");
+
+    static const std::string sql =
+        std::string(sqlite_codec::SELECT_SQL<qmark::OAuthConnection>.view()) + " WHERE is_active = 1;";
+
+    // Shards are read concurrently, then concatenated
+    std::vector<std::vector<qmark::OAuthConnection>> parts(shardCount());
+    forEachShard([&](Shard& shard) {
+        ConnectionLease lease(shard);
+        auto& connections = parts[shard.index];
+
+        if (!shard.db) {
+            Logger::error("Database not initialized");
+            return;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard.db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare load OAuth connections statement: " + std::string(sqlite3_errmsg(shard.db)));
+            return;
+        }
+
+        sqlite_codec::ColumnMap<qmark::OAuthConnection> columns(stmt);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            columns.read(stmt, connections.emplace_back());
+        }
+
+        sqlite3_finalize(stmt);
+    });
+
+    std::vector<qmark::OAuthConnection> connections = std::move(parts[0]);
+    for (size_t i = 1; i < parts.size(); i++) {
+        std::move(parts[i].begin(), parts[i].end(), std::back_inserter(connections));
+    }
+    return connections;
+}
+
+bool DatabaseManager::saveOAuthConnections(const std::vector<qmark::OAuthConnection>& connections) {
+    TraceSpan span("db", "DatabaseManager::saveOAuthConnections");
+
+    if (connections.empty()) {
+        return true;
+    }
+
+    constexpr auto& sql = sqlite_codec::UPSERT_SQL<qmark::OAuthConnection>;
+
+    bool all_ok = true;
+    for (const auto& [shard, indices] : groupByShard(connections, [](const qmark::OAuthConnection& c) { return c.user_id; })) {
+        ConnectionLease lease(*shard);
+
+        if (!shard->db) {
+            Logger::error("Database not initialized");
+            return false;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard->db, sql.c_str(), static_cast<int>(sql.view().size()), &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare save OAuth connections statement: " + std::string(sqlite3_errmsg(shard->db)));
+            all_ok = false;
+            continue;
+        }
+
+        execute(shard->db, "BEGIN TRANSACTION;");
+
+        bool ok = true;
+        for (size_t index : indices) {
+            sqlite_codec::bindFields(stmt, connections[index]);
+
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                Logger::error("Failed to save OAuth connection: " + std::string(sqlite3_errmsg(shard->db)));
+                ok = false;
+                break;
+            }
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+
+        sqlite3_finalize(stmt);
+        execute(shard->db, ok ? "COMMIT;" : "ROLLBACK;");
+        all_ok = all_ok && ok;
+    }
+    return all_ok;
+}
+
+std::optional<std::vector<qmark::ConnectionId>> DatabaseManager::deleteOAuthConnections(
+    const std::string& provider, const std::string& provider_user_id) {
+    TraceSpan span("db", "DatabaseManager::deleteOAuthConnections");
+
+    // Keyed by the provider's user, not ours: every shard is asked
+    const char* sql = "DELETE FROM oauth_connections WHERE provider = ? AND provider_user_id = ? RETURNING id;";
+
+    std::vector<qmark::ConnectionId> ids;
+    for (Shard* shard : tenantShards()) {
+        ConnectionLease lease(*shard);
+
+        if (!shard->db) {
+            Logger::error("Database not initialized");
+            return std::nullopt;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard->db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare delete OAuth connections statement: " + std::string(sqlite3_errmsg(shard->db)));
+            return std::nullopt;
+        }
+
+        sqlite3_bind_text(stmt, 1, provider.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 2, provider_user_id.c_str(), -1, SQLITE_STATIC);
+
+        int rc;
+        while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+            ids.push_back(static_cast<qmark::ConnectionId>(sqlite3_column_int64(stmt, 0)));
+        }
+        sqlite3_finalize(stmt);
+
+        if (rc != SQLITE_DONE) {
+            Logger::error("Failed to delete OAuth connections: " + std::string(sqlite3_errmsg(shard->db)));
+            return std::nullopt;
+        }
+    }
+    return ids;
+}
+
+bool DatabaseManager::saveAutomation(qmark::Automation& automation) {
+    TraceSpan span("db", "DatabaseManager::saveAutomation");
+
+    Shard& shard = tenantShard(automation.user_id);
+    ConnectionLease lease(shard);
+
+    if (!shard.db) {
+        Logger::error("Database not initialized");
+        return false;
+    }
+
+    constexpr auto& sql = sqlite_codec::UPSERT_SQL<qmark::Automation>;
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(shard.db, sql.c_str(), static_cast<int>(sql.view().size()), &stmt, nullptr) != SQLITE_OK) {
+        Logger::error("Failed to prepare save automation statement: " + std::string(sqlite3_errmsg(shard.db)));
+        return false;
+    }
+
+    qmark::Automation row = automation;
+    if (row.id == 0) {
+        row.id = static_cast<qmark::AutomationId>(allocateId(shard, "automations"));
+    }
+    sqlite_codec::bindFields(stmt, row);
+
+    int result = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+
+    if (result != SQLITE_DONE) {
+        Logger::error("Failed to save automation: " + std::string(sqlite3_errmsg(shard.db)));
+        return false;
+    }
+
+    if (automation.id == 0) {
+        automation.id = row.id != 0 ? row.id : static_cast<qmark::AutomationId>(sqlite3_last_insert_rowid(shard.db));
+    }
+    return true;
+}
+
+std::vector<qmark::Automation> DatabaseManager::loadActiveAutomations() {
+    TraceSpan span("db", "DatabaseManager::loadActiveAutomations");
+
+    static const std::string sql =
+        std::string(sqlite_codec::SELECT_SQL<qmark::Automation>.view()) + " WHERE is_active = 1;";
+
+    std::vector<std::vector<qmark::Automation>> parts(shardCount());
+    forEachShard([&](Shard& shard) {
+        ConnectionLease lease(shard);
+        auto& automations = parts[shard.index];
+
+        if (!shard.db) {
+            Logger::error("Database not initialized");
+            return;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard.db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare load automations statement: " + std::string(sqlite3_errmsg(shard.db)));
+            return;
+        }
+
+        sqlite_codec::ColumnMap<qmark::Automation> columns(stmt);
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            columns.read(stmt, automations.emplace_back());
+        }
+
+        sqlite3_finalize(stmt);
+    });
+
+    std::vector<qmark::Automation> automations = std::move(parts[0]);
+    for (size_t i = 1; i < parts.size(); i++) {
+        std::move(parts[i].begin(), parts[i].end(), std::back_inserter(automations));
+    }
+    return automations;
+}
+
+bool DatabaseManager::recordAutomationRuns(const std::vector<AutomationRunRecord>& runs) {
+    TraceSpan span("db", "DatabaseManager::recordAutomationRuns");
+
+    if (runs.empty()) {
+        return true;
+    }
+
+    bool all_ok = true;
+    for (const auto& [shard, indices] : groupByShard(runs, [](const AutomationRunRecord& run) { return run.user_id; })) {
+        ConnectionLease lease(*shard);
+        sqlite3* db = shard->db;
+
+        if (!db) {
+            Logger::error("Database not initialized");
+            return false;
+        }
+
+        // Several runs of one automation in a batch collapse into one UPDATE
+        std::map<uint64_t, std::pair<int64_t, int64_t>> totals;     // id -> (last_run, runs)
+        for (size_t index : indices) {
+            const auto& run = runs[index];
+            auto& [last_run, count] = totals[run.automation_id];
+            last_run = std::max(last_run, run.finished_at);
+            count++;
+        }
+
+        sqlite3_stmt* update_stmt;
+        sqlite3_stmt* activity_stmt;
+        if (sqlite3_prepare_v2(db,
+                "UPDATE automations SET last_run = ?, run_count = run_count + ?, updated_at = ? WHERE id = ?;",
+                -1, &update_stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare automation run update: " + std::string(sqlite3_errmsg(db)));
+            all_ok = false;
+            continue;
+        }
+        if (sqlite3_prepare_v2(db,
+                "INSERT INTO activities (user_id, type, title, description, created_at) VALUES (?, ?, ?, ?, ?);",
+                -1, &activity_stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare activity insert: " + std::string(sqlite3_errmsg(db)));
+            sqlite3_finalize(update_stmt);
+            all_ok = false;
+            continue;
+        }
+
+        execute(db, "BEGIN TRANSACTION;");
+
+        bool ok = true;
+        for (const auto& [id, total] : totals) {
+            sqlite3_bind_int64(update_stmt, 1, total.first);
+            sqlite3_bind_int64(update_stmt, 2, total.second);
+            sqlite3_bind_int64(update_stmt, 3, total.first);
+            sqlite3_bind_int64(update_stmt, 4, static_cast<sqlite3_int64>(id));
+
+            if (sqlite3_step(update_stmt) != SQLITE_DONE) {
+                Logger::error("Failed to update automation run: " + std::string(sqlite3_errmsg(db)));
+                ok = false;
+                break;
+            }
+            sqlite3_reset(update_stmt);
+        }
+
+        // Activity ids are local to a shard: nothing refers to them
+        for (size_t i = 0; ok && i < indices.size(); i++) {
+            const auto& run = runs[indices[i]];
+            sqlite3_bind_int64(activity_stmt, 1, run.user_id);
+            sqlite3_bind_text(activity_stmt, 2, run.success ? "automation_run" : "automation_failed", -1, SQLITE_STATIC);
+            sqlite3_bind_text(activity_stmt, 3, run.title.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(activity_stmt, 4, run.detail.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(activity_stmt, 5, run.finished_at);
+
+            if (sqlite3_step(activity_stmt) != SQLITE_DONE) {
+                Logger::error("Failed to insert activity: " + std::string(sqlite3_errmsg(db)));
+                ok = false;
+            }
+            sqlite3_reset(activity_stmt);
+        }
+
+        sqlite3_finalize(update_stmt);
+        sqlite3_finalize(activity_stmt);
+        execute(db, ok ? "COMMIT;" : "ROLLBACK;");
+        all_ok = all_ok && ok;
+    }
+    return all_ok;
+}
+
+bool DatabaseManager::loadLeadKeys(const std::function<void(qmark::LeadId, qmark::UserId, std::string_view, std::string_view)>& visit) {
+    TraceSpan span("db", "DatabaseManager::loadLeadKeys");
+
+    // Shard after shard: the visitor is not required to be thread-safe
+    for (Shard* shard : tenantShards()) {
+        ConnectionLease lease(*shard);
+
+        if (!shard->db) {
+            Logger::error("Database not initialized");
+            return false;
+        }
+
+        // Streamed row by row: millions of leads never sit in memory as rows
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard->db, "SELECT id, user_id, email, phone FROM leads;", -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare load lead keys statement: " + std::string(sqlite3_errmsg(shard->db)));
+            return false;
+        }
+
+        int result;
+        while ((result = sqlite3_step(stmt)) == SQLITE_ROW) {
+            auto text = [stmt](int column) {
+                const char* value = reinterpret_cast<const char*>(sqlite3_column_text(stmt, column));
+                return value ? std::string_view(value, static_cast<size_t>(sqlite3_column_bytes(stmt, column)))
+                             : std::string_view();
+            };
+            visit(static_cast<qmark::LeadId>(sqlite3_column_int64(stmt, 0)),
+                  static_cast<qmark::UserId>(sqlite3_column_int64(stmt, 1)), text(2), text(3));
+        }
+
+        sqlite3_finalize(stmt);
+        if (result != SQLITE_DONE) {
+            Logger::error("Failed to load lead keys: " + std::string(sqlite3_errmsg(shard->db)));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DatabaseManager::writeLeads(std::vector<qmark::Lead>& inserts, const std::vector<qmark::Lead>& merges) {
+    TraceSpan span("db", "DatabaseManager::writeLeads");
+
+    if (inserts.empty() && merges.empty()) {
+        return true;
+    }
+
+    // Both halves of the batch, per shard
+    auto user_of = [](const qmark::Lead& lead) { return lead.user_id; };
+    std::map<Shard*, std::pair<std::vector<size_t>, std::vector<size_t>>> groups;
+    for (auto& [shard, indices] : groupByShard(inserts, user_of)) {
+        groups[shard].first = std::move(indices);
+    }
+    for (auto& [shard, indices] : groupByShard(merges, user_of)) {
+        groups[shard].second = std::move(indices);
+    }
+
+    constexpr auto& insert_sql = sqlite_codec::UPSERT_SQL<qmark::Lead>;
+
+    bool all_ok = true;
+    for (const auto& [shard, batch] : groups) {
+        const auto& [insert_indices, merge_indices] = batch;
+        ConnectionLease lease(*shard);
+        sqlite3* db = shard->db;
+
+        if (!db) {
+            Logger::error("Database not initialized");
+            return false;
+        }
+
+        sqlite3_stmt* insert_stmt;
+        sqlite3_stmt* merge_stmt;
+        if (sqlite3_prepare_v2(db, insert_sql.c_str(), static_cast<int>(insert_sql.view().size()), &insert_stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare lead insert: " + std::string(sqlite3_errmsg(db)));
+            all_ok = false;
+            continue;
+        }
+        // A merge only fills in what the stored lead is missing
+        if (sqlite3_prepare_v2(db,
+                "UPDATE leads SET name = CASE WHEN name = '' THEN ?1 ELSE name END, "
+                "email = CASE WHEN email = '' THEN ?2 ELSE email END, "
+                "phone = CASE WHEN phone = '' THEN ?3 ELSE phone END, "
+                "updated_at = ?4 WHERE id = ?5;",
+                -1, &merge_stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare lead merge: " + std::string(sqlite3_errmsg(db)));
+            sqlite3_finalize(insert_stmt);
+            all_ok = false;
+            continue;
+        }
+
+        execute(db, "BEGIN TRANSACTION;");
+
+        bool ok = true;
+        for (size_t i = 0; ok && i < insert_indices.size(); i++) {
+            qmark::Lead& lead = inserts[insert_indices[i]];
+            if (lead.id == 0) {
+                lead.id = static_cast<qmark::LeadId>(allocateId(*shard, "leads"));
+            }
+            sqlite_codec::bindFields(insert_stmt, lead);
+
+            if (sqlite3_step(insert_stmt) != SQLITE_DONE) {
+                Logger::error("Failed to insert lead: " + std::string(sqlite3_errmsg(db)));
+                ok = false;
+            } else if (lead.id == 0) {
+                lead.id = static_cast<qmark::LeadId>(sqlite3_last_insert_rowid(db));
+            }
+            sqlite3_reset(insert_stmt);
+            sqlite3_clear_bindings(insert_stmt);
+        }
+
+        for (size_t i = 0; ok && i < merge_indices.size(); i++) {
+            const qmark::Lead& lead = merges[merge_indices[i]];
+            sqlite3_bind_text(merge_stmt, 1, lead.name.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(merge_stmt, 2, lead.email.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_text(merge_stmt, 3, lead.phone.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(merge_stmt, 4, reflect::toUnixSeconds(lead.updated_at));
+            sqlite3_bind_int64(merge_stmt, 5, static_cast<sqlite3_int64>(lead.id));
+
+            if (sqlite3_step(merge_stmt) != SQLITE_DONE) {
+                Logger::error("Failed to merge lead: " + std::string(sqlite3_errmsg(db)));
+                ok = false;
+            }
+            sqlite3_reset(merge_stmt);
+        }
+
+        sqlite3_finalize(insert_stmt);
+        sqlite3_finalize(merge_stmt);
+        execute(db, ok ? "COMMIT;" : "ROLLBACK;");
+
+        // Ids handed out inside a rolled back transaction do not exist
+        if (!ok) {
+            for (size_t index : insert_indices) {
+                inserts[index].id = 0;
+            }
+        }
+        all_ok = all_ok && ok;
+    }
+    return all_ok;
+}
+
+bool DatabaseManager::loadMetrics(uint64_t after_revision, const std::function<void(const qmark::DailyMetrics&)>& visit) {
+    TraceSpan span("db", "DatabaseManager::loadMetrics");
+
+    static const std::string sql =
+        std::string(sqlite_codec::SELECT_SQL<qmark::DailyMetrics>.view()) + " WHERE revision > ?;";
+
+    for (Shard* shard : tenantShards()) {
+        ConnectionLease lease(*shard);
+
+        if (!shard->db) {
+            Logger::error("Database not initialized");
+            return false;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard->db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare load metrics statement: " + std::string(sqlite3_errmsg(shard->db)));
+            return false;
+        }
+        sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(after_revision));
+
+        sqlite_codec::ColumnMap<qmark::DailyMetrics> columns(stmt);
+        qmark::DailyMetrics day;
+        int result;
+        while ((result = sqlite3_step(stmt)) == SQLITE_ROW) {
+            columns.read(stmt, day);
+            visit(day);
+        }
+
+        sqlite3_finalize(stmt);
+        if (result != SQLITE_DONE) {
+            Logger::error("Failed to load metrics: " + std::string(sqlite3_errmsg(shard->db)));
+            return false;
+        }
+    }
+    return true;
+}
+
+bool DatabaseManager::saveMetrics(const std::vector<qmark::DailyMetrics>& days) {
+    TraceSpan span("db", "DatabaseManager::saveMetrics");
+
+    if (days.empty()) {
+        return true;
+    }
+
+    constexpr auto& sql = sqlite_codec::UPSERT_SQL<qmark::DailyMetrics>;
+
+    bool all_ok = true;
+    for (const auto& [shard, indices] : groupByShard(days, [](const qmark::DailyMetrics& day) { return day.user_id; })) {
+        ConnectionLease lease(*shard);
+
+        if (!shard->db) {
+            Logger::error("Database not initialized");
+            return false;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard->db, sql.c_str(), static_cast<int>(sql.view().size()), &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare save metrics statement: " + std::string(sqlite3_errmsg(shard->db)));
+            all_ok = false;
+            continue;
+        }
+
+        execute(shard->db, "BEGIN TRANSACTION;");
+
+        bool ok = true;
+        for (size_t index : indices) {
+            sqlite_codec::bindFields(stmt, days[index]);
+
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                Logger::error("Failed to save metrics: " + std::string(sqlite3_errmsg(shard->db)));
+                ok = false;
+                break;
+            }
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+
+        sqlite3_finalize(stmt);
+        execute(shard->db, ok ? "COMMIT;" : "ROLLBACK;");
+        all_ok = all_ok && ok;
+    }
+    return all_ok;
+}
+
+std::span<const std::string_view> DatabaseManager::exportColumns(ExportTable table) {
+    // Same order as the SELECT lists in exportPage
+    static constexpr std::string_view LEAD_COLUMNS[] = {
+        "id", "name", "email", "phone", "source", "status", "notes", "metadata", "created_at", "updated_at"
+    };
+    static constexpr std::string_view ACTIVITY_COLUMNS[] = {
+        "id", "type", "title", "description", "metadata", "created_at"
+    };
+    if (table == ExportTable::LEADS) {
+        return LEAD_COLUMNS;
+    }
+    return ACTIVITY_COLUMNS;
+}
+
+bool DatabaseManager::exportPage(ExportTable table, qmark::UserId user_id, ExportCursor& cursor, size_t limit,
+                                 const std::function<bool(std::span<const ExportValue>)>& visit) {
+    TraceSpan span("db", "DatabaseManager::exportPage");
+
+    // Keyset pages: each one seeks to where the previous one stopped, through
+    // idx_leads_user_id (user_id, rowid) or idx_activities_user_created
+    static const char* const LEADS_SQL =
+        "SELECT id, name, email, phone, source, status, notes, metadata, created_at, updated_at "
+        "FROM leads WHERE user_id = ? AND id > ? ORDER BY id LIMIT ?;";
+    static const char* const ACTIVITIES_SQL =
+        "SELECT id, type, title, description, metadata, created_at "
+        "FROM activities WHERE user_id = ? AND (created_at, id) > (?, ?) ORDER BY created_at, id LIMIT ?;";
+    constexpr size_t MAX_COLUMNS = 10;
+
+    bool leads = table == ExportTable::LEADS;
+    size_t column_count = exportColumns(table).size();
+    int created_at_column = static_cast<int>(leads ? column_count - 2 : column_count - 1);
+
+    Shard& shard = tenantShard(user_id);
+    ConnectionLease lease(shard);
+
+    if (!shard.db) {
+        Logger::error("Database not initialized");
+        return false;
+    }
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(shard.db, leads ? LEADS_SQL : ACTIVITIES_SQL, -1, &stmt, nullptr) != SQLITE_OK) {
+        Logger::error("Failed to prepare export statement: " + std::string(sqlite3_errmsg(shard.db)));
+        return false;
+    }
+    int param = 1;
+    sqlite3_bind_int64(stmt, param++, user_id);
+    if (!leads) {
+        sqlite3_bind_int64(stmt, param++, cursor.after_created_at);
+    }
+    sqlite3_bind_int64(stmt, param++, cursor.after_id);
+    sqlite3_bind_int64(stmt, param, static_cast<sqlite3_int64>(limit));
+
+    ExportValue values[MAX_COLUMNS];
+    size_t rows = 0;
+    bool stopped = false;
+    int result = SQLITE_DONE;
+    while (!stopped && (result = sqlite3_step(stmt)) == SQLITE_ROW) {
+        for (size_t i = 0; i < column_count; i++) {
+            int column = static_cast<int>(i);
+            ExportValue& value = values[i];
+            switch (sqlite3_column_type(stmt, column)) {
+                case SQLITE_NULL:
+                    value.type = ExportValue::Type::NUL;
+                    break;
+                case SQLITE_INTEGER:
+                    value.type = ExportValue::Type::INTEGER;
+                    value.integer = sqlite3_column_int64(stmt, column);
+                    break;
+                case SQLITE_FLOAT:
+                    value.type = ExportValue::Type::REAL;
+                    value.real = sqlite3_column_double(stmt, column);
+                    break;
+                default: {
+                    const unsigned char* text = sqlite3_column_text(stmt, column);
+                    value.type = ExportValue::Type::TEXT;
+                    value.text = text ? std::string_view(reinterpret_cast<const char*>(text),
+                                                         static_cast<size_t>(sqlite3_column_bytes(stmt, column)))
+                                      : std::string_view();
+                    break;
+                }
+            }
+        }
+        cursor.after_id = sqlite3_column_int64(stmt, 0);
+        cursor.after_created_at = sqlite3_column_int64(stmt, created_at_column);
+        rows++;
+        stopped = !visit(std::span<const ExportValue>(values, column_count));
+    }
+
+    sqlite3_finalize(stmt);
+    if (!stopped && result != SQLITE_DONE) {
+        Logger::error("Failed to read export page: " + std::string(sqlite3_errmsg(shard.db)));
+        return false;
+    }
+    // A short page is the last one
+    cursor.done = !stopped && rows < limit;
+    return true;
+}
+
+std::vector<SessionRecord> DatabaseManager::loadSessions(int64_t not_expired_after) {
+    TraceSpan span("db", "DatabaseManager::loadSessions");
+
+    std::string sql =
+        "SELECT id, user_id, data, CAST(strftime('%s', expires_at) AS INTEGER) "
+        "FROM sessions WHERE expires_at > datetime(?, 'unixepoch');";
+
+    std::vector<std::vector<SessionRecord>> parts(shardCount());
+    forEachShard([&](Shard& shard) {
+        ConnectionLease lease(shard);
+        auto& sessions = parts[shard.index];
+
+        if (!shard.db) {
+            Logger::error("Database not initialized");
+            return;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard.db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare load sessions statement: " + std::string(sqlite3_errmsg(shard.db)));
+            return;
+        }
+
+        sqlite3_bind_int64(stmt, 1, not_expired_after);
+
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            SessionRecord record;
+            const char* id = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            const char* data = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+
+            record.id = id ? id : "";
+            record.user_id = sqlite3_column_int64(stmt, 1);
+            record.data = data ? data : "";
+            record.expires_at = sqlite3_column_int64(stmt, 3);
+            sessions.push_back(std::move(record));
+        }
+
+        sqlite3_finalize(stmt);
+    });
+
+    std::vector<SessionRecord> sessions = std::move(parts[0]);
+    for (size_t i = 1; i < parts.size(); i++) {
+        std::move(parts[i].begin(), parts[i].end(), std::back_inserter(sessions));
+    }
+    return sessions;
+}
+
+bool DatabaseManager::saveSessions(const std::vector<SessionRecord>& sessions) {
+    TraceSpan span("db", "DatabaseManager::saveSessions");
+
+    if (sessions.empty()) {
+        return true;
+    }
+
+    std::string sql =
+        "INSERT OR REPLACE INTO sessions (id, user_id, data, expires_at) "
+        "VALUES (?, ?, ?, datetime(?, 'unixepoch'));";
+
+    bool all_ok = true;
+    for (const auto& [shard, indices] : groupByShard(sessions, [](const SessionRecord& session) { return session.user_id; })) {
+        ConnectionLease lease(*shard);
+
+        if (!shard->db) {
+            Logger::error("Database not initialized");
+            return false;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard->db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare save sessions statement: " + std::string(sqlite3_errmsg(shard->db)));
+            all_ok = false;
+            continue;
+        }
+
+        execute(shard->db, "BEGIN TRANSACTION;");
+
+        bool ok = true;
+        for (size_t index : indices) {
+            const auto& session = sessions[index];
+            sqlite3_bind_text(stmt, 1, session.id.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 2, session.user_id);
+            sqlite3_bind_text(stmt, 3, session.data.c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int64(stmt, 4, session.expires_at);
+
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                Logger::error("Failed to save session: " + std::string(sqlite3_errmsg(shard->db)));
+                ok = false;
+                break;
+            }
+
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+
+        sqlite3_finalize(stmt);
+        execute(shard->db, ok ? "COMMIT;" : "ROLLBACK;");
+        all_ok = all_ok && ok;
+    }
+    return all_ok;
+}
+
+bool DatabaseManager::updateSessionExpiry(const std::vector<std::pair<std::string, int64_t>>& expiries) {
+    TraceSpan span("db", "DatabaseManager::updateSessionExpiry");
+
+    if (expiries.empty()) {
+        return true;
+    }
+
+    std::string sql = "UPDATE sessions SET expires_at = datetime(?, 'unixepoch') WHERE id = ?;";
+
+    // Only the session id is known here: each shard updates the rows it has
+    bool all_ok = true;
+    for (Shard* shard : tenantShards()) {
+        ConnectionLease lease(*shard);
+
+        if (!shard->db) {
+            Logger::error("Database not initialized");
+            return false;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard->db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare update session statement: " + std::string(sqlite3_errmsg(shard->db)));
+            all_ok = false;
+            continue;
+        }
+
+        execute(shard->db, "BEGIN TRANSACTION;");
+
+        bool ok = true;
+        for (const auto& [id, expires_at] : expiries) {
+            sqlite3_bind_int64(stmt, 1, expires_at);
+            sqlite3_bind_text(stmt, 2, id.c_str(), -1, SQLITE_STATIC);
+
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                Logger::error("Failed to update session expiry: " + std::string(sqlite3_errmsg(shard->db)));
+                ok = false;
+                break;
+            }
+
+            sqlite3_reset(stmt);
+            sqlite3_clear_bindings(stmt);
+        }
+
+        sqlite3_finalize(stmt);
+        execute(shard->db, ok ? "COMMIT;" : "ROLLBACK;");
+        all_ok = all_ok && ok;
+    }
+    return all_ok;
+}
+
+bool DatabaseManager::deleteSessions(const std::vector<std::string>& session_ids) {
+    TraceSpan span("db", "DatabaseManager::deleteSessions");
+
+    if (session_ids.empty()) {
+        return true;
+    }
+
+    std::string sql = "DELETE FROM sessions WHERE id = ?;";
+
+    bool all_ok = true;
+    for (Shard* shard : tenantShards()) {
+        ConnectionLease lease(*shard);
+
+        if (!shard->db) {
+            Logger::error("Database not initialized");
+            return false;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard->db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare delete session statement: " + std::string(sqlite3_errmsg(shard->db)));
+            all_ok = false;
+            continue;
+        }
+
+        execute(shard->db, "BEGIN TRANSACTION;");
+
+        bool ok = true;
+        for (const auto& id : session_ids) {
+            sqlite3_bind_text(stmt, 1, id.c_str(), -1, SQLITE_STATIC);
+
+            if (sqlite3_step(stmt) != SQLITE_DONE) {
+                Logger::error("Failed to delete session: " + std::string(sqlite3_errmsg(shard->db)));
+                ok = false;
+                break;
+            }
+
+            sqlite3_reset(stmt);
+        }
+
+        sqlite3_finalize(stmt);
+        execute(shard->db, ok ? "COMMIT;" : "ROLLBACK;");
+        all_ok = all_ok && ok;
+    }
+    return all_ok;
+}
+
+bool DatabaseManager::purgeExpiredSessions(int64_t now) {
+    TraceSpan span("db", "DatabaseManager::purgeExpiredSessions");
+
+    std::atomic<bool> ok{true};
+    forEachShard([&](Shard& shard) {
+        ConnectionLease lease(shard);
+
+        if (!shard.db) {
+            Logger::error("Database not initialized");
+            ok = false;
+            return;
+        }
+
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(shard.db, "DELETE FROM sessions WHERE expires_at <= datetime(?, 'unixepoch');",
+                               -1, &stmt, nullptr) != SQLITE_OK) {
+            Logger::error("Failed to prepare purge sessions statement: " + std::string(sqlite3_errmsg(shard.db)));
+            ok = false;
+            return;
+        }
+
+        sqlite3_bind_int64(stmt, 1, now);
+        int result = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+
+        if (result != SQLITE_DONE) {
+            Logger::error("Failed to purge expired sessions: " + std::string(sqlite3_errmsg(shard.db)));
+            ok = false;
+        }
+    });
+
+    return ok;
+}
+
+bool DatabaseManager::saveSnapshotToken(const std::string& name, uint64_t token) {
+    TraceSpan span("db", "DatabaseManager::saveSnapshotToken");
+    ConnectionLease lease(catalog_);
+
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(catalog_.db, "INSERT OR REPLACE INTO cache_snapshots (name, token) VALUES (?, ?);",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        Logger::error("Failed to prepare save snapshot token statement: " + std::string(sqlite3_errmsg(catalog_.db)));
+        return false;
+    }
+
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(token));
+    int result = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+
+    if (result != SQLITE_DONE) {
+        Logger::error("Failed to save snapshot token: " + std::string(sqlite3_errmsg(catalog_.db)));
+        return false;
+    }
+    return true;
+}
+
+std::optional<uint64_t> DatabaseManager::takeSnapshotToken(const std::string& name) {
+    TraceSpan span("db", "DatabaseManager::takeSnapshotToken");
+    ConnectionLease lease(catalog_);
+
+    // Deleted as it is read: a run that stops without writing a new snapshot
+    // leaves no token behind
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(catalog_.db, "DELETE FROM cache_snapshots WHERE name = ? RETURNING token;",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        Logger::error("Failed to prepare take snapshot token statement: " + std::string(sqlite3_errmsg(catalog_.db)));
+        return std::nullopt;
+    }
+
+    sqlite3_bind_text(stmt, 1, name.c_str(), -1, SQLITE_STATIC);
+    std::optional<uint64_t> token;
+    int result = sqlite3_step(stmt);
+    if (result == SQLITE_ROW) {
+        token = static_cast<uint64_t>(sqlite3_column_int64(stmt, 0));
+        result = sqlite3_step(stmt);
+    }
+    sqlite3_finalize(stmt);
+
+    if (result != SQLITE_DONE) {
+        Logger::error("Failed to take snapshot token: " + std::string(sqlite3_errmsg(catalog_.db)));
+        return std::nullopt;
+    }
+    return token;
+}
+
+} // namespace QMark
@@ -0,0 +1,108 @@
+#include "ingest/webhook_handlers.hpp"
+#include "leads/lead_index.hpp"
+#include "analytics/metrics_store.hpp"
+#include "outbound/token_refresher.hpp"
+#include "server/event_hub.hpp"
+#include "database/database_manager.hpp"
+#include "utils/json_reader.hpp"
+#include "utils/logger.hpp"
+#include "utils/tracing.hpp"
+
+namespace QMark {
+
+namespace {
+
+bool rejectPayload(const WebhookEvent& event, const std::string& reason) {
+    Logger::warn("Discarding webhook " + event.source + " #" + std::to_string(event.seq) + ": " + reason);
+    return true;
+}
+
+} // namespace
+
+bool handleLeadWebhook(const WebhookEvent& event) {
+    TraceSpan span("webhooks", "handleLeadWebhook");
+
+    thread_local JsonReader reader;
+    if (!reader.parse(event.body) || reader.root().type != JsonType::OBJECT) {
+        return rejectPayload(event, "invalid JSON");
+    }
+
+    int64_t user_id = 0;
+    const JsonReader::Value* user = reader.find("user_id");
+    if (!user || !JsonReader::getInt64(*user, user_id) || user_id <= 0) {
+        return rejectPayload(event, "missing user_id");
+    }
+
+    const JsonReader::Value* items = reader.find("leads");
+    if (!items || items->type != JsonType::ARRAY) {
+        return rejectPayload(event, "missing leads array");
+    }
+
+    std::vector<qmark::Lead> leads;
+    leads.reserve(reader.elementCount(*items));
+    reader.forEachElement(*items, [&](const JsonReader::Value& item) {
+        if (item.type != JsonType::OBJECT) {
+            return;
+        }
+        qmark::Lead& lead = leads.emplace_back();
+        reader.forEachMember(item, [&](std::string_view key, const JsonReader::Value& value) {
+            if (JsonReader::keyEquals(key, "name")) {
+                JsonReader::getString(value, lead.name);
+            } else if (JsonReader::keyEquals(key, "email")) {
+                JsonReader::getString(value, lead.email);
+            } else if (JsonReader::keyEquals(key, "phone")) {
+                JsonReader::getString(value, lead.phone);
+            } else if (JsonReader::keyEquals(key, "source")) {
+                JsonReader::getString(value, lead.source);
+            } else if (JsonReader::keyEquals(key, "notes")) {
+                JsonReader::getString(value, lead.notes);
+            }
+        });
+        if (lead.source.empty()) {
+            lead.source = event.source;
+        }
+    });
+    if (leads.empty()) {
+        return true;
+    }
+
+    // Replays after a crash land on the leads already written and merge into them
+    auto result = LeadIndex::getInstance().upsert(user_id, leads);
+    if (!result) {
+        return false;
+    }
+
+    if (result->inserted > 0) {
+        // Counted on the day the platform delivered them, not the day a replay processed them
+        int32_t day = MetricsStore::dayOf(qmark::Timestamp(std::chrono::milliseconds(event.received_at_ms)));
+        MetricsStore::getInstance().record(user_id, day, {.leads = static_cast<int32_t>(result->inserted)});
+        EventHub::getInstance().publishDelta(user_id, "leads", static_cast<int64_t>(result->inserted));
+    }
+    return true;
+}
+
+bool handleFacebookDeletion(const WebhookEvent& event) {
+    TraceSpan span("webhooks", "handleFacebookDeletion");
+
+    thread_local JsonReader reader;
+    std::string provider_user_id;
+    const JsonReader::Value* user = nullptr;
+    if (!reader.parse(event.body) || !(user = reader.find("user_id")) ||
+        !JsonReader::getString(*user, provider_user_id) || provider_user_id.empty()) {
+        return rejectPayload(event, "missing user_id");
+    }
+
+    auto deleted = DatabaseManager::getInstance().deleteOAuthConnections("facebook", provider_user_id);
+    if (!deleted) {
+        return false;
+    }
+
+    for (qmark::ConnectionId id : *deleted) {
+        TokenRefresher::getInstance().untrack(id);
+    }
+    Logger::info("Facebook data deletion " + event.delivery_id + ": " + std::to_string(deleted->size()) +
+                 " OAuth connections removed");
+    return true;
+}
+
+} // namespace QMark
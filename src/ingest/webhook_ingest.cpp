@@ -0,0 +1,909 @@
+#include "ingest/webhook_ingest.hpp"
+#include "security/encryption.hpp"
+#include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+#include "utils/tracing.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+
+namespace QMark {
+
+namespace {
+
+// Segment file: magic, then records
+//   u32 length, u32 crc32 (of the next `length` bytes),
+//   u64 seq, i64 received_at_ms, u16 source_len, u16 delivery_len, u32 body_len,
+//   source, delivery id, body
+constexpr char SEGMENT_MAGIC[8] = {'Q', 'M', 'K', 'W', 'A', 'L', '1', '\n'};
+constexpr uint64_t SEGMENT_HEADER_SIZE = sizeof(SEGMENT_MAGIC);
+constexpr size_t RECORD_PREFIX_SIZE = 8;
+constexpr size_t RECORD_FIXED_SIZE = 8 + 8 + 2 + 2 + 4;
+constexpr uint32_t MAX_RECORD_SIZE = 256u * 1024 * 1024;
+
+// Accounted per queued event on top of its strings
+constexpr size_t EVENT_OVERHEAD = sizeof(WebhookEvent) + 64;
+
+size_t eventBytes(const WebhookEvent& event) {
+    return event.body.size() + event.source.size() + event.delivery_id.size() + EVENT_OVERHEAD;
+}
+
+std::string deliveryKey(const std::string& source, const std::string& delivery_id) {
+    std::string key;
+    key.reserve(source.size() + 1 + delivery_id.size());
+    key.append(source).append(1, '\n').append(delivery_id);
+    return key;
+}
+
+std::string segmentPath(const std::string& directory, uint64_t first_seq) {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020llu.wal", static_cast<unsigned long long>(first_seq));
+    return directory + "/" + name;
+}
+
+bool writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool syncDirectory(const std::string& directory) {
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+const char BASE64URL[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+
+// Unpadded, as Facebook sends it
+std::string base64UrlEncode(const std::vector<unsigned char>& bytes) {
+    std::string out;
+    out.reserve((bytes.size() + 2) / 3 * 4);
+    size_t i = 0;
+    for (; i + 2 < bytes.size(); i += 3) {
+        uint32_t n = (uint32_t{bytes[i]} << 16) | (uint32_t{bytes[i + 1]} << 8) | bytes[i + 2];
+        out += BASE64URL[(n >> 18) & 63];
+        out += BASE64URL[(n >> 12) & 63];
+        out += BASE64URL[(n >> 6) & 63];
+        out += BASE64URL[n & 63];
+    }
+    if (i + 1 == bytes.size()) {
+        uint32_t n = uint32_t{bytes[i]} << 16;
+        out += BASE64URL[(n >> 18) & 63];
+        out += BASE64URL[(n >> 12) & 63];
+    } else if (i + 2 == bytes.size()) {
+        uint32_t n = (uint32_t{bytes[i]} << 16) | (uint32_t{bytes[i + 1]} << 8);
+        out += BASE64URL[(n >> 18) & 63];
+        out += BASE64URL[(n >> 12) & 63];
+        out += BASE64URL[(n >> 6) & 63];
+    }
+    return out;
+}
+
+// Accepts both alphabets, with or without padding
+bool base64UrlDecode(std::string_view input, std::string& out) {
+    while (!input.empty() && input.back() == '=') {
+        input.remove_suffix(1);
+    }
+    if (input.size() % 4 == 1) {
+        return false;
+    }
+
+    out.clear();
+    out.reserve(input.size() * 3 / 4);
+    uint32_t buffer = 0;
+    int bits = 0;
+    for (char c : input) {
+        int value;
+        if (c >= 'A' && c <= 'Z') {
+            value = c - 'A';
+        } else if (c >= 'a' && c <= 'z') {
+            value = c - 'a' + 26;
+        } else if (c >= '0' && c <= '9') {
+            value = c - '0' + 52;
+        } else if (c == '-' || c == '+') {
+            value = 62;
+        } else if (c == '_' || c == '/') {
+            value = 63;
+        } else {
+            return false;
+        }
+        buffer = (buffer << 6) | static_cast<uint32_t>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out += static_cast<char>((buffer >> bits) & 0xFF);
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+WebhookIngest& WebhookIngest::getInstance() {
+    static WebhookIngest instance;
+    return instance;
+}
+
+WebhookIngest::WebhookIngest() : running_(false), received_(0), duplicates_(0), processed_(0), failed_(0) {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    received_counter_ = metrics.registerCounter("qmark_webhooks_received_total", "Webhook deliveries written to the journal and acknowledged.");
+    duplicate_counter_ = metrics.registerCounter("qmark_webhooks_duplicates_total", "Webhook deliveries acknowledged as already received.");
+    processed_counter_ = metrics.registerCounter("qmark_webhooks_processed_total", "Journaled webhooks handled by a consumer.");
+    failed_counter_ = metrics.registerCounter("qmark_webhooks_failed_total", "Journaled webhooks given up on after all attempts.");
+    metrics.registerCallback("qmark_webhooks_backlog", "Journaled webhooks not yet handled.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(stats().backlog); });
+}
+
+WebhookIngest::~WebhookIngest() {
+    stop();
+}
+
+int64_t WebhookIngest::nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool WebhookIngest::start(const WebhookIngestConfig& config) {
+    if (running_) {
+        return true;
+    }
+
+    config_ = config;
+    if (config_.consumers == 0) {
+        config_.consumers = 1;
+    }
+    if (config_.max_attempts == 0) {
+        config_.max_attempts = 1;
+    }
+
+    if (!recover()) {
+        return false;
+    }
+
+    running_ = true;
+    writer_thread_ = std::thread([this]() {
+        writerLoop();
+    });
+    for (size_t i = 0; i < config_.consumers; i++) {
+        consumer_threads_.emplace_back([this]() {
+            consumerLoop();
+        });
+    }
+
+    Logger::info("Webhook ingestion started with " + std::to_string(config_.sources.size()) + " sources, " +
+                 std::to_string(stats().backlog) + " events to replay");
+    return true;
+}
+
+void WebhookIngest::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    append_cv_.notify_all();
+    committed_cv_.notify_all();
+    work_cv_.notify_all();
+
+    // The writer drains appends already queued; consumers stop between events
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+    for (auto& thread : consumer_threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    consumer_threads_.clear();
+
+    checkpoint();
+    if (active_fd_ >= 0) {
+        ::close(active_fd_);
+        active_fd_ = -1;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.clear();
+        pending_bytes_ = 0;
+        in_flight_.clear();
+    }
+    Logger::info("Webhook ingestion stopped");
+}
+
+const WebhookSource* WebhookIngest::source(const std::string& name) const {
+    auto it = config_.sources.find(name);
+    return it == config_.sources.end() ? nullptr : &it->second;
+}
+
+void WebhookIngest::encodeRecord(const WebhookEvent& event, std::string& out) {
+    uint16_t source_length = static_cast<uint16_t>(event.source.size());
+    uint16_t delivery_length = static_cast<uint16_t>(event.delivery_id.size());
+    uint32_t body_length = static_cast<uint32_t>(event.body.size());
+    uint32_t length = static_cast<uint32_t>(RECORD_FIXED_SIZE + source_length + delivery_length + body_length);
+
+    size_t start = out.size();
+    out.resize(start + RECORD_PREFIX_SIZE + length);
+    char* p = out.data() + start;
+    std::memcpy(p, &length, 4);
+
+    char* record = p + RECORD_PREFIX_SIZE;
+    char* cursor = record;
+    std::memcpy(cursor, &event.seq, 8);
+    std::memcpy(cursor + 8, &event.received_at_ms, 8);
+    std::memcpy(cursor + 16, &source_length, 2);
+    std::memcpy(cursor + 18, &delivery_length, 2);
+    std::memcpy(cursor + 20, &body_length, 4);
+    cursor += RECORD_FIXED_SIZE;
+    std::memcpy(cursor, event.source.data(), source_length);
+    cursor += source_length;
+    std::memcpy(cursor, event.delivery_id.data(), delivery_length);
+    cursor += delivery_length;
+    std::memcpy(cursor, event.body.data(), body_length);
+
+    uint32_t crc = static_cast<uint32_t>(crc32(0L, reinterpret_cast<const Bytef*>(record), length));
+    std::memcpy(p + 4, &crc, 4);
+}
+
+WebhookIngest::ReadResult WebhookIngest::readRecord(std::FILE* file, WebhookEvent& event, uint64_t& length) {
+    char prefix[RECORD_PREFIX_SIZE];
+    size_t got = std::fread(prefix, 1, sizeof(prefix), file);
+    if (got == 0) {
+        return ReadResult::END;
+    }
+    if (got != sizeof(prefix)) {
+        return ReadResult::CORRUPT;
+    }
+
+    uint32_t record_length;
+    uint32_t crc;
+    std::memcpy(&record_length, prefix, 4);
+    std::memcpy(&crc, prefix + 4, 4);
+    if (record_length < RECORD_FIXED_SIZE || record_length > MAX_RECORD_SIZE) {
+        return ReadResult::CORRUPT;
+    }
+
+    thread_local std::string record;
+    record.resize(record_length);
+    if (std::fread(record.data(), 1, record_length, file) != record_length ||
+        static_cast<uint32_t>(crc32(0L, reinterpret_cast<const Bytef*>(record.data()), record_length)) != crc) {
+        return ReadResult::CORRUPT;
+    }
+
+    uint16_t source_length;
+    uint16_t delivery_length;
+    uint32_t body_length;
+    const char* p = record.data();
+    std::memcpy(&event.seq, p, 8);
+    std::memcpy(&event.received_at_ms, p + 8, 8);
+    std::memcpy(&source_length, p + 16, 2);
+    std::memcpy(&delivery_length, p + 18, 2);
+    std::memcpy(&body_length, p + 20, 4);
+    if (RECORD_FIXED_SIZE + source_length + delivery_length + uint64_t{body_length} != record_length) {
+        return ReadResult::CORRUPT;
+    }
+
+    p += RECORD_FIXED_SIZE;
+    event.source.assign(p, source_length);
+    p += source_length;
+    event.delivery_id.assign(p, delivery_length);
+    p += delivery_length;
+    event.body.assign(p, body_length);
+
+    length = RECORD_PREFIX_SIZE + record_length;
+    return ReadResult::OK;
+}
+
+bool WebhookIngest::recover() {
+    TraceSpan span("webhooks", "WebhookIngest::recover");
+    namespace fs = std::filesystem;
+
+    std::error_code error;
+    fs::create_directories(config_.directory, error);
+    if (error) {
+        Logger::error("Failed to create webhook journal directory " + config_.directory + ": " + error.message());
+        return false;
+    }
+
+    uint64_t checkpoint_seq = 0;
+    {
+        std::ifstream checkpoint_file(config_.directory + "/checkpoint");
+        checkpoint_file >> checkpoint_seq;
+    }
+
+    std::vector<std::pair<uint64_t, std::string>> files;
+    for (const auto& entry : fs::directory_iterator(config_.directory, error)) {
+        std::string name = entry.path().filename().string();
+        if (name.size() != 24 || name.compare(20, 4, ".wal") != 0 ||
+            !std::all_of(name.begin(), name.begin() + 20, [](char c) { return std::isdigit(static_cast<unsigned char>(c)); })) {
+            continue;
+        }
+        files.emplace_back(std::stoull(name.substr(0, 20)), entry.path().string());
+    }
+    std::sort(files.begin(), files.end());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    segments_.clear();
+    deliveries_.clear();
+    delivery_order_.clear();
+    append_queue_.clear();
+    pending_.clear();
+    pending_bytes_ = 0;
+    in_flight_.clear();
+
+    // Every retained record goes back into the dedupe cache, processed or not:
+    // a platform retrying an old delivery must still be recognized
+    int64_t now = nowMillis();
+    int64_t ttl_ms = std::chrono::duration_cast<std::chrono::milliseconds>(config_.dedupe_ttl).count();
+    uint64_t last_seq = checkpoint_seq;
+    size_t records = 0;
+
+    for (size_t i = 0; i < files.size(); i++) {
+        const auto& [first_seq, path] = files[i];
+        bool last_file = i + 1 == files.size();
+
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            Logger::error("Failed to open webhook segment " + path + ": " + std::strerror(errno));
+            continue;
+        }
+
+        char magic[SEGMENT_HEADER_SIZE];
+        if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+            std::memcmp(magic, SEGMENT_MAGIC, sizeof(magic)) != 0) {
+            std::fclose(file);
+            Logger::warn("Discarding webhook segment without a valid header: " + path);
+            fs::remove(path, error);
+            continue;
+        }
+
+        uint64_t offset = SEGMENT_HEADER_SIZE;
+        uint64_t segment_last = 0;
+        int64_t segment_received = 0;
+        uint64_t length = 0;
+        WebhookEvent event;
+        ReadResult result;
+        while ((result = readRecord(file, event, length)) == ReadResult::OK) {
+            offset += length;
+            segment_last = event.seq;
+            segment_received = event.received_at_ms;
+            records++;
+            if (event.received_at_ms + ttl_ms > now) {
+                rememberDelivery(deliveryKey(event.source, event.delivery_id), event.received_at_ms + ttl_ms, event.seq);
+            }
+        }
+        std::fclose(file);
+
+        if (result == ReadResult::CORRUPT) {
+            if (last_file) {
+                // A batch torn by the crash was never acknowledged: drop it
+                Logger::warn("Truncating torn tail of webhook segment " + path + " at byte " + std::to_string(offset));
+                fs::resize_file(path, offset, error);
+            } else {
+                Logger::error("Corrupt record in webhook segment " + path + " at byte " + std::to_string(offset) +
+                              ", rest of the segment skipped");
+            }
+        }
+
+        if (segment_last == 0) {
+            fs::remove(path, error);
+            continue;
+        }
+        segments_[first_seq] = Segment{path, segment_last, segment_received};
+        last_seq = std::max(last_seq, segment_last);
+    }
+
+    next_seq_ = last_seq + 1;
+    durable_seq_ = last_seq;
+    checkpoint_seq_ = checkpoint_seq;
+    written_checkpoint_ = checkpoint_seq;
+    dispatched_seq_ = checkpoint_seq;
+
+    // Everything after the checkpoint is replayed through the spill path
+    next_read_seq_ = checkpoint_seq + 1;
+    read_segment_ = 0;
+    read_offset_ = 0;
+    spilled_ = next_read_seq_ <= durable_seq_;
+    reading_ = false;
+
+    active_fd_ = -1;
+    active_first_seq_ = 0;
+    active_bytes_ = 0;
+
+    Logger::info("Webhook journal recovered: " + std::to_string(segments_.size()) + " segments, " +
+                 std::to_string(records) + " records, checkpoint #" + std::to_string(checkpoint_seq));
+    return true;
+}
+
+bool WebhookIngest::openSegment(uint64_t first_seq) {
+    if (active_fd_ >= 0) {
+        ::close(active_fd_);
+        active_fd_ = -1;
+    }
+
+    std::string path = segmentPath(config_.directory, first_seq);
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        Logger::error("Failed to create webhook segment " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    if (!writeAll(fd, SEGMENT_MAGIC, sizeof(SEGMENT_MAGIC)) || !syncDirectory(config_.directory)) {
+        Logger::error("Failed to initialize webhook segment " + path + ": " + std::strerror(errno));
+        ::close(fd);
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments_[first_seq] = Segment{path, 0, 0};
+    }
+    active_fd_ = fd;
+    active_first_seq_ = first_seq;
+    active_bytes_ = SEGMENT_HEADER_SIZE;
+    return true;
+}
+
+bool WebhookIngest::writeBatch(const std::string& buffer, uint64_t first_seq) {
+    TraceSpan span("webhooks", "WebhookIngest::writeBatch");
+
+    if (active_fd_ < 0 ||
+        (active_bytes_ > SEGMENT_HEADER_SIZE && active_bytes_ + buffer.size() > config_.segment_bytes)) {
+        if (!openSegment(first_seq)) {
+            return false;
+        }
+    }
+
+    if (!writeAll(active_fd_, buffer.data(), buffer.size()) ||
+        (config_.sync && ::fdatasync(active_fd_) != 0)) {
+        Logger::error("Failed to write webhook journal: " + std::string(std::strerror(errno)));
+        // Leave no partial batch behind for the next one to land after
+        if (::ftruncate(active_fd_, static_cast<off_t>(active_bytes_)) != 0) {
+            ::close(active_fd_);
+            active_fd_ = -1;
+        }
+        return false;
+    }
+
+    active_bytes_ += buffer.size();
+    return true;
+}
+
+void WebhookIngest::writerLoop() {
+    std::vector<std::shared_ptr<PendingAppend>> batch;
+    std::string buffer;
+    auto last_checkpoint = std::chrono::steady_clock::now();
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            append_cv_.wait_for(lock, config_.checkpoint_interval, [this]() {
+                return !append_queue_.empty() || !running_;
+            });
+            if (append_queue_.empty() && !running_) {
+                break;
+            }
+            batch.swap(append_queue_);
+        }
+
+        if (!batch.empty()) {
+            // Group commit: everything queued while the previous batch was syncing
+            buffer.clear();
+            size_t bytes = 0;
+            for (const auto& pending : batch) {
+                encodeRecord(*pending->event, buffer);
+                bytes += eventBytes(*pending->event);
+            }
+            bool ok = writeBatch(buffer, batch.front()->event->seq);
+
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (ok) {
+                    uint64_t last_seq = batch.back()->event->seq;
+                    durable_seq_ = last_seq;
+                    Segment& segment = segments_[active_first_seq_];
+                    segment.last_seq = last_seq;
+                    segment.last_received_ms = batch.back()->event->received_at_ms;
+
+                    // Past the memory budget the events stay on disk until consumers catch up
+                    if (!spilled_ && pending_bytes_ + bytes <= config_.memory_limit_bytes) {
+                        for (const auto& pending : batch) {
+                            pending_.push_back(pending->event);
+                        }
+                        pending_bytes_ += bytes;
+                        next_read_seq_ = last_seq + 1;
+                    } else {
+                        spilled_ = true;
+                    }
+                } else {
+                    // Not acknowledged: the platform's retry must not be taken for a duplicate
+                    for (const auto& pending : batch) {
+                        deliveries_.erase(deliveryKey(pending->event->source, pending->event->delivery_id));
+                    }
+                }
+                for (const auto& pending : batch) {
+                    pending->done = true;
+                    pending->ok = ok;
+                }
+            }
+            committed_cv_.notify_all();
+            work_cv_.notify_all();
+            batch.clear();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_checkpoint >= config_.checkpoint_interval) {
+            checkpoint();
+            last_checkpoint = now;
+        }
+    }
+}
+
+void WebhookIngest::checkpoint() {
+    int64_t ttl_ms = std::chrono::duration_cast<std::chrono::milliseconds>(config_.dedupe_ttl).count();
+    int64_t now = nowMillis();
+
+    uint64_t checkpoint_seq;
+    std::vector<std::string> obsolete;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        checkpoint_seq = checkpoint_seq_;
+        // Handled and out of the dedupe window, never the one being appended to
+        for (auto it = segments_.begin(); it != segments_.end() && it->first != active_first_seq_;) {
+            if (it->second.last_seq > checkpoint_seq || it->second.last_received_ms + ttl_ms > now) {
+                break;
+            }
+            obsolete.push_back(it->second.path);
+            it = segments_.erase(it);
+        }
+    }
+
+    // Written before any segment goes, so a crash never replays from a deleted one
+    if (checkpoint_seq != written_checkpoint_) {
+        std::string path = config_.directory + "/checkpoint";
+        std::string temporary = path + ".tmp";
+        std::FILE* file = std::fopen(temporary.c_str(), "w");
+        bool ok = file && std::fprintf(file, "%llu\n", static_cast<unsigned long long>(checkpoint_seq)) > 0 &&
+                  std::fflush(file) == 0 && ::fdatasync(fileno(file)) == 0;
+        if (file) {
+            ok = std::fclose(file) == 0 && ok;
+        }
+        if (!ok || std::rename(temporary.c_str(), path.c_str()) != 0) {
+            // Segments stay on disk; the next start picks them up again
+            Logger::error("Failed to write webhook checkpoint: " + std::string(std::strerror(errno)));
+            return;
+        }
+        written_checkpoint_ = checkpoint_seq;
+    }
+
+    for (const auto& segment : obsolete) {
+        ::unlink(segment.c_str());
+    }
+}
+
+void WebhookIngest::consumerLoop() {
+    while (true) {
+        std::shared_ptr<WebhookEvent> event;
+        bool refill = false;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_cv_.wait(lock, [this]() {
+                return !running_ || !pending_.empty() || (spilled_ && !reading_);
+            });
+            if (!running_) {
+                return;
+            }
+            if (pending_.empty()) {
+                lock.unlock();
+                readSpilled();
+                continue;
+            }
+
+            event = std::move(pending_.front());
+            pending_.pop_front();
+            pending_bytes_ -= eventBytes(*event);
+            in_flight_.insert(event->seq);
+            dispatched_seq_ = event->seq;
+
+            // Read ahead before the queue runs dry
+            refill = spilled_ && !reading_ && pending_bytes_ < config_.memory_limit_bytes / 4;
+        }
+
+        if (refill) {
+            readSpilled();
+        }
+
+        // Stopping mid-retry: left unacknowledged, replayed on the next start
+        if (!process(*event)) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_.erase(event->seq);
+        checkpoint_seq_ = in_flight_.empty() ? dispatched_seq_ : *in_flight_.begin() - 1;
+    }
+}
+
+void WebhookIngest::readSpilled() {
+    TraceSpan span("webhooks", "WebhookIngest::readSpilled");
+
+    uint64_t from;
+    uint64_t until;
+    uint64_t cursor_segment;
+    uint64_t cursor_offset;
+    std::vector<std::pair<uint64_t, std::string>> files;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!spilled_ || reading_) {
+            return;
+        }
+        reading_ = true;
+        from = next_read_seq_;
+        until = durable_seq_;
+        cursor_segment = read_segment_;
+        cursor_offset = read_offset_;
+
+        auto it = segments_.upper_bound(from);
+        if (it != segments_.begin()) {
+            --it;
+        }
+        for (; it != segments_.end(); ++it) {
+            files.emplace_back(it->first, it->second.path);
+        }
+    }
+
+    std::vector<std::shared_ptr<WebhookEvent>> events;
+    size_t bytes = 0;
+    size_t budget = std::max<size_t>(config_.memory_limit_bytes / 2, 1);
+    uint64_t next = from;
+    uint64_t end_segment = cursor_segment;
+    uint64_t end_offset = cursor_offset;
+
+    for (const auto& [first_seq, path] : files) {
+        if (bytes >= budget || next > until) {
+            break;
+        }
+
+        std::FILE* file = std::fopen(path.c_str(), "rb");
+        if (!file) {
+            continue;
+        }
+
+        // Resume where the previous read stopped instead of rescanning the segment
+        uint64_t offset = first_seq == cursor_segment && cursor_offset >= SEGMENT_HEADER_SIZE ? cursor_offset
+                                                                                             : SEGMENT_HEADER_SIZE;
+        if (std::fseek(file, static_cast<long>(offset), SEEK_SET) == 0) {
+            WebhookEvent event;
+            uint64_t length = 0;
+            // Records past the durable snapshot may still be in the middle of a write
+            while (bytes < budget && readRecord(file, event, length) == ReadResult::OK && event.seq <= until) {
+                offset += length;
+                if (event.seq < next) {
+                    continue;
+                }
+                next = event.seq + 1;
+                bytes += eventBytes(event);
+                events.push_back(std::make_shared<WebhookEvent>(std::move(event)));
+                event = WebhookEvent{};
+            }
+        }
+        std::fclose(file);
+
+        end_segment = first_seq;
+        end_offset = offset;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& event : events) {
+            pending_.push_back(std::move(event));
+        }
+        pending_bytes_ += bytes;
+
+        if (next == from && from <= until) {
+            Logger::error("Webhook journal has no readable record from #" + std::to_string(from) +
+                          ", skipping to #" + std::to_string(until + 1));
+            next = until + 1;
+        }
+        next_read_seq_ = next;
+        read_segment_ = end_segment;
+        read_offset_ = end_offset;
+
+        // Batches committed during the read keep the spill going
+        if (next_read_seq_ > durable_seq_) {
+            spilled_ = false;
+        }
+        reading_ = false;
+    }
+    work_cv_.notify_all();
+}
+
+bool WebhookIngest::process(const WebhookEvent& event) {
+    TraceSpan span("webhooks", "WebhookIngest::process");
+
+    const WebhookSource* handler_source = source(event.source);
+    if (!handler_source || !handler_source->handler) {
+        Logger::error("No handler for webhook source " + event.source + ", dropping #" + std::to_string(event.seq));
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        MetricsRegistry::getInstance().increment(failed_counter_);
+        return true;
+    }
+
+    for (uint32_t attempt = 1;; attempt++) {
+        bool ok = false;
+        try {
+            ok = handler_source->handler(event);
+        } catch (const std::exception& e) {
+            Logger::error("Webhook " + event.source + " #" + std::to_string(event.seq) + " handler threw: " + e.what());
+        }
+
+        if (ok) {
+            processed_.fetch_add(1, std::memory_order_relaxed);
+            MetricsRegistry::getInstance().increment(processed_counter_);
+            return true;
+        }
+        if (attempt >= config_.max_attempts) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (work_cv_.wait_for(lock, config_.retry_backoff * attempt, [this]() { return !running_; })) {
+            return false;
+        }
+    }
+
+    Logger::error("Webhook " + event.source + " #" + std::to_string(event.seq) + " (delivery " + event.delivery_id +
+                  ") failed after " + std::to_string(config_.max_attempts) + " attempts");
+    failed_.fetch_add(1, std::memory_order_relaxed);
+    MetricsRegistry::getInstance().increment(failed_counter_);
+    return true;
+}
+
+void WebhookIngest::rememberDelivery(const std::string& key, int64_t expires_ms, uint64_t seq) {
+    deliveries_[key] = Delivery{expires_ms, seq};
+    delivery_order_.emplace_back(expires_ms, key);
+
+    // Over capacity the oldest deliveries are forgotten first
+    while (deliveries_.size() > config_.dedupe_capacity && !delivery_order_.empty()) {
+        auto& [oldest_expiry, oldest_key] = delivery_order_.front();
+        auto it = deliveries_.find(oldest_key);
+        if (it != deliveries_.end() && it->second.expires_ms == oldest_expiry) {
+            deliveries_.erase(it);
+        }
+        delivery_order_.pop_front();
+    }
+}
+
+void WebhookIngest::expireDeliveries(int64_t now_ms) {
+    while (!delivery_order_.empty() && delivery_order_.front().first <= now_ms) {
+        auto it = deliveries_.find(delivery_order_.front().second);
+        if (it != deliveries_.end() && it->second.expires_ms == delivery_order_.front().first) {
+            deliveries_.erase(it);
+        }
+        delivery_order_.pop_front();
+    }
+}
+
+WebhookIngest::Status WebhookIngest::append(const std::string& source, const std::string& delivery_id, std::string body) {
+    TraceSpan span("webhooks", "WebhookIngest::append");
+
+    if (!running_) {
+        return Status::FAILED;
+    }
+
+    int64_t now = nowMillis();
+    auto pending = std::make_shared<PendingAppend>();
+    pending->event = std::make_shared<WebhookEvent>();
+    WebhookEvent& event = *pending->event;
+    event.source = source;
+    event.delivery_id = delivery_id;
+    event.received_at_ms = now;
+    event.body = std::move(body);
+    std::string key = deliveryKey(source, delivery_id);
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        expireDeliveries(now);
+
+        while (true) {
+            if (!running_) {
+                return Status::FAILED;
+            }
+            auto it = deliveries_.find(key);
+            if (it == deliveries_.end()) {
+                break;
+            }
+            if (it->second.seq <= durable_seq_) {
+                duplicates_.fetch_add(1, std::memory_order_relaxed);
+                MetricsRegistry::getInstance().increment(duplicate_counter_);
+                return Status::DUPLICATE;
+            }
+            // The first copy is still being written; if that write fails this one takes over
+            committed_cv_.wait(lock);
+        }
+
+        event.seq = next_seq_++;
+        int64_t ttl_ms = std::chrono::duration_cast<std::chrono::milliseconds>(config_.dedupe_ttl).count();
+        rememberDelivery(key, now + ttl_ms, event.seq);
+        append_queue_.push_back(pending);
+        append_cv_.notify_one();
+
+        committed_cv_.wait(lock, [&pending]() { return pending->done; });
+    }
+
+    if (!pending->ok) {
+        return Status::FAILED;
+    }
+    received_.fetch_add(1, std::memory_order_relaxed);
+    MetricsRegistry::getInstance().increment(received_counter_);
+    return Status::ACCEPTED;
+}
+
+bool WebhookIngest::verifyHubSignature(const std::string& secret, std::string_view body, std::string_view header) {
+    constexpr std::string_view prefix = "sha256=";
+    if (secret.empty() || header.size() <= prefix.size() || header.substr(0, prefix.size()) != prefix) {
+        return false;
+    }
+
+    std::string given(header.substr(prefix.size()));
+    std::transform(given.begin(), given.end(), given.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    return Encryption::constantTimeEquals(Encryption::bytesToHex(Encryption::hmacSha256(secret, body)), given);
+}
+
+bool WebhookIngest::decodeSignedRequest(const std::string& secret, std::string_view signed_request, std::string& payload) {
+    size_t dot = signed_request.find('.');
+    if (secret.empty() || dot == std::string_view::npos) {
+        return false;
+    }
+
+    std::string_view signature = signed_request.substr(0, dot);
+    std::string_view encoded = signed_request.substr(dot + 1);
+    while (!signature.empty() && signature.back() == '=') {
+        signature.remove_suffix(1);
+    }
+
+    // The signature covers the payload as sent, still base64url-encoded
+    if (!Encryption::constantTimeEquals(base64UrlEncode(Encryption::hmacSha256(secret, encoded)), signature)) {
+        return false;
+    }
+    return base64UrlDecode(encoded, payload);
+}
+
+WebhookIngest::Stats WebhookIngest::stats() const {
+    Stats stats;
+    stats.received = received_.load(std::memory_order_relaxed);
+    stats.duplicates = duplicates_.load(std::memory_order_relaxed);
+    stats.processed = processed_.load(std::memory_order_relaxed);
+    stats.failed = failed_.load(std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.backlog = durable_seq_ > checkpoint_seq_ ? durable_seq_ - checkpoint_seq_ : 0;
+    stats.spilled = spilled_;
+    return stats;
+}
+
+} // namespace QMark
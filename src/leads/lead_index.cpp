@@ -0,0 +1,647 @@
+#include "leads/lead_index.hpp"
+#include "database/database_manager.hpp"
+#include "security/random.hpp"
+#include "utils/logger.hpp"
+#include "utils/snapshot_file.hpp"
+#include "utils/tracing.hpp"
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+
+namespace QMark {
+
+namespace {
+
+constexpr size_t MIN_CAPACITY = 16;
+
+// Snapshot body: string default_country_code, u64 user count, then per user
+//   i64 user_id, u64 size, u64 capacity, hashes[capacity] u64,
+//   lead_ids[capacity] i64, u64 filter words, filter[words] u64
+// Bump the version whenever hashKey or the normalization rules change.
+constexpr char SNAPSHOT_KIND[] = "LEAD";
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr char SNAPSHOT_NAME[] = "leads";
+
+// E.164 allows at most 15 digits; shorter than 8 is no reachable subscriber
+constexpr size_t MIN_PHONE_DIGITS = 8;
+constexpr size_t MAX_PHONE_DIGITS = 15;
+
+uint64_t mix(uint64_t x) {
+    x ^= x >> 32;
+    x *= 0xD6E8FEB86659FD93ULL;
+    x ^= x >> 32;
+    x *= 0xD6E8FEB86659FD93ULL;
+    x ^= x >> 32;
+    return x;
+}
+
+// Four bits of one 64-bit word: a lookup costs a single memory access
+uint64_t filterMask(uint64_t hash) {
+    return (uint64_t{1} << (hash & 63)) | (uint64_t{1} << ((hash >> 6) & 63)) |
+           (uint64_t{1} << ((hash >> 12) & 63)) | (uint64_t{1} << ((hash >> 18) & 63));
+}
+
+size_t filterWord(const std::vector<uint64_t>& filter, uint64_t hash) {
+    return static_cast<size_t>(hash >> 32) & (filter.size() - 1);
+}
+
+std::string_view trim(std::string_view value) {
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front()))) {
+        value.remove_prefix(1);
+    }
+    while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) {
+        value.remove_suffix(1);
+    }
+    return value;
+}
+
+int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+LeadIndex& LeadIndex::getInstance() {
+    static LeadIndex instance;
+    return instance;
+}
+
+LeadIndex::LeadIndex() {}
+
+bool LeadIndex::start(const LeadIndexConfig& config) {
+    config_ = config;
+    if (config_.max_load <= 0.0 || config_.max_load > 0.95) {
+        config_.max_load = 0.8;
+    }
+    if (config_.filter_bits_per_key == 0) {
+        config_.filter_bits_per_key = 8;
+    }
+    if (!config_.write) {
+        config_.write = [](std::vector<qmark::Lead>& inserts, const std::vector<qmark::Lead>& merges) {
+            return DatabaseManager::getInstance().writeLeads(inserts, merges);
+        };
+    }
+
+    {
+        std::unique_lock<std::shared_mutex> lock(users_mutex_);
+        users_.clear();
+    }
+
+    if (!config_.load_from_database) {
+        return true;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    if (loadSnapshot()) {
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        Stats loaded = stats();
+        Logger::info("Lead index loaded from snapshot: " + std::to_string(loaded.keys) + " keys, " +
+                     std::to_string(loaded.memory_bytes / 1024) + " KiB in " + std::to_string(elapsed.count()) + " ms");
+        return true;
+    }
+
+    TraceSpan span("leads", "LeadIndex::rebuild");
+    size_t rows = 0;
+
+    // One user's rows are usually contiguous: keep its index at hand between rows
+    qmark::UserId current_user = 0;
+    UserIndex* current = nullptr;
+    bool ok = DatabaseManager::getInstance().loadLeadKeys(
+        [&](qmark::LeadId lead_id, qmark::UserId user_id, std::string_view email, std::string_view phone) {
+            if (!current || user_id != current_user) {
+                current = &userFor(user_id);
+                current_user = user_id;
+            }
+            std::unique_lock<std::shared_mutex> lock(current->mutex);
+            addLocked(*current, lead_id, email, phone);
+            rows++;
+        });
+
+    if (!ok) {
+        Logger::error("Failed to rebuild the lead deduplication index");
+        return false;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Stats loaded = stats();
+    Logger::info("Lead index rebuilt: " + std::to_string(rows) + " leads, " + std::to_string(loaded.keys) +
+                 " keys, " + std::to_string(loaded.memory_bytes / 1024) + " KiB in " +
+                 std::to_string(elapsed.count()) + " ms");
+    return true;
+}
+
+bool LeadIndex::saveSnapshot() {
+    if (config_.snapshot_path.empty() || !config_.load_from_database) {
+        return false;
+    }
+
+    TraceSpan span("leads", "LeadIndex::saveSnapshot");
+    auto started = std::chrono::steady_clock::now();
+
+    uint64_t token = 0;
+    SecureRandom::fill(reinterpret_cast<unsigned char*>(&token), sizeof(token));
+
+    SnapshotWriter writer(config_.snapshot_path, SNAPSHOT_KIND, SNAPSHOT_VERSION, token);
+    writer.putString(config_.default_country_code);
+    {
+        std::shared_lock<std::shared_mutex> lock(users_mutex_);
+        writer.put(static_cast<uint64_t>(users_.size()));
+        for (const auto& [user_id, index] : users_) {
+            std::shared_lock<std::shared_mutex> user_lock(index->mutex);
+            writer.put(static_cast<int64_t>(user_id));
+            writer.put(static_cast<uint64_t>(index->size));
+            writer.put(static_cast<uint64_t>(index->hashes.size()));
+            writer.write(index->hashes.data(), index->hashes.size() * sizeof(uint64_t));
+            writer.write(index->lead_ids.data(), index->lead_ids.size() * sizeof(qmark::LeadId));
+            writer.put(static_cast<uint64_t>(index->filter.size()));
+            writer.write(index->filter.data(), index->filter.size() * sizeof(uint64_t));
+        }
+    }
+
+    // The token goes to the database last: without it the snapshot is never used
+    if (!writer.commit() || !DatabaseManager::getInstance().saveSnapshotToken(SNAPSHOT_NAME, token)) {
+        Logger::error("Failed to write lead index snapshot " + config_.snapshot_path);
+        return false;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger::info("Lead index snapshot written: " + std::to_string(writer.bytes() / 1024) + " KiB in " +
+                 std::to_string(elapsed.count()) + " ms");
+    return true;
+}
+
+bool LeadIndex::loadSnapshot() {
+    if (config_.snapshot_path.empty()) {
+        return false;
+    }
+
+    TraceSpan span("leads", "LeadIndex::loadSnapshot");
+
+    // Taken even when unused, so a later crash cannot revive this snapshot
+    std::optional<uint64_t> token = DatabaseManager::getInstance().takeSnapshotToken(SNAPSHOT_NAME);
+
+    SnapshotReader reader;
+    if (!reader.open(config_.snapshot_path, SNAPSHOT_KIND, SNAPSHOT_VERSION)) {
+        return false;
+    }
+    if (!token || *token != reader.info().token) {
+        // Leads written by a run that did not stop cleanly, or another database
+        Logger::warn("Ignoring stale lead index snapshot " + config_.snapshot_path);
+        return false;
+    }
+
+    // Phone keys were normalized with this country code
+    std::string country_code;
+    uint64_t user_count = 0;
+    if (!reader.getString(country_code) || !reader.get(user_count)) {
+        return false;
+    }
+    if (country_code != config_.default_country_code) {
+        Logger::warn("Ignoring lead index snapshot built for country code " + country_code);
+        return false;
+    }
+
+    std::unordered_map<qmark::UserId, std::unique_ptr<UserIndex>> users;
+    users.reserve(user_count);
+    for (uint64_t i = 0; i < user_count; i++) {
+        int64_t user_id = 0;
+        uint64_t size = 0;
+        uint64_t capacity = 0;
+        uint64_t words = 0;
+        auto index = std::make_unique<UserIndex>();
+        bool ok = reader.get(user_id) && reader.get(size) && reader.get(capacity) &&
+                  (capacity == 0 || std::has_single_bit(capacity)) && size <= capacity &&
+                  reader.remaining() >= capacity * (sizeof(uint64_t) + sizeof(qmark::LeadId));
+        if (ok) {
+            index->size = static_cast<size_t>(size);
+            index->hashes.resize(capacity);
+            index->lead_ids.resize(capacity);
+            reader.take(index->hashes.data(), capacity * sizeof(uint64_t));
+            reader.take(index->lead_ids.data(), capacity * sizeof(qmark::LeadId));
+            ok = reader.get(words) && (capacity == 0 ? words == 0 : std::has_single_bit(words)) &&
+                 reader.remaining() >= words * sizeof(uint64_t);
+        }
+        if (!ok) {
+            Logger::warn("Truncated lead index snapshot: " + config_.snapshot_path);
+            return false;
+        }
+        index->filter.resize(words);
+        reader.take(index->filter.data(), words * sizeof(uint64_t));
+        users[static_cast<qmark::UserId>(user_id)] = std::move(index);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(users_mutex_);
+    users_ = std::move(users);
+    return true;
+}
+
+std::string LeadIndex::normalizeEmail(std::string_view email) {
+    email = trim(email);
+
+    size_t at = email.find('@');
+    if (at == 0 || at == std::string_view::npos || at + 1 >= email.size() ||
+        email.find('@', at + 1) != std::string_view::npos) {
+        return "";
+    }
+
+    std::string local;
+    std::string domain;
+    local.reserve(at);
+    domain.reserve(email.size() - at - 1);
+    for (char c : email.substr(0, at)) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            return "";
+        }
+        local += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    for (char c : email.substr(at + 1)) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            return "";
+        }
+        domain += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+
+    // Sub-addressing: "jean+facebook" and "jean" are the same mailbox
+    size_t plus = local.find('+');
+    if (plus != std::string::npos) {
+        local.resize(plus);
+    }
+
+    // Gmail ignores dots and answers on both domains
+    if (domain == "gmail.com" || domain == "googlemail.com") {
+        local.erase(std::remove(local.begin(), local.end(), '.'), local.end());
+        domain = "gmail.com";
+    }
+
+    if (local.empty()) {
+        return "";
+    }
+    return local + "@" + domain;
+}
+
+std::string LeadIndex::normalizePhone(std::string_view phone, std::string_view default_country_code) {
+    phone = trim(phone);
+
+    bool international = !phone.empty() && phone.front() == '+';
+    std::string digits;
+    digits.reserve(phone.size());
+    for (char c : phone) {
+        if (c >= '0' && c <= '9') {
+            digits += c;
+        } else if (c != ' ' && c != '-' && c != '.' && c != '(' && c != ')' && c != '+' && c != '/') {
+            // Extensions, letters: not a number we can key on
+            return "";
+        }
+    }
+
+    if (!international && digits.compare(0, 2, "00") == 0) {
+        digits.erase(0, 2);
+        international = true;
+    }
+
+    if (!international) {
+        if (!digits.empty() && digits.front() == '0') {
+            // National trunk prefix: "06 12 34 56 78" -> "+33 6 12 34 56 78"
+            digits.replace(0, 1, default_country_code);
+        } else if (!(digits.size() > 10 && digits.compare(0, default_country_code.size(), default_country_code) == 0)) {
+            // Already carrying the country code without the '+' otherwise
+            digits.insert(0, default_country_code);
+        }
+    }
+
+    if (digits.size() < MIN_PHONE_DIGITS || digits.size() > MAX_PHONE_DIGITS || digits.front() == '0') {
+        return "";
+    }
+    return "+" + digits;
+}
+
+uint64_t LeadIndex::hashKey(KeyKind kind, std::string_view key) {
+    uint64_t hash = 0x9E3779B97F4A7C15ULL ^ (static_cast<uint64_t>(kind) << 56) ^ key.size();
+
+    size_t i = 0;
+    for (; i + 8 <= key.size(); i += 8) {
+        uint64_t word;
+        std::memcpy(&word, key.data() + i, 8);
+        hash = mix(hash ^ word);
+    }
+    uint64_t tail = 0;
+    std::memcpy(&tail, key.data() + i, key.size() - i);
+    hash = mix(hash ^ tail);
+
+    // Zero marks an empty slot
+    return hash ? hash : 1;
+}
+
+LeadIndex::UserIndex* LeadIndex::findUser(qmark::UserId user_id) const {
+    std::shared_lock<std::shared_mutex> lock(users_mutex_);
+    auto it = users_.find(user_id);
+    return it == users_.end() ? nullptr : it->second.get();
+}
+
+LeadIndex::UserIndex& LeadIndex::userFor(qmark::UserId user_id) {
+    if (UserIndex* index = findUser(user_id)) {
+        return *index;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(users_mutex_);
+    auto& index = users_[user_id];
+    if (!index) {
+        index = std::make_unique<UserIndex>();
+    }
+    return *index;
+}
+
+qmark::LeadId LeadIndex::probe(const UserIndex& index, uint64_t hash) const {
+    if (index.hashes.empty()) {
+        return 0;
+    }
+
+    // Most keys of a new lead are absent: the filter answers without touching the table
+    uint64_t mask = filterMask(hash);
+    if ((index.filter[filterWord(index.filter, hash)] & mask) != mask) {
+        return 0;
+    }
+
+    size_t slot_mask = index.hashes.size() - 1;
+    for (size_t slot = hash & slot_mask;; slot = (slot + 1) & slot_mask) {
+        uint64_t stored = index.hashes[slot];
+        if (stored == hash) {
+            return index.lead_ids[slot];
+        }
+        if (stored == 0) {
+            return 0;
+        }
+    }
+}
+
+void LeadIndex::addToFilter(UserIndex& index, uint64_t hash) {
+    index.filter[filterWord(index.filter, hash)] |= filterMask(hash);
+}
+
+void LeadIndex::grow(UserIndex& index) {
+    size_t capacity = std::max(MIN_CAPACITY, index.hashes.size() * 2);
+
+    std::vector<uint64_t> hashes(capacity, 0);
+    std::vector<qmark::LeadId> lead_ids(capacity, 0);
+    size_t slot_mask = capacity - 1;
+    for (size_t i = 0; i < index.hashes.size(); i++) {
+        uint64_t hash = index.hashes[i];
+        if (hash == 0) {
+            continue;
+        }
+        size_t slot = hash & slot_mask;
+        while (hashes[slot] != 0) {
+            slot = (slot + 1) & slot_mask;
+        }
+        hashes[slot] = hash;
+        lead_ids[slot] = index.lead_ids[i];
+    }
+    index.hashes.swap(hashes);
+    index.lead_ids.swap(lead_ids);
+
+    // Sized for the most keys this capacity holds; rebuilt without removed keys
+    size_t keys = static_cast<size_t>(static_cast<double>(capacity) * config_.max_load);
+    size_t words = std::bit_ceil(std::max<size_t>(1, keys * config_.filter_bits_per_key / 64));
+    index.filter.assign(words, 0);
+    for (uint64_t hash : index.hashes) {
+        if (hash != 0) {
+            addToFilter(index, hash);
+        }
+    }
+}
+
+void LeadIndex::insertKey(UserIndex& index, uint64_t hash, qmark::LeadId lead_id) {
+    if (static_cast<double>(index.size + 1) > static_cast<double>(index.hashes.size()) * config_.max_load) {
+        grow(index);
+    }
+
+    size_t slot_mask = index.hashes.size() - 1;
+    size_t slot = hash & slot_mask;
+    while (index.hashes[slot] != 0) {
+        // The first lead to claim a key keeps it
+        if (index.hashes[slot] == hash) {
+            return;
+        }
+        slot = (slot + 1) & slot_mask;
+    }
+
+    index.hashes[slot] = hash;
+    index.lead_ids[slot] = lead_id;
+    index.size++;
+    addToFilter(index, hash);
+}
+
+void LeadIndex::eraseKey(UserIndex& index, uint64_t hash, qmark::LeadId lead_id) {
+    if (index.hashes.empty()) {
+        return;
+    }
+
+    size_t slot_mask = index.hashes.size() - 1;
+    size_t hole = hash & slot_mask;
+    while (index.hashes[hole] != hash) {
+        if (index.hashes[hole] == 0) {
+            return;
+        }
+        hole = (hole + 1) & slot_mask;
+    }
+    if (index.lead_ids[hole] != lead_id) {
+        return;
+    }
+
+    // Backward shift: later entries of the run move into the hole, so no tombstones
+    for (size_t next = (hole + 1) & slot_mask; index.hashes[next] != 0; next = (next + 1) & slot_mask) {
+        size_t home = index.hashes[next] & slot_mask;
+        bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            index.hashes[hole] = index.hashes[next];
+            index.lead_ids[hole] = index.lead_ids[next];
+            hole = next;
+        }
+    }
+    index.hashes[hole] = 0;
+    index.lead_ids[hole] = 0;
+    index.size--;
+}
+
+void LeadIndex::addLocked(UserIndex& index, qmark::LeadId lead_id, std::string_view email, std::string_view phone) {
+    std::string email_key = normalizeEmail(email);
+    if (!email_key.empty()) {
+        insertKey(index, hashKey(KeyKind::EMAIL, email_key), lead_id);
+    }
+    std::string phone_key = normalizePhone(phone, config_.default_country_code);
+    if (!phone_key.empty()) {
+        insertKey(index, hashKey(KeyKind::PHONE, phone_key), lead_id);
+    }
+}
+
+void LeadIndex::add(qmark::UserId user_id, qmark::LeadId lead_id, std::string_view email, std::string_view phone) {
+    UserIndex& index = userFor(user_id);
+    std::unique_lock<std::shared_mutex> lock(index.mutex);
+    addLocked(index, lead_id, email, phone);
+}
+
+void LeadIndex::remove(qmark::UserId user_id, qmark::LeadId lead_id, std::string_view email, std::string_view phone) {
+    UserIndex* index = findUser(user_id);
+    if (!index) {
+        return;
+    }
+
+    std::string email_key = normalizeEmail(email);
+    std::string phone_key = normalizePhone(phone, config_.default_country_code);
+
+    std::unique_lock<std::shared_mutex> lock(index->mutex);
+    if (!email_key.empty()) {
+        eraseKey(*index, hashKey(KeyKind::EMAIL, email_key), lead_id);
+    }
+    if (!phone_key.empty()) {
+        eraseKey(*index, hashKey(KeyKind::PHONE, phone_key), lead_id);
+    }
+}
+
+LeadIndex::Match LeadIndex::find(qmark::UserId user_id, std::string_view email, std::string_view phone) const {
+    Match match;
+
+    const UserIndex* index = findUser(user_id);
+    if (!index) {
+        return match;
+    }
+
+    std::string email_key = normalizeEmail(email);
+    std::string phone_key = normalizePhone(phone, config_.default_country_code);
+
+    std::shared_lock<std::shared_mutex> lock(index->mutex);
+    qmark::LeadId by_email = email_key.empty() ? 0 : probe(*index, hashKey(KeyKind::EMAIL, email_key));
+    qmark::LeadId by_phone = phone_key.empty() ? 0 : probe(*index, hashKey(KeyKind::PHONE, phone_key));
+
+    // An e-mail identifies a person more reliably than a shared or recycled number
+    match.lead_id = by_email ? by_email : by_phone;
+    match.by_email = by_email != 0 && by_email == match.lead_id;
+    match.by_phone = by_phone != 0 && by_phone == match.lead_id;
+    return match;
+}
+
+std::optional<LeadIndex::UpsertResult> LeadIndex::upsert(qmark::UserId user_id, std::vector<qmark::Lead>& leads) {
+    TraceSpan span("leads", "LeadIndex::upsert");
+
+    // A key resolves to a stored lead, or to a lead inserted earlier in this batch
+    struct Target {
+        qmark::LeadId lead_id = 0;
+        size_t insert = 0;
+    };
+
+    UpsertResult result;
+    std::vector<qmark::Lead> inserts;
+    std::vector<qmark::Lead> merges;
+    std::vector<Target> resolved(leads.size());
+    std::vector<std::pair<uint64_t, Target>> learned;
+    std::unordered_map<uint64_t, Target> batch_keys;
+
+    qmark::Timestamp now = qmark::Timestamp(std::chrono::seconds(nowSeconds()));
+
+    UserIndex& index = userFor(user_id);
+    // Held across the write: two imports for one user cannot both insert the same person
+    std::unique_lock<std::shared_mutex> lock(index.mutex);
+
+    for (size_t i = 0; i < leads.size(); i++) {
+        qmark::Lead& lead = leads[i];
+        lead.user_id = user_id;
+
+        std::string email_key = normalizeEmail(lead.email);
+        std::string phone_key = normalizePhone(lead.phone, config_.default_country_code);
+        uint64_t hashes[2] = {
+            email_key.empty() ? 0 : hashKey(KeyKind::EMAIL, email_key),
+            phone_key.empty() ? 0 : hashKey(KeyKind::PHONE, phone_key)
+        };
+
+        std::optional<Target> target;
+        for (uint64_t hash : hashes) {
+            if (target || hash == 0) {
+                continue;
+            }
+            if (qmark::LeadId existing = probe(index, hash)) {
+                target = Target{existing, 0};
+            } else if (auto pending = batch_keys.find(hash); pending != batch_keys.end()) {
+                target = pending->second;
+            }
+        }
+
+        if (!target) {
+            if (lead.created_at == qmark::Timestamp{}) {
+                lead.created_at = now;
+            }
+            lead.updated_at = now;
+            target = Target{0, inserts.size()};
+            inserts.push_back(lead);
+            result.inserted++;
+        } else if (target->lead_id != 0) {
+            qmark::Lead merge = lead;
+            merge.id = target->lead_id;
+            merge.updated_at = now;
+            merges.push_back(std::move(merge));
+            result.merged++;
+        } else {
+            // Same person twice in one batch: fill what the first occurrence lacked
+            qmark::Lead& first = inserts[target->insert];
+            if (first.name.empty()) {
+                first.name = lead.name;
+            }
+            if (first.email.empty()) {
+                first.email = lead.email;
+            }
+            if (first.phone.empty()) {
+                first.phone = lead.phone;
+            }
+            result.merged++;
+        }
+
+        resolved[i] = *target;
+        for (uint64_t hash : hashes) {
+            if (hash != 0 && batch_keys.emplace(hash, *target).second) {
+                learned.emplace_back(hash, *target);
+            }
+        }
+    }
+
+    if (!config_.write(inserts, merges)) {
+        Logger::error("Failed to write " + std::to_string(inserts.size()) + " new and " +
+                      std::to_string(merges.size()) + " merged leads for user " + std::to_string(user_id));
+        return std::nullopt;
+    }
+
+    auto idOf = [&inserts](const Target& target) {
+        return target.lead_id != 0 ? target.lead_id : inserts[target.insert].id;
+    };
+
+    // Keys already owned by another lead stay with it (insertKey keeps the first owner)
+    for (const auto& [hash, target] : learned) {
+        insertKey(index, hash, idOf(target));
+    }
+
+    result.ids.reserve(leads.size());
+    for (size_t i = 0; i < leads.size(); i++) {
+        leads[i].id = idOf(resolved[i]);
+        result.ids.push_back(leads[i].id);
+    }
+    return result;
+}
+
+LeadIndex::Stats LeadIndex::stats() const {
+    Stats stats;
+
+    std::shared_lock<std::shared_mutex> lock(users_mutex_);
+    stats.users = users_.size();
+    for (const auto& [user_id, index] : users_) {
+        std::shared_lock<std::shared_mutex> user_lock(index->mutex);
+        stats.keys += index->size;
+        stats.memory_bytes += sizeof(UserIndex) + index->hashes.capacity() * sizeof(uint64_t) +
+                              index->lead_ids.capacity() * sizeof(qmark::LeadId) +
+                              index->filter.capacity() * sizeof(uint64_t);
+    }
+    return stats;
+}
+
+} // namespace QMark
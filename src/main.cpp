@@ -1,18 +1,182 @@
 #include "qmark.hpp"
 #include "server/http_server.hpp"
+#include "server/session_store.hpp"
+#include "server/event_hub.hpp"
+#include "automation/automation_scheduler.hpp"
+#include "outbound/token_refresher.hpp"
+#include "leads/lead_index.hpp"
+#include "analytics/metrics_store.hpp"
+#include "ingest/webhook_ingest.hpp"
+#include "ingest/webhook_handlers.hpp"
+#include "security/encryption.hpp"
+#include "database/database_manager.hpp"
 #include "utils/logger.hpp"
+#include "utils/binary_log.hpp"
+#include "utils/tracing.hpp"
+#include "utils/json_writer.hpp"
+#include <pthread.h>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <memory>
 
 int main() {
+    // SIGINT/SIGTERM bloqués dans tous les threads (hérité à leur création),
+    // attendus par le thread principal pour un arrêt propre
+    sigset_t stop_signals;
+    sigemptyset(&stop_signals);
+    sigaddset(&stop_signals, SIGINT);
+    sigaddset(&stop_signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop_signals, nullptr);
+
     try {
         // Initialisation du logger
-        QMark::Logger::getInstance().init("logs/qmark.log");
+        // Rotation à 100 Mo ou quotidienne, segments compressés par un thread de fond
+        QMark::LoggerOptions log_options;
+        log_options.max_file_bytes = 100 * 1024 * 1024;
+        log_options.rotate_interval = std::chrono::hours(24);
+        QMark::Logger::getInstance().init("logs/qmark.log", log_options);
         QMark::Logger::info("Starting QMARK Server v1.0.0");
 
+        // Journal structuré binaire (décodage : qmark-logdecode logs/qmark.blog),
+        // mêmes seuils de rotation et même rétention que le journal texte
+        QMark::BinaryLogOptions binary_log_options;
+        binary_log_options.max_file_bytes = log_options.max_file_bytes;
+        binary_log_options.rotate_interval = log_options.rotate_interval;
+        binary_log_options.retention = log_options.retention;
+        QMark::BinaryLog::getInstance().open("logs/qmark.blog", binary_log_options);
+
+        // Traces de requêtes : 1 sur 100, plus toute requête de plus de 250 ms
+        QMark::TracingConfig tracing_config;
+        tracing_config.sample_every = 100;
+        tracing_config.slow_threshold = std::chrono::milliseconds(250);
+        QMark::Tracer::getInstance().configure(tracing_config);
+
+        // Base de données et sessions (instantané du dernier arrêt propre, sinon SQLite)
+        if (!QMark::DatabaseManager::getInstance().init(DEFAULT_DATABASE_PATH)) {
+            QMark::Logger::error("Failed to initialize database");
+            return 1;
+        }
+        QMark::SessionStore::getInstance().start();
+
+        // Index de déduplication des prospects (instantané, sinon reconstruit depuis SQLite)
+        if (!QMark::LeadIndex::getInstance().start()) {
+            QMark::Logger::error("Failed to build lead index");
+            return 1;
+        }
+
+        // Métriques journalières en colonnes (instantané + révisions récentes de SQLite)
+        if (!QMark::MetricsStore::getInstance().start()) {
+            QMark::Logger::error("Failed to load metrics store");
+            return 1;
+        }
+
+        // Flux SSE du tableau de bord (un thread epoll pour tous les abonnés)
+        QMark::EventHub::getInstance().start();
+
+        // Automatisations actives (roue temporelle, exécutions persistées par lots) ;
+        // chaque lot écrit est aussi poussé aux tableaux de bord ouverts
+        QMark::AutomationSchedulerConfig scheduler_config;
+        scheduler_config.persist_runs = [](const std::vector<QMark::AutomationRunRecord>& runs) {
+            if (!QMark::DatabaseManager::getInstance().recordAutomationRuns(runs)) {
+                return false;
+            }
+            QMark::EventHub& hub = QMark::EventHub::getInstance();
+            QMark::MetricsStore& metrics = QMark::MetricsStore::getInstance();
+            std::string data;
+            for (const auto& run : runs) {
+                int32_t day = QMark::MetricsStore::dayOf(qmark::Timestamp(std::chrono::seconds(run.finished_at)));
+                metrics.record(run.user_id, day, {.automations = 1});
+                data.clear();
+                QMark::JsonWriter writer(data);
+                writer.beginObject()
+                    .field("type", run.success ? "automation_run" : "automation_failed")
+                    .field("title", run.title)
+                    .field("description", run.detail)
+                    .field("created_at", run.finished_at)
+                    .endObject();
+                hub.publish(run.user_id, "activity", data);
+                hub.publishDelta(run.user_id, run.success ? "automation_runs" : "automation_failures", 1);
+            }
+            return true;
+        };
+        QMark::AutomationScheduler::getInstance().start(scheduler_config);
+
+        // Rafraîchissement anticipé des jetons OAuth (mêmes variables que le serveur Node)
+        bool refresher_started = false;
+        if (const char* encryption_key = std::getenv("ENCRYPTION_KEY")) {
+            auto key_bytes = QMark::Encryption::hexToBytes(encryption_key);
+            QMark::TokenRefresherConfig refresher_config;
+            refresher_config.encryption_key.assign(key_bytes.begin(), key_bytes.end());
+
+            auto provider = [&](const char* name, const char* origin, const char* path,
+                                const char* id_variable, const char* secret_variable) {
+                const char* client_id = std::getenv(id_variable);
+                const char* client_secret = std::getenv(secret_variable);
+                if (client_id && client_secret) {
+                    refresher_config.providers[name] = QMark::OAuthProviderConfig{origin, path, client_id, client_secret};
+                }
+            };
+            provider("google", "https://oauth2.googleapis.com", "/token", "GOOGLE_CLIENT_ID", "GOOGLE_CLIENT_SECRET");
+            provider("facebook", "https://graph.facebook.com", "/v18.0/oauth/access_token",
+                     "FACEBOOK_CLIENT_ID", "FACEBOOK_CLIENT_SECRET");
+            provider("whatsapp", "https://graph.facebook.com", "/v18.0/oauth/access_token",
+                     "FACEBOOK_CLIENT_ID", "FACEBOOK_CLIENT_SECRET");
+
+            refresher_started = QMark::TokenRefresher::getInstance().start(refresher_config);
+        } else {
+            QMark::Logger::warn("ENCRYPTION_KEY not set, OAuth token refresher disabled");
+        }
+
+        // Webhooks des plateformes : journal local acquitté avant tout accès à la base,
+        // traité en tâche de fond et rejoué après un arrêt brutal
+        QMark::WebhookIngestConfig ingest_config;
+        if (const char* secret = std::getenv("LEADS_WEBHOOK_SECRET")) {
+            QMark::WebhookSource leads;
+            leads.secret = secret;
+            leads.delivery_header = "X-Delivery-Id";
+            leads.handler = QMark::handleLeadWebhook;
+            ingest_config.sources["leads"] = std::move(leads);
+        }
+        if (const char* secret = std::getenv("FACEBOOK_CLIENT_SECRET")) {
+            QMark::WebhookSource deletion;
+            deletion.secret = secret;
+            deletion.signature = QMark::WebhookSignature::SIGNED_REQUEST;
+            if (const char* status_url = std::getenv("FACEBOOK_DELETION_STATUS_URL")) {
+                deletion.status_url = status_url;
+            }
+            deletion.handler = QMark::handleFacebookDeletion;
+            ingest_config.sources["facebook_deletion"] = std::move(deletion);
+        }
+        if (!QMark::WebhookIngest::getInstance().start(ingest_config)) {
+            QMark::Logger::error("Failed to start webhook ingestion");
+            return 1;
+        }
+
         // Configuration du serveur
         auto server = std::make_unique<QMark::HttpServer>();
 
+        // TLS terminé par le serveur lui-même quand un certificat est fourni
+        const char* tls_cert = std::getenv("TLS_CERT_PATH");
+        const char* tls_key = std::getenv("TLS_KEY_PATH");
+        const bool tls_enabled = tls_cert && tls_key;
+        if (tls_enabled) {
+            QMark::TlsConfig tls_config;
+            tls_config.cert_path = tls_cert;
+            tls_config.key_path = tls_key;
+            if (const char* ocsp = std::getenv("TLS_OCSP_RESPONSE_PATH")) {
+                tls_config.ocsp_response_path = ocsp;
+            }
+            if (const char* ktls = std::getenv("TLS_KERNEL_OFFLOAD")) {
+                tls_config.kernel_tls = std::string(ktls) != "0";
+            }
+            if (!server->enableTls(tls_config)) {
+                QMark::Logger::error("Failed to configure TLS");
+                return 1;
+            }
+        }
+
         // Configuration des routes
         server->setupRoutes();
 
@@ -24,11 +188,24 @@ int main() {
             QMark::Logger::info("QMARK Server started successfully");
 
             // Boucle principale
-            std::cout << "QMARK Server running on http://0.0.0.0:" << port << std::endl;
+            std::cout << "QMARK Server running on " << (tls_enabled ? "https" : "http") << "://0.0.0.0:" << port << std::endl;
             std::cout << "Press Ctrl+C to stop..." << std::endl;
 
-            // Attendre l'arrêt
-            server->waitForStop();
+            // Attendre l'arrêt : plus de requêtes, puis les caches écrivent leurs instantanés
+            int signal_number = 0;
+            sigwait(&stop_signals, &signal_number);
+            QMark::Logger::info("Received " + std::string(strsignal(signal_number)) + ", shutting down");
+            server->stop();
+            QMark::WebhookIngest::getInstance().stop();
+            QMark::EventHub::getInstance().stop();
+            if (refresher_started) {
+                QMark::TokenRefresher::getInstance().stop();
+            }
+            QMark::AutomationScheduler::getInstance().stop();
+            QMark::MetricsStore::getInstance().stop();
+            QMark::SessionStore::getInstance().stop();
+            // Instantanés repris au prochain démarrage (caches chauds dès le départ)
+            QMark::LeadIndex::getInstance().saveSnapshot();
         } else {
             QMark::Logger::error("Failed to start server");
             return 1;
@@ -0,0 +1,104 @@
+#include "outbound/circuit_breaker.hpp"
+#include <algorithm>
+
+namespace QMark {
+
+CircuitBreaker::CircuitBreaker(const CircuitBreakerConfig& config)
+    : config_(config), state_(State::CLOSED), consecutive_failures_(0), probes_in_flight_(0),
+      current_open_duration_(config.open_duration), rejected_(0) {
+    if (config_.failure_threshold == 0) {
+        config_.failure_threshold = 1;
+    }
+    if (config_.half_open_probes == 0) {
+        config_.half_open_probes = 1;
+    }
+}
+
+void CircuitBreaker::open(Clock::time_point now) {
+    state_ = State::OPEN;
+    open_until_ = now + current_open_duration_;
+    probes_in_flight_ = 0;
+}
+
+bool CircuitBreaker::allow(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (state_ == State::OPEN) {
+        if (now < open_until_) {
+            rejected_++;
+            return false;
+        }
+        state_ = State::HALF_OPEN;
+        probes_in_flight_ = 0;
+    }
+
+    if (state_ == State::HALF_OPEN) {
+        if (probes_in_flight_ >= config_.half_open_probes) {
+            rejected_++;
+            return false;
+        }
+        probes_in_flight_++;
+    }
+
+    return true;
+}
+
+void CircuitBreaker::onSuccess() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    consecutive_failures_ = 0;
+    if (state_ == State::HALF_OPEN) {
+        state_ = State::CLOSED;
+        probes_in_flight_ = 0;
+        current_open_duration_ = config_.open_duration;
+    }
+}
+
+void CircuitBreaker::onFailure(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    switch (state_) {
+        case State::CLOSED:
+            if (++consecutive_failures_ >= config_.failure_threshold) {
+                open(now);
+            }
+            break;
+        case State::HALF_OPEN:
+            // The provider is still degraded: back off longer before probing again
+            current_open_duration_ = std::min(current_open_duration_ * 2, config_.max_open_duration);
+            open(now);
+            break;
+        case State::OPEN:
+            // Late result of a call admitted before the circuit opened
+            break;
+    }
+}
+
+void CircuitBreaker::onAbandon() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (state_ == State::HALF_OPEN && probes_in_flight_ > 0) {
+        probes_in_flight_--;
+    }
+}
+
+CircuitBreaker::State CircuitBreaker::state() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+uint64_t CircuitBreaker::rejected() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rejected_;
+}
+
+const char* CircuitBreaker::stateName(State state) {
+    switch (state) {
+        case State::CLOSED: return "closed";
+        case State::OPEN: return "open";
+        case State::HALF_OPEN: return "half_open";
+    }
+    return "unknown";
+}
+
+} // namespace QMark
@@ -0,0 +1,533 @@
+#include "outbound/http_client.hpp"
+#include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+#include "utils/tracing.hpp"
+#include <httplib.h>
+#include <algorithm>
+#include <cctype>
+
+namespace QMark {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+bool equalsIgnoreCase(const std::string& a, const std::string& b) {
+    return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) {
+        return std::tolower(static_cast<unsigned char>(x)) == std::tolower(static_cast<unsigned char>(y));
+    });
+}
+
+std::string normalizeOrigin(std::string origin) {
+    while (!origin.empty() && origin.back() == '/') {
+        origin.pop_back();
+    }
+    return origin;
+}
+
+bool isIdempotent(const std::string& method) {
+    return method == "GET" || method == "HEAD" || method == "PUT" || method == "DELETE" || method == "OPTIONS";
+}
+
+// Throttling and server errors count against the provider, client errors do not
+bool isProviderFailure(int status) {
+    return status == 0 || status == 429 || status >= 500;
+}
+
+// Identical GETs share one flight only if they would see the same response,
+// so credentials and every other header are part of the key
+std::string flightKey(const OutboundRequest& request) {
+    OutboundHeaders headers = request.headers;
+    std::sort(headers.begin(), headers.end());
+
+    std::string key = request.path;
+    for (const auto& [name, value] : headers) {
+        key += '\n';
+        key += name;
+        key += ':';
+        key += value;
+    }
+    return key;
+}
+
+// Session tickets of one host, shared by all of its pooled connections
+struct TlsSessionCache {
+    std::atomic<uint64_t> handshakes{0};
+    std::atomic<uint64_t> resumed{0};
+    uint32_t resumed_counter = 0;
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    std::mutex mutex;
+    SSL_SESSION* session = nullptr;
+
+    ~TlsSessionCache() {
+        if (session) {
+            SSL_SESSION_free(session);
+        }
+    }
+#endif
+};
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+int cacheIndex() {
+    static const int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+TlsSessionCache* cacheOf(const SSL* ssl) {
+    return static_cast<TlsSessionCache*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), cacheIndex()));
+}
+
+// TLS 1.3 tickets arrive after the handshake, on the first read
+int onNewSession(SSL* ssl, SSL_SESSION* session) {
+    TlsSessionCache* cache = cacheOf(ssl);
+    if (!cache) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (cache->session) {
+        SSL_SESSION_free(cache->session);
+    }
+    cache->session = session;
+    return 1;
+}
+
+// httplib has no hook between SSL_new and SSL_connect: the cached session is
+// attached when the client state machine announces the handshake start,
+// before the ClientHello is built
+void onHandshakeEvent(const SSL* ssl, int where, int) {
+    TlsSessionCache* cache = cacheOf(ssl);
+    if (!cache) {
+        return;
+    }
+
+    if ((where & SSL_CB_HANDSHAKE_START) && SSL_in_before(ssl)) {
+        std::lock_guard<std::mutex> lock(cache->mutex);
+        if (cache->session) {
+            SSL_set_session(const_cast<SSL*>(ssl), cache->session);
+        }
+    }
+
+    if (where & SSL_CB_HANDSHAKE_DONE) {
+        cache->handshakes++;
+        if (SSL_session_reused(const_cast<SSL*>(ssl))) {
+            cache->resumed++;
+            MetricsRegistry::getInstance().increment(cache->resumed_counter);
+        }
+    }
+}
+#endif
+
+} // namespace
+
+std::string OutboundResponse::header(const std::string& name) const {
+    for (const auto& [key, value] : headers) {
+        if (equalsIgnoreCase(key, name)) {
+            return value;
+        }
+    }
+    return "";
+}
+
+struct OutboundClient::Connection {
+    std::unique_ptr<httplib::Client> client;
+    Clock::time_point last_used;
+    uint64_t requests = 0;
+};
+
+struct OutboundClient::HostPool {
+    std::string origin;
+    OutboundHostConfig config;
+    bool https;
+    CircuitBreaker breaker;
+    TlsSessionCache tls;
+
+    std::mutex mutex;
+    std::condition_variable available;
+    std::vector<std::unique_ptr<Connection>> idle;     // la plus récente en dernier
+    size_t leased = 0;
+    size_t waiting = 0;
+    bool closed = false;
+    std::unordered_map<std::string, Flight> flights;
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<uint64_t> connections_opened{0};
+    std::atomic<uint64_t> coalesced{0};
+
+    HostPool(std::string host_origin, const OutboundHostConfig& host_config)
+        : origin(std::move(host_origin)), config(host_config),
+          https(origin.rfind("https://", 0) == 0), breaker(host_config.breaker) {}
+
+    ~HostPool() {
+        // Connections go before the session cache their SSL contexts point to
+        idle.clear();
+    }
+
+    void pruneIdle(Clock::time_point now) {
+        auto fresh = std::find_if(idle.begin(), idle.end(), [&](const std::unique_ptr<Connection>& connection) {
+            return now - connection->last_used < config.idle_timeout;
+        });
+        idle.erase(idle.begin(), fresh);
+    }
+};
+
+OutboundClient& OutboundClient::getInstance() {
+    static OutboundClient instance;
+    return instance;
+}
+
+OutboundClient::OutboundClient() {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    request_counter_ = metrics.registerCounter("qmark_outbound_requests_total", "Outbound HTTP requests sent to providers.");
+    failure_counter_ = metrics.registerCounter("qmark_outbound_failures_total", "Outbound requests that failed in transport or with 429/5xx.");
+    coalesced_counter_ = metrics.registerCounter("qmark_outbound_coalesced_total", "Outbound GETs answered by an identical request already in flight.");
+    rejected_counter_ = metrics.registerCounter("qmark_outbound_rejected_total", "Outbound requests refused by an open circuit or an exhausted pool.");
+    connection_counter_ = metrics.registerCounter("qmark_outbound_connections_opened_total", "Outbound TCP connections opened.");
+    resumed_counter_ = metrics.registerCounter("qmark_outbound_tls_resumed_total", "Outbound TLS handshakes that resumed a cached session.");
+}
+
+OutboundClient::~OutboundClient() {
+    shutdown();
+}
+
+void OutboundClient::configureHost(const std::string& origin, const OutboundHostConfig& config) {
+    std::string key = normalizeOrigin(origin);
+    std::lock_guard<std::mutex> lock(mutex_);
+    host_configs_[key] = config;
+
+    // In-flight requests keep the old pool alive until they return
+    pools_.erase(key);
+}
+
+void OutboundClient::setDefaultConfig(const OutboundHostConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    default_config_ = config;
+}
+
+std::shared_ptr<OutboundClient::HostPool> OutboundClient::poolFor(const std::string& origin) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = pools_.find(origin);
+    if (it != pools_.end()) {
+        return it->second;
+    }
+
+    auto config = host_configs_.find(origin);
+    auto pool = std::make_shared<HostPool>(origin, config != host_configs_.end() ? config->second : default_config_);
+    pool->tls.resumed_counter = resumed_counter_;
+    pools_.emplace(origin, pool);
+    return pool;
+}
+
+std::unique_ptr<OutboundClient::Connection> OutboundClient::acquire(HostPool& pool, std::string& error) {
+    {
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        size_t limit = std::max<size_t>(pool.config.max_connections, 1);
+
+        pool.waiting++;
+        bool ready = pool.available.wait_for(lock, pool.config.acquire_timeout, [&]() {
+            return pool.closed || pool.leased < limit;
+        });
+        pool.waiting--;
+
+        if (pool.closed) {
+            error = "Outbound client is shut down";
+            return nullptr;
+        }
+        if (!ready) {
+            error = "No connection to " + pool.origin + " available within " +
+                    std::to_string(pool.config.acquire_timeout.count()) + " ms";
+            return nullptr;
+        }
+        pool.leased++;
+
+        // Most recently used first: its socket is the most likely to still be open
+        pool.pruneIdle(Clock::now());
+        if (!pool.idle.empty()) {
+            auto connection = std::move(pool.idle.back());
+            pool.idle.pop_back();
+            return connection;
+        }
+    }
+
+    auto connection = std::make_unique<Connection>();
+    connection->client = std::make_unique<httplib::Client>(pool.origin);
+    httplib::Client& client = *connection->client;
+
+    if (!client.is_valid()) {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.leased--;
+        pool.available.notify_one();
+        error = "Invalid outbound origin: " + pool.origin;
+        return nullptr;
+    }
+
+    client.set_keep_alive(true);
+    client.set_follow_location(false);
+    client.set_tcp_nodelay(true);
+    client.set_connection_timeout(pool.config.connect_timeout);
+    client.set_read_timeout(pool.config.read_timeout);
+    client.set_write_timeout(pool.config.write_timeout);
+
+    // httplib reconnects transparently when the peer closed a kept-alive socket
+    uint32_t connection_counter = connection_counter_;
+    HostPool* owner = &pool;
+    client.set_socket_options([owner, connection_counter](socket_t) {
+        owner->connections_opened++;
+        MetricsRegistry::getInstance().increment(connection_counter);
+    });
+
+#ifdef CPPHTTPLIB_OPENSSL_SUPPORT
+    if (pool.https) {
+        client.enable_server_certificate_verification(pool.config.verify_certificates);
+        if (!pool.config.ca_cert_path.empty()) {
+            client.set_ca_cert_path(pool.config.ca_cert_path);
+        }
+
+        if (SSL_CTX* ctx = client.ssl_context()) {
+            SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            SSL_CTX_sess_set_new_cb(ctx, onNewSession);
+            SSL_CTX_set_info_callback(ctx, onHandshakeEvent);
+            SSL_CTX_set_ex_data(ctx, cacheIndex(), &pool.tls);
+        }
+    }
+#endif
+
+    return connection;
+}
+
+void OutboundClient::release(HostPool& pool, std::unique_ptr<Connection> connection) {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+
+    pool.leased--;
+    if (!pool.closed) {
+        connection->last_used = Clock::now();
+        pool.idle.push_back(std::move(connection));
+        pool.pruneIdle(Clock::now());
+    }
+    pool.available.notify_one();
+}
+
+OutboundResponse OutboundClient::perform(HostPool& pool, const OutboundRequest& request) {
+    OutboundResponse response;
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+
+    // Fail fast before queueing for a connection to a provider known to be down
+    if (!pool.breaker.allow()) {
+        response.error = "Circuit open for " + pool.origin;
+        metrics.increment(rejected_counter_);
+        return response;
+    }
+
+    auto connection = acquire(pool, response.error);
+    if (!connection) {
+        pool.breaker.onAbandon();
+        metrics.increment(rejected_counter_);
+        return response;
+    }
+
+    httplib::Request outbound;
+    outbound.method = request.method;
+    outbound.path = request.path;
+    for (const auto& [name, value] : request.headers) {
+        outbound.headers.emplace(name, value);
+    }
+    if (!request.content_type.empty()) {
+        outbound.set_header("Content-Type", request.content_type);
+    }
+    outbound.body = request.body;
+
+    auto started = Clock::now();
+    httplib::Result result = connection->client->send(outbound);
+
+    // A kept-alive socket can be closed by the peer right after the liveness
+    // check; idempotent requests get one more try on a fresh socket
+    if (!result && connection->requests > 0 && isIdempotent(request.method) &&
+        (result.error() == httplib::Error::Write || result.error() == httplib::Error::Read) &&
+        Clock::now() - started < pool.config.read_timeout) {
+        result = connection->client->send(outbound);
+    }
+    connection->requests++;
+
+    pool.requests++;
+    metrics.increment(request_counter_);
+
+    if (result) {
+        response.status = result->status;
+        response.body = std::move(result->body);
+        response.headers.reserve(result->headers.size());
+        for (auto& [name, value] : result->headers) {
+            response.headers.emplace_back(name, value);
+        }
+    } else {
+        response.error = "Outbound request to " + pool.origin + " failed: " + httplib::to_string(result.error());
+    }
+
+    release(pool, std::move(connection));
+
+    if (isProviderFailure(response.status)) {
+        pool.failures++;
+        metrics.increment(failure_counter_);
+
+        CircuitBreaker::State before = pool.breaker.state();
+        pool.breaker.onFailure();
+        if (before != CircuitBreaker::State::OPEN && pool.breaker.state() == CircuitBreaker::State::OPEN) {
+            Logger::warn("Circuit opened for " + pool.origin + " after repeated failures" +
+                         (response.error.empty() ? " (HTTP " + std::to_string(response.status) + ")" : ": " + response.error));
+        }
+    } else {
+        pool.breaker.onSuccess();
+    }
+
+    return response;
+}
+
+OutboundResponse OutboundClient::coalesce(HostPool& pool, const OutboundRequest& request) {
+    std::string key = flightKey(request);
+    std::promise<OutboundResponse> promise;
+    Flight flight;
+    bool leader = false;
+
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        auto it = pool.flights.find(key);
+        if (it != pool.flights.end()) {
+            flight = it->second;
+        } else {
+            flight = promise.get_future().share();
+            pool.flights.emplace(key, flight);
+            leader = true;
+        }
+    }
+
+    if (!leader) {
+        OutboundResponse response = flight.get();
+        response.coalesced = true;
+        pool.coalesced++;
+        MetricsRegistry::getInstance().increment(coalesced_counter_);
+        return response;
+    }
+
+    OutboundResponse response;
+    try {
+        response = perform(pool, request);
+    } catch (...) {
+        {
+            std::lock_guard<std::mutex> lock(pool.mutex);
+            pool.flights.erase(key);
+        }
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+
+    // Later callers start a new flight rather than reuse this response
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.flights.erase(key);
+    }
+    promise.set_value(response);
+    return response;
+}
+
+OutboundResponse OutboundClient::send(const OutboundRequest& request) {
+    TraceSpan span("outbound", "OutboundClient::send");
+
+    std::string origin = normalizeOrigin(request.origin);
+    if (origin.rfind("http://", 0) != 0 && origin.rfind("https://", 0) != 0) {
+        OutboundResponse response;
+        response.error = "Unsupported outbound origin: " + request.origin;
+        return response;
+    }
+
+    auto pool = poolFor(origin);
+    if (request.method == "GET") {
+        return coalesce(*pool, request);
+    }
+    return perform(*pool, request);
+}
+
+OutboundResponse OutboundClient::get(const std::string& origin, const std::string& path,
+                                     const OutboundHeaders& headers) {
+    OutboundRequest request;
+    request.origin = origin;
+    request.path = path;
+    request.headers = headers;
+    return send(request);
+}
+
+OutboundResponse OutboundClient::post(const std::string& origin, const std::string& path, const std::string& body,
+                                      const std::string& content_type, const OutboundHeaders& headers) {
+    OutboundRequest request;
+    request.method = "POST";
+    request.origin = origin;
+    request.path = path;
+    request.headers = headers;
+    request.body = body;
+    request.content_type = content_type;
+    return send(request);
+}
+
+OutboundClient::HostStats OutboundClient::hostStats(const std::string& origin) const {
+    HostStats stats;
+
+    std::shared_ptr<HostPool> pool;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pools_.find(normalizeOrigin(origin));
+        if (it == pools_.end()) {
+            return stats;
+        }
+        pool = it->second;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        stats.idle = pool->idle.size();
+        stats.leased = pool->leased;
+        stats.waiting = pool->waiting;
+    }
+    stats.requests = pool->requests.load();
+    stats.failures = pool->failures.load();
+    stats.connections_opened = pool->connections_opened.load();
+    stats.tls_handshakes = pool->tls.handshakes.load();
+    stats.tls_resumed = pool->tls.resumed.load();
+    stats.coalesced = pool->coalesced.load();
+    stats.rejected = pool->breaker.rejected();
+    stats.circuit = pool->breaker.state();
+    return stats;
+}
+
+void OutboundClient::closeIdle() {
+    std::vector<std::shared_ptr<HostPool>> pools;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [origin, pool] : pools_) {
+            pools.push_back(pool);
+        }
+    }
+
+    auto now = Clock::now();
+    for (auto& pool : pools) {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->pruneIdle(now);
+    }
+}
+
+void OutboundClient::shutdown() {
+    std::unordered_map<std::string, std::shared_ptr<HostPool>> pools;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pools.swap(pools_);
+    }
+
+    for (auto& [origin, pool] : pools) {
+        std::lock_guard<std::mutex> lock(pool->mutex);
+        pool->closed = true;
+        pool->idle.clear();
+        pool->available.notify_all();
+    }
+}
+
+} // namespace QMark
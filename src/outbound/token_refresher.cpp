@@ -0,0 +1,483 @@
+#include "outbound/token_refresher.hpp"
+#include "outbound/http_client.hpp"
+#include "database/database_manager.hpp"
+#include "security/encryption.hpp"
+#include "utils/json_reader.hpp"
+#include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+#include "utils/tracing.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace QMark {
+
+namespace {
+
+// application/x-www-form-urlencoded value
+std::string formEncode(const std::string& value) {
+    static const char HEX[] = "0123456789ABCDEF";
+
+    std::string out;
+    out.reserve(value.size() * 3);
+    for (unsigned char c : value) {
+        if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += static_cast<char>(c);
+        } else {
+            out += '%';
+            out += HEX[c >> 4];
+            out += HEX[c & 0x0F];
+        }
+    }
+    return out;
+}
+
+int64_t toMillis(const qmark::Timestamp& timestamp) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+}
+
+} // namespace
+
+TokenRefresher& TokenRefresher::getInstance() {
+    static TokenRefresher instance;
+    return instance;
+}
+
+TokenRefresher::TokenRefresher() : running_(false), refreshed_(0), failures_(0), joined_(0), revoked_(0) {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    refresh_counter_ = metrics.registerCounter("qmark_oauth_refreshes_total", "OAuth access tokens refreshed ahead of expiry or on demand.");
+    failure_counter_ = metrics.registerCounter("qmark_oauth_refresh_failures_total", "OAuth token refreshes that failed and were rescheduled or revoked.");
+    joined_counter_ = metrics.registerCounter("qmark_oauth_refresh_joined_total", "Refresh requests that waited on a refresh already in flight.");
+    metrics.registerCallback("qmark_oauth_connections_tracked", "OAuth connections held by the token refresher.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(stats().tracked); });
+}
+
+TokenRefresher::~TokenRefresher() {
+    stop();
+}
+
+int64_t TokenRefresher::nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool TokenRefresher::start(const TokenRefresherConfig& config) {
+    if (running_) {
+        return true;
+    }
+
+    config_ = config;
+    if (config_.batch_size == 0) {
+        config_.batch_size = 1;
+    }
+    if (!config_.persist) {
+        config_.persist = [](const std::vector<qmark::OAuthConnection>& connections) {
+            return DatabaseManager::getInstance().saveOAuthConnections(connections);
+        };
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        connections_.clear();
+        heap_ = {};
+        pending_writes_.clear();
+        flush_retry_ms_ = 0;
+    }
+
+    if (config_.load_from_database) {
+        for (const auto& connection : DatabaseManager::getInstance().loadActiveOAuthConnections()) {
+            track(connection);
+        }
+    }
+
+    running_ = true;
+    refresher_thread_ = std::thread([this]() {
+        refresherLoop();
+    });
+
+    Logger::info("Token refresher started with " + std::to_string(stats().tracked) + " OAuth connections");
+    return true;
+}
+
+void TokenRefresher::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    wake_cv_.notify_all();
+    if (refresher_thread_.joinable()) {
+        refresher_thread_.join();
+    }
+
+    // Tokens refreshed on demand after the last batch
+    flushWrites();
+    Logger::info("Token refresher stopped");
+}
+
+void TokenRefresher::schedule(qmark::ConnectionId id, Tracked& tracked, int64_t due_ms) {
+    tracked.generation++;
+    bool earliest = heap_.empty() || due_ms < heap_.top().due_ms;
+    heap_.push(HeapEntry{due_ms, id, tracked.generation});
+    if (earliest) {
+        wake_cv_.notify_one();
+    }
+}
+
+void TokenRefresher::scheduleFromExpiry(qmark::ConnectionId id, Tracked& tracked) {
+    const qmark::OAuthConnection& connection = tracked.connection;
+
+    // Without an expiry, a refresh token or a token endpoint there is nothing to do ahead of time
+    int64_t expires_ms = toMillis(connection.expires_at);
+    if (expires_ms <= 0 || connection.encrypted_refresh_token.empty() ||
+        config_.providers.find(connection.provider) == config_.providers.end()) {
+        tracked.generation++;
+        return;
+    }
+
+    int64_t ahead_ms = std::chrono::duration_cast<std::chrono::milliseconds>(config_.refresh_ahead).count();
+    schedule(id, tracked, expires_ms - ahead_ms);
+}
+
+void TokenRefresher::track(const qmark::OAuthConnection& connection) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!connection.is_active) {
+        connections_.erase(connection.id);
+        return;
+    }
+
+    Tracked& tracked = connections_[connection.id];
+    tracked.connection = connection;
+    tracked.failures = 0;
+    scheduleFromExpiry(connection.id, tracked);
+}
+
+void TokenRefresher::untrack(qmark::ConnectionId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Heap entries go stale with the connection
+    connections_.erase(id);
+}
+
+TokenRefresher::Outcome TokenRefresher::requestTokens(const qmark::OAuthConnection& connection) {
+    TraceSpan span("oauth", "TokenRefresher::requestTokens");
+    Outcome outcome;
+
+    auto provider = config_.providers.find(connection.provider);
+    if (provider == config_.providers.end()) {
+        outcome.error = "No token endpoint configured for provider " + connection.provider;
+        return outcome;
+    }
+    const OAuthProviderConfig& endpoint = provider->second;
+
+    try {
+        std::string refresh_token = Encryption::decrypt(connection.encrypted_refresh_token, config_.encryption_key);
+        std::string body = "grant_type=refresh_token&refresh_token=" + formEncode(refresh_token) +
+                           "&client_id=" + formEncode(endpoint.client_id) +
+                           "&client_secret=" + formEncode(endpoint.client_secret);
+
+        OutboundResponse response = OutboundClient::getInstance().post(
+            endpoint.token_origin, endpoint.token_path, body, "application/x-www-form-urlencoded",
+            {{"Accept", "application/json"}});
+
+        if (response.status == 0) {
+            outcome.error = response.error;
+            return outcome;
+        }
+
+        JsonReader reader;
+        bool parsed = reader.parse(response.body) && reader.root().type == JsonType::OBJECT;
+
+        if (!response.ok()) {
+            // A refresh token the provider no longer accepts needs the user to reconnect
+            std::string error;
+            const JsonReader::Value* value = parsed ? reader.find("error") : nullptr;
+            if (value && JsonReader::getString(*value, error) && error == "invalid_grant") {
+                outcome.revoked = true;
+            }
+            outcome.error = "Token endpoint returned HTTP " + std::to_string(response.status) +
+                            (error.empty() ? "" : " (" + error + ")");
+            return outcome;
+        }
+
+        std::string access_token;
+        const JsonReader::Value* value = parsed ? reader.find("access_token") : nullptr;
+        if (!value || !JsonReader::getString(*value, access_token) || access_token.empty()) {
+            outcome.error = "Token endpoint response has no access_token";
+            return outcome;
+        }
+
+        // Providers that rotate refresh tokens send a new one; others keep the old
+        std::string rotated;
+        if ((value = reader.find("refresh_token")) && JsonReader::getString(*value, rotated) && !rotated.empty()) {
+            outcome.encrypted_refresh_token = Encryption::encrypt(rotated, config_.encryption_key);
+        }
+        if ((value = reader.find("expires_in"))) {
+            JsonReader::getInt64(*value, outcome.expires_in);
+        }
+
+        outcome.encrypted_access_token = Encryption::encrypt(access_token, config_.encryption_key);
+        outcome.success = true;
+    } catch (const std::exception& e) {
+        outcome.error = e.what();
+    }
+
+    return outcome;
+}
+
+std::shared_future<bool> TokenRefresher::refresh(qmark::ConnectionId id) {
+    std::promise<bool> promise;
+    std::shared_future<bool> result = promise.get_future().share();
+    qmark::OAuthConnection snapshot;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto it = connections_.find(id);
+        if (it == connections_.end()) {
+            promise.set_value(false);
+            return result;
+        }
+        if (it->second.in_flight) {
+            joined_++;
+            MetricsRegistry::getInstance().increment(joined_counter_);
+            return *it->second.in_flight;
+        }
+        it->second.in_flight = result;
+        snapshot = it->second.connection;
+        in_flight_++;
+    }
+
+    Outcome outcome = requestTokens(snapshot);
+    int64_t now = nowMillis();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        in_flight_--;
+
+        auto it = connections_.find(id);
+        if (it != connections_.end()) {
+            Tracked& tracked = it->second;
+            qmark::OAuthConnection& connection = tracked.connection;
+            tracked.in_flight.reset();
+
+            if (outcome.success) {
+                connection.encrypted_access_token = std::move(outcome.encrypted_access_token);
+                if (!outcome.encrypted_refresh_token.empty()) {
+                    connection.encrypted_refresh_token = std::move(outcome.encrypted_refresh_token);
+                }
+                connection.expires_at = outcome.expires_in > 0
+                    ? qmark::Timestamp(std::chrono::milliseconds(now + outcome.expires_in * 1000))
+                    : qmark::Timestamp{};
+                connection.updated_at = qmark::Timestamp(std::chrono::milliseconds(now));
+                tracked.failures = 0;
+                pending_writes_.push_back(connection);
+                scheduleFromExpiry(id, tracked);
+            } else if (outcome.revoked) {
+                connection.is_active = false;
+                connection.updated_at = qmark::Timestamp(std::chrono::milliseconds(now));
+                pending_writes_.push_back(connection);
+                connections_.erase(it);
+            } else {
+                // Exponential backoff, never later than the refresh would have been useful
+                int64_t initial_ms = std::chrono::duration_cast<std::chrono::milliseconds>(config_.retry_initial).count();
+                int64_t max_ms = std::chrono::duration_cast<std::chrono::milliseconds>(config_.retry_max).count();
+                int64_t backoff = initial_ms << std::min<uint32_t>(tracked.failures, 20);
+                tracked.failures++;
+                schedule(id, tracked, now + std::min(backoff, max_ms));
+            }
+        }
+    }
+
+    if (outcome.success) {
+        refreshed_++;
+        MetricsRegistry::getInstance().increment(refresh_counter_);
+    } else {
+        failures_++;
+        MetricsRegistry::getInstance().increment(failure_counter_);
+        if (outcome.revoked) {
+            revoked_++;
+            Logger::warn("OAuth connection " + std::to_string(id) + " (" + snapshot.provider +
+                         ") revoked by the provider: " + outcome.error);
+        } else {
+            Logger::warn("OAuth token refresh failed for connection " + std::to_string(id) + ": " + outcome.error);
+        }
+    }
+
+    // On-demand refreshes are written by the next flush, which this wakes
+    wake_cv_.notify_one();
+    promise.set_value(outcome.success);
+    return result;
+}
+
+bool TokenRefresher::refreshNow(qmark::ConnectionId id) {
+    return refresh(id).get();
+}
+
+std::optional<std::string> TokenRefresher::accessToken(qmark::ConnectionId id) {
+    int64_t min_validity_ms = std::chrono::duration_cast<std::chrono::milliseconds>(config_.min_validity).count();
+    bool refreshable = false;
+    int64_t expires_ms = 0;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = connections_.find(id);
+        if (it == connections_.end()) {
+            return std::nullopt;
+        }
+        const qmark::OAuthConnection& connection = it->second.connection;
+        expires_ms = toMillis(connection.expires_at);
+        refreshable = !connection.encrypted_refresh_token.empty();
+    }
+
+    // Usually the background refresher got there first and this is skipped
+    if (refreshable && expires_ms > 0 && expires_ms - nowMillis() < min_validity_ms) {
+        refresh(id).get();
+    }
+
+    std::string encrypted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = connections_.find(id);
+        if (it == connections_.end()) {
+            return std::nullopt;
+        }
+        const qmark::OAuthConnection& connection = it->second.connection;
+        expires_ms = toMillis(connection.expires_at);
+        if (expires_ms > 0 && expires_ms <= nowMillis()) {
+            return std::nullopt;
+        }
+        encrypted = connection.encrypted_access_token;
+    }
+
+    try {
+        return Encryption::decrypt(encrypted, config_.encryption_key);
+    } catch (const std::exception& e) {
+        Logger::error("Failed to decrypt access token of connection " + std::to_string(id) + ": " + e.what());
+        return std::nullopt;
+    }
+}
+
+void TokenRefresher::flushWrites() {
+    std::vector<qmark::OAuthConnection> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_writes_.empty()) {
+            return;
+        }
+        batch.swap(pending_writes_);
+    }
+
+    // The same connection refreshed twice between flushes is written once
+    std::stable_sort(batch.begin(), batch.end(), [](const qmark::OAuthConnection& a, const qmark::OAuthConnection& b) {
+        return a.id < b.id;
+    });
+    std::vector<qmark::OAuthConnection> latest;
+    for (auto it = batch.rbegin(); it != batch.rend(); ++it) {
+        if (latest.empty() || latest.back().id != it->id) {
+            latest.push_back(std::move(*it));
+        }
+    }
+
+    if (!config_.persist(latest)) {
+        // Rotated refresh tokens must not be lost: keep them for a later attempt
+        Logger::error("Failed to persist " + std::to_string(latest.size()) + " refreshed OAuth connections");
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_writes_.insert(pending_writes_.begin(), latest.begin(), latest.end());
+        flush_retry_ms_ = nowMillis() + 5 * config_.batch_interval.count();
+    }
+}
+
+void TokenRefresher::refresherLoop() {
+    int64_t interval_ms = config_.batch_interval.count();
+    int64_t last_batch_ms = 0;
+    std::vector<qmark::ConnectionId> batch;
+
+    while (running_) {
+        batch.clear();
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            while (running_) {
+                int64_t now = nowMillis();
+                if (!pending_writes_.empty() && now >= flush_retry_ms_) {
+                    break;
+                }
+
+                while (!heap_.empty()) {
+                    auto it = connections_.find(heap_.top().id);
+                    if (it != connections_.end() && it->second.generation == heap_.top().generation) {
+                        break;
+                    }
+                    heap_.pop();
+                }
+
+                // Rate limit: the next batch starts no earlier than one interval after the last
+                int64_t wake = heap_.empty() ? INT64_MAX : std::max(heap_.top().due_ms, last_batch_ms + interval_ms);
+                if (!pending_writes_.empty()) {
+                    wake = std::min(wake, flush_retry_ms_);
+                }
+                if (wake <= now) {
+                    break;
+                }
+                if (wake == INT64_MAX) {
+                    wake_cv_.wait(lock);
+                } else {
+                    wake_cv_.wait_for(lock, std::chrono::milliseconds(wake - now));
+                }
+            }
+            if (!running_) {
+                break;
+            }
+
+            int64_t now = nowMillis();
+            if (now >= last_batch_ms + interval_ms) {
+                while (!heap_.empty() && batch.size() < config_.batch_size && heap_.top().due_ms <= now) {
+                    HeapEntry entry = heap_.top();
+                    heap_.pop();
+
+                    // A refresh already in flight reschedules the connection when it lands
+                    auto it = connections_.find(entry.id);
+                    if (it != connections_.end() && it->second.generation == entry.generation && !it->second.in_flight) {
+                        batch.push_back(entry.id);
+                    }
+                }
+                if (!batch.empty()) {
+                    last_batch_ms = now;
+                }
+            }
+        }
+
+        if (!batch.empty()) {
+            std::vector<std::future<bool>> results;
+            results.reserve(batch.size());
+            for (qmark::ConnectionId id : batch) {
+                results.push_back(std::async(std::launch::async, [this, id]() {
+                    return refresh(id).get();
+                }));
+            }
+            for (auto& result : results) {
+                result.wait();
+            }
+        }
+
+        flushWrites();
+    }
+}
+
+TokenRefresher::Stats TokenRefresher::stats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.tracked = connections_.size();
+        stats.in_flight = in_flight_;
+    }
+    stats.refreshed = refreshed_.load();
+    stats.failures = failures_.load();
+    stats.joined = joined_.load();
+    stats.revoked = revoked_.load();
+    return stats;
+}
+
+} // namespace QMark
@@ -1,24 +1,68 @@
-#include "qmark.hpp"
+#include "qmark_json.hpp"
+#include "qmark_reflection.hpp"
+#include "utils/json_codec.hpp"
+#include "utils/json_reader.hpp"
 #include <nlohmann/json.hpp>
 #include "utils/logger.hpp"
+#include <ctime>
 
 using json = nlohmann::json;
 
 namespace QMark {
 
+namespace {
+
+template<typename Write>
+std::string writeToString(Write&& write) {
+    std::string out;
+    JsonWriter writer(out);
+    write(writer);
+    return out;
+}
+
+template<typename T>
+bool parseObject(const std::string& json, T& out) {
+    thread_local JsonReader reader;
+    if (!reader.parse(json)) {
+        Logger::error("JSON parse failed: " + reader.error());
+        return false;
+    }
+    return json_codec::read(reader, reader.root(), out);
+}
+
+} // namespace
+
 namespace JSON {
 
 std::string serialize(const std::map<std::string, std::string>& data) {
-    try {
-        json j = data;
-        return j.dump();
-    } catch (const std::exception& e) {
-        Logger::error("JSON serialization failed: " + std::string(e.what()));
-        return "{}";
-    }
+    return writeToString([&](JsonWriter& writer) {
+        writer.beginObject();
+        for (const auto& [key, value] : data) {
+            writer.field(key, value);
+        }
+        writer.endObject();
+    });
 }
 
 std::map<std::string, std::string> deserialize(const std::string& json_str) {
+    // Object documents: strings decoded, other values kept as their source text
+    JsonReader reader;
+    if (reader.parse(json_str) && reader.root().type == JsonType::OBJECT) {
+        std::map<std::string, std::string> result;
+        std::string key;
+        for (const auto& member : reader.fields()) {
+            key.clear();
+            JsonReader::unescape(member.key, key);
+
+            std::string& value = result[key];
+            if (!JsonReader::getString(member.value, value)) {
+                value.assign(member.value.raw);
+            }
+        }
+        return result;
+    }
+
+    // Anything else goes through the DOM parser as before
     try {
         json j = json::parse(json_str);
         std::map<std::string, std::string> result;
@@ -38,23 +82,83 @@ std::map<std::string, std::string> deserialize(const std::string& json_str) {
     }
 }
 
-json createResponse(const std::string& status, const std::string& message, const json& data) {
-    return json{
-        {"status", status},
-        {"message", message},
-        {"data", data},
-        {"timestamp", std::time(nullptr)}
-    };
+std::string createResponse(const std::string& status, const std::string& message, std::string_view data_json) {
+    return writeToString([&](JsonWriter& writer) {
+        writer.beginObject()
+            .field("status", status)
+            .field("message", message);
+        writer.key("data").raw(data_json);
+        writer.field("timestamp", static_cast<int64_t>(std::time(nullptr)))
+            .endObject();
+    });
 }
 
-json createErrorResponse(const std::string& error, int code) {
-    return json{
-        {"error", error},
-        {"code", code},
-        {"timestamp", std::time(nullptr)}
-    };
+std::string createErrorResponse(const std::string& error, int code) {
+    return writeToString([&](JsonWriter& writer) {
+        writer.beginObject()
+            .field("error", error)
+            .field("code", code)
+            .field("timestamp", static_cast<int64_t>(std::time(nullptr)))
+            .endObject();
+    });
 }
 
 } // namespace JSON
 
-} // namespace QMark
\ No newline at end of file
+namespace json_utils {
+
+// Field lists come from the descriptors in qmark_reflection.hpp
+void write_user(JsonWriter& writer, const qmark::User& user) {
+    json_codec::write(writer, user);
+}
+
+void write_oauth_connection(JsonWriter& writer, const qmark::OAuthConnection& connection) {
+    // Encrypted tokens are flagged NOT_JSON and never leave the server
+    json_codec::write(writer, connection);
+}
+
+void write_dashboard_metrics(JsonWriter& writer, const qmark::DashboardMetrics& metrics) {
+    json_codec::write(writer, metrics);
+}
+
+std::string serialize_user(const qmark::User& user) {
+    return writeToString([&](JsonWriter& writer) { write_user(writer, user); });
+}
+
+std::string serialize_oauth_connection(const qmark::OAuthConnection& connection) {
+    return writeToString([&](JsonWriter& writer) { write_oauth_connection(writer, connection); });
+}
+
+std::string serialize_dashboard_metrics(const qmark::DashboardMetrics& metrics) {
+    return writeToString([&](JsonWriter& writer) { write_dashboard_metrics(writer, metrics); });
+}
+
+std::string serialize_error(const std::string& message, int code) {
+    return writeToString([&](JsonWriter& writer) {
+        writer.beginObject()
+            .field("error", message)
+            .field("code", code)
+            .endObject();
+    });
+}
+
+std::string serialize_success(const std::string& message) {
+    return writeToString([&](JsonWriter& writer) {
+        writer.beginObject()
+            .field("status", "success")
+            .field("message", message)
+            .endObject();
+    });
+}
+
+bool parse_user(const std::string& json, qmark::User& user) {
+    return parseObject(json, user);
+}
+
+bool parse_oauth_connection(const std::string& json, qmark::OAuthConnection& connection) {
+    return parseObject(json, connection);
+}
+
+} // namespace json_utils
+
+} // namespace QMark
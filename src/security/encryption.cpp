@@ -1,8 +1,11 @@
 
 #include "security/encryption.hpp"
+#include "security/random.hpp"
 #include "utils/logger.hpp"
-#include <openssl/rand.h>
+#include "utils/tracing.hpp"
+#include <openssl/crypto.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <openssl/sha.h>
 #include <iomanip>
 #include <sstream>
@@ -10,17 +13,12 @@
 namespace QMark {
 
 std::string Encryption::generateSalt(size_t length) {
-    std::vector<unsigned char> salt(length);
-    
-    if (RAND_bytes(salt.data(), static_cast<int>(length)) != 1) {
-        Logger::error("Failed to generate random salt");
-        throw std::runtime_error("Failed to generate random salt");
-    }
-    
-    return bytesToHex(salt);
+    return SecureRandom::hex(length);
 }
 
 std::string Encryption::hashPassword(const std::string& password, const std::string& salt) {
+    TraceSpan span("crypto", "Encryption::hashPassword");
+
     std::string salted_password = password + salt;
     
     unsigned char hash[SHA256_DIGEST_LENGTH];
@@ -45,6 +43,8 @@ std::string Encryption::hashPassword(const std::string& password, const std::str
 }
 
 bool Encryption::verifyPassword(const std::string& password, const std::string& hash, const std::string& salt) {
+    TraceSpan span("crypto", "Encryption::verifyPassword");
+
     try {
         std::string computed_hash = hashPassword(password, salt);
         return computed_hash == hash;
@@ -55,6 +55,8 @@ bool Encryption::verifyPassword(const std::string& password, const std::string&
 }
 
 std::string Encryption::encrypt(const std::string& plaintext, const std::string& key) {
+    TraceSpan span("crypto", "Encryption::encrypt");
+
     EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
     if (!ctx) {
         Logger::error("Failed to create cipher context");
@@ -63,10 +65,12 @@ std::string Encryption::encrypt(const std::string& plaintext, const std::string&
     
     // Generate random IV
     std::vector<unsigned char> iv(EVP_CIPHER_iv_length(EVP_aes_256_cbc()));
-    if (RAND_bytes(iv.data(), static_cast<int>(iv.size())) != 1) {
+    try {
+        SecureRandom::fill(iv.data(), iv.size());
+    } catch (const std::exception&) {
         EVP_CIPHER_CTX_free(ctx);
         Logger::error("Failed to generate IV");
-        throw std::runtime_error("Failed to generate IV");
+        throw;
     }
     
     // Initialize encryption
@@ -111,6 +115,8 @@ std::string Encryption::encrypt(const std::string& plaintext, const std::string&
 }
 
 std::string Encryption::decrypt(const std::string& ciphertext_hex, const std::string& key) {
+    TraceSpan span("crypto", "Encryption::decrypt");
+
     std::vector<unsigned char> data = hexToBytes(ciphertext_hex);
     
     // Extract IV
@@ -164,6 +170,29 @@ std::string Encryption::decrypt(const std::string& ciphertext_hex, const std::st
     return std::string(reinterpret_cast<char*>(plaintext.data()), plaintext_len);
 }
 
+std::vector<unsigned char> Encryption::hmacSha256(const std::string& key, std::string_view data) {
+    std::vector<unsigned char> digest(EVP_MAX_MD_SIZE);
+    unsigned int length = 0;
+    if (!HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()),
+              reinterpret_cast<const unsigned char*>(data.data()), data.size(), digest.data(), &length)) {
+        Logger::error("Failed to compute HMAC-SHA256");
+        throw std::runtime_error("Failed to compute HMAC-SHA256");
+    }
+    digest.resize(length);
+    return digest;
+}
+
+std::string Encryption::sha256Hex(std::string_view data) {
+    unsigned char hash[SHA256_DIGEST_LENGTH];
+    SHA256(reinterpret_cast<const unsigned char*>(data.data()), data.size(), hash);
+    return bytesToHex(std::vector<unsigned char>(hash, hash + SHA256_DIGEST_LENGTH));
+}
+
+bool Encryption::constantTimeEquals(std::string_view a, std::string_view b) {
+    // Only the length may leak, never the position of the first difference
+    return a.size() == b.size() && CRYPTO_memcmp(a.data(), b.data(), a.size()) == 0;
+}
+
 std::string Encryption::bytesToHex(const std::vector<unsigned char>& bytes) {
     std::stringstream ss;
     ss << std::hex << std::setfill('0');
@@ -192,4 +221,8 @@ std::vector<unsigned char> Encryption::hexToBytes(const std::string& hex) {
     return bytes;
 }
 
+std::string TokenManager::generate_csrf_token() {
+    return SecureRandom::hex(32);
+}
+
 } // namespace QMark
@@ -0,0 +1,185 @@
+#include "security/random.hpp"
+#include "utils/logger.hpp"
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <pthread.h>
+#include <sys/random.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+namespace QMark {
+
+namespace {
+
+constexpr size_t KEY_SIZE = 32;
+constexpr size_t IV_SIZE = 16;
+
+// Bumped in the child after fork() so every inherited DRBG state reseeds
+std::atomic<uint64_t> fork_generation{0};
+std::once_flag atfork_once;
+
+void onFork() {
+    fork_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
+void osEntropy(unsigned char* out, size_t length) {
+    size_t filled = 0;
+
+    while (filled < length) {
+        ssize_t result = getrandom(out + filled, length - filled, 0);
+        if (result < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+
+            // Kernel without getrandom(2): fall back to OpenSSL's private DRBG
+            if (RAND_priv_bytes(out + filled, static_cast<int>(length - filled)) != 1) {
+                Logger::error("Failed to read OS entropy");
+                throw std::runtime_error("Failed to read OS entropy");
+            }
+            return;
+        }
+
+        filled += static_cast<size_t>(result);
+    }
+}
+
+struct ThreadDrbg {
+    EVP_CIPHER_CTX* ctx = nullptr;
+    std::array<unsigned char, KEY_SIZE> key{};
+    std::array<unsigned char, SecureRandom::BUFFER_SIZE> buffer{};
+    size_t available = 0;
+    size_t since_reseed = 0;
+    uint64_t generation = 0;
+    bool seeded = false;
+
+    ~ThreadDrbg() {
+        if (ctx) {
+            EVP_CIPHER_CTX_free(ctx);
+        }
+        OPENSSL_cleanse(key.data(), key.size());
+        OPENSSL_cleanse(buffer.data(), buffer.size());
+    }
+
+    void reseed() {
+        std::array<unsigned char, KEY_SIZE> entropy;
+        osEntropy(entropy.data(), entropy.size());
+
+        for (size_t i = 0; i < KEY_SIZE; i++) {
+            key[i] ^= entropy[i];
+        }
+        OPENSSL_cleanse(entropy.data(), entropy.size());
+
+        OPENSSL_cleanse(buffer.data(), buffer.size());
+        available = 0;
+        since_reseed = 0;
+        generation = fork_generation.load(std::memory_order_relaxed);
+        seeded = true;
+    }
+
+    // Fast key erasure: the first KEY_SIZE bytes of each keystream block
+    // become the next key, so past output cannot be recomputed from state
+    void refill() {
+        if (!ctx) {
+            ctx = EVP_CIPHER_CTX_new();
+            if (!ctx) {
+                Logger::error("Failed to create DRBG cipher context");
+                throw std::runtime_error("Failed to create DRBG cipher context");
+            }
+        }
+
+        static const std::array<unsigned char, IV_SIZE> iv{};
+        if (EVP_EncryptInit_ex(ctx, EVP_chacha20(), nullptr, key.data(), iv.data()) != 1) {
+            Logger::error("Failed to initialize DRBG cipher");
+            throw std::runtime_error("Failed to initialize DRBG cipher");
+        }
+
+        std::memset(buffer.data(), 0, buffer.size());
+        int len = 0;
+        if (EVP_EncryptUpdate(ctx, buffer.data(), &len, buffer.data(), static_cast<int>(buffer.size())) != 1) {
+            Logger::error("Failed to generate DRBG keystream");
+            throw std::runtime_error("Failed to generate DRBG keystream");
+        }
+
+        std::memcpy(key.data(), buffer.data(), KEY_SIZE);
+        OPENSSL_cleanse(buffer.data(), KEY_SIZE);
+        available = buffer.size() - KEY_SIZE;
+    }
+
+    void generate(unsigned char* out, size_t length) {
+        if (!seeded || generation != fork_generation.load(std::memory_order_relaxed) ||
+            since_reseed >= SecureRandom::RESEED_INTERVAL) {
+            reseed();
+        }
+
+        while (length > 0) {
+            if (available == 0) {
+                refill();
+            }
+
+            size_t chunk = std::min(length, available);
+            unsigned char* source = buffer.data() + buffer.size() - available;
+            std::memcpy(out, source, chunk);
+            // Handed-out bytes are wiped so a later state leak cannot reveal them
+            OPENSSL_cleanse(source, chunk);
+
+            out += chunk;
+            length -= chunk;
+            available -= chunk;
+            since_reseed += chunk;
+        }
+    }
+};
+
+ThreadDrbg& threadDrbg() {
+    std::call_once(atfork_once, []() {
+        pthread_atfork(nullptr, nullptr, onFork);
+    });
+
+    thread_local ThreadDrbg drbg;
+    return drbg;
+}
+
+} // namespace
+
+void SecureRandom::fill(unsigned char* out, size_t length) {
+    threadDrbg().generate(out, length);
+}
+
+std::vector<unsigned char> SecureRandom::bytes(size_t length) {
+    std::vector<unsigned char> result(length);
+    fill(result.data(), length);
+    return result;
+}
+
+std::string SecureRandom::hex(size_t length) {
+    static const char hex_digits[] = "0123456789abcdef";
+    std::array<unsigned char, 64> chunk;
+    std::string result;
+    result.reserve(length * 2);
+
+    while (length > 0) {
+        size_t n = std::min(length, chunk.size());
+        fill(chunk.data(), n);
+        for (size_t i = 0; i < n; i++) {
+            result += hex_digits[chunk[i] >> 4];
+            result += hex_digits[chunk[i] & 0x0f];
+        }
+        length -= n;
+    }
+
+    OPENSSL_cleanse(chunk.data(), chunk.size());
+    return result;
+}
+
+void SecureRandom::reseed() {
+    threadDrbg().reseed();
+}
+
+} // namespace QMark
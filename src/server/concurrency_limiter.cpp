@@ -0,0 +1,108 @@
+#include "server/concurrency_limiter.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace QMark {
+
+ConcurrencyLimiter::ConcurrencyLimiter(const ConcurrencyLimiterConfig& config)
+    : config_(config), limit_(0), in_flight_(0), admitted_(0), rejected_{}, window_peak_in_flight_(0) {
+    config_.min_limit = std::max<size_t>(config_.min_limit, 2);
+    config_.max_limit = std::max(config_.max_limit, config_.min_limit);
+    config_.window_min_samples = std::max<size_t>(config_.window_min_samples, 1);
+    config_.baseline_windows = std::max<size_t>(config_.baseline_windows, 1);
+
+    estimated_limit_ = static_cast<double>(std::clamp(config_.initial_limit, config_.min_limit, config_.max_limit));
+    limit_ = static_cast<size_t>(estimated_limit_);
+    window_start_ = std::chrono::steady_clock::now();
+}
+
+bool ConcurrencyLimiter::tryAcquire(RequestPriority priority) {
+    size_t limit = limit_.load(std::memory_order_relaxed);
+    size_t allowed = limit;
+    if (priority == RequestPriority::NORMAL) {
+        allowed = static_cast<size_t>(static_cast<double>(limit) * config_.normal_share);
+    } else if (priority == RequestPriority::BULK) {
+        allowed = static_cast<size_t>(static_cast<double>(limit) * config_.bulk_share);
+    }
+    allowed = std::max<size_t>(allowed, 1);
+
+    size_t current = in_flight_.load(std::memory_order_relaxed);
+    do {
+        if (current >= allowed) {
+            rejected_[static_cast<size_t>(priority)].fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!in_flight_.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+
+    admitted_.fetch_add(1, std::memory_order_relaxed);
+
+    // Peak of the window: tells a saturated limit from an idle server
+    size_t peak = window_peak_in_flight_.load(std::memory_order_relaxed);
+    while (current + 1 > peak &&
+           !window_peak_in_flight_.compare_exchange_weak(peak, current + 1, std::memory_order_relaxed)) {
+    }
+    return true;
+}
+
+void ConcurrencyLimiter::release() {
+    in_flight_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ConcurrencyLimiter::release(std::chrono::microseconds latency) {
+    in_flight_.fetch_sub(1, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    window_latency_us_ += static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+    window_samples_++;
+    if (window_samples_ >= config_.window_min_samples &&
+        std::chrono::steady_clock::now() - window_start_ >= config_.window) {
+        updateLimit();
+    }
+}
+
+void ConcurrencyLimiter::updateLimit() {
+    double recent = std::max(1.0, static_cast<double>(window_latency_us_) / static_cast<double>(window_samples_));
+    size_t peak = window_peak_in_flight_.exchange(in_flight_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    window_start_ = std::chrono::steady_clock::now();
+    window_latency_us_ = 0;
+    window_samples_ = 0;
+
+    // Baseline: the unloaded latency, i.e. the lowest seen. It only creeps up,
+    // so a lasting change (bigger tenants, slower disk) is accepted within
+    // baseline_windows while a spike is not
+    recent_us_ = recent;
+    if (baseline_us_ == 0.0 || recent < baseline_us_) {
+        baseline_us_ = recent;
+    } else {
+        baseline_us_ += (recent - baseline_us_) / static_cast<double>(config_.baseline_windows);
+    }
+
+    // Less than half the limit in use: the window says nothing about it
+    if (static_cast<double>(peak) < estimated_limit_ / 2.0) {
+        return;
+    }
+
+    // 1 while recent latency stays within tolerance of the baseline, down to 0.5 beyond
+    double gradient = std::clamp(config_.tolerance * baseline_us_ / recent, 0.5, 1.0);
+    double target = estimated_limit_ * gradient + std::sqrt(estimated_limit_);
+    estimated_limit_ = std::clamp(estimated_limit_ * (1.0 - config_.smoothing) + target * config_.smoothing,
+                                  static_cast<double>(config_.min_limit), static_cast<double>(config_.max_limit));
+    limit_.store(static_cast<size_t>(estimated_limit_), std::memory_order_relaxed);
+}
+
+ConcurrencyLimiter::Stats ConcurrencyLimiter::stats() const {
+    Stats stats;
+    stats.limit = limit();
+    stats.in_flight = inFlight();
+    stats.admitted = admitted_.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < 3; i++) {
+        stats.rejected[i] = rejected_[i].load(std::memory_order_relaxed);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats.recent_latency_ms = recent_us_ / 1000.0;
+    stats.baseline_latency_ms = baseline_us_ / 1000.0;
+    return stats;
+}
+
+} // namespace QMark
@@ -0,0 +1,557 @@
+#include "server/event_hub.hpp"
+#include "utils/json_writer.hpp"
+#include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace QMark {
+
+namespace {
+
+constexpr int MAX_EPOLL_EVENTS = 256;
+constexpr uint32_t READ_EVENTS = EPOLLIN | EPOLLRDHUP;
+
+// The response went out with Transfer-Encoding: chunked, so every write is one chunk
+void appendChunk(std::string& out, std::string_view payload) {
+    char size[20];
+    int length = std::snprintf(size, sizeof(size), "%zx\r\n", payload.size());
+    out.append(size, static_cast<size_t>(length));
+    out.append(payload);
+    out.append("\r\n", 2);
+}
+
+// One SSE frame; a data field may not span lines, so each line gets its own
+std::string formatEvent(std::string_view event, std::string_view data) {
+    std::string frame;
+    frame.reserve(event.size() + data.size() + 16);
+    frame.append("event: ").append(event).append("\n");
+
+    size_t start = 0;
+    while (true) {
+        size_t end = data.find('\n', start);
+        frame.append("data: ").append(data.substr(start, end - start)).append("\n");
+        if (end == std::string_view::npos) {
+            break;
+        }
+        start = end + 1;
+    }
+    frame.append("\n");
+    return frame;
+}
+
+} // namespace
+
+EventHub& EventHub::getInstance() {
+    static EventHub instance;
+    return instance;
+}
+
+EventHub::EventHub() : running_(false), published_(0), coalesced_(0), dropped_(0) {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    published_counter_ = metrics.registerCounter("qmark_sse_events_published_total", "Dashboard events queued to SSE subscribers.");
+    dropped_counter_ = metrics.registerCounter("qmark_sse_subscribers_dropped_total", "SSE subscribers disconnected for not keeping up.");
+    metrics.registerCallback("qmark_sse_subscribers", "Open Server-Sent Events streams.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(stats().subscribers); });
+}
+
+EventHub::~EventHub() {
+    stop();
+}
+
+int64_t EventHub::nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool EventHub::start(const EventHubConfig& config) {
+    if (running_) {
+        return true;
+    }
+
+    config_ = config;
+    if (config_.queue_limit == 0) {
+        config_.queue_limit = 1;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        Logger::error("Failed to create event hub descriptors: " + std::string(std::strerror(errno)));
+        stop();
+        return false;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = wake_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) != 0) {
+        Logger::error("Failed to register event hub wakeup: " + std::string(std::strerror(errno)));
+        stop();
+        return false;
+    }
+
+    running_ = true;
+    loop_thread_ = std::thread([this]() {
+        eventLoop();
+    });
+
+    Logger::info("Event hub started (max " + std::to_string(config_.max_subscribers) + " subscribers)");
+    return true;
+}
+
+void EventHub::stop() {
+    bool was_running = running_.exchange(false);
+    if (was_running) {
+        wake();
+        if (loop_thread_.joinable()) {
+            loop_thread_.join();
+        }
+    }
+
+    std::unordered_map<int, std::unique_ptr<Subscriber>> subscribers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        subscribers.swap(subscribers_);
+        by_user_.clear();
+        dirty_.clear();
+    }
+    // Best effort: end the chunked body so clients see a clean close
+    for (auto& [fd, subscriber] : subscribers) {
+        ::send(fd, "0\r\n\r\n", 5, MSG_NOSIGNAL | MSG_DONTWAIT);
+        ::close(fd);
+    }
+
+    if (wake_fd_ >= 0) {
+        ::close(wake_fd_);
+        wake_fd_ = -1;
+    }
+    if (epoll_fd_ >= 0) {
+        ::close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+
+    if (was_running) {
+        Logger::info("Event hub stopped");
+    }
+}
+
+bool EventHub::adopt(int fd, int64_t user_id) {
+    if (!running_) {
+        return false;
+    }
+
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        return false;
+    }
+
+    bool wake_loop = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (subscribers_.size() >= config_.max_subscribers) {
+            return false;
+        }
+
+        auto subscriber = std::make_unique<Subscriber>();
+        subscriber->fd = fd;
+        subscriber->user_id = user_id;
+        subscriber->last_write_ms = nowMillis();
+        subscriber->events.push_back("retry: " + std::to_string(config_.retry.count()) + "\n: connected\n\n");
+
+        // Registered under the lock, so the loop never sees an fd it cannot look up
+        epoll_event event{};
+        event.events = READ_EVENTS;
+        event.data.fd = fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+            Logger::warn("Failed to register SSE subscriber: " + std::string(std::strerror(errno)));
+            return false;
+        }
+
+        Subscriber* raw = subscriber.get();
+        subscribers_[fd] = std::move(subscriber);
+        by_user_[user_id].push_back(raw);
+        wake_loop = markDirty(*raw);
+    }
+
+    if (wake_loop) {
+        wake();
+    }
+    return true;
+}
+
+bool EventHub::markDirty(Subscriber& subscriber) {
+    if (subscriber.dirty) {
+        return false;
+    }
+    subscriber.dirty = true;
+    dirty_.push_back(&subscriber);
+    return dirty_.size() == 1;
+}
+
+void EventHub::wake() {
+    if (wake_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+        (void)written;
+    }
+}
+
+void EventHub::publish(int64_t user_id, std::string_view event, std::string_view data) {
+    if (!running_) {
+        return;
+    }
+
+    std::string frame;
+    bool wake_loop = false;
+    size_t queued = 0;
+    uint64_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = by_user_.find(user_id);
+        if (it == by_user_.end()) {
+            return;
+        }
+
+        frame = formatEvent(event, data);
+        for (Subscriber* subscriber : it->second) {
+            if (subscriber->closing) {
+                continue;
+            }
+            if (subscriber->events.size() >= config_.queue_limit) {
+                // Too far behind to catch up: the browser reconnects and reloads a snapshot
+                subscriber->closing = true;
+                dropped++;
+            } else {
+                subscriber->events.push_back(frame);
+                queued++;
+            }
+            wake_loop |= markDirty(*subscriber);
+        }
+    }
+
+    if (queued > 0) {
+        published_ += queued;
+        MetricsRegistry::getInstance().increment(published_counter_, queued);
+    }
+    if (dropped > 0) {
+        dropped_ += dropped;
+        MetricsRegistry::getInstance().increment(dropped_counter_, dropped);
+    }
+    if (wake_loop) {
+        wake();
+    }
+}
+
+void EventHub::publishDelta(int64_t user_id, std::string_view metric, int64_t delta) {
+    if (!running_) {
+        return;
+    }
+
+    bool wake_loop = false;
+    size_t queued = 0;
+    uint64_t coalesced = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = by_user_.find(user_id);
+        if (it == by_user_.end()) {
+            return;
+        }
+
+        for (Subscriber* subscriber : it->second) {
+            if (subscriber->closing) {
+                continue;
+            }
+            auto pending = subscriber->deltas.find(metric);
+            if (pending != subscriber->deltas.end()) {
+                pending->second += delta;
+                coalesced++;
+            } else {
+                subscriber->deltas.emplace(std::string(metric), delta);
+                queued++;
+            }
+            wake_loop |= markDirty(*subscriber);
+        }
+    }
+
+    coalesced_ += coalesced;
+    if (queued > 0) {
+        published_ += queued;
+        MetricsRegistry::getInstance().increment(published_counter_, queued);
+    }
+    if (wake_loop) {
+        wake();
+    }
+}
+
+void EventHub::flushDirty(int64_t now) {
+    std::vector<Subscriber*> ready;
+    std::vector<Subscriber*> closing;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready.reserve(dirty_.size());
+
+        for (Subscriber* subscriber : dirty_) {
+            subscriber->dirty = false;
+            if (subscriber->closing) {
+                closing.push_back(subscriber);
+                continue;
+            }
+
+            std::string payload;
+            for (const auto& frame : subscriber->events) {
+                payload += frame;
+            }
+            subscriber->events.clear();
+
+            // Every delta accumulated since the last flush goes out as one stats event
+            if (!subscriber->deltas.empty()) {
+                payload += "event: stats\ndata: ";
+                JsonWriter writer(payload);
+                writer.beginObject();
+                for (const auto& [metric, delta] : subscriber->deltas) {
+                    writer.field(metric, delta);
+                }
+                writer.endObject();
+                payload += "\n\n";
+                subscriber->deltas.clear();
+            }
+
+            if (!payload.empty()) {
+                appendChunk(subscriber->out, payload);
+                ready.push_back(subscriber);
+            }
+        }
+        dirty_.clear();
+    }
+
+    // Subscribers are only ever removed by this thread, so the pointers stay valid
+    for (Subscriber* subscriber : ready) {
+        if (!writeOut(*subscriber, now)) {
+            closing.push_back(subscriber);
+        }
+    }
+    close(closing);
+}
+
+bool EventHub::writeOut(Subscriber& subscriber, int64_t now) {
+    while (subscriber.out_offset < subscriber.out.size()) {
+        ssize_t sent = ::send(subscriber.fd, subscriber.out.data() + subscriber.out_offset,
+                              subscriber.out.size() - subscriber.out_offset, MSG_NOSIGNAL);
+        if (sent > 0) {
+            subscriber.out_offset += static_cast<size_t>(sent);
+            subscriber.last_write_ms = now;
+        } else if (sent < 0 && errno == EINTR) {
+            continue;
+        } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+
+    size_t unsent = subscriber.out.size() - subscriber.out_offset;
+    if (unsent == 0) {
+        subscriber.out.clear();
+        subscriber.out_offset = 0;
+    } else if (unsent > config_.max_buffered_bytes) {
+        // The socket buffer is full and stays full: a stalled reader
+        dropped_++;
+        MetricsRegistry::getInstance().increment(dropped_counter_);
+        return false;
+    } else if (subscriber.out_offset > unsent) {
+        subscriber.out.erase(0, subscriber.out_offset);
+        subscriber.out_offset = 0;
+    }
+
+    // Only ask for EPOLLOUT while something is waiting to be written
+    bool want_write = unsent > 0;
+    if (want_write != subscriber.want_write) {
+        epoll_event event{};
+        event.events = want_write ? (READ_EVENTS | EPOLLOUT) : READ_EVENTS;
+        event.data.fd = subscriber.fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, subscriber.fd, &event) != 0) {
+            return false;
+        }
+        subscriber.want_write = want_write;
+    }
+    return true;
+}
+
+void EventHub::heartbeat(int64_t now) {
+    // Swept every half interval, so no stream stays silent longer than one interval
+    int64_t idle_before = now - std::chrono::duration_cast<std::chrono::milliseconds>(config_.heartbeat).count() / 2;
+
+    std::vector<Subscriber*> idle;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& [fd, subscriber] : subscribers_) {
+            if (!subscriber->closing && subscriber->last_write_ms <= idle_before) {
+                idle.push_back(subscriber.get());
+            }
+        }
+    }
+
+    // Keeps proxies from timing out idle streams and reveals dead peers
+    std::vector<Subscriber*> closing;
+    for (Subscriber* subscriber : idle) {
+        appendChunk(subscriber->out, ": ping\n\n");
+        if (!writeOut(*subscriber, now)) {
+            closing.push_back(subscriber);
+        }
+    }
+    close(closing);
+}
+
+void EventHub::close(const std::vector<Subscriber*>& subscribers) {
+    if (subscribers.empty()) {
+        return;
+    }
+
+    // A subscriber listed twice must not be looked at after it is freed
+    std::vector<Subscriber*> unique(subscribers);
+    std::sort(unique.begin(), unique.end());
+    unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+
+    std::vector<int> fds;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Subscriber* subscriber : unique) {
+            auto it = subscribers_.find(subscriber->fd);
+            if (it == subscribers_.end() || it->second.get() != subscriber) {
+                continue;
+            }
+
+            auto user = by_user_.find(subscriber->user_id);
+            if (user != by_user_.end()) {
+                auto& list = user->second;
+                list.erase(std::remove(list.begin(), list.end(), subscriber), list.end());
+                if (list.empty()) {
+                    by_user_.erase(user);
+                }
+            }
+            if (subscriber->dirty) {
+                dirty_.erase(std::remove(dirty_.begin(), dirty_.end(), subscriber), dirty_.end());
+            }
+
+            fds.push_back(subscriber->fd);
+            subscribers_.erase(it);
+        }
+    }
+
+    // Closed only once out of the map, so a reused descriptor cannot collide
+    for (int fd : fds) {
+        ::close(fd);
+    }
+}
+
+void EventHub::eventLoop() {
+    epoll_event events[MAX_EPOLL_EVENTS];
+    int64_t flush_interval_ms = config_.flush_interval.count();
+    int64_t heartbeat_ms = std::max<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(config_.heartbeat).count() / 2, 1);
+    int64_t last_flush_ms = 0;
+    int64_t next_heartbeat_ms = nowMillis() + heartbeat_ms;
+    std::vector<Subscriber*> closing;
+
+    while (running_) {
+        int64_t now = nowMillis();
+        bool pending;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending = !dirty_.empty();
+        }
+
+        // Updates arriving within one flush interval of the last flush wait and merge
+        if (pending && now >= last_flush_ms + flush_interval_ms) {
+            flushDirty(now);
+            last_flush_ms = now;
+            pending = false;
+        }
+        if (now >= next_heartbeat_ms) {
+            heartbeat(now);
+            next_heartbeat_ms = now + heartbeat_ms;
+        }
+
+        int64_t deadline = next_heartbeat_ms;
+        if (pending) {
+            deadline = std::min(deadline, last_flush_ms + flush_interval_ms);
+        }
+        int timeout = static_cast<int>(std::max<int64_t>(deadline - now, 0));
+
+        int count = epoll_wait(epoll_fd_, events, MAX_EPOLL_EVENTS, timeout);
+        if (count < 0 && errno != EINTR) {
+            Logger::error("Event hub epoll_wait failed: " + std::string(std::strerror(errno)));
+            break;
+        }
+
+        now = nowMillis();
+        closing.clear();
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            uint32_t ready = events[i].events;
+
+            if (fd == wake_fd_) {
+                uint64_t value;
+                while (::read(wake_fd_, &value, sizeof(value)) > 0) {
+                }
+                continue;
+            }
+
+            Subscriber* subscriber;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = subscribers_.find(fd);
+                if (it == subscribers_.end()) {
+                    continue;
+                }
+                subscriber = it->second.get();
+            }
+
+            if (ready & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) {
+                closing.push_back(subscriber);
+                continue;
+            }
+            if (ready & EPOLLIN) {
+                // EventSource never sends after the request: anything here is the peer going away
+                char discard[512];
+                ssize_t received;
+                while ((received = ::recv(fd, discard, sizeof(discard), 0)) > 0) {
+                }
+                if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+                    closing.push_back(subscriber);
+                    continue;
+                }
+            }
+            if ((ready & EPOLLOUT) && !writeOut(*subscriber, now)) {
+                closing.push_back(subscriber);
+            }
+        }
+        close(closing);
+    }
+}
+
+bool EventHub::isFull() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return subscribers_.size() >= config_.max_subscribers;
+}
+
+EventHub::Stats EventHub::stats() const {
+    Stats stats;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats.subscribers = subscribers_.size();
+    }
+    stats.published = published_.load();
+    stats.coalesced = coalesced_.load();
+    stats.dropped = dropped_.load();
+    return stats;
+}
+
+} // namespace QMark
@@ -0,0 +1,225 @@
+#include "server/export_stream.hpp"
+#include "utils/logger.hpp"
+#include <charconv>
+
+namespace QMark {
+
+namespace {
+
+// deflate output buffer, reused for the whole export
+constexpr size_t GZIP_CHUNK = 16 * 1024;
+
+// Spreadsheets run a cell starting with =, +, -, @ as a formula (CSV
+// injection). Lead fields come from outside, so such text is prefixed with a
+// quote; numbers and phone numbers ("+33 6 12 34 56 78") are left alone.
+bool needsFormulaGuard(std::string_view text) {
+    if (text.empty()) {
+        return false;
+    }
+    switch (text[0]) {
+        case '=':
+        case '@':
+        case '\t':
+        case '\r':
+            return true;
+        case '+':
+        case '-':
+            return text.find_first_not_of("0123456789 .()-+", 1) != std::string_view::npos;
+        default:
+            return false;
+    }
+}
+
+template<typename T>
+void appendNumber(std::string& out, T number) {
+    char digits[32];
+    auto result = std::to_chars(digits, digits + sizeof(digits), number);
+    out.append(digits, result.ptr);
+}
+
+} // namespace
+
+ExportEncoder::ExportEncoder(ExportFormat format, std::span<const std::string_view> columns, bool gzip, int gzip_level)
+    : format_(format), columns_(columns), json_(text_), gzip_(gzip) {
+    if (!gzip_) {
+        return;
+    }
+    // windowBits 15 + 16: gzip header and trailer instead of a raw zlib stream
+    if (deflateInit2(&zstream_, gzip_level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        Logger::warn("Failed to initialize gzip for an export, sending it uncompressed");
+        gzip_ = false;
+        return;
+    }
+    compressed_.resize(GZIP_CHUNK);
+}
+
+ExportEncoder::~ExportEncoder() {
+    if (gzip_) {
+        deflateEnd(&zstream_);
+    }
+}
+
+void ExportEncoder::header() {
+    if (format_ != ExportFormat::CSV) {
+        return;
+    }
+    for (size_t i = 0; i < columns_.size(); i++) {
+        if (i > 0) {
+            text_ += ',';
+        }
+        text_.append(columns_[i]);
+    }
+    text_.append("\r\n");
+}
+
+void ExportEncoder::appendCsvField(const ExportValue& value) {
+    switch (value.type) {
+        case ExportValue::Type::NUL:
+            return;
+        case ExportValue::Type::INTEGER:
+            appendNumber(text_, value.integer);
+            return;
+        case ExportValue::Type::REAL:
+            appendNumber(text_, value.real);
+            return;
+        case ExportValue::Type::TEXT:
+            break;
+    }
+
+    bool guard = needsFormulaGuard(value.text);
+    if (value.text.find_first_of(",\"\r\n") == std::string_view::npos) {
+        if (guard) {
+            text_ += '\'';
+        }
+        text_.append(value.text);
+        return;
+    }
+
+    text_ += '"';
+    if (guard) {
+        text_ += '\'';
+    }
+    for (char c : value.text) {
+        if (c == '"') {
+            text_ += '"';
+        }
+        text_ += c;
+    }
+    text_ += '"';
+}
+
+void ExportEncoder::row(std::span<const ExportValue> values) {
+    rows_++;
+
+    if (format_ == ExportFormat::CSV) {
+        for (size_t i = 0; i < values.size(); i++) {
+            if (i > 0) {
+                text_ += ',';
+            }
+            appendCsvField(values[i]);
+        }
+        text_.append("\r\n");
+        return;
+    }
+
+    json_.beginObject();
+    for (size_t i = 0; i < values.size(); i++) {
+        json_.key(columns_[i]);
+        const ExportValue& value = values[i];
+        switch (value.type) {
+            case ExportValue::Type::NUL:
+                json_.null();
+                break;
+            case ExportValue::Type::INTEGER:
+                json_.value(value.integer);
+                break;
+            case ExportValue::Type::REAL:
+                json_.value(value.real);
+                break;
+            case ExportValue::Type::TEXT:
+                // metadata included: kept as the stored text, valid or not
+                json_.value(value.text);
+                break;
+        }
+    }
+    json_.endObject();
+    text_ += '\n';
+}
+
+bool ExportEncoder::deflateTo(const Sink& sink, int flush) {
+    zstream_.next_in = reinterpret_cast<Bytef*>(text_.data());
+    zstream_.avail_in = static_cast<uInt>(text_.size());
+
+    // Until deflate leaves output space unused: all input taken (and, on
+    // Z_FINISH, the trailer written)
+    do {
+        zstream_.next_out = reinterpret_cast<Bytef*>(compressed_.data());
+        zstream_.avail_out = static_cast<uInt>(compressed_.size());
+        if (deflate(&zstream_, flush) == Z_STREAM_ERROR) {
+            Logger::error("gzip stream error during an export");
+            return false;
+        }
+        size_t produced = compressed_.size() - zstream_.avail_out;
+        if (produced > 0) {
+            if (!sink(compressed_.data(), produced)) {
+                return false;
+            }
+            bytes_sent_ += produced;
+        }
+    } while (zstream_.avail_out == 0);
+    return true;
+}
+
+bool ExportEncoder::drain(const Sink& sink) {
+    bool ok = true;
+    if (gzip_) {
+        ok = deflateTo(sink, Z_NO_FLUSH);
+    } else if (!text_.empty()) {
+        ok = sink(text_.data(), text_.size());
+        bytes_sent_ += ok ? text_.size() : 0;
+    }
+    text_.clear();
+    return ok;
+}
+
+bool ExportEncoder::finish(const Sink& sink) {
+    if (!drain(sink)) {
+        return false;
+    }
+    return !gzip_ || deflateTo(sink, Z_FINISH);
+}
+
+ExportLimiter::ExportLimiter(size_t max_per_user, size_t max_total)
+    : max_per_user_(max_per_user), max_total_(max_total) {}
+
+std::shared_ptr<void> ExportLimiter::tryAcquire(qmark::UserId user_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (total_ >= max_total_) {
+        return nullptr;
+    }
+    size_t& count = active_[user_id];
+    if (count >= max_per_user_) {
+        return nullptr;
+    }
+    count++;
+    total_++;
+
+    // Non-null so callers can test it; only the deleter matters
+    return std::shared_ptr<void>(this, [this, user_id](void*) { release(user_id); });
+}
+
+void ExportLimiter::release(qmark::UserId user_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = active_.find(user_id);
+    if (it != active_.end() && --it->second == 0) {
+        active_.erase(it);
+    }
+    total_--;
+}
+
+size_t ExportLimiter::active() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return total_;
+}
+
+} // namespace QMark
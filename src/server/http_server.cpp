@@ -1,72 +1,667 @@
 #include "server/http_server.hpp"
+#include "server/event_hub.hpp"
+#include "ingest/webhook_ingest.hpp"
+#include "analytics/metrics_store.hpp"
 #include "utils/logger.hpp"
+#include "utils/binary_log.hpp"
+#include "utils/metrics.hpp"
+#include "utils/tracing.hpp"
+#include "utils/json_writer.hpp"
+#include "utils/json_schema.hpp"
+#include "utils/wire_format.hpp"
+#include "utils/request_arena.hpp"
 #include "security/encryption.hpp"
+#include "security/random.hpp"
 #include "database/database_manager.hpp"
-#include <nlohmann/json.hpp>
+#include <fcntl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <thread>
 
-using json = nlohmann::json;
 
 namespace QMark {
 
-HttpServer::HttpServer() : server_(std::make_unique<httplib::Server>()) {
+namespace {
+
+const char* const SERVER_GAUGES[] = {
+    "qmark_http_active_connections",
+    "qmark_http_queued_connections",
+    "qmark_sessions_active",
+    "qmark_db_pool_size",
+    "qmark_db_connections_in_use",
+    "qmark_db_connection_waiters",
+    "qmark_log_dropped_total",
+    "qmark_http_concurrency_limit",
+    "qmark_http_requests_in_flight",
+    "qmark_http_shed_total",
+    "qmark_http_exports_active",
+    "qmark_tls_handshakes_total",
+    "qmark_tls_resumed_total",
+    "qmark_tls_kernel_offload_total"
+};
+
+// Start of the request being handled by this worker thread (0 = not routed)
+thread_local std::chrono::steady_clock::time_point request_start{};
+
+// Response encoding negotiated from the Accept header of that request
+thread_local WireFormat response_format = WireFormat::JSON;
+
+// Socket of the connection this worker thread is serving, and whether a
+// handler handed it over to the event hub
+thread_local socket_t current_socket = INVALID_SOCKET;
+thread_local bool socket_adopted = false;
+
+// TLS session of that connection (nullptr on plain HTTP)
+thread_local SSL* current_ssl = nullptr;
+
+// Limiter that admitted the request this worker thread is serving, released
+// once the response is written
+thread_local ConcurrencyLimiter* admitted_by = nullptr;
+
+// Largest file slice handed to sendfile per provider call
+constexpr size_t SENDFILE_CHUNK = 256 * 1024;
+
+// Stands in for bytes sendfile already put on the wire, so httplib's offset
+// accounting still goes through DataSink::write (never read)
+const char SENDFILE_PLACEHOLDER[SENDFILE_CHUNK] = {};
+
+// httplib's stream for the connection, plus a way to send a file slice
+// without copying it through user space: sendfile on plain sockets,
+// SSL_sendfile when the kernel does the TLS encryption
+class ConnectionStream final : public httplib::Stream {
+private:
+    httplib::Stream& inner_;
+    SSL* ssl_;
+    size_t sent_ahead_ = 0;         // sent by sendFile, not yet accounted by httplib
+
+public:
+    ConnectionStream(httplib::Stream& inner, SSL* ssl) : inner_(inner), ssl_(ssl) {}
+
+    bool is_readable() const override { return inner_.is_readable(); }
+    bool wait_readable() const override { return inner_.wait_readable(); }
+    bool wait_writable() const override { return inner_.wait_writable(); }
+    ssize_t read(char* ptr, size_t size) override { return inner_.read(ptr, size); }
+    void get_remote_ip_and_port(std::string& ip, int& port) const override { inner_.get_remote_ip_and_port(ip, port); }
+    void get_local_ip_and_port(std::string& ip, int& port) const override { inner_.get_local_ip_and_port(ip, port); }
+    socket_t socket() const override { return inner_.socket(); }
+    time_t duration() const override { return inner_.duration(); }
+
+    ssize_t write(const char* ptr, size_t size) override {
+        if (sent_ahead_ > 0) {
+            size_t accounted = std::min(size, sent_ahead_);
+            sent_ahead_ -= accounted;
+            return static_cast<ssize_t>(accounted);
+        }
+        return inner_.write(ptr, size);
+    }
+
+    bool canSendFile() const {
+        return !ssl_ || TlsContext::kernelSend(ssl_);
+    }
+
+    // Up to length bytes of fd from offset; the caller reports them with
+    // DataSink::write(SENDFILE_PLACEHOLDER, n). 0 on failure.
+    size_t sendFile(int fd, size_t offset, size_t length) {
+        length = std::min(length, SENDFILE_CHUNK);
+        ssize_t sent;
+        if (ssl_) {
+            sent = SSL_sendfile(ssl_, fd, static_cast<off_t>(offset), length, 0);
+        } else {
+            off_t position = static_cast<off_t>(offset);
+            sent = ::sendfile(inner_.socket(), fd, &position, length);
+        }
+        if (sent <= 0) {
+            return 0;
+        }
+        sent_ahead_ = static_cast<size_t>(sent);
+        return static_cast<size_t>(sent);
+    }
+};
+
+thread_local ConnectionStream* current_stream = nullptr;
+
+// httplib::Server whose handlers may keep the connection's socket once the
+// response head is out (same shape as httplib's SSLServer override). With a
+// TLS context, connections are TLS only, as in SSLServer.
+class StreamingServer final : public httplib::Server {
+private:
+    TlsContext* tls_ = nullptr;
+    std::mutex ssl_mutex_;
+
+    bool process_and_close_socket(socket_t sock) override {
+        std::string remote_addr;
+        int remote_port = 0;
+        httplib::detail::get_remote_ip_and_port(sock, remote_addr, remote_port);
+
+        std::string local_addr;
+        int local_port = 0;
+        httplib::detail::get_local_ip_and_port(sock, local_addr, local_port);
+
+        auto serve = [&](httplib::Stream& stream, bool close_connection, bool& connection_closed) {
+            ConnectionStream connection(stream, current_ssl);
+            current_stream = &connection;
+            bool served = process_request(connection, remote_addr, remote_port, local_addr,
+                                          local_port, close_connection, connection_closed,
+                                          [](httplib::Request& req) { req.ssl = current_ssl; });
+            current_stream = nullptr;
+            return served;
+        };
+
+        current_socket = sock;
+        socket_adopted = false;
+        bool ret = false;
+        if (tls_) {
+            SSL* ssl = httplib::detail::ssl_new(
+                sock, tls_->context(), ssl_mutex_,
+                [&](SSL* accepting) {
+                    return httplib::detail::ssl_connect_or_accept_nonblocking(
+                        sock, accepting, SSL_accept, read_timeout_sec_, read_timeout_usec_);
+                },
+                [](SSL*) { return true; });
+            if (ssl) {
+                tls_->onHandshake(ssl);
+                current_ssl = ssl;
+                ret = httplib::detail::process_server_socket_ssl(
+                    svr_sock_, ssl, sock, keep_alive_max_count_, keep_alive_timeout_sec_,
+                    read_timeout_sec_, read_timeout_usec_, write_timeout_sec_,
+                    write_timeout_usec_, serve);
+                current_ssl = nullptr;
+                // A client leaving without close_notify keeps its session
+                // resumable (OpenSSL drops it from the cache otherwise); fatal
+                // alerts still invalidate it
+                if (!ret || socket_adopted) {
+                    SSL_set_shutdown(ssl, SSL_SENT_SHUTDOWN);
+                }
+                // An adopted socket keeps its kernel TLS state: no close_notify
+                httplib::detail::ssl_delete(ssl_mutex_, ssl, sock, ret && !socket_adopted);
+            }
+        } else {
+            ret = httplib::detail::process_server_socket(
+                svr_sock_, sock, keep_alive_max_count_, keep_alive_timeout_sec_,
+                read_timeout_sec_, read_timeout_usec_, write_timeout_sec_,
+                write_timeout_usec_, serve);
+        }
+        current_socket = INVALID_SOCKET;
+
+        // Connection lost between admission and the response
+        if (admitted_by) {
+            admitted_by->release();
+            admitted_by = nullptr;
+        }
+
+        // The event hub owns the socket now and closes it itself
+        if (socket_adopted) {
+            socket_adopted = false;
+            return ret;
+        }
+
+        httplib::detail::shutdown_socket(sock);
+        httplib::detail::close_socket(sock);
+        return ret;
+    }
+
+public:
+    void enableTls(TlsContext* tls) {
+        tls_ = tls;
+    }
+};
+
+// The event hub writes plaintext to adopted sockets: fine on plain HTTP, and
+// on TLS only when the kernel encrypts what is written to the socket
+bool socketAdoptable() {
+    return current_socket != INVALID_SOCKET && (!current_ssl || TlsContext::kernelSend(current_ssl));
+}
+
+// httplib's thread pool, counting connections waiting for and holding a worker
+class InstrumentedTaskQueue final : public httplib::TaskQueue {
+private:
+    httplib::ThreadPool pool_;
+    std::atomic<size_t>& queued_;
+    std::atomic<size_t>& active_;
+
+public:
+    InstrumentedTaskQueue(size_t threads, std::atomic<size_t>& queued, std::atomic<size_t>& active)
+        : pool_(threads), queued_(queued), active_(active) {}
+
+    bool enqueue(std::function<void()> fn) override {
+        queued_.fetch_add(1, std::memory_order_relaxed);
+        bool accepted = pool_.enqueue([this, fn = std::move(fn)]() {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+            active_.fetch_add(1, std::memory_order_relaxed);
+            fn();
+            active_.fetch_sub(1, std::memory_order_relaxed);
+        });
+        if (!accepted) {
+            queued_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return accepted;
+    }
+
+    void shutdown() override {
+        pool_.shutdown();
+    }
+};
+
+// Serializes into the worker's reusable buffer: a single copy into the body.
+// Handlers only see JsonWriter; the negotiated format decides the encoding.
+template<typename Write>
+void sendJson(httplib::Response& res, int status, Write&& write) {
+    std::string& buffer = JsonWriter::threadBuffer();
+    JsonWriter writer(buffer, response_format);
+    write(writer);
+    res.status = status;
+    res.set_header("Vary", "Accept");
+    res.set_content(buffer, wire::contentType(response_format));
+}
+
+// {"error", "message"} when a detail is given, {"error", "code"} otherwise
+void sendError(httplib::Response& res, int status, std::string_view error, std::string_view message = {}) {
+    sendJson(res, status, [&](JsonWriter& writer) {
+        writer.beginObject().field("error", error);
+        if (message.empty()) {
+            writer.field("code", status);
+        } else {
+            writer.field("message", message);
+        }
+        writer.endObject();
+    });
+}
+
+// Same for every response; written by the header writer instead of being
+// inserted into each response's header map
+constexpr std::string_view CORS_HEADERS =
+    "Access-Control-Allow-Origin: *\r\n"
+    "Access-Control-Allow-Methods: GET, POST, PUT, DELETE, OPTIONS\r\n"
+    "Access-Control-Allow-Headers: Content-Type, Authorization\r\n";
+
+// httplib's default writer builds one string per header and grows the head
+// buffer once per write; this formats the whole head in the request arena
+ssize_t writeResponseHead(httplib::Stream& stream, httplib::Headers& headers) {
+    std::pmr::string head(RequestArena::resource());
+    head.reserve(512);
+    for (const auto& [name, value] : headers) {
+        head.append(name).append(": ").append(value).append("\r\n");
+    }
+    head.append(CORS_HEADERS).append("\r\n");
+    return stream.write(head.data(), head.size());
+}
+
+// Shedding order by path prefix: the first match wins, anything else is NORMAL
+struct RoutePriority {
+    std::string_view prefix;
+    RequestPriority priority;
+};
+
+constexpr RoutePriority ROUTE_PRIORITIES[] = {
+    {"/health", RequestPriority::CRITICAL},
+    {"/metrics", RequestPriority::CRITICAL},
+    {"/admin/", RequestPriority::CRITICAL},
+    {"/api/auth/", RequestPriority::CRITICAL},
+    {"/webhooks/", RequestPriority::BULK},
+    {"/api/export/", RequestPriority::BULK}
+};
+
+RequestPriority requestPriority(const httplib::Request& req) {
+    // CORS preflights are answered without any work
+    if (req.method == "OPTIONS") {
+        return RequestPriority::CRITICAL;
+    }
+    for (const auto& route : ROUTE_PRIORITIES) {
+        if (req.path.starts_with(route.prefix)) {
+            return route.priority;
+        }
+    }
+    return RequestPriority::NORMAL;
+}
+
+// Parses and validates a request body; on failure the 400 response is already set
+bool readJsonBody(const httplib::Request& req, httplib::Response& res, const JsonSchema& schema, JsonReader& reader) {
+    TraceSpan span("json", "parse request");
+
+    std::string_view body = req.body;
+    WireFormat body_format = wire::fromContentType(req.get_header_value("Content-Type"));
+    if (body_format != WireFormat::JSON) {
+        // Binary bodies are transcoded once, so schemas and handlers only deal with JSON
+        thread_local std::string transcoded;
+        transcoded.clear();
+        JsonWriter writer(transcoded);
+        std::string error;
+        if (!wire::transcode(body_format, req.body, writer, error)) {
+            sendError(res, 400, std::string("Invalid ") + wire::formatName(body_format), error);
+            return false;
+        }
+        body = transcoded;
+    }
+
+    if (!reader.parse(body)) {
+        sendError(res, 400, "Invalid JSON", reader.error());
+        return false;
+    }
+
+    std::vector<std::string> errors;
+    if (!schema.validate(reader, errors)) {
+        sendJson(res, 400, [&](JsonWriter& writer) {
+            writer.beginObject().field("error", "Invalid request body");
+            writer.key("details").beginArray();
+            for (const auto& error : errors) {
+                writer.value(error);
+            }
+            writer.endArray().endObject();
+        });
+        return false;
+    }
+
+    return true;
+}
+
+// Request body schemas, per route
+const JsonSchema CREATE_DATA_SCHEMA{
+    {"name", json_types::STRING, true, 256},
+    {"value", json_types::ANY, true}
+};
+
+// "YYYY-MM-DD" <-> days since 1970-01-01
+bool parseDay(const std::string& text, int32_t& day) {
+    int year = 0;
+    unsigned month = 0;
+    unsigned day_of_month = 0;
+    char trailing = 0;
+    if (std::sscanf(text.c_str(), "%4d-%2u-%2u%c", &year, &month, &day_of_month, &trailing) != 3) {
+        return false;
+    }
+    std::chrono::year_month_day date{std::chrono::year(year), std::chrono::month(month), std::chrono::day(day_of_month)};
+    if (!date.ok()) {
+        return false;
+    }
+    day = static_cast<int32_t>(std::chrono::sys_days(date).time_since_epoch().count());
+    return true;
+}
+
+std::string formatDay(int32_t day) {
+    std::chrono::year_month_day date{std::chrono::sys_days(std::chrono::days(day))};
+    char buffer[16];
+    std::snprintf(buffer, sizeof(buffer), "%04d-%02u-%02u", static_cast<int>(date.year()),
+                  static_cast<unsigned>(date.month()), static_cast<unsigned>(date.day()));
+    return buffer;
+}
+
+// Ten years of daily points
+constexpr int32_t MAX_METRICS_DAYS = 3660;
+
+// Served under /static
+const std::string STATIC_ROOT = "./public";
+
+// Large documents go straight to the socket in chunks, never fully buffered
+void streamJson(httplib::Response& res, std::function<void(JsonWriter&)> write, WireFormat format) {
+    res.set_chunked_content_provider(wire::contentType(format),
+        [write = std::move(write), format](size_t, httplib::DataSink& sink) {
+            std::string buffer;
+            buffer.reserve(16 * 1024);
+            JsonWriter writer(buffer, [&sink](const char* data, size_t length) {
+                return sink.write(data, length);
+            }, 16 * 1024, format);
+            write(writer);
+            writer.flush();
+            if (writer.ok()) {
+                sink.done();
+            }
+            return writer.ok();
+        });
+}
+
+const std::string& apiInfoBody(WireFormat format) {
+    // Static document, serialized once per wire format
+    auto build = [](WireFormat format) {
+        struct Endpoint {
+            const char* path;
+            const char* method;
+            const char* description;
+        };
+        const Endpoint endpoints[] = {
+            {"/health", "GET", "Health check"},
+            {"/api/info", "GET", "API information"},
+            {"/metrics", "GET", "Prometheus metrics"},
+            {"/api/data", "GET", "Get data"},
+            {"/api/data", "POST", "Create data"},
+            {"/api/auth/user", "GET", "Current session user"},
+            {"/api/auth/logout", "POST", "Destroy current session"},
+            {"/api/events", "GET", "Live dashboard events (Server-Sent Events)"},
+            {"/api/metrics", "GET", "Daily metrics over a date range (?from&to&granularity=day|week|month)"},
+            {"/api/export/leads", "GET", "All leads, streamed (?format=csv|ndjson, gzip if accepted)"},
+            {"/api/export/activities", "GET", "All activities, streamed (?format=csv|ndjson, gzip if accepted)"},
+            {"/webhooks/:source", "POST", "Platform webhook intake (signed, acknowledged once journaled)"}
+        };
+
+        std::string out;
+        JsonWriter writer(out, format);
+        writer.beginObject()
+            .field("name", "QMARK API")
+            .field("version", "1.0.0")
+            .field("description", "High-performance C++ API server");
+        writer.key("endpoints").beginArray();
+        for (const auto& endpoint : endpoints) {
+            writer.beginObject()
+                .field("path", endpoint.path)
+                .field("method", endpoint.method)
+                .field("description", endpoint.description)
+                .endObject();
+        }
+        writer.endArray().endObject();
+        return out;
+    };
+    static const std::string bodies[] = {
+        build(WireFormat::JSON),
+        build(WireFormat::MSGPACK),
+        build(WireFormat::CBOR)
+    };
+    return bodies[static_cast<size_t>(format)];
+}
+
+} // namespace
+
+HttpServer::HttpServer(const ConcurrencyLimiterConfig& limits)
+    : server_(std::make_unique<StreamingServer>()), queued_connections_(0), active_connections_(0), limiter_(limits),
+      exports_(export_config_.max_per_user, export_config_.max_total) {
+    server_->new_task_queue = [this]() {
+        return new InstrumentedTaskQueue(CPPHTTPLIB_THREAD_POOL_COUNT, queued_connections_, active_connections_);
+    };
+    // Headers and body leave in separate writes: without this, every keep-alive
+    // response after the first waits on the client's delayed ACK (~40 ms)
+    server_->set_tcp_nodelay(true);
+
     setupMiddleware();
+    setupMetrics();
 }
 
 HttpServer::~HttpServer() {
     stop();
+
+    for (const char* gauge : SERVER_GAUGES) {
+        MetricsRegistry::getInstance().removeCallback(gauge);
+    }
 }
 
 void HttpServer::setupMiddleware() {
-    // CORS middleware
-    server_->set_pre_routing_handler([](const httplib::Request& req, httplib::Response& res) {
-        res.set_header("Access-Control-Allow-Origin", "*");
-        res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-        res.set_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    // Response head (CORS headers included) serialized in one piece
+    server_->set_header_writer(writeResponseHead);
+
+    // Per-request state and load shedding
+    server_->set_pre_routing_handler([this](const httplib::Request& req, httplib::Response& res) {
+        request_start = std::chrono::steady_clock::now();
+        response_format = wire::negotiate(req.get_header_value("Accept"));
+        Tracer::getInstance().beginRequest();
+
+        // Load shedding: refused before any parsing, database or session work
+        if (!limiter_.tryAcquire(requestPriority(req))) {
+            res.set_header("Retry-After", std::to_string(limiter_.retryAfter().count()));
+            sendError(res, 503, "Server overloaded", "Too many requests in progress, retry later");
+            return httplib::Server::HandlerResponse::Handled;
+        }
+        admitted_by = &limiter_;
         return httplib::Server::HandlerResponse::Unhandled;
     });
 
-    // Logging middleware
+    // Logging and metrics middleware (runs once the response is written)
     server_->set_logger([](const httplib::Request& req, const httplib::Response& res) {
-        Logger::info("HTTP " + req.method + " " + req.path + " -> " + std::to_string(res.status));
+        uint64_t micros = 0;
+        if (request_start != std::chrono::steady_clock::time_point{}) {
+            micros = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - request_start).count());
+            request_start = {};
+        }
+        if (admitted_by) {
+            admitted_by->release(std::chrono::microseconds(micros));
+            admitted_by = nullptr;
+        }
+        MetricsRegistry::getInstance().recordRequest(req.method, req.matched_route, res.status, micros);
+
+        std::pmr::string trace_name(req.method, RequestArena::resource());
+        trace_name.append(1, ' ').append(req.path);
+        Tracer::getInstance().endRequest(trace_name, res.status);
+
+        QLOG_INFO("HTTP {} {} -> {}", req.method, req.path, res.status);
+
+        // Everything the request took from its arena goes back at once
+        RequestArena::local().reset();
     });
 
-    // Error handler
+    // Error handler: only fills in responses that have no body of their own
     server_->set_error_handler([](const httplib::Request&, httplib::Response& res) {
-        json error_response = {
-            {"error", "Internal Server Error"},
-            {"code", res.status}
-        };
-        res.set_content(error_response.dump(), "application/json");
+        if (!res.body.empty()) {
+            return;
+        }
+        sendError(res, res.status, httplib::status_message(res.status));
     });
 }
 
+void HttpServer::setupMetrics() {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+
+    metrics.registerCallback("qmark_http_active_connections", "Connections currently held by a worker thread.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(get_active_connections()); });
+    metrics.registerCallback("qmark_http_queued_connections", "Accepted connections waiting for a worker thread.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(queued_connections_.load(std::memory_order_relaxed)); });
+    metrics.registerCallback("qmark_sessions_active", "Sessions held by the in-memory session store.",
+        MetricType::GAUGE, []() { return static_cast<double>(SessionStore::getInstance().size()); });
+    metrics.registerCallback("qmark_db_pool_size", "SQLite connections available.",
+        MetricType::GAUGE, []() { return static_cast<double>(DatabaseManager::getInstance().poolSize()); });
+    metrics.registerCallback("qmark_db_connections_in_use", "SQLite connections currently leased.",
+        MetricType::GAUGE, []() { return static_cast<double>(DatabaseManager::getInstance().connectionsInUse()); });
+    metrics.registerCallback("qmark_db_connection_waiters", "Threads waiting for a SQLite connection.",
+        MetricType::GAUGE, []() { return static_cast<double>(DatabaseManager::getInstance().connectionWaiters()); });
+    metrics.registerCallback("qmark_log_dropped_total", "Log records dropped by the overflow policy.",
+        MetricType::COUNTER, []() { return static_cast<double>(Logger::getInstance().getDroppedCount()); });
+    metrics.registerCallback("qmark_http_concurrency_limit", "Adaptive limit on requests in progress.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(limiter_.limit()); });
+    metrics.registerCallback("qmark_http_requests_in_flight", "Admitted requests not yet answered.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(limiter_.inFlight()); });
+    metrics.registerCallback("qmark_http_shed_total", "Requests refused with 503 by the concurrency limiter.",
+        MetricType::COUNTER, [this]() {
+            ConcurrencyLimiter::Stats stats = limiter_.stats();
+            return static_cast<double>(stats.rejected[0] + stats.rejected[1] + stats.rejected[2]);
+        });
+    metrics.registerCallback("qmark_http_exports_active", "Lead and activity exports being streamed.",
+        MetricType::GAUGE, [this]() { return static_cast<double>(exports_.active()); });
+}
+
+bool HttpServer::enableTls(const TlsConfig& config) {
+    auto tls = std::make_unique<TlsContext>();
+    if (!tls->init(config)) {
+        return false;
+    }
+    tls_ = std::move(tls);
+    static_cast<StreamingServer&>(*server_).enableTls(tls_.get());
+
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    metrics.registerCallback("qmark_tls_handshakes_total", "Completed TLS handshakes.",
+        MetricType::COUNTER, [this]() { return static_cast<double>(tls_->stats().handshakes); });
+    metrics.registerCallback("qmark_tls_resumed_total", "TLS handshakes that resumed a session (cache or ticket).",
+        MetricType::COUNTER, [this]() { return static_cast<double>(tls_->stats().resumed); });
+    metrics.registerCallback("qmark_tls_kernel_offload_total", "TLS connections whose records the kernel encrypts (kTLS).",
+        MetricType::COUNTER, [this]() { return static_cast<double>(tls_->stats().kernel_tls); });
+    return true;
+}
+
 void HttpServer::setupRoutes() {
     // Health check
     server_->Get("/health", [](const httplib::Request&, httplib::Response& res) {
-        json response = {
-            {"status", "healthy"},
-            {"service", "qmark-server"},
-            {"version", "1.0.0"},
-            {"timestamp", std::time(nullptr)}
-        };
-        res.set_content(response.dump(), "application/json");
+        sendJson(res, 200, [](JsonWriter& writer) {
+            writer.beginObject()
+                .field("status", "healthy")
+                .field("service", "qmark-server")
+                .field("version", "1.0.0")
+                .field("timestamp", static_cast<int64_t>(std::time(nullptr)))
+                .endObject();
+        });
+    });
+
+    // Prometheus scrape endpoint
+    server_->Get("/metrics", [](const httplib::Request&, httplib::Response& res) {
+        res.set_content(MetricsRegistry::getInstance().renderPrometheus(), "text/plain; version=0.0.4");
+    });
+
+    // Kept request traces as Chrome/Perfetto trace-event JSON (loopback only)
+    server_->Get("/admin/traces", [](const httplib::Request& req, httplib::Response& res) {
+        if (!isLoopback(req)) {
+            sendError(res, 403, "Forbidden");
+            return;
+        }
+
+        try {
+            std::optional<uint64_t> id;
+            if (req.has_param("id")) {
+                id = std::stoull(req.get_param_value("id"));
+            }
+            std::string min_ms = req.get_param_value("min_ms");
+            std::string limit = req.get_param_value("limit");
+
+            auto traces = std::make_shared<std::vector<Tracer::Trace>>(Tracer::getInstance().select(
+                id,
+                std::chrono::milliseconds(min_ms.empty() ? 0 : std::stoll(min_ms)),
+                limit.empty() ? 20 : std::stoul(limit)));
+            // Chrome and Perfetto only read JSON, whatever the client asked for
+            streamJson(res, [traces](JsonWriter& writer) {
+                Tracer::writeChromeTrace(writer, *traces);
+            }, WireFormat::JSON);
+        } catch (const std::exception& e) {
+            sendError(res, 400, "Invalid trace selection", e.what());
+        }
+    });
+
+    // Storage totals, aggregated across shards in parallel
+    server_->Get("/admin/database", [](const httplib::Request& req, httplib::Response& res) {
+        if (!isLoopback(req)) {
+            sendError(res, 403, "Forbidden");
+            return;
+        }
+
+        DatabaseManager& db = DatabaseManager::getInstance();
+        auto started = std::chrono::steady_clock::now();
+        auto users = db.countUsers();
+        auto connections = db.countActiveConnections();
+        auto leads = db.countLeads();
+        if (!users || !connections || !leads) {
+            sendError(res, 500, "Aggregation failed");
+            return;
+        }
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started);
+
+        sendJson(res, 200, [&](JsonWriter& writer) {
+            writer.beginObject()
+                .field("shards", db.shardCount())
+                .field("users", *users)
+                .field("active_connections", *connections)
+                .field("leads", *leads)
+                .field("elapsed_ms", elapsed.count())
+                .endObject();
+        });
     });
 
     // API Info
     server_->Get("/api/info", [](const httplib::Request&, httplib::Response& res) {
-        json response = {
-            {"name", "QMARK API"},
-            {"version", "1.0.0"},
-            {"description", "High-performance C++ API server"},
-            {"endpoints", {
-                {{"path", "/health"}, {"method", "GET"}, {"description", "Health check"}},
-                {{"path", "/api/info"}, {"method", "GET"}, {"description", "API information"}},
-                {{"path", "/api/data"}, {"method", "GET"}, {"description", "Get data"}},
-                {{"path", "/api/data"}, {"method", "POST"}, {"description", "Create data"}}
-            }}
-        };
-        res.set_content(response.dump(), "application/json");
+        res.set_header("Vary", "Accept");
+        res.set_content(apiInfoBody(response_format), wire::contentType(response_format));
     });
 
     // Data endpoints
@@ -78,8 +673,47 @@ void HttpServer::setupRoutes() {
         handlePostData(req, res);
     });
 
-    // Static file serving
-    server_->set_mount_point("/static", "./public");
+    // Session endpoints
+    server_->Get("/api/auth/user", [this](const httplib::Request& req, httplib::Response& res) {
+        handleAuthUser(req, res);
+    });
+
+    server_->Post("/api/auth/logout", [this](const httplib::Request& req, httplib::Response& res) {
+        handleAuthLogout(req, res);
+    });
+
+    // Live dashboard updates, replacing the stats and activities polling
+    server_->Get("/api/events", [this](const httplib::Request& req, httplib::Response& res) {
+        handleEvents(req, res);
+    });
+
+    // Dashboard charts, aggregated from the in-memory columnar store
+    server_->Get("/api/metrics", [this](const httplib::Request& req, httplib::Response& res) {
+        handleMetrics(req, res);
+    });
+
+    // Full exports, streamed page by page at the client's pace
+    server_->Get("/api/export/leads", [this](const httplib::Request& req, httplib::Response& res) {
+        handleExport(req, res, ExportTable::LEADS);
+    });
+
+    server_->Get("/api/export/activities", [this](const httplib::Request& req, httplib::Response& res) {
+        handleExport(req, res, ExportTable::ACTIVITIES);
+    });
+
+    // Platform webhooks: acknowledged once journaled, processed asynchronously
+    server_->Post("/webhooks/:source", [this](const httplib::Request& req, httplib::Response& res) {
+        handleWebhook(req, res);
+    });
+
+    server_->Get("/webhooks/:source", [this](const httplib::Request& req, httplib::Response& res) {
+        handleWebhookChallenge(req, res);
+    });
+
+    // Static file serving, zero-copy where the connection allows it
+    server_->Get(R"(/static(/.*)?)", [](const httplib::Request& req, httplib::Response& res) {
+        handleStatic(req, res);
+    });
 
     // OPTIONS handler for CORS
     server_->Options(".*", [](const httplib::Request&, httplib::Response& res) {
@@ -126,84 +760,463 @@ void HttpServer::waitForStop() {
 }
 
 void HttpServer::handleGetData(const httplib::Request& req, httplib::Response& res) {
+    TraceSpan span("http", "HttpServer::handleGetData");
+
     try {
         // Get query parameters
         std::string limit = req.get_param_value("limit");
         std::string offset = req.get_param_value("offset");
 
-        // Mock data for now
-        json response = {
-            {"data", {
-                {{"id", 1}, {"name", "Sample Data 1"}, {"value", 100}},
-                {{"id", 2}, {"name", "Sample Data 2"}, {"value", 200}},
-                {{"id", 3}, {"name", "Sample Data 3"}, {"value", 300}}
-            }},
-            {"total", 3},
-            {"limit", limit.empty() ? 10 : std::stoi(limit)},
-            {"offset", offset.empty() ? 0 : std::stoi(offset)}
-        };
+        int limit_value = limit.empty() ? 10 : std::stoi(limit);
+        int offset_value = offset.empty() ? 0 : std::stoi(offset);
 
-        res.set_content(response.dump(), "application/json");
+        // Mock data for now
+        TraceSpan build_span("json", "serialize response");
+        sendJson(res, 200, [&](JsonWriter& writer) {
+            writer.beginObject();
+            writer.key("data").beginArray();
+            for (int id = 1; id <= 3; id++) {
+                char name[32];
+                std::snprintf(name, sizeof(name), "Sample Data %d", id);
+                writer.beginObject()
+                    .field("id", id)
+                    .field("name", name)
+                    .field("value", id * 100)
+                    .endObject();
+            }
+            writer.endArray()
+                .field("total", 3)
+                .field("limit", limit_value)
+                .field("offset", offset_value)
+                .endObject();
+        });
         Logger::info("Data retrieved successfully");
 
     } catch (const std::exception& e) {
-        json error = {
-            {"error", "Failed to retrieve data"},
-            {"message", e.what()}
-        };
-        res.status = 500;
-        res.set_content(error.dump(), "application/json");
+        sendError(res, 500, "Failed to retrieve data", e.what());
         Logger::error("Error retrieving data: " + std::string(e.what()));
     }
 }
 
 void HttpServer::handlePostData(const httplib::Request& req, httplib::Response& res) {
+    TraceSpan span("http", "HttpServer::handlePostData");
+
     try {
-        // Parse JSON body
-        json request_data = json::parse(req.body);
-
-        // Validate required fields
-        if (!request_data.contains("name") || !request_data.contains("value")) {
-            json error = {
-                {"error", "Missing required fields"},
-                {"required", {"name", "value"}}
-            };
-            res.status = 400;
-            res.set_content(error.dump(), "application/json");
+        // Validated in place: fields stay views into the request body
+        thread_local JsonReader reader;
+        if (!readJsonBody(req, res, CREATE_DATA_SCHEMA, reader)) {
             return;
         }
 
-        // Mock response
-        json response = {
-            {"id", 4},
-            {"name", request_data["name"]},
-            {"value", request_data["value"]},
-            {"created_at", std::time(nullptr)},
-            {"status", "created"}
-        };
-
-        res.status = 201;
-        res.set_content(response.dump(), "application/json");
+        // Mock response (client values are echoed back as given)
+        sendJson(res, 201, [&](JsonWriter& writer) {
+            writer.beginObject().field("id", 4);
+            writer.key("name").raw(reader.find("name")->raw);
+            writer.key("value").raw(reader.find("value")->raw);
+            writer.field("created_at", static_cast<int64_t>(std::time(nullptr)))
+                .field("status", "created")
+                .endObject();
+        });
         Logger::info("Data created successfully");
 
-    } catch (const json::parse_error& e) {
-        json error = {
-            {"error", "Invalid JSON"},
-            {"message", e.what()}
-        };
-        res.status = 400;
-        res.set_content(error.dump(), "application/json");
-        Logger::error("JSON parse error: " + std::string(e.what()));
-
     } catch (const std::exception& e) {
-        json error = {
-            {"error", "Failed to create data"},
-            {"message", e.what()}
-        };
-        res.status = 500;
-        res.set_content(error.dump(), "application/json");
+        sendError(res, 500, "Failed to create data", e.what());
         Logger::error("Error creating data: " + std::string(e.what()));
     }
 }
 
+std::string HttpServer::extractSessionId(const httplib::Request& req) {
+    std::string auth = req.get_header_value("Authorization");
+    const std::string bearer = "Bearer ";
+    if (auth.compare(0, bearer.size(), bearer) == 0) {
+        return auth.substr(bearer.size());
+    }
+
+    std::string cookies = req.get_header_value("Cookie");
+    const std::string name = "qmark_sid=";
+    size_t pos = cookies.find(name);
+    while (pos != std::string::npos && pos != 0 && cookies[pos - 1] != ' ' && cookies[pos - 1] != ';') {
+        pos = cookies.find(name, pos + 1);
+    }
+    if (pos == std::string::npos) {
+        return "";
+    }
+
+    size_t start = pos + name.size();
+    size_t end = cookies.find(';', start);
+    return cookies.substr(start, end == std::string::npos ? std::string::npos : end - start);
+}
+
+bool HttpServer::isLoopback(const httplib::Request& req) {
+    return req.remote_addr == "127.0.0.1" || req.remote_addr == "::1" ||
+           req.remote_addr.compare(0, 13, "::ffff:127.0.") == 0;
+}
+
+std::optional<SessionStore::Session> HttpServer::currentSession(const httplib::Request& req) {
+    TraceSpan span("session", "HttpServer::currentSession");
+
+    std::string session_id = extractSessionId(req);
+    if (session_id.empty()) {
+        return std::nullopt;
+    }
+
+    return SessionStore::getInstance().find(session_id);
+}
+
+void HttpServer::handleAuthUser(const httplib::Request& req, httplib::Response& res) {
+    auto session = currentSession(req);
+    if (!session) {
+        sendError(res, 401, "Unauthorized");
+        return;
+    }
+
+    sendJson(res, 200, [&](JsonWriter& writer) {
+        writer.beginObject()
+            .field("user_id", session->user_id)
+            .field("expires_at", session->expires_at)
+            .endObject();
+    });
+}
+
+void HttpServer::handleAuthLogout(const httplib::Request& req, httplib::Response& res) {
+    std::string session_id = extractSessionId(req);
+    bool destroyed = !session_id.empty() && SessionStore::getInstance().destroy(session_id);
+
+    res.set_header("Set-Cookie", "qmark_sid=; Path=/; Max-Age=0; HttpOnly; SameSite=Lax");
+    sendJson(res, 200, [&](JsonWriter& writer) {
+        writer.beginObject()
+            .field("status", destroyed ? "logged_out" : "no_session")
+            .endObject();
+    });
+}
+
+void HttpServer::handleEvents(const httplib::Request& req, httplib::Response& res) {
+    auto session = currentSession(req);
+    if (!session) {
+        sendError(res, 401, "Unauthorized");
+        return;
+    }
+
+    EventHub& hub = EventHub::getInstance();
+    if (!hub.isRunning() || hub.isFull() || !socketAdoptable()) {
+        sendError(res, 503, "Event stream unavailable");
+        return;
+    }
+
+    // httplib writes the chunked response head, then the first provider call
+    // hands the socket to the hub and releases this worker thread
+    int64_t user_id = session->user_id;
+    res.set_header("Cache-Control", "no-cache");
+    res.set_header("X-Accel-Buffering", "no");
+    res.set_chunked_content_provider("text/event-stream", [user_id](size_t, httplib::DataSink&) {
+        if (socketAdoptable() && EventHub::getInstance().adopt(current_socket, user_id)) {
+            socket_adopted = true;
+        } else {
+            Logger::warn("SSE subscriber rejected for user " + std::to_string(user_id));
+        }
+        return false;
+    });
+}
+
+void HttpServer::handleStatic(const httplib::Request& req, httplib::Response& res) {
+    std::string sub_path = req.matches[1].length() > 0 ? req.matches[1].str() : "/";
+    if (!httplib::detail::is_valid_path(sub_path)) {
+        sendError(res, 404, "Not found");
+        return;
+    }
+    std::string path = STATIC_ROOT + sub_path;
+    if (path.back() == '/') {
+        path += "index.html";
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat info{};
+    if (fd < 0 || ::fstat(fd, &info) != 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        sendError(res, 404, "Not found");
+        return;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        ::close(fd);
+        res.set_redirect(req.path + "/", 301);
+        return;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        ::close(fd);
+        sendError(res, 404, "Not found");
+        return;
+    }
+
+    // The descriptor lives as long as the provider, ranges included
+    auto file = std::shared_ptr<int>(new int(fd), [](int* descriptor) {
+        ::close(*descriptor);
+        delete descriptor;
+    });
+    res.set_content_provider(
+        static_cast<size_t>(info.st_size),
+        httplib::detail::find_content_type(path, {}, "application/octet-stream"),
+        [file](size_t offset, size_t length, httplib::DataSink& sink) {
+            if (current_stream && current_stream->canSendFile()) {
+                size_t sent = current_stream->sendFile(*file, offset, length);
+                return sent > 0 && sink.write(SENDFILE_PLACEHOLDER, sent);
+            }
+
+            char buffer[64 * 1024];
+            ssize_t got = ::pread(*file, buffer, std::min(length, sizeof(buffer)), static_cast<off_t>(offset));
+            return got > 0 && sink.write(buffer, static_cast<size_t>(got));
+        });
+}
+
+void HttpServer::handleMetrics(const httplib::Request& req, httplib::Response& res) {
+    TraceSpan span("http", "HttpServer::handleMetrics");
+
+    auto session = currentSession(req);
+    if (!session) {
+        sendError(res, 401, "Unauthorized");
+        return;
+    }
+
+    // Defaults to the last 30 days, one point per day
+    int32_t to_day = MetricsStore::today();
+    int32_t from_day = 0;
+    if (req.has_param("to") && !parseDay(req.get_param_value("to"), to_day)) {
+        sendError(res, 400, "Invalid date", "to must be YYYY-MM-DD");
+        return;
+    }
+    if (req.has_param("from")) {
+        if (!parseDay(req.get_param_value("from"), from_day)) {
+            sendError(res, 400, "Invalid date", "from must be YYYY-MM-DD");
+            return;
+        }
+    } else {
+        from_day = to_day - 29;
+    }
+    if (from_day > to_day || to_day - from_day + 1 > MAX_METRICS_DAYS) {
+        sendError(res, 400, "Invalid range", "from must not be after to, and the range is limited to " +
+                  std::to_string(MAX_METRICS_DAYS) + " days");
+        return;
+    }
+
+    std::string granularity_name = req.has_param("granularity") ? req.get_param_value("granularity") : "day";
+    MetricsStore::Granularity granularity;
+    if (granularity_name == "day") {
+        granularity = MetricsStore::Granularity::DAY;
+    } else if (granularity_name == "week") {
+        granularity = MetricsStore::Granularity::WEEK;
+    } else if (granularity_name == "month") {
+        granularity = MetricsStore::Granularity::MONTH;
+    } else {
+        sendError(res, 400, "Invalid granularity", "granularity must be day, week or month");
+        return;
+    }
+
+    MetricsStore& store = MetricsStore::getInstance();
+    MetricsStore::Summary summary = store.summarize(session->user_id, from_day, to_day);
+    std::vector<MetricsStore::Bucket> buckets = store.series(session->user_id, from_day, to_day, granularity);
+
+    auto column = [](JsonWriter& writer, std::string_view name, const MetricsStore::ColumnStats& stats, double scale) {
+        writer.key(name).beginObject()
+            .field("total", static_cast<double>(stats.sum) / scale)
+            .field("min", static_cast<double>(stats.min) / scale)
+            .field("max", static_cast<double>(stats.max) / scale)
+            .endObject();
+    };
+
+    sendJson(res, 200, [&](JsonWriter& writer) {
+        writer.beginObject()
+            .field("from", formatDay(from_day))
+            .field("to", formatDay(to_day))
+            .field("granularity", granularity_name);
+        writer.key("summary").beginObject().field("days", summary.days);
+        column(writer, "leads", summary.leads, 1.0);
+        column(writer, "conversions", summary.conversions, 1.0);
+        column(writer, "automations", summary.automations, 1.0);
+        column(writer, "revenue", summary.revenue_cents, 100.0);
+        writer.field("conversion_rate", summary.conversion_rate).endObject();
+        writer.key("series").beginArray();
+        for (const auto& bucket : buckets) {
+            writer.beginObject()
+                .field("date", formatDay(bucket.start_day))
+                .field("days", bucket.days)
+                .field("leads", bucket.leads)
+                .field("conversions", bucket.conversions)
+                .field("automations", bucket.automations)
+                .field("revenue", static_cast<double>(bucket.revenue_cents) / 100.0)
+                .field("conversion_rate", bucket.conversion_rate)
+                .endObject();
+        }
+        writer.endArray().endObject();
+    });
+}
+
+void HttpServer::handleExport(const httplib::Request& req, httplib::Response& res, ExportTable table) {
+    TraceSpan span("http", "HttpServer::handleExport");
+
+    auto session = currentSession(req);
+    if (!session) {
+        sendError(res, 401, "Unauthorized");
+        return;
+    }
+
+    std::string format_name = req.has_param("format") ? req.get_param_value("format") : "csv";
+    ExportFormat format;
+    if (format_name == "csv") {
+        format = ExportFormat::CSV;
+    } else if (format_name == "ndjson") {
+        format = ExportFormat::NDJSON;
+    } else {
+        sendError(res, 400, "Invalid format", "format must be csv or ndjson");
+        return;
+    }
+
+    auto slot = exports_.tryAcquire(session->user_id);
+    if (!slot) {
+        res.set_header("Retry-After", std::to_string(export_config_.retry_after.count()));
+        sendError(res, 429, "Too many exports", "Wait for the exports in progress to finish");
+        return;
+    }
+
+    bool gzip = wire::acceptsEncoding(req.get_header_value("Accept-Encoding"), "gzip");
+    auto encoder = std::make_shared<ExportEncoder>(format, DatabaseManager::exportColumns(table), gzip,
+                                                   export_config_.gzip_level);
+
+    std::string name = table == ExportTable::LEADS ? "leads" : "activities";
+    res.set_header("Content-Disposition", "attachment; filename=\"" + name +
+                   (format == ExportFormat::CSV ? ".csv\"" : ".ndjson\""));
+    res.set_header("Cache-Control", "no-store");
+    res.set_header("Vary", "Accept-Encoding");
+    if (encoder->gzip()) {
+        res.set_header("Content-Encoding", "gzip");
+    }
+
+    // Only one page of rows is ever held: read under the shard lease, then
+    // written with the lease released. sink.write blocks while the socket is
+    // full, so a slow client slows the reads down instead of growing memory.
+    res.set_chunked_content_provider(format == ExportFormat::CSV ? "text/csv; charset=utf-8" : "application/x-ndjson",
+        [encoder, slot, table, name, user_id = session->user_id, config = export_config_](size_t, httplib::DataSink& sink) {
+            // The download goes at the client's pace and says nothing about
+            // server latency: it leaves the concurrency limiter unmeasured
+            if (admitted_by) {
+                admitted_by->release();
+                admitted_by = nullptr;
+            }
+
+            auto started = std::chrono::steady_clock::now();
+            ExportEncoder::Sink write = [&sink](const char* data, size_t length) {
+                return sink.write(data, length);
+            };
+            DatabaseManager& db = DatabaseManager::getInstance();
+
+            ExportCursor cursor;
+            encoder->header();
+            while (!cursor.done) {
+                bool read = db.exportPage(table, user_id, cursor, config.page_rows,
+                    [&](std::span<const ExportValue> values) {
+                        encoder->row(values);
+                        return encoder->pending() < config.page_bytes;
+                    });
+                if (!read || !encoder->drain(write)) {
+                    Logger::warn("Export of " + name + " for user " + std::to_string(user_id) + " aborted after " +
+                                 std::to_string(encoder->rows()) + " rows");
+                    return false;
+                }
+            }
+            if (!encoder->finish(write)) {
+                return false;
+            }
+            sink.done();
+
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+            Logger::info("Exported " + std::to_string(encoder->rows()) + " " + name + " for user " +
+                         std::to_string(user_id) + " (" + std::to_string(encoder->bytesSent()) + " bytes" +
+                         (encoder->gzip() ? ", gzip" : "") + ") in " + std::to_string(elapsed.count()) + " ms");
+            return true;
+        });
+}
+
+void HttpServer::handleWebhook(const httplib::Request& req, httplib::Response& res) {
+    TraceSpan span("http", "HttpServer::handleWebhook");
+
+    WebhookIngest& ingest = WebhookIngest::getInstance();
+    if (!ingest.isRunning()) {
+        sendError(res, 503, "Webhook intake unavailable");
+        return;
+    }
+
+    const std::string& name = req.path_params.at("source");
+    const WebhookSource* source = ingest.source(name);
+    if (!source) {
+        sendError(res, 404, "Unknown webhook source");
+        return;
+    }
+    if (req.body.size() > ingest.maxBodyBytes()) {
+        sendError(res, 413, "Payload too large");
+        return;
+    }
+
+    // Only verified payloads reach the journal
+    std::string body;
+    if (source->signature == WebhookSignature::SIGNED_REQUEST) {
+        if (!WebhookIngest::decodeSignedRequest(source->secret, req.get_param_value("signed_request"), body)) {
+            sendError(res, 401, "Invalid signature");
+            return;
+        }
+    } else {
+        if (!WebhookIngest::verifyHubSignature(source->secret, req.body, req.get_header_value(source->signature_header))) {
+            sendError(res, 401, "Invalid signature");
+            return;
+        }
+        body = req.body;
+    }
+
+    std::string delivery_id = source->delivery_header.empty() ? "" : req.get_header_value(source->delivery_header);
+    if (delivery_id.empty() || delivery_id.size() > 128) {
+        delivery_id = Encryption::sha256Hex(body);
+    }
+
+    WebhookIngest::Status status = ingest.append(name, delivery_id, std::move(body));
+    if (status == WebhookIngest::Status::FAILED) {
+        sendError(res, 503, "Webhook intake unavailable");
+        return;
+    }
+
+    sendJson(res, 200, [&](JsonWriter& writer) {
+        writer.beginObject();
+        if (!source->status_url.empty()) {
+            // Data deletion callbacks answer with where to follow the request
+            writer.field("url", source->status_url + "?code=" + delivery_id)
+                .field("confirmation_code", delivery_id);
+        } else {
+            writer.field("status", status == WebhookIngest::Status::DUPLICATE ? "duplicate" : "accepted");
+        }
+        writer.endObject();
+    });
+}
+
+void HttpServer::handleWebhookChallenge(const httplib::Request& req, httplib::Response& res) {
+    // Subscription check: echo hub.challenge when the verify token matches
+    const WebhookSource* source = WebhookIngest::getInstance().source(req.path_params.at("source"));
+    if (!source || source->verify_token.empty() || req.get_param_value("hub.mode") != "subscribe" ||
+        !Encryption::constantTimeEquals(req.get_param_value("hub.verify_token"), source->verify_token)) {
+        sendError(res, 403, "Forbidden");
+        return;
+    }
+
+    res.set_content(req.get_param_value("hub.challenge"), "text/plain");
+}
+
+size_t HttpServer::get_active_connections() const {
+    return active_connections_.load(std::memory_order_relaxed);
+}
+
+uint64_t HttpServer::get_requests_count() const {
+    return MetricsRegistry::getInstance().requestsTotal();
+}
+
+std::string HttpServer::generate_session_id() {
+    return SecureRandom::hex(32);
+}
+
 } // namespace QMark
\ No newline at end of file
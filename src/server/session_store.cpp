@@ -0,0 +1,469 @@
+#include "server/session_store.hpp"
+#include "security/random.hpp"
+#include "utils/logger.hpp"
+#include "utils/metrics.hpp"
+#include "utils/snapshot_file.hpp"
+#include <functional>
+
+namespace QMark {
+
+namespace {
+
+// Snapshot body, one record per session up to the end:
+//   string id, i64 user_id, string data, i64 expires_at, i64 persisted_expires_at
+constexpr char SNAPSHOT_KIND[] = "SESS";
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr char SNAPSHOT_NAME[] = "sessions";
+
+} // namespace
+
+SessionStore& SessionStore::getInstance() {
+    static SessionStore instance;
+    return instance;
+}
+
+SessionStore::SessionStore() : size_(0), running_(false) {
+    MetricsRegistry& metrics = MetricsRegistry::getInstance();
+    hit_counter_ = metrics.registerCounter("qmark_session_cache_hits_total", "Session lookups served from memory.");
+    miss_counter_ = metrics.registerCounter("qmark_session_cache_misses_total", "Session lookups for unknown or expired ids.");
+}
+
+SessionStore::~SessionStore() {
+    stop();
+}
+
+int64_t SessionStore::nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+SessionStore::Shard& SessionStore::shardFor(const std::string& session_id) {
+    return *shards_[std::hash<std::string>{}(session_id) % shards_.size()];
+}
+
+bool SessionStore::start(const SessionStoreConfig& config) {
+    if (running_) {
+        return true;
+    }
+
+    config_ = config;
+    if (config_.shard_count == 0) {
+        config_.shard_count = 1;
+    }
+
+    int64_t now = nowSeconds();
+    shards_.clear();
+    for (size_t i = 0; i < config_.shard_count; i++) {
+        auto shard = std::make_unique<Shard>();
+        shard->wheel = TimingWheel<std::string>(static_cast<uint64_t>(now));
+        shards_.push_back(std::move(shard));
+    }
+    size_ = 0;
+
+    auto started = std::chrono::steady_clock::now();
+    bool from_snapshot = loadSnapshot();
+    if (!from_snapshot) {
+        warmLoad();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+
+    running_ = true;
+    flusher_thread_ = std::thread([this]() {
+        flusherLoop();
+    });
+
+    Logger::info("Session store started with " + std::to_string(size_.load()) + " sessions in " +
+                 std::to_string(shards_.size()) + " shards, loaded " +
+                 (from_snapshot ? "from snapshot" : "from SQLite") + " in " + std::to_string(elapsed.count()) + " ms");
+    return true;
+}
+
+void SessionStore::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    pending_cv_.notify_all();
+    if (flusher_thread_.joinable()) {
+        flusher_thread_.join();
+    }
+
+    // Last batch written after the flusher is gone, with a few quick
+    // retries: whatever is still failing after that is lost with the process
+    flushPending();
+    for (int retry = 0; retry < 3 && failed_.size() > 0; retry++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        flushPending();
+    }
+    if (failed_.size() > 0) {
+        Logger::error("Session store stopped with " + std::to_string(failed_.size()) + " unpersisted operations");
+        failed_ = PendingWrites{};
+    }
+    if (!config_.snapshot_path.empty()) {
+        saveSnapshot();
+    }
+    Logger::info("Session store stopped");
+}
+
+bool SessionStore::saveSnapshot() {
+    auto started = std::chrono::steady_clock::now();
+
+    uint64_t token = 0;
+    SecureRandom::fill(reinterpret_cast<unsigned char*>(&token), sizeof(token));
+
+    SnapshotWriter writer(config_.snapshot_path, SNAPSHOT_KIND, SNAPSHOT_VERSION, token);
+    uint64_t written = 0;
+    for (auto& shard_ptr : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard_ptr->mutex);
+        for (const auto& [session_id, entry] : shard_ptr->sessions) {
+            writer.putString(session_id);
+            writer.put(entry.user_id);
+            writer.putString(entry.data);
+            writer.put(entry.expires_at.load(std::memory_order_relaxed));
+            writer.put(entry.persisted_expires_at.load(std::memory_order_relaxed));
+            written++;
+        }
+    }
+
+    // The token goes to the database last: without it the snapshot is never used
+    if (!writer.commit() ||
+        !DatabaseManager::getInstance().saveSnapshotToken(SNAPSHOT_NAME, token)) {
+        Logger::error("Failed to write session snapshot " + config_.snapshot_path);
+        return false;
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+    Logger::info("Session snapshot written: " + std::to_string(written) + " sessions, " +
+                 std::to_string(writer.bytes() / 1024) + " KiB in " + std::to_string(elapsed.count()) + " ms");
+    return true;
+}
+
+bool SessionStore::loadSnapshot() {
+    if (config_.snapshot_path.empty()) {
+        return false;
+    }
+
+    // Taken even when unused, so a later crash cannot revive this snapshot
+    std::optional<uint64_t> token = DatabaseManager::getInstance().takeSnapshotToken(SNAPSHOT_NAME);
+
+    SnapshotReader reader;
+    if (!reader.open(config_.snapshot_path, SNAPSHOT_KIND, SNAPSHOT_VERSION)) {
+        return false;
+    }
+    if (!token || *token != reader.info().token) {
+        // Written before a run that did not stop cleanly, or for another database
+        Logger::warn("Ignoring stale session snapshot " + config_.snapshot_path);
+        return false;
+    }
+
+    int64_t now = nowSeconds();
+    bool ok = true;
+    std::vector<std::string> expired;
+    while (ok && reader.remaining() > 0) {
+        std::string session_id;
+        int64_t user_id = 0;
+        std::string data;
+        int64_t expires_at = 0;
+        int64_t persisted_expires_at = 0;
+        ok = reader.getString(session_id) && reader.get(user_id) && reader.getString(data) &&
+             reader.get(expires_at) && reader.get(persisted_expires_at);
+        if (!ok) {
+            break;
+        }
+
+        // Expired while the server was down: dropped here, deleted by the flusher
+        if (expires_at <= now) {
+            expired.push_back(std::move(session_id));
+            continue;
+        }
+
+        Shard& shard = shardFor(session_id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto [it, inserted] = shard.sessions.try_emplace(std::move(session_id), user_id, std::move(data), expires_at);
+        if (inserted) {
+            it->second.persisted_expires_at.store(persisted_expires_at, std::memory_order_relaxed);
+            shard.wheel.schedule(it->first, static_cast<uint64_t>(expires_at));
+            size_++;
+        }
+    }
+
+    if (!ok) {
+        Logger::warn("Truncated session snapshot: " + config_.snapshot_path);
+        for (auto& shard_ptr : shards_) {
+            std::unique_lock<std::shared_mutex> lock(shard_ptr->mutex);
+            shard_ptr->sessions.clear();
+            shard_ptr->wheel = TimingWheel<std::string>(static_cast<uint64_t>(now));
+        }
+        size_ = 0;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    for (auto& session_id : expired) {
+        pending_.deletes.push_back(std::move(session_id));
+    }
+    return true;
+}
+
+void SessionStore::warmLoad() {
+    auto& db = DatabaseManager::getInstance();
+    int64_t now = nowSeconds();
+
+    db.purgeExpiredSessions(now);
+
+    for (auto& record : db.loadSessions(now)) {
+        Shard& shard = shardFor(record.id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+        auto [it, inserted] = shard.sessions.try_emplace(record.id, record.user_id,
+                                                         std::move(record.data), record.expires_at);
+        if (inserted) {
+            shard.wheel.schedule(it->first, static_cast<uint64_t>(record.expires_at));
+            size_++;
+        }
+    }
+}
+
+std::string SessionStore::create(int64_t user_id, const std::string& data) {
+    std::string session_id = SecureRandom::hex(32);
+    int64_t expires_at = nowSeconds() + config_.ttl.count();
+
+    {
+        Shard& shard = shardFor(session_id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.sessions.try_emplace(session_id, user_id, data, expires_at);
+        shard.wheel.schedule(session_id, static_cast<uint64_t>(expires_at));
+    }
+    size_++;
+
+    enqueueUpsert(SessionRecord{session_id, user_id, data, expires_at});
+    return session_id;
+}
+
+std::optional<SessionStore::Session> SessionStore::find(const std::string& session_id) {
+    if (shards_.empty()) {
+        return std::nullopt;
+    }
+
+    int64_t now = nowSeconds();
+    int64_t extended = now + config_.ttl.count();
+    bool persist = false;
+    Session session;
+
+    {
+        Shard& shard = shardFor(session_id);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+
+        auto it = shard.sessions.find(session_id);
+        if (it == shard.sessions.end()) {
+            MetricsRegistry::getInstance().increment(miss_counter_);
+            return std::nullopt;
+        }
+
+        Entry& entry = it->second;
+        int64_t expires_at = entry.expires_at.load(std::memory_order_relaxed);
+        if (expires_at <= now) {
+            MetricsRegistry::getInstance().increment(miss_counter_);
+            return std::nullopt;
+        }
+        MetricsRegistry::getInstance().increment(hit_counter_);
+
+        // Sliding expiration: memory only, the wheel re-arms lazily on fire
+        if (extended > expires_at) {
+            entry.expires_at.store(extended, std::memory_order_relaxed);
+            expires_at = extended;
+
+            int64_t persisted = entry.persisted_expires_at.load(std::memory_order_relaxed);
+            if (extended - persisted >= config_.persist_slack.count()) {
+                persist = entry.persisted_expires_at.compare_exchange_strong(persisted, extended);
+            }
+        }
+
+        session.id = session_id;
+        session.user_id = entry.user_id;
+        session.data = entry.data;
+        session.expires_at = expires_at;
+    }
+
+    if (persist) {
+        enqueueExpiry(session_id, session.expires_at);
+    }
+
+    return session;
+}
+
+bool SessionStore::update(const std::string& session_id, const std::string& data) {
+    if (shards_.empty()) {
+        return false;
+    }
+
+    SessionRecord record;
+    {
+        Shard& shard = shardFor(session_id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+        auto it = shard.sessions.find(session_id);
+        if (it == shard.sessions.end()) {
+            return false;
+        }
+
+        Entry& entry = it->second;
+        entry.data = data;
+
+        int64_t expires_at = entry.expires_at.load(std::memory_order_relaxed);
+        entry.persisted_expires_at.store(expires_at, std::memory_order_relaxed);
+        record = SessionRecord{session_id, entry.user_id, data, expires_at};
+    }
+
+    enqueueUpsert(std::move(record));
+    return true;
+}
+
+bool SessionStore::destroy(const std::string& session_id) {
+    if (shards_.empty()) {
+        return false;
+    }
+
+    {
+        Shard& shard = shardFor(session_id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+        // The wheel entry becomes stale and is skipped when it fires
+        if (shard.sessions.erase(session_id) == 0) {
+            return false;
+        }
+    }
+    size_--;
+
+    enqueueDelete(session_id);
+    return true;
+}
+
+size_t SessionStore::size() const {
+    return size_.load(std::memory_order_relaxed);
+}
+
+void SessionStore::expireDue(int64_t now) {
+    std::vector<std::string> expired;
+
+    for (auto& shard_ptr : shards_) {
+        Shard& shard = *shard_ptr;
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+
+        shard.wheel.advance(static_cast<uint64_t>(now), [&](std::string&& session_id) {
+            auto it = shard.sessions.find(session_id);
+            if (it == shard.sessions.end()) {
+                return;
+            }
+
+            int64_t expires_at = it->second.expires_at.load(std::memory_order_relaxed);
+            if (expires_at > now) {
+                // Extended by a touch since it was scheduled
+                shard.wheel.schedule(std::move(session_id), static_cast<uint64_t>(expires_at));
+                return;
+            }
+
+            shard.sessions.erase(it);
+            expired.push_back(std::move(session_id));
+        });
+    }
+
+    if (!expired.empty()) {
+        size_ -= expired.size();
+
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        for (auto& session_id : expired) {
+            pending_.deletes.push_back(std::move(session_id));
+        }
+    }
+}
+
+void SessionStore::enqueueUpsert(SessionRecord record) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_.upserts.push_back(std::move(record));
+    if (pending_.size() >= config_.flush_batch_size) {
+        pending_cv_.notify_one();
+    }
+}
+
+void SessionStore::enqueueExpiry(const std::string& session_id, int64_t expires_at) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_.expiries.emplace_back(session_id, expires_at);
+    if (pending_.size() >= config_.flush_batch_size) {
+        pending_cv_.notify_one();
+    }
+}
+
+void SessionStore::enqueueDelete(const std::string& session_id) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_.deletes.push_back(session_id);
+    if (pending_.size() >= config_.flush_batch_size) {
+        pending_cv_.notify_one();
+    }
+}
+
+void SessionStore::flushPending() {
+    PendingWrites batch;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        std::swap(batch, pending_);
+    }
+
+    // A failed batch goes first so its operations keep their order
+    // relative to what was queued since
+    if (failed_.size() > 0) {
+        auto prepend = [](auto& older, auto& newer) {
+            older.insert(older.end(), std::make_move_iterator(newer.begin()), std::make_move_iterator(newer.end()));
+            newer = std::move(older);
+            older.clear();
+        };
+        prepend(failed_.upserts, batch.upserts);
+        prepend(failed_.expiries, batch.expiries);
+        prepend(failed_.deletes, batch.deletes);
+    }
+
+    if (batch.size() == 0) {
+        return;
+    }
+
+    // Order matters: a session created and destroyed in the same batch
+    // must end up deleted. Every statement is idempotent, so a batch that
+    // failed halfway can be replayed whole.
+    auto& db = DatabaseManager::getInstance();
+    bool ok = db.saveSessions(batch.upserts) &&
+              db.updateSessionExpiry(batch.expiries) &&
+              db.deleteSessions(batch.deletes);
+
+    if (ok) {
+        failed_attempts_ = 0;
+        return;
+    }
+
+    failed_attempts_++;
+    if (failed_attempts_ >= config_.flush_max_attempts) {
+        Logger::error("Dropping session batch of " + std::to_string(batch.size()) + " operations after " +
+                      std::to_string(failed_attempts_) + " failed attempts");
+        failed_attempts_ = 0;
+        return;
+    }
+
+    Logger::warn("Failed to persist session batch of " + std::to_string(batch.size()) +
+                 " operations, retrying (attempt " + std::to_string(failed_attempts_) + ")");
+    failed_ = std::move(batch);
+}
+
+void SessionStore::flusherLoop() {
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(pending_mutex_);
+            pending_cv_.wait_for(lock, config_.flush_interval, [this]() {
+                return !running_ || pending_.size() >= config_.flush_batch_size;
+            });
+        }
+
+        expireDue(nowSeconds());
+        flushPending();
+    }
+}
+
+} // namespace QMark
@@ -0,0 +1,348 @@
+#include "server/tls_context.hpp"
+#include "utils/logger.hpp"
+#include <openssl/core_names.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/ocsp.h>
+#include <openssl/params.h>
+#include <openssl/rand.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace QMark {
+
+namespace {
+
+std::string lastSslError() {
+    unsigned long code = ERR_get_error();
+    if (code == 0) {
+        return "unknown error";
+    }
+    char buffer[256];
+    ERR_error_string_n(code, buffer, sizeof(buffer));
+    ERR_clear_error();
+    return buffer;
+}
+
+bool setMacKey(EVP_MAC_CTX* mac, const std::array<unsigned char, 32>& key) {
+    OSSL_PARAM params[] = {
+        OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, const_cast<unsigned char*>(key.data()), key.size()),
+        OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, const_cast<char*>("SHA256"), 0),
+        OSSL_PARAM_construct_end()
+    };
+    return EVP_MAC_CTX_set_params(mac, params) == 1;
+}
+
+std::time_t asn1ToTime(const ASN1_GENERALIZEDTIME* time) {
+    std::tm parts{};
+    if (!time || ASN1_TIME_to_tm(time, &parts) != 1) {
+        return 0;
+    }
+    return timegm(&parts);
+}
+
+// Empty when the response says GOOD for the context's leaf certificate, is
+// signed by its issuer (or a responder the issuer delegated to) and is
+// current; otherwise why it must not be stapled. A stale file left over from
+// a certificate rollover fails the CertID match.
+std::string checkOcspResponse(SSL_CTX* ctx, OCSP_RESPONSE* response, std::time_t& next_update) {
+    if (OCSP_response_status(response) != OCSP_RESPONSE_STATUS_SUCCESSFUL) {
+        return "responder status is not successful";
+    }
+
+    X509* leaf = SSL_CTX_get0_certificate(ctx);
+    STACK_OF(X509)* chain = nullptr;
+    SSL_CTX_get0_chain_certs(ctx, &chain);
+    X509* issuer = nullptr;
+    for (int i = 0; leaf && i < sk_X509_num(chain); i++) {
+        X509* candidate = sk_X509_value(chain, i);
+        if (X509_check_issued(candidate, leaf) == X509_V_OK) {
+            issuer = candidate;
+            break;
+        }
+    }
+    if (!issuer) {
+        return "the certificate chain does not contain the issuer of the leaf certificate";
+    }
+
+    OCSP_BASICRESP* basic = OCSP_response_get1_basic(response);
+    if (!basic) {
+        return "not a basic OCSP response";
+    }
+
+    // Responders echo the hash algorithm of the request's CertID: build ours with the same one
+    const EVP_MD* digest = EVP_sha1();
+    if (OCSP_SINGLERESP* single = OCSP_resp_get0(basic, 0)) {
+        ASN1_OBJECT* digest_oid = nullptr;
+        OCSP_id_get0_info(nullptr, &digest_oid, nullptr, nullptr, const_cast<OCSP_CERTID*>(OCSP_SINGLERESP_get0_id(single)));
+        if (const EVP_MD* echoed = digest_oid ? EVP_get_digestbyobj(digest_oid) : nullptr) {
+            digest = echoed;
+        }
+    }
+
+    std::string problem;
+    OCSP_CERTID* id = OCSP_cert_to_id(digest, leaf, issuer);
+    X509_STORE* store = X509_STORE_new();
+    int status = -1;
+    int reason = 0;
+    ASN1_GENERALIZEDTIME* this_update = nullptr;
+    ASN1_GENERALIZEDTIME* next = nullptr;
+
+    if (!id || !store) {
+        problem = "out of memory";
+    } else if (X509_STORE_add_cert(store, issuer) != 1 ||
+               X509_STORE_set_flags(store, X509_V_FLAG_PARTIAL_CHAIN) != 1 ||
+               OCSP_basic_verify(basic, chain, store, 0) != 1) {
+        // The issuer is the trust anchor: no need for the root to be on disk
+        problem = "signature does not verify against the certificate issuer (" + lastSslError() + ")";
+    } else if (OCSP_resp_find_status(basic, id, &status, &reason, nullptr, &this_update, &next) != 1) {
+        problem = "no status for the loaded certificate";
+    } else if (status != V_OCSP_CERTSTATUS_GOOD) {
+        problem = std::string("certificate status is ") + OCSP_cert_status_str(status);
+    } else if (OCSP_check_validity(this_update, next, 300, -1) != 1) {
+        problem = "response is not yet valid or has expired";
+    } else {
+        next_update = asn1ToTime(next);
+    }
+
+    ERR_clear_error();
+    X509_STORE_free(store);
+    OCSP_CERTID_free(id);
+    OCSP_BASICRESP_free(basic);
+    return problem;
+}
+
+} // namespace
+
+TlsContext::TlsContext() : handshakes_(0), resumed_(0), kernel_tls_(0) {}
+
+TlsContext::~TlsContext() {
+    SSL_CTX_free(ctx_);
+}
+
+bool TlsContext::init(const TlsConfig& config) {
+    config_ = config;
+
+    ctx_ = SSL_CTX_new(TLS_server_method());
+    if (!ctx_) {
+        Logger::error("Failed to create TLS context: " + lastSslError());
+        return false;
+    }
+    SSL_CTX_set_app_data(ctx_, this);
+    SSL_CTX_set_min_proto_version(ctx_, TLS1_2_VERSION);
+
+    uint64_t options = SSL_OP_NO_COMPRESSION | SSL_OP_NO_SESSION_RESUMPTION_ON_RENEGOTIATION | SSL_OP_NO_RENEGOTIATION;
+#ifndef OPENSSL_NO_KTLS
+    if (config_.kernel_tls) {
+        options |= SSL_OP_ENABLE_KTLS;
+    }
+#else
+    if (config_.kernel_tls) {
+        Logger::warn("Kernel TLS requested but this OpenSSL build has no kTLS support, encrypting in user space");
+        config_.kernel_tls = false;
+    }
+#endif
+    SSL_CTX_set_options(ctx_, options);
+
+    if (SSL_CTX_use_certificate_chain_file(ctx_, config_.cert_path.c_str()) != 1 ||
+        SSL_CTX_use_PrivateKey_file(ctx_, config_.key_path.c_str(), SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(ctx_) != 1) {
+        Logger::error("Failed to load TLS certificate " + config_.cert_path + " / key " + config_.key_path +
+                      ": " + lastSslError());
+        return false;
+    }
+
+    // TLS 1.2 resumption by session id: one cache for every connection of the process
+    static const unsigned char SESSION_CONTEXT[] = "qmark";
+    SSL_CTX_set_session_id_context(ctx_, SESSION_CONTEXT, sizeof(SESSION_CONTEXT) - 1);
+    SSL_CTX_set_session_cache_mode(ctx_, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_sess_set_cache_size(ctx_, static_cast<long>(config_.session_cache_size));
+    SSL_CTX_set_timeout(ctx_, static_cast<long>(config_.session_timeout.count()));
+
+    // Tickets (TLS 1.2 and 1.3) under keys we rotate instead of OpenSSL's fixed per-context key
+    if (!rotateTicketKey(false)) {
+        Logger::error("Failed to generate a session ticket key: " + lastSslError());
+        return false;
+    }
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx_, ticketKeyCallback);
+
+    if (!config_.ocsp_response_path.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(ocsp_mutex_);
+            reloadOcspResponse(true);
+        }
+        SSL_CTX_set_tlsext_status_cb(ctx_, ocspStatusCallback);
+        SSL_CTX_set_tlsext_status_arg(ctx_, this);
+    }
+
+    Logger::info("TLS enabled with " + config_.cert_path + (config_.kernel_tls ? " (kernel TLS requested)" : "") +
+                 (ocsp_response_ ? ", stapling " + config_.ocsp_response_path : ""));
+    return true;
+}
+
+bool TlsContext::ticketKeyDue() const {
+    return std::chrono::steady_clock::now() - ticket_keys_[0].created >= config_.ticket_key_rotation;
+}
+
+bool TlsContext::rotateTicketKey(bool only_if_due) {
+    TicketKey key;
+    if (RAND_bytes(key.name.data(), static_cast<int>(key.name.size())) != 1 ||
+        RAND_bytes(key.aes_key.data(), static_cast<int>(key.aes_key.size())) != 1 ||
+        RAND_bytes(key.hmac_key.data(), static_cast<int>(key.hmac_key.size())) != 1) {
+        return false;
+    }
+    key.created = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::shared_mutex> lock(ticket_mutex_);
+    // Another handshake may have rotated since we looked: rotating again would
+    // push the key every outstanding ticket uses out of [1]
+    if (only_if_due && !ticketKeyDue()) {
+        return true;
+    }
+    ticket_keys_[1] = ticket_keys_[0];
+    ticket_keys_[0] = key;
+    ticket_key_count_ = std::min<size_t>(ticket_key_count_ + 1, ticket_keys_.size());
+    return true;
+}
+
+int TlsContext::ticketKeyCallback(SSL* ssl, unsigned char* key_name, unsigned char* iv,
+                                  EVP_CIPHER_CTX* cipher, EVP_MAC_CTX* mac, int encrypt) {
+    auto* self = static_cast<TlsContext*>(SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl)));
+
+    if (encrypt) {
+        bool due;
+        {
+            std::shared_lock<std::shared_mutex> lock(self->ticket_mutex_);
+            due = self->ticketKeyDue();
+        }
+        if (due) {
+            self->rotateTicketKey(true);
+        }
+
+        std::shared_lock<std::shared_mutex> lock(self->ticket_mutex_);
+        const TicketKey& key = self->ticket_keys_[0];
+        if (RAND_bytes(iv, EVP_CIPHER_get_iv_length(EVP_aes_256_cbc())) != 1 ||
+            EVP_EncryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.aes_key.data(), iv) != 1 ||
+            !setMacKey(mac, key.hmac_key)) {
+            return -1;
+        }
+        std::memcpy(key_name, key.name.data(), key.name.size());
+        return 1;
+    }
+
+    std::shared_lock<std::shared_mutex> lock(self->ticket_mutex_);
+    for (size_t i = 0; i < self->ticket_key_count_; i++) {
+        const TicketKey& key = self->ticket_keys_[i];
+        if (std::memcmp(key_name, key.name.data(), key.name.size()) != 0) {
+            continue;
+        }
+        if (EVP_DecryptInit_ex(cipher, EVP_aes_256_cbc(), nullptr, key.aes_key.data(), iv) != 1 ||
+            !setMacKey(mac, key.hmac_key)) {
+            return -1;
+        }
+        // Under the previous key: resume, and hand out a ticket under the current one
+        return i == 0 ? 1 : 2;
+    }
+    // Unknown or expired key: full handshake
+    return 0;
+}
+
+void TlsContext::reloadOcspResponse(bool force) {
+    ocsp_checked_ = std::chrono::steady_clock::now();
+
+    struct stat info{};
+    if (::stat(config_.ocsp_response_path.c_str(), &info) != 0) {
+        if (force) {
+            Logger::warn("OCSP response " + config_.ocsp_response_path + " not found, stapling disabled until it appears");
+        }
+        return;
+    }
+    if (!force && info.st_mtime == ocsp_mtime_) {
+        return;
+    }
+    ocsp_mtime_ = info.st_mtime;
+
+    std::ifstream file(config_.ocsp_response_path, std::ios::binary);
+    std::string der((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // Only a response that vouches for our own certificate is ever stapled
+    const unsigned char* cursor = reinterpret_cast<const unsigned char*>(der.data());
+    OCSP_RESPONSE* response = d2i_OCSP_RESPONSE(nullptr, &cursor, static_cast<long>(der.size()));
+    if (!response) {
+        Logger::warn("Ignoring unparseable OCSP response in " + config_.ocsp_response_path);
+        return;
+    }
+    std::time_t next_update = 0;
+    std::string problem = checkOcspResponse(ctx_, response, next_update);
+    OCSP_RESPONSE_free(response);
+    if (!problem.empty()) {
+        Logger::warn("Ignoring OCSP response in " + config_.ocsp_response_path + ": " + problem);
+        return;
+    }
+
+    ocsp_response_ = std::make_shared<const std::string>(std::move(der));
+    ocsp_next_update_ = next_update;
+    Logger::info("Loaded OCSP response " + config_.ocsp_response_path);
+}
+
+std::shared_ptr<const std::string> TlsContext::ocspResponse() {
+    std::lock_guard<std::mutex> lock(ocsp_mutex_);
+    if (std::chrono::steady_clock::now() - ocsp_checked_ >= config_.ocsp_check_interval) {
+        reloadOcspResponse(false);
+    }
+    // A stale response would make strict clients fail the handshake: better none
+    if (ocsp_next_update_ != 0 && std::time(nullptr) > ocsp_next_update_) {
+        return nullptr;
+    }
+    return ocsp_response_;
+}
+
+int TlsContext::ocspStatusCallback(SSL* ssl, void* arg) {
+    auto response = static_cast<TlsContext*>(arg)->ocspResponse();
+    if (!response) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+
+    // OpenSSL takes ownership of the copy
+    auto* copy = static_cast<unsigned char*>(OPENSSL_malloc(response->size()));
+    if (!copy) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+    std::memcpy(copy, response->data(), response->size());
+    SSL_set_tlsext_status_ocsp_resp(ssl, copy, static_cast<long>(response->size()));
+    return SSL_TLSEXT_ERR_OK;
+}
+
+bool TlsContext::kernelSend(SSL* ssl) {
+#ifndef OPENSSL_NO_KTLS
+    return BIO_get_ktls_send(SSL_get_wbio(ssl)) > 0;
+#else
+    (void)ssl;
+    return false;
+#endif
+}
+
+void TlsContext::onHandshake(SSL* ssl) {
+    handshakes_.fetch_add(1, std::memory_order_relaxed);
+    if (SSL_session_reused(ssl)) {
+        resumed_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (kernelSend(ssl)) {
+        kernel_tls_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+TlsContext::Stats TlsContext::stats() const {
+    Stats stats;
+    stats.handshakes = handshakes_.load(std::memory_order_relaxed);
+    stats.resumed = resumed_.load(std::memory_order_relaxed);
+    stats.kernel_tls = kernel_tls_.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(ocsp_mutex_);
+    stats.ocsp_loaded = ocsp_response_ != nullptr;
+    return stats;
+}
+
+} // namespace QMark
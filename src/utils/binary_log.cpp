@@ -0,0 +1,332 @@
+#include "utils/binary_log.hpp"
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <thread>
+
+namespace QMark {
+
+namespace binlog {
+
+namespace {
+
+std::mutex site_mutex;
+std::atomic<uint32_t> next_site_id{1};
+std::atomic<uint32_t> next_thread_id{1};
+
+template<typename T>
+void append(std::vector<uint8_t>& out, const T& value) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void appendString16(std::vector<uint8_t>& out, const char* text) {
+    size_t length = std::min<size_t>(std::strlen(text), UINT16_MAX);
+    append(out, static_cast<uint16_t>(length));
+    out.insert(out.end(), text, text + length);
+}
+
+// Marks the buffer retired when its thread exits; the writer frees it once drained
+struct ThreadBufferHolder {
+    std::shared_ptr<ThreadBuffer> buffer;
+
+    ThreadBufferHolder() : buffer(std::make_shared<ThreadBuffer>()) {
+        buffer->thread_id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+        BinaryLog::getInstance().addThread(buffer);
+    }
+
+    ~ThreadBufferHolder() {
+        buffer->retired.store(true, std::memory_order_release);
+    }
+};
+
+} // namespace
+
+ThreadBuffer& threadBuffer() {
+    thread_local ThreadBufferHolder holder;
+    return *holder.buffer;
+}
+
+uint32_t registerSite(Site& site, const uint8_t* types, size_t count) {
+    std::lock_guard<std::mutex> lock(site_mutex);
+
+    uint32_t id = site.id.load(std::memory_order_relaxed);
+    if (id != 0) {
+        return id;
+    }
+
+    id = next_site_id.fetch_add(1, std::memory_order_relaxed);
+    BinaryLog::getInstance().addSite(id, site, types, count);
+    site.id.store(id, std::memory_order_release);
+    return id;
+}
+
+} // namespace binlog
+
+struct BinaryLog::State {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<binlog::ThreadBuffer>> buffers;
+    std::vector<uint8_t> all_sites;
+    std::vector<uint8_t> pending_sites;
+
+    std::string path;
+    BinaryLogOptions options;
+    LogArchiver archiver;
+    double tsc_ticks_per_ns = 1.0;
+
+    std::FILE* file = nullptr;
+    uint64_t file_bytes = 0;
+    std::chrono::system_clock::time_point next_rotation;
+    std::vector<uint8_t> batch;
+    std::thread worker;
+    std::atomic<bool> stop{false};
+    std::chrono::steady_clock::time_point last_sync;
+};
+
+BinaryLog& BinaryLog::getInstance() {
+    static BinaryLog instance;
+    return instance;
+}
+
+BinaryLog::BinaryLog() : state_(std::make_unique<State>()), open_(false), min_level_(LogLevel::INFO) {}
+
+BinaryLog::~BinaryLog() {
+    close();
+}
+
+void BinaryLog::addSite(uint32_t id, const binlog::Site& site, const uint8_t* types, size_t count) {
+    std::vector<uint8_t> record;
+    record.push_back(binlog::RECORD_SITE);
+    binlog::append(record, id);
+    record.push_back(static_cast<uint8_t>(site.level));
+    binlog::append(record, site.line);
+    binlog::appendString16(record, site.file);
+    binlog::appendString16(record, site.format);
+    record.push_back(static_cast<uint8_t>(count));
+    record.insert(record.end(), types, types + count);
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->all_sites.insert(state_->all_sites.end(), record.begin(), record.end());
+    state_->pending_sites.insert(state_->pending_sites.end(), record.begin(), record.end());
+}
+
+void BinaryLog::addThread(const std::shared_ptr<binlog::ThreadBuffer>& buffer) {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->buffers.push_back(buffer);
+}
+
+bool BinaryLog::open(const std::string& path, const BinaryLogOptions& options) {
+    if (open_) {
+        close();
+    }
+
+    std::filesystem::path log_path(path);
+    if (log_path.has_parent_path()) {
+        std::filesystem::create_directories(log_path.parent_path());
+    }
+
+    // TSC calibration against the steady clock, reused by every segment of this run
+    auto steady_start = std::chrono::steady_clock::now();
+    uint64_t tsc_start = binlog::readTsc();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    auto steady_end = std::chrono::steady_clock::now();
+    uint64_t tsc_end = binlog::readTsc();
+
+    double elapsed_ns = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(steady_end - steady_start).count());
+
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->path = path;
+        state_->options = options;
+        state_->tsc_ticks_per_ns = elapsed_ns > 0 ? static_cast<double>(tsc_end - tsc_start) / elapsed_ns : 1.0;
+        state_->archiver.configure(path, options.retention);
+
+        // The previous run's log is what a post-mortem needs: keep it as a segment
+        if (!retireActiveFile() || !openSegment()) {
+            return false;
+        }
+    }
+
+    state_->stop = false;
+    state_->last_sync = std::chrono::steady_clock::now();
+    state_->worker = std::thread([this]() {
+        workerLoop();
+    });
+    open_ = true;
+
+    Logger::info("Binary log opened: " + path);
+    return true;
+}
+
+bool BinaryLog::retireActiveFile() {
+    std::error_code ec;
+    if (std::filesystem::file_size(state_->path, ec) == 0 || ec) {
+        return true;
+    }
+
+    std::string segment = LogArchiver::segmentPath(state_->path);
+    std::filesystem::rename(state_->path, segment, ec);
+    if (ec) {
+        // Opening over it would destroy it
+        Logger::error("Failed to retire binary log " + state_->path + ": " + ec.message());
+        return false;
+    }
+    state_->archiver.submit(segment);
+    return true;
+}
+
+bool BinaryLog::openSegment() {
+    std::FILE* file = std::fopen(state_->path.c_str(), "wb");
+    if (!file) {
+        Logger::error("Failed to open binary log: " + state_->path);
+        return false;
+    }
+    std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+    binlog::FileHeader header{};
+    std::memcpy(header.magic, binlog::FILE_MAGIC, sizeof(header.magic));
+    header.version = binlog::FILE_VERSION;
+    header.tsc_ticks_per_ns = state_->tsc_ticks_per_ns;
+    header.anchor_tsc = binlog::readTsc();
+    header.anchor_unix_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::fwrite(&header, sizeof(header), 1, file);
+
+    // Every segment decodes on its own: it starts with all sites registered so far
+    std::fwrite(state_->all_sites.data(), 1, state_->all_sites.size(), file);
+    state_->pending_sites.clear();
+
+    state_->file = file;
+    state_->file_bytes = 0;
+    if (state_->options.rotate_interval.count() > 0) {
+        state_->next_rotation = LogArchiver::nextBoundary(std::chrono::system_clock::now(),
+                                                          state_->options.rotate_interval);
+    }
+    return true;
+}
+
+void BinaryLog::close() {
+    if (!open_.exchange(false)) {
+        return;
+    }
+
+    state_->stop = true;
+    if (state_->worker.joinable()) {
+        state_->worker.join();
+    }
+
+    drainOnce();
+
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (state_->file) {
+            std::fclose(state_->file);
+            state_->file = nullptr;
+        }
+    }
+    state_->archiver.stop();
+}
+
+bool BinaryLog::drainOnce() {
+    std::vector<std::shared_ptr<binlog::ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        buffers = state_->buffers;
+    }
+
+    // Snapshot write positions before collecting sites: any event inside the
+    // snapshot was pushed after its site was registered
+    std::vector<size_t> limits;
+    limits.reserve(buffers.size());
+    for (const auto& buffer : buffers) {
+        limits.push_back(buffer->write_pos.load(std::memory_order_acquire));
+    }
+
+    std::vector<uint8_t>& batch = state_->batch;
+    batch.clear();
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        batch.swap(state_->pending_sites);
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (now - state_->last_sync >= std::chrono::seconds(1)) {
+        batch.push_back(binlog::RECORD_SYNC);
+        binlog::append(batch, binlog::readTsc());
+        binlog::append(batch, static_cast<int64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count()));
+        state_->last_sync = now;
+    }
+
+    bool wrote_events = false;
+    for (size_t i = 0; i < buffers.size(); i++) {
+        binlog::ThreadBuffer& buffer = *buffers[i];
+        size_t read = buffer.read_pos.load(std::memory_order_relaxed);
+        size_t limit = limits[i];
+
+        if (limit != read) {
+            size_t length = limit - read;
+            size_t offset = read & (binlog::ThreadBuffer::CAPACITY - 1);
+            size_t first = std::min(length, binlog::ThreadBuffer::CAPACITY - offset);
+            batch.insert(batch.end(), buffer.data.get() + offset, buffer.data.get() + offset + first);
+            batch.insert(batch.end(), buffer.data.get(), buffer.data.get() + (length - first));
+            buffer.read_pos.store(limit, std::memory_order_release);
+            wrote_events = true;
+        }
+
+        uint64_t dropped = buffer.dropped.load(std::memory_order_relaxed);
+        if (dropped != buffer.reported_dropped) {
+            batch.push_back(binlog::RECORD_DROPPED);
+            binlog::append(batch, buffer.thread_id);
+            binlog::append(batch, dropped - buffer.reported_dropped);
+            buffer.reported_dropped = dropped;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->file && !batch.empty()) {
+        const BinaryLogOptions& options = state_->options;
+        bool full = options.max_file_bytes > 0 && state_->file_bytes > 0 &&
+                    state_->file_bytes + batch.size() > options.max_file_bytes;
+        bool due = options.rotate_interval.count() > 0 && std::chrono::system_clock::now() >= state_->next_rotation;
+        if (full || due) {
+            // Records already in the batch (sites included) simply follow the new header
+            std::fclose(state_->file);
+            state_->file = nullptr;
+            if (!retireActiveFile()) {
+                // Keep appending to the current segment and retry at the next threshold
+                state_->file = std::fopen(state_->path.c_str(), "ab");
+                state_->file_bytes = 0;
+                state_->next_rotation = LogArchiver::nextBoundary(std::chrono::system_clock::now(),
+                                                                  std::max(options.rotate_interval, std::chrono::seconds(60)));
+            } else {
+                openSegment();
+            }
+        }
+    }
+    if (state_->file && !batch.empty()) {
+        std::fwrite(batch.data(), 1, batch.size(), state_->file);
+        std::fflush(state_->file);
+        state_->file_bytes += batch.size();
+    }
+
+    // Buffers of exited threads are released once fully drained
+    std::erase_if(state_->buffers, [](const std::shared_ptr<binlog::ThreadBuffer>& buffer) {
+        return buffer->retired.load(std::memory_order_acquire) &&
+               buffer->read_pos.load(std::memory_order_relaxed) ==
+               buffer->write_pos.load(std::memory_order_acquire);
+    });
+
+    return wrote_events;
+}
+
+void BinaryLog::workerLoop() {
+    while (!state_->stop.load(std::memory_order_acquire)) {
+        if (!drainOnce()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+    }
+}
+
+} // namespace QMark
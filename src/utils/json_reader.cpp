@@ -0,0 +1,800 @@
+#include "utils/json_reader.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace QMark {
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 64;
+
+struct BlockMasks {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t structural;    // { } [ ] : ,
+    uint64_t control;       // bytes < 0x20
+    uint64_t non_ascii;
+};
+
+#if defined(__AVX2__)
+
+inline uint64_t combine(__m256i lo, __m256i hi) {
+    return static_cast<uint32_t>(_mm256_movemask_epi8(lo)) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(hi))) << 32);
+}
+
+inline BlockMasks scanBlock(const uint8_t* block) {
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+
+    auto equals = [&](char c) {
+        __m256i needle = _mm256_set1_epi8(c);
+        return combine(_mm256_cmpeq_epi8(lo, needle), _mm256_cmpeq_epi8(hi, needle));
+    };
+
+    // x <= 0x1F  <=>  max(x, 0x1F) == 0x1F (unsigned)
+    __m256i limit = _mm256_set1_epi8(0x1F);
+    uint64_t control = combine(_mm256_cmpeq_epi8(_mm256_max_epu8(lo, limit), limit),
+                               _mm256_cmpeq_epi8(_mm256_max_epu8(hi, limit), limit));
+
+    return BlockMasks{
+        equals('"'),
+        equals('\\'),
+        equals('{') | equals('}') | equals('[') | equals(']') | equals(':') | equals(','),
+        control,
+        combine(lo, hi)
+    };
+}
+
+// Keiser & Lemire lookup validation: each byte is classified by its own high
+// nibble and both nibbles of the byte before it; continuation bytes owed by
+// 3- and 4-byte sequences are checked against the bytes two and three back
+constexpr uint8_t TOO_SHORT = 1 << 0;
+constexpr uint8_t TOO_LONG = 1 << 1;
+constexpr uint8_t OVERLONG_3 = 1 << 2;
+constexpr uint8_t TOO_LARGE = 1 << 3;
+constexpr uint8_t SURROGATE = 1 << 4;
+constexpr uint8_t OVERLONG_2 = 1 << 5;
+constexpr uint8_t TWO_CONTS = 1 << 7;
+constexpr uint8_t TOO_LARGE_1000 = 1 << 6;
+constexpr uint8_t OVERLONG_4 = 1 << 6;
+constexpr uint8_t CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+inline __m256i table16(uint8_t b0, uint8_t b1, uint8_t b2, uint8_t b3, uint8_t b4, uint8_t b5, uint8_t b6, uint8_t b7,
+                       uint8_t b8, uint8_t b9, uint8_t b10, uint8_t b11, uint8_t b12, uint8_t b13, uint8_t b14,
+                       uint8_t b15) {
+    return _mm256_setr_epi8(static_cast<char>(b0), static_cast<char>(b1), static_cast<char>(b2),
+                            static_cast<char>(b3), static_cast<char>(b4), static_cast<char>(b5),
+                            static_cast<char>(b6), static_cast<char>(b7), static_cast<char>(b8),
+                            static_cast<char>(b9), static_cast<char>(b10), static_cast<char>(b11),
+                            static_cast<char>(b12), static_cast<char>(b13), static_cast<char>(b14),
+                            static_cast<char>(b15), static_cast<char>(b0), static_cast<char>(b1),
+                            static_cast<char>(b2), static_cast<char>(b3), static_cast<char>(b4),
+                            static_cast<char>(b5), static_cast<char>(b6), static_cast<char>(b7),
+                            static_cast<char>(b8), static_cast<char>(b9), static_cast<char>(b10),
+                            static_cast<char>(b11), static_cast<char>(b12), static_cast<char>(b13),
+                            static_cast<char>(b14), static_cast<char>(b15));
+}
+
+// The 32 bytes ending N bytes before the end of `input`, taking the head from `previous`
+template<int N>
+inline __m256i shiftIn(__m256i input, __m256i previous) {
+    return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(previous, input, 0x21), 16 - N);
+}
+
+inline __m256i highNibbles(__m256i bytes) {
+    return _mm256_and_si256(_mm256_srli_epi16(bytes, 4), _mm256_set1_epi8(0x0F));
+}
+
+class Utf8Checker {
+private:
+    __m256i error_ = _mm256_setzero_si256();
+    __m256i previous_ = _mm256_setzero_si256();
+    __m256i incomplete_ = _mm256_setzero_si256();
+
+    void checkLane(__m256i input, __m256i previous) {
+        const __m256i byte_1_high = table16(
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            TOO_SHORT | OVERLONG_2,
+            TOO_SHORT,
+            TOO_SHORT | OVERLONG_3 | SURROGATE,
+            TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4);
+        const __m256i byte_1_low = table16(
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+            CARRY | OVERLONG_2,
+            CARRY,
+            CARRY,
+            CARRY | TOO_LARGE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000);
+        const __m256i byte_2_high = table16(
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT);
+
+        __m256i prev1 = shiftIn<1>(input, previous);
+        __m256i special = _mm256_and_si256(
+            _mm256_and_si256(_mm256_shuffle_epi8(byte_1_high, highNibbles(prev1)),
+                             _mm256_shuffle_epi8(byte_1_low, _mm256_and_si256(prev1, _mm256_set1_epi8(0x0F)))),
+            _mm256_shuffle_epi8(byte_2_high, highNibbles(input)));
+
+        // Bytes that must be continuations: third byte after an E_ lead, fourth after an F_ lead
+        __m256i third = _mm256_subs_epu8(shiftIn<2>(input, previous), _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+        __m256i fourth = _mm256_subs_epu8(shiftIn<3>(input, previous), _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+        __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+
+        error_ = _mm256_or_si256(error_, _mm256_xor_si256(must_continue, special));
+    }
+
+public:
+    void checkBlock(const uint8_t* block, bool ascii) {
+        __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + 32));
+
+        if (ascii) {
+            // A sequence cut by the previous block's end is never completed by ASCII
+            error_ = _mm256_or_si256(error_, incomplete_);
+        } else {
+            checkLane(lo, previous_);
+            checkLane(hi, lo);
+
+            // Leads in the last three bytes still owed continuation bytes
+            const __m256i max_complete = _mm256_setr_epi8(
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                static_cast<char>(0xF0 - 1), static_cast<char>(0xE0 - 1), static_cast<char>(0xC0 - 1));
+            incomplete_ = _mm256_subs_epu8(hi, max_complete);
+        }
+        previous_ = hi;
+    }
+
+    bool valid() const {
+        __m256i error = _mm256_or_si256(error_, incomplete_);
+        return _mm256_testz_si256(error, error) != 0;
+    }
+};
+
+#elif defined(__SSE2__)
+
+inline BlockMasks scanBlock(const uint8_t* block) {
+    __m128i chunks[4];
+    for (size_t i = 0; i < 4; i++) {
+        chunks[i] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i * 16));
+    }
+
+    auto collect = [&](auto&& predicate) {
+        uint64_t mask = 0;
+        for (size_t i = 0; i < 4; i++) {
+            mask |= static_cast<uint64_t>(static_cast<uint16_t>(_mm_movemask_epi8(predicate(chunks[i])))) << (i * 16);
+        }
+        return mask;
+    };
+    auto equals = [&](char c) {
+        __m128i needle = _mm_set1_epi8(c);
+        return collect([&](__m128i chunk) { return _mm_cmpeq_epi8(chunk, needle); });
+    };
+
+    __m128i limit = _mm_set1_epi8(0x1F);
+    return BlockMasks{
+        equals('"'),
+        equals('\\'),
+        equals('{') | equals('}') | equals('[') | equals(']') | equals(':') | equals(','),
+        collect([&](__m128i chunk) { return _mm_cmpeq_epi8(_mm_max_epu8(chunk, limit), limit); }),
+        collect([](__m128i chunk) { return chunk; })
+    };
+}
+
+#else
+
+inline BlockMasks scanBlock(const uint8_t* block) {
+    BlockMasks masks{};
+    for (size_t i = 0; i < BLOCK_SIZE; i++) {
+        uint64_t bit = uint64_t(1) << i;
+        uint8_t c = block[i];
+        if (c == '"') masks.quote |= bit;
+        if (c == '\\') masks.backslash |= bit;
+        if (c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',') masks.structural |= bit;
+        if (c < 0x20) masks.control |= bit;
+        if (c >= 0x80) masks.non_ascii |= bit;
+    }
+    return masks;
+}
+
+#endif
+
+// Bit i set when an odd number of quotes precede or sit at position i
+inline uint64_t prefixXor(uint64_t bits) {
+#if defined(__PCLMUL__)
+    __m128i product = _mm_clmulepi64_si128(_mm_set_epi64x(0, static_cast<int64_t>(bits)), _mm_set1_epi8(-1), 0);
+    return static_cast<uint64_t>(_mm_cvtsi128_si64(product));
+#else
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+#endif
+}
+
+// Characters preceded by an odd-length run of backslashes (simdjson's carry trick)
+inline uint64_t findEscaped(uint64_t backslash, uint64_t& prev_escaped) {
+    constexpr uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+    backslash &= ~prev_escaped;
+    uint64_t follows_escape = (backslash << 1) | prev_escaped;
+    uint64_t odd_sequence_starts = backslash & ~EVEN_BITS & ~follows_escape;
+
+    unsigned long long sequences_starting_on_even_bits;
+    prev_escaped = __builtin_uaddll_overflow(odd_sequence_starts, backslash, &sequences_starting_on_even_bits);
+    uint64_t invert_mask = static_cast<uint64_t>(sequences_starting_on_even_bits) << 1;
+    return (EVEN_BITS ^ invert_mask) & follows_escape;
+}
+
+inline bool isHex(uint8_t c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// Scalar UTF-8 validation from the first non-ASCII byte, 8 ASCII bytes at a time
+bool validateUtf8(const uint8_t* data, size_t size, size_t& error_position) {
+    size_t i = 0;
+    while (i < size) {
+        if (i + 8 <= size) {
+            uint64_t word;
+            std::memcpy(&word, data + i, 8);
+            if ((word & 0x8080808080808080ULL) == 0) {
+                i += 8;
+                continue;
+            }
+        }
+
+        uint8_t lead = data[i];
+        if (lead < 0x80) {
+            i++;
+            continue;
+        }
+
+        size_t length;
+        uint32_t code;
+        if ((lead & 0xE0) == 0xC0) {
+            length = 2;
+            code = lead & 0x1F;
+        } else if ((lead & 0xF0) == 0xE0) {
+            length = 3;
+            code = lead & 0x0F;
+        } else if ((lead & 0xF8) == 0xF0) {
+            length = 4;
+            code = lead & 0x07;
+        } else {
+            error_position = i;
+            return false;
+        }
+
+        if (i + length > size) {
+            error_position = i;
+            return false;
+        }
+        for (size_t j = 1; j < length; j++) {
+            if ((data[i + j] & 0xC0) != 0x80) {
+                error_position = i;
+                return false;
+            }
+            code = (code << 6) | (data[i + j] & 0x3F);
+        }
+
+        static const uint32_t MIN_CODE[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (code < MIN_CODE[length] || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+            error_position = i;
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+// JSON number grammar; sets is_integer when there is no fraction or exponent
+bool scanNumber(std::string_view text, bool& is_integer) {
+    size_t i = 0;
+    size_t n = text.size();
+    is_integer = true;
+
+    if (i < n && text[i] == '-') {
+        i++;
+    }
+    if (i >= n) {
+        return false;
+    }
+    if (text[i] == '0') {
+        i++;
+    } else if (text[i] >= '1' && text[i] <= '9') {
+        while (i < n && text[i] >= '0' && text[i] <= '9') {
+            i++;
+        }
+    } else {
+        return false;
+    }
+
+    if (i < n && text[i] == '.') {
+        is_integer = false;
+        i++;
+        size_t digits = i;
+        while (i < n && text[i] >= '0' && text[i] <= '9') {
+            i++;
+        }
+        if (i == digits) {
+            return false;
+        }
+    }
+
+    if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+        is_integer = false;
+        i++;
+        if (i < n && (text[i] == '+' || text[i] == '-')) {
+            i++;
+        }
+        size_t digits = i;
+        while (i < n && text[i] >= '0' && text[i] <= '9') {
+            i++;
+        }
+        if (i == digits) {
+            return false;
+        }
+    }
+
+    return i == n;
+}
+
+void appendUtf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+uint32_t parseHex4(std::string_view text) {
+    uint32_t value = 0;
+    std::from_chars(text.data(), text.data() + 4, value, 16);
+    return value;
+}
+
+} // namespace
+
+const char* jsonTypeName(JsonType type) {
+    switch (type) {
+        case JsonType::NULL_VALUE: return "null";
+        case JsonType::BOOLEAN: return "boolean";
+        case JsonType::INTEGER: return "integer";
+        case JsonType::NUMBER: return "number";
+        case JsonType::STRING: return "string";
+        case JsonType::ARRAY: return "array";
+        case JsonType::OBJECT: return "object";
+        default: return "unknown";
+    }
+}
+
+bool JsonReader::indexStructurals(std::string_view input, std::vector<uint32_t>& out, size_t& count,
+                                  std::string& error) {
+    count = 0;
+    if (input.size() >= UINT32_MAX - BLOCK_SIZE) {
+        error = "document too large";
+        return false;
+    }
+
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(input.data());
+    size_t size = input.size();
+    uint64_t prev_escaped = 0;
+    uint64_t prev_in_string = 0;
+    size_t first_non_ascii = size;
+#if defined(__AVX2__)
+    Utf8Checker utf8;
+#endif
+
+    for (size_t offset = 0; offset < size; offset += BLOCK_SIZE) {
+        const uint8_t* block = data + offset;
+        uint8_t tail[BLOCK_SIZE];
+        if (size - offset < BLOCK_SIZE) {
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, block, size - offset);
+            block = tail;
+        }
+
+        BlockMasks masks = scanBlock(block);
+        uint64_t escaped = findEscaped(masks.backslash, prev_escaped);
+        uint64_t quotes = masks.quote & ~escaped;
+        uint64_t in_string = prefixXor(quotes) ^ prev_in_string;
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+
+        if (uint64_t bad = masks.control & in_string) {
+            error = "control character in string at offset " + std::to_string(offset + __builtin_ctzll(bad));
+            return false;
+        }
+
+        // Escapes are rare: check their targets one by one
+        for (uint64_t targets = escaped & in_string; targets != 0; targets &= targets - 1) {
+            size_t position = offset + __builtin_ctzll(targets);
+            uint8_t c = position < size ? data[position] : 0;
+            bool valid = c == '"' || c == '\\' || c == '/' || c == 'b' || c == 'f' ||
+                         c == 'n' || c == 'r' || c == 't';
+            if (c == 'u') {
+                valid = position + 4 < size && isHex(data[position + 1]) && isHex(data[position + 2]) &&
+                        isHex(data[position + 3]) && isHex(data[position + 4]);
+            }
+            if (!valid) {
+                error = "invalid escape sequence at offset " + std::to_string(position - 1);
+                return false;
+            }
+        }
+
+        if (masks.non_ascii != 0 && first_non_ascii == size) {
+            first_non_ascii = offset + __builtin_ctzll(masks.non_ascii);
+        }
+#if defined(__AVX2__)
+        utf8.checkBlock(block, masks.non_ascii == 0);
+#endif
+
+        // Grow-only scratch: a block adds at most 64 entries, written in whole
+        // batches without a branch per bit (past `found`, the slots are junk
+        // that the next block overwrites)
+        if (out.size() < count + BLOCK_SIZE) {
+            out.resize(std::max(out.size() * 2, count + 2 * BLOCK_SIZE + (size - offset) / 4));
+        }
+        uint64_t structural = (masks.structural & ~in_string) | quotes;
+        size_t found = static_cast<size_t>(std::popcount(structural));
+        uint32_t* slot = out.data() + count;
+        uint32_t base = static_cast<uint32_t>(offset);
+#if defined(__AVX512F__)
+        // 16 positions per compress, stored whole; the next store overwrites the unused tail
+        const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+        for (unsigned part = 0; part < 4; part++) {
+            __mmask16 bits = static_cast<__mmask16>(structural >> (16 * part));
+            __m512i positions = _mm512_add_epi32(lanes, _mm512_set1_epi32(static_cast<int>(base + 16 * part)));
+            _mm512_storeu_si512(slot, _mm512_maskz_compress_epi32(bits, positions));
+            slot += std::popcount(static_cast<unsigned>(bits));
+        }
+#else
+        for (size_t i = 0; i < found; i += 8) {
+            for (size_t j = 0; j < 8; j++) {
+                slot[i + j] = base + static_cast<uint32_t>(std::countr_zero(structural));
+                structural &= structural - 1;
+            }
+        }
+#endif
+        count += found;
+    }
+
+    if (prev_in_string) {
+        error = "unterminated string";
+        return false;
+    }
+
+    if (first_non_ascii < size) {
+#if defined(__AVX2__)
+        bool utf8_valid = utf8.valid();
+#else
+        bool utf8_valid = false;
+#endif
+        // The vector check only says whether the input is valid; the scalar
+        // one runs on failure (or without AVX2) to locate the offending byte
+        size_t error_position = 0;
+        if (!utf8_valid && !validateUtf8(data + first_non_ascii, size - first_non_ascii, error_position)) {
+            error = "invalid UTF-8 at offset " + std::to_string(first_non_ascii + error_position);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool JsonReader::fail(const std::string& message, size_t position) {
+    error_ = message + " at offset " + std::to_string(position);
+    return false;
+}
+
+bool JsonReader::parse(std::string_view input) {
+    input_ = input;
+    fields_.clear();
+    root_ = Value{};
+    error_.clear();
+
+    if (!indexStructurals(input, structurals_, structural_count_, error_)) {
+        return false;
+    }
+    if (closes_.size() < structural_count_) {
+        closes_.resize(structural_count_);
+    }
+
+    size_t cursor = 0;
+    if (!validateDocument(cursor)) {
+        return false;
+    }
+
+    cursor = skipWhitespace(cursor);
+    if (cursor != input_.size()) {
+        return fail("trailing characters", cursor);
+    }
+    return true;
+}
+
+bool JsonReader::validateDocument(size_t& cursor) {
+    // Iterative over the structural index: cursor and k stay in registers and
+    // there is one call frame however deep the document is
+    struct Frame {
+        uint32_t open_index;
+        bool is_object;
+    };
+    std::array<Frame, MAX_DEPTH + 1> frames;
+    size_t depth = 0;
+
+    const uint32_t* structurals = structurals_.data();
+    size_t count = structural_count_;
+    size_t size = input_.size();
+    size_t k = 0;
+    bool expect_key = false;
+    std::string_view field_key;
+    cursor = 0;
+
+    for (;;) {
+        if (expect_key) {
+            if (cursor >= size || input_[cursor] != '"' || k + 1 >= count) {
+                return fail("expected string key", cursor);
+            }
+            size_t key_close = structurals[k + 1];
+            if (depth == 1) {
+                field_key = view(cursor + 1, key_close);
+            }
+            k += 2;
+
+            cursor = skipWhitespace(key_close + 1);
+            if (cursor >= size || input_[cursor] != ':') {
+                return fail("expected ':'", cursor);
+            }
+            k++;
+            cursor++;
+            expect_key = false;
+        }
+
+        if (depth > MAX_DEPTH) {
+            return fail("nesting too deep", cursor);
+        }
+        cursor = skipWhitespace(cursor);
+        if (cursor >= size) {
+            return fail("unexpected end of input", cursor);
+        }
+
+        Value value;
+        char c = input_[cursor];
+
+        if (c == '{' || c == '[') {
+            if (k >= count || structurals[k] != cursor) {
+                return fail("malformed document", cursor);
+            }
+            bool is_object = c == '{';
+            uint32_t open_index = static_cast<uint32_t>(k);
+            size_t start = cursor;
+
+            k++;
+            cursor = skipWhitespace(cursor + 1);
+            if (cursor >= size || input_[cursor] != (is_object ? '}' : ']')) {
+                frames[depth++] = Frame{open_index, is_object};
+                expect_key = is_object;
+                continue;
+            }
+
+            k++;
+            cursor++;
+            closes_[open_index] = open_index + 1;
+            value = Value{is_object ? JsonType::OBJECT : JsonType::ARRAY, view(start, cursor), open_index};
+        } else if (c == '"') {
+            if (k + 1 >= count || structurals[k] != cursor) {
+                return fail("malformed string", cursor);
+            }
+            size_t close = structurals[k + 1];
+            k += 2;
+            value = Value{JsonType::STRING, view(cursor, close + 1), 0};
+            cursor = close + 1;
+        } else {
+            // Scalars run up to the next structural character
+            size_t stop = k < count ? structurals[k] : size;
+            while (stop > cursor && isWhitespace(input_[stop - 1])) {
+                stop--;
+            }
+            std::string_view text = view(cursor, stop);
+
+            bool is_integer = false;
+            if (text == "true" || text == "false") {
+                value = Value{JsonType::BOOLEAN, text, 0};
+            } else if (text == "null") {
+                value = Value{JsonType::NULL_VALUE, text, 0};
+            } else if (scanNumber(text, is_integer)) {
+                value = Value{is_integer ? JsonType::INTEGER : JsonType::NUMBER, text, 0};
+            } else {
+                return fail("invalid value", cursor);
+            }
+            cursor = stop;
+        }
+
+        // A complete value: hand it to its container, closing as many as it completes
+        for (;;) {
+            if (depth == 0) {
+                root_ = value;
+                return true;
+            }
+
+            const Frame& frame = frames[depth - 1];
+            if (depth == 1 && frame.is_object) {
+                fields_.push_back(Member{field_key, value});
+            }
+
+            cursor = skipWhitespace(cursor);
+            if (cursor < size && input_[cursor] == ',') {
+                k++;
+                cursor = skipWhitespace(cursor + 1);
+                expect_key = frame.is_object;
+                break;
+            }
+            if (cursor < size && input_[cursor] == (frame.is_object ? '}' : ']')) {
+                k++;
+                cursor++;
+                closes_[frame.open_index] = static_cast<uint32_t>(k - 1);
+                value = Value{frame.is_object ? JsonType::OBJECT : JsonType::ARRAY,
+                              view(structurals[frame.open_index], cursor), frame.open_index};
+                depth--;
+                continue;
+            }
+            return fail(frame.is_object ? "expected ',' or '}'" : "expected ',' or ']'", cursor);
+        }
+    }
+}
+
+const JsonReader::Value* JsonReader::find(std::string_view key) const {
+    // Last occurrence wins, as with the DOM parser
+    for (auto it = fields_.rbegin(); it != fields_.rend(); ++it) {
+        if (keyEquals(it->key, key)) {
+            return &it->value;
+        }
+    }
+    return nullptr;
+}
+
+size_t JsonReader::elementCount(const Value& array) const {
+    size_t count = 0;
+    forEachElement(array, [&](const Value&) { count++; });
+    return count;
+}
+
+bool JsonReader::getString(const Value& value, std::string& out) {
+    if (value.type != JsonType::STRING) {
+        return false;
+    }
+    out.clear();
+    unescape(value.raw.substr(1, value.raw.size() - 2), out);
+    return true;
+}
+
+bool JsonReader::getInt64(const Value& value, int64_t& out) {
+    if (value.type != JsonType::INTEGER) {
+        return false;
+    }
+    auto result = std::from_chars(value.raw.data(), value.raw.data() + value.raw.size(), out);
+    return result.ec == std::errc();
+}
+
+bool JsonReader::getDouble(const Value& value, double& out) {
+    if (value.type != JsonType::INTEGER && value.type != JsonType::NUMBER) {
+        return false;
+    }
+    auto result = std::from_chars(value.raw.data(), value.raw.data() + value.raw.size(), out);
+    return result.ec == std::errc();
+}
+
+bool JsonReader::getBool(const Value& value, bool& out) {
+    if (value.type != JsonType::BOOLEAN) {
+        return false;
+    }
+    out = value.raw == "true";
+    return true;
+}
+
+void JsonReader::unescape(std::string_view content, std::string& out) {
+    out.reserve(out.size() + content.size());
+
+    size_t i = 0;
+    while (i < content.size()) {
+        size_t backslash = content.find('\\', i);
+        if (backslash == std::string_view::npos) {
+            out.append(content.substr(i));
+            return;
+        }
+        out.append(content.substr(i, backslash - i));
+
+        char c = content[backslash + 1];
+        i = backslash + 2;
+        switch (c) {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u': {
+                uint32_t code = parseHex4(content.substr(i, 4));
+                i += 4;
+                if (code >= 0xD800 && code <= 0xDBFF && i + 6 <= content.size() &&
+                    content[i] == '\\' && content[i + 1] == 'u') {
+                    uint32_t low = parseHex4(content.substr(i + 2, 4));
+                    if (low >= 0xDC00 && low <= 0xDFFF) {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    }
+                }
+                // Lone surrogates cannot be encoded in UTF-8
+                if (code >= 0xD800 && code <= 0xDFFF) {
+                    code = 0xFFFD;
+                }
+                appendUtf8(out, code);
+                break;
+            }
+            default: out += c; break;      // " \ /
+        }
+    }
+}
+
+size_t JsonReader::codePointCount(const Value& string_value) {
+    std::string_view content = string_value.raw.substr(1, string_value.raw.size() - 2);
+
+    std::string decoded;
+    if (content.find('\\') != std::string_view::npos) {
+        unescape(content, decoded);
+        content = decoded;
+    }
+
+    size_t count = 0;
+    for (char c : content) {
+        if ((static_cast<uint8_t>(c) & 0xC0) != 0x80) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool JsonReader::keyEquals(std::string_view raw_key, std::string_view key) {
+    if (raw_key.find('\\') == std::string_view::npos) {
+        return raw_key == key;
+    }
+    std::string decoded;
+    unescape(raw_key, decoded);
+    return decoded == key;
+}
+
+} // namespace QMark
@@ -0,0 +1,85 @@
+#include "utils/json_schema.hpp"
+
+namespace QMark {
+
+namespace {
+
+std::string describeTypes(uint32_t types) {
+    static const JsonType ALL[] = {
+        JsonType::STRING, JsonType::INTEGER, JsonType::NUMBER, JsonType::BOOLEAN,
+        JsonType::ARRAY, JsonType::OBJECT, JsonType::NULL_VALUE
+    };
+
+    if ((types & json_types::NUMBER) == json_types::NUMBER) {
+        types &= ~json_types::INTEGER;
+    }
+
+    std::string out;
+    for (JsonType type : ALL) {
+        if (types & static_cast<uint32_t>(type)) {
+            if (!out.empty()) {
+                out += " or ";
+            }
+            out += jsonTypeName(type);
+        }
+    }
+    return out;
+}
+
+} // namespace
+
+JsonSchema::JsonSchema(std::initializer_list<JsonFieldRule> rules, bool allow_unknown_fields)
+    : rules_(rules), allow_unknown_fields_(allow_unknown_fields) {}
+
+bool JsonSchema::validate(const JsonReader& reader, std::vector<std::string>& errors) const {
+    errors.clear();
+
+    if (reader.root().type != JsonType::OBJECT) {
+        errors.push_back(std::string("body: expected object, got ") + jsonTypeName(reader.root().type));
+        return false;
+    }
+
+    for (const auto& rule : rules_) {
+        const JsonReader::Value* value = reader.find(rule.name);
+        if (!value) {
+            if (rule.required) {
+                errors.push_back(rule.name + ": required");
+            }
+            continue;
+        }
+
+        if ((rule.types & static_cast<uint32_t>(value->type)) == 0) {
+            errors.push_back(rule.name + ": expected " + describeTypes(rule.types) +
+                             ", got " + jsonTypeName(value->type));
+            continue;
+        }
+
+        if (rule.max_length == 0) {
+            continue;
+        }
+        if (value->type == JsonType::STRING && JsonReader::codePointCount(*value) > rule.max_length) {
+            errors.push_back(rule.name + ": longer than " + std::to_string(rule.max_length) + " characters");
+        } else if (value->type == JsonType::ARRAY && reader.elementCount(*value) > rule.max_length) {
+            errors.push_back(rule.name + ": more than " + std::to_string(rule.max_length) + " elements");
+        }
+    }
+
+    if (!allow_unknown_fields_) {
+        for (const auto& member : reader.fields()) {
+            bool known = false;
+            for (const auto& rule : rules_) {
+                if (JsonReader::keyEquals(member.key, rule.name)) {
+                    known = true;
+                    break;
+                }
+            }
+            if (!known) {
+                errors.push_back(std::string(member.key) + ": unknown field");
+            }
+        }
+    }
+
+    return errors.empty();
+}
+
+} // namespace QMark
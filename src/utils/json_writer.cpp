@@ -0,0 +1,423 @@
+#include "utils/json_writer.hpp"
+#include "utils/json_reader.hpp"
+#include <cstring>
+
+namespace QMark {
+
+namespace {
+
+constexpr size_t THREAD_BUFFER_RESERVE = 4 * 1024;
+constexpr size_t THREAD_BUFFER_MAX_RETAINED = 1024 * 1024;
+
+// 0 = copied as-is, 1 = escape sequence, 2 = start of a multi-byte UTF-8 sequence
+constexpr std::array<uint8_t, 256> buildClassTable() {
+    std::array<uint8_t, 256> table{};
+    for (size_t c = 0; c < 0x20; c++) {
+        table[c] = 1;
+    }
+    table['"'] = 1;
+    table['\\'] = 1;
+    for (size_t c = 0x80; c < 256; c++) {
+        table[c] = 2;
+    }
+    return table;
+}
+
+constexpr std::array<uint8_t, 256> CHAR_CLASS = buildClassTable();
+
+// Length of the valid UTF-8 sequence at `p`, or 0 if it is malformed
+size_t utf8SequenceLength(const unsigned char* p, size_t available) {
+    unsigned char lead = p[0];
+    size_t length;
+    uint32_t min_code;
+
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        min_code = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        min_code = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        min_code = 0x10000;
+    } else {
+        return 0;
+    }
+
+    if (available < length) {
+        return 0;
+    }
+
+    uint32_t code = lead & (0x7F >> length);
+    for (size_t i = 1; i < length; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        code = (code << 6) | (p[i] & 0x3F);
+    }
+
+    // Overlong encodings, surrogates and out-of-range code points
+    if (code < min_code || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+        return 0;
+    }
+    return length;
+}
+
+bool isValidUtf8(std::string_view text) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+    size_t i = 0;
+    while (i < text.size()) {
+        if (data[i] < 0x80) {
+            i++;
+            continue;
+        }
+        size_t length = utf8SequenceLength(data + i, text.size() - i);
+        if (length == 0) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+// Same policy as the JSON escaper: malformed sequences become U+FFFD
+std::string replaceInvalidUtf8(std::string_view text) {
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+    std::string cleaned;
+    cleaned.reserve(text.size() + 8);
+    size_t i = 0;
+    while (i < text.size()) {
+        size_t length = data[i] < 0x80 ? 1 : utf8SequenceLength(data + i, text.size() - i);
+        if (length == 0) {
+            cleaned += "\xEF\xBF\xBD";
+            i++;
+        } else {
+            cleaned.append(text.data() + i, length);
+            i += length;
+        }
+    }
+    return cleaned;
+}
+
+void appendBigEndian(std::string& out, uint64_t value, size_t bytes) {
+    char buffer[8];
+    for (size_t i = 0; i < bytes; i++) {
+        buffer[i] = static_cast<char>(value >> (8 * (bytes - 1 - i)));
+    }
+    out.append(buffer, bytes);
+}
+
+// CBOR initial byte plus argument, in the shortest form (RFC 8949 §3)
+void appendCborHead(std::string& out, uint8_t major, uint64_t argument) {
+    uint8_t type = static_cast<uint8_t>(major << 5);
+    if (argument < 24) {
+        out += static_cast<char>(type | argument);
+    } else if (argument <= 0xFF) {
+        out += static_cast<char>(type | 24);
+        appendBigEndian(out, argument, 1);
+    } else if (argument <= 0xFFFF) {
+        out += static_cast<char>(type | 25);
+        appendBigEndian(out, argument, 2);
+    } else if (argument <= 0xFFFFFFFF) {
+        out += static_cast<char>(type | 26);
+        appendBigEndian(out, argument, 4);
+    } else {
+        out += static_cast<char>(type | 27);
+        appendBigEndian(out, argument, 8);
+    }
+}
+
+// Re-emits a parsed JSON value through the writer's current encoding
+void transcodeValue(const JsonReader& reader, const JsonReader::Value& value, JsonWriter& writer, std::string& scratch) {
+    switch (value.type) {
+        case JsonType::NULL_VALUE:
+            writer.null();
+            break;
+        case JsonType::BOOLEAN:
+            writer.value(value.raw == "true");
+            break;
+        case JsonType::INTEGER: {
+            int64_t number;
+            uint64_t unsigned_number;
+            double approximate;
+            if (JsonReader::getInt64(value, number)) {
+                writer.value(number);
+            } else if (std::from_chars(value.raw.data(), value.raw.data() + value.raw.size(),
+                                       unsigned_number).ec == std::errc()) {
+                writer.value(unsigned_number);
+            } else {
+                JsonReader::getDouble(value, approximate);
+                writer.value(approximate);
+            }
+            break;
+        }
+        case JsonType::NUMBER: {
+            double number = 0.0;
+            JsonReader::getDouble(value, number);
+            writer.value(number);
+            break;
+        }
+        case JsonType::STRING:
+            JsonReader::getString(value, scratch);
+            writer.value(scratch);
+            break;
+        case JsonType::ARRAY:
+            writer.beginArray();
+            reader.forEachElement(value, [&](const JsonReader::Value& element) {
+                transcodeValue(reader, element, writer, scratch);
+            });
+            writer.endArray();
+            break;
+        case JsonType::OBJECT:
+            writer.beginObject();
+            reader.forEachMember(value, [&](std::string_view raw_key, const JsonReader::Value& member) {
+                scratch.clear();
+                JsonReader::unescape(raw_key, scratch);
+                writer.key(scratch);
+                transcodeValue(reader, member, writer, scratch);
+            });
+            writer.endObject();
+            break;
+    }
+}
+
+} // namespace
+
+JsonWriter::JsonWriter(std::string& out, WireFormat format) : out_(out), flush_bytes_(0), format_(format) {}
+
+JsonWriter::JsonWriter(std::string& out, Sink sink, size_t flush_bytes, WireFormat format)
+    : out_(out), sink_(std::move(sink)), flush_bytes_(flush_bytes), format_(format) {}
+
+std::string& JsonWriter::threadBuffer() {
+    thread_local std::string buffer;
+
+    // An occasional huge response must not pin its buffer for the thread's lifetime
+    if (buffer.capacity() > THREAD_BUFFER_MAX_RETAINED) {
+        std::string().swap(buffer);
+    }
+    buffer.clear();
+    buffer.reserve(THREAD_BUFFER_RESERVE);
+    return buffer;
+}
+
+void JsonWriter::writeEscaped(std::string_view text) {
+    static const char HEX[] = "0123456789abcdef";
+
+    out_ += '"';
+
+    const unsigned char* data = reinterpret_cast<const unsigned char*>(text.data());
+    size_t size = text.size();
+    size_t run_start = 0;
+    size_t i = 0;
+
+    while (i < size) {
+        uint8_t cls = CHAR_CLASS[data[i]];
+        if (cls == 0) {
+            i++;
+            continue;
+        }
+
+        if (cls == 2) {
+            size_t length = utf8SequenceLength(data + i, size - i);
+            if (length != 0) {
+                i += length;
+                continue;
+            }
+        }
+
+        // Flush the clean run, then the escaped character
+        out_.append(text.data() + run_start, i - run_start);
+
+        if (cls == 2) {
+            out_ += "\\ufffd";
+        } else {
+            switch (data[i]) {
+                case '"':  out_ += "\\\""; break;
+                case '\\': out_ += "\\\\"; break;
+                case '\b': out_ += "\\b"; break;
+                case '\f': out_ += "\\f"; break;
+                case '\n': out_ += "\\n"; break;
+                case '\r': out_ += "\\r"; break;
+                case '\t': out_ += "\\t"; break;
+                default: {
+                    char escape[6] = {'\\', 'u', '0', '0', HEX[data[i] >> 4], HEX[data[i] & 0x0F]};
+                    out_.append(escape, sizeof(escape));
+                    break;
+                }
+            }
+        }
+
+        i++;
+        run_start = i;
+    }
+
+    out_.append(text.data() + run_start, size - run_start);
+    out_ += '"';
+}
+
+void JsonWriter::openBinary(bool object) {
+    if (format_ == WireFormat::CBOR) {
+        // Indefinite-length containers: nothing to patch, output can stream
+        out_ += static_cast<char>(object ? 0xBF : 0x9F);
+        return;
+    }
+
+    // MessagePack needs the element count up front: reserve the 16-bit form
+    header_at_[depth_] = out_.size();
+    out_.append(3, '\0');
+}
+
+void JsonWriter::closeBinary(bool object) {
+    if (format_ == WireFormat::CBOR) {
+        out_ += static_cast<char>(0xFF);
+        return;
+    }
+
+    size_t header = header_at_[depth_];
+    uint32_t count = items_[depth_];
+
+    if (count <= 15) {
+        // fixmap / fixarray: shrink the reserved header to one byte
+        out_[header] = static_cast<char>((object ? 0x80 : 0x90) | count);
+        out_.erase(header + 1, 2);
+    } else if (count <= 0xFFFF) {
+        out_[header] = static_cast<char>(object ? 0xDE : 0xDC);
+        out_[header + 1] = static_cast<char>(count >> 8);
+        out_[header + 2] = static_cast<char>(count);
+    } else {
+        out_[header] = static_cast<char>(object ? 0xDF : 0xDD);
+        out_.insert(header + 1, 2, '\0');
+        for (size_t i = 0; i < 4; i++) {
+            out_[header + 1 + i] = static_cast<char>(count >> (8 * (3 - i)));
+        }
+    }
+}
+
+void JsonWriter::writeBinaryString(std::string_view text) {
+    // Text strings must be valid UTF-8 in both formats
+    std::string cleaned;
+    if (!isValidUtf8(text)) {
+        cleaned = replaceInvalidUtf8(text);
+        text = cleaned;
+    }
+
+    size_t size = text.size();
+    if (format_ == WireFormat::CBOR) {
+        appendCborHead(out_, 3, size);
+    } else if (size <= 31) {
+        out_ += static_cast<char>(0xA0 | size);
+    } else if (size <= 0xFF) {
+        out_ += static_cast<char>(0xD9);
+        appendBigEndian(out_, size, 1);
+    } else if (size <= 0xFFFF) {
+        out_ += static_cast<char>(0xDA);
+        appendBigEndian(out_, size, 2);
+    } else {
+        out_ += static_cast<char>(0xDB);
+        appendBigEndian(out_, size, 4);
+    }
+    out_.append(text);
+}
+
+void JsonWriter::writeBinaryBool(bool flag) {
+    if (format_ == WireFormat::CBOR) {
+        out_ += static_cast<char>(flag ? 0xF5 : 0xF4);
+    } else {
+        out_ += static_cast<char>(flag ? 0xC3 : 0xC2);
+    }
+}
+
+void JsonWriter::writeBinaryNull() {
+    out_ += static_cast<char>(format_ == WireFormat::CBOR ? 0xF6 : 0xC0);
+}
+
+void JsonWriter::writeBinaryInt(int64_t number) {
+    if (number >= 0) {
+        writeBinaryUint(static_cast<uint64_t>(number));
+        return;
+    }
+
+    if (format_ == WireFormat::CBOR) {
+        // Major type 1 encodes -1 - n
+        appendCborHead(out_, 1, ~static_cast<uint64_t>(number));
+    } else if (number >= -32) {
+        out_ += static_cast<char>(number);                  // negative fixint
+    } else if (number >= INT8_MIN) {
+        out_ += static_cast<char>(0xD0);
+        appendBigEndian(out_, static_cast<uint64_t>(number), 1);
+    } else if (number >= INT16_MIN) {
+        out_ += static_cast<char>(0xD1);
+        appendBigEndian(out_, static_cast<uint64_t>(number), 2);
+    } else if (number >= INT32_MIN) {
+        out_ += static_cast<char>(0xD2);
+        appendBigEndian(out_, static_cast<uint64_t>(number), 4);
+    } else {
+        out_ += static_cast<char>(0xD3);
+        appendBigEndian(out_, static_cast<uint64_t>(number), 8);
+    }
+}
+
+void JsonWriter::writeBinaryUint(uint64_t number) {
+    if (format_ == WireFormat::CBOR) {
+        appendCborHead(out_, 0, number);
+    } else if (number <= 0x7F) {
+        out_ += static_cast<char>(number);                  // positive fixint
+    } else if (number <= 0xFF) {
+        out_ += static_cast<char>(0xCC);
+        appendBigEndian(out_, number, 1);
+    } else if (number <= 0xFFFF) {
+        out_ += static_cast<char>(0xCD);
+        appendBigEndian(out_, number, 2);
+    } else if (number <= 0xFFFFFFFF) {
+        out_ += static_cast<char>(0xCE);
+        appendBigEndian(out_, number, 4);
+    } else {
+        out_ += static_cast<char>(0xCF);
+        appendBigEndian(out_, number, 8);
+    }
+}
+
+void JsonWriter::writeBinaryDouble(double number) {
+    bool cbor = format_ == WireFormat::CBOR;
+
+    // Single precision whenever it round-trips exactly
+    float narrow = static_cast<float>(number);
+    if (static_cast<double>(narrow) == number) {
+        uint32_t bits;
+        std::memcpy(&bits, &narrow, sizeof(bits));
+        out_ += static_cast<char>(cbor ? 0xFA : 0xCA);
+        appendBigEndian(out_, bits, 4);
+        return;
+    }
+
+    uint64_t bits;
+    std::memcpy(&bits, &number, sizeof(bits));
+    out_ += static_cast<char>(cbor ? 0xFB : 0xCB);
+    appendBigEndian(out_, bits, 8);
+}
+
+void JsonWriter::writeTranscoded(std::string_view json) {
+    thread_local JsonReader reader;
+    if (!reader.parse(json)) {
+        throw std::runtime_error("invalid JSON fragment: " + reader.error());
+    }
+    std::string scratch;
+    transcodeValue(reader, reader.root(), *this, scratch);
+}
+
+void JsonWriter::flush() {
+    if (!sink_ || out_.empty()) {
+        return;
+    }
+    // Open MessagePack headers still point into the buffer
+    if (format_ == WireFormat::MSGPACK && depth_ > 0) {
+        return;
+    }
+
+    if (!sink_failed_ && !sink_(out_.data(), out_.size())) {
+        sink_failed_ = true;
+    }
+    out_.clear();
+}
+
+} // namespace QMark
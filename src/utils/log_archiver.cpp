@@ -0,0 +1,205 @@
+#include "utils/log_archiver.hpp"
+#include "utils/logger.hpp"
+#include <zlib.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+namespace QMark {
+
+namespace fs = std::filesystem;
+
+LogArchiver::LogArchiver() : should_stop_(false) {}
+
+LogArchiver::~LogArchiver() {
+    stop();
+}
+
+void LogArchiver::configure(const std::string& active_path, const LogRetention& retention) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_path_ = active_path;
+    retention_ = retention;
+
+    if (!worker_thread_.joinable()) {
+        should_stop_ = false;
+        worker_thread_ = std::thread([this]() {
+            workerLoop();
+        });
+    }
+}
+
+void LogArchiver::submit(const std::string& segment_path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.push_back(segment_path);
+    }
+    cv_.notify_one();
+}
+
+void LogArchiver::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!worker_thread_.joinable()) {
+            return;
+        }
+        should_stop_ = true;
+    }
+    cv_.notify_one();
+    worker_thread_.join();
+}
+
+std::string LogArchiver::segmentPath(const std::string& active_path) {
+    std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+    std::tm local{};
+    localtime_r(&now, &local);
+    char suffix[32];
+    std::strftime(suffix, sizeof(suffix), "%Y%m%d-%H%M%S", &local);
+
+    std::string segment = active_path + "." + suffix;
+    for (int n = 1; fs::exists(segment) || fs::exists(segment + ".gz"); n++) {
+        segment = active_path + "." + suffix + "-" + std::to_string(n);
+    }
+    return segment;
+}
+
+std::chrono::system_clock::time_point LogArchiver::nextBoundary(std::chrono::system_clock::time_point now,
+                                                                std::chrono::seconds interval) {
+    std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+    std::tm local{};
+    localtime_r(&seconds, &local);
+
+    int64_t local_seconds = static_cast<int64_t>(seconds) + local.tm_gmtoff;
+    int64_t step = interval.count();
+    int64_t boundary = (local_seconds / step + 1) * step;
+    return std::chrono::system_clock::from_time_t(static_cast<std::time_t>(boundary - local.tm_gmtoff));
+}
+
+void LogArchiver::workerLoop() {
+    // Compression must never compete with request threads
+    setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 19);
+
+    for (;;) {
+        std::string segment;
+        bool compress_segments;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() {
+                return should_stop_ || !pending_.empty();
+            });
+
+            // Segments already handed over are finished before exiting
+            if (pending_.empty()) {
+                return;
+            }
+
+            segment = pending_.front();
+            pending_.pop_front();
+            compress_segments = retention_.compress;
+        }
+
+        if (compress_segments) {
+            compress(segment);
+        }
+        applyRetention();
+    }
+}
+
+bool LogArchiver::compress(const std::string& segment_path) {
+    std::string gz_path = segment_path + ".gz";
+    std::string tmp_path = gz_path + ".tmp";
+
+    std::ifstream input(segment_path, std::ios::binary);
+    if (!input) {
+        Logger::error("Log archiver cannot read segment: " + segment_path);
+        return false;
+    }
+
+    gzFile output = gzopen(tmp_path.c_str(), "wb6");
+    if (!output) {
+        Logger::error("Log archiver cannot create: " + tmp_path);
+        return false;
+    }
+
+    std::vector<char> buffer(256 * 1024);
+    bool ok = true;
+    while (input) {
+        input.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        std::streamsize count = input.gcount();
+        if (count > 0 && gzwrite(output, buffer.data(), static_cast<unsigned>(count)) != count) {
+            ok = false;
+            break;
+        }
+    }
+
+    if (gzclose(output) != Z_OK) {
+        ok = false;
+    }
+
+    std::error_code ec;
+    if (!ok) {
+        fs::remove(tmp_path, ec);
+        Logger::error("Log archiver failed to compress: " + segment_path);
+        return false;
+    }
+
+    fs::rename(tmp_path, gz_path, ec);
+    if (ec) {
+        fs::remove(tmp_path, ec);
+        Logger::error("Log archiver failed to finalize: " + gz_path);
+        return false;
+    }
+
+    fs::remove(segment_path, ec);
+    return true;
+}
+
+void LogArchiver::applyRetention() {
+    std::string active_path;
+    LogRetention retention;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_path = active_path_;
+        retention = retention_;
+    }
+
+    fs::path active(active_path);
+    fs::path directory = active.has_parent_path() ? active.parent_path() : fs::path(".");
+    std::string prefix = active.filename().string() + ".";
+
+    struct Segment {
+        fs::path path;
+        fs::file_time_type modified;
+    };
+    std::vector<Segment> segments;
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        std::string name = entry.path().filename().string();
+        if (!entry.is_regular_file(ec) || name.compare(0, prefix.size(), prefix) != 0 ||
+            (name.size() > 4 && name.compare(name.size() - 4, 4, ".tmp") == 0)) {
+            continue;
+        }
+        segments.push_back(Segment{entry.path(), entry.last_write_time(ec)});
+    }
+
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+        return a.modified > b.modified;
+    });
+
+    auto now = fs::file_time_type::clock::now();
+    for (size_t i = 0; i < segments.size(); i++) {
+        bool too_many = retention.max_files > 0 && i >= retention.max_files;
+        bool too_old = retention.max_age.count() > 0 && now - segments[i].modified > retention.max_age;
+
+        if (too_many || too_old) {
+            fs::remove(segments[i].path, ec);
+        }
+    }
+}
+
+} // namespace QMark
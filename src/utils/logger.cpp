@@ -1,84 +1,425 @@
-
 #include "utils/logger.hpp"
 #include <iostream>
 #include <fstream>
 #include <filesystem>
-#include <iomanip>
-#include <sstream>
+#include <cstdio>
+#include <ctime>
 
 namespace QMark {
 
+namespace {
+
+// Backoff used by producers under the BLOCK policy
+void backoff(unsigned& attempt) {
+    if (attempt < 16) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+    attempt++;
+}
+
+// Formats "YYYY-MM-DD HH:MM:SS.mmm", calling localtime_r once per second
+class TimestampFormatter {
+private:
+    std::time_t cached_second_ = -1;
+    char cached_prefix_[32] = {};
+
+public:
+    void append(std::string& out, std::chrono::system_clock::time_point tp) {
+        auto since_epoch = tp.time_since_epoch();
+        std::time_t seconds = std::chrono::duration_cast<std::chrono::seconds>(since_epoch).count();
+        int ms = static_cast<int>(
+            std::chrono::duration_cast<std::chrono::milliseconds>(since_epoch).count() % 1000);
+
+        if (seconds != cached_second_) {
+            std::tm local{};
+            localtime_r(&seconds, &local);
+            std::strftime(cached_prefix_, sizeof(cached_prefix_), "%Y-%m-%d %H:%M:%S", &local);
+            cached_second_ = seconds;
+        }
+
+        char millis[8];
+        std::snprintf(millis, sizeof(millis), ".%03d", ms);
+        out += cached_prefix_;
+        out += millis;
+    }
+};
+
+} // namespace
+
 Logger& Logger::getInstance() {
     static Logger instance;
     return instance;
 }
 
-Logger::Logger() : log_level_(LogLevel::INFO) {}
+Logger::Logger()
+    : log_level_(LogLevel::INFO),
+      overflow_policy_(LoggerOptions{}.overflow_policy),
+      sample_every_(LoggerOptions{}.sample_every),
+      current_file_bytes_(0),
+      ring_(std::make_unique<Slot[]>(QUEUE_CAPACITY)),
+      enqueue_pos_(0),
+      dequeue_pos_(0),
+      dropped_(0),
+      overflow_count_(0),
+      reported_dropped_(0),
+      consumer_waiting_(false),
+      should_stop_(false),
+      written_pos_(0) {
+    for (size_t i = 0; i < QUEUE_CAPACITY; i++) {
+        ring_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    worker_thread_ = std::thread([this]() {
+        workerLoop();
+    });
+}
+
+Logger::~Logger() {
+    shutdown();
+}
+
+void Logger::init(const std::string& log_file, const LoggerOptions& options) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        // Create logs directory if it doesn't exist
+        std::filesystem::path log_path(log_file);
+        if (log_path.has_parent_path()) {
+            std::filesystem::create_directories(log_path.parent_path());
+        }
+
+        // The file is opened once and owned by the consumer thread from here on
+        auto stream = std::make_unique<std::ofstream>(log_file, std::ios::app | std::ios::binary);
+        if (!stream->is_open()) {
+            stream.reset();
+        }
+
+        std::error_code ec;
+        auto existing_size = std::filesystem::file_size(log_path, ec);
+
+        log_file_ = log_file;
+        options_ = options;
+        if (options_.sample_every == 0) {
+            options_.sample_every = 1;
+        }
+        file_stream_ = std::move(stream);
+        current_file_bytes_ = ec ? 0 : existing_size;
+        overflow_policy_.store(options_.overflow_policy, std::memory_order_relaxed);
+        sample_every_.store(options_.sample_every, std::memory_order_relaxed);
+        if (options_.rotate_interval.count() > 0) {
+            next_rotation_ = LogArchiver::nextBoundary(std::chrono::system_clock::now(), options_.rotate_interval);
+        }
+    }
+
+    if (options.max_file_bytes > 0 || options.rotate_interval.count() > 0) {
+        archiver_.configure(log_file, options.retention);
+    }
 
-void Logger::init(const std::string& log_file) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    // Create logs directory if it doesn't exist
-    std::filesystem::path log_path(log_file);
-    std::filesystem::create_directories(log_path.parent_path());
-    
-    log_file_ = log_file;
-    initialized_ = true;
-    
     log(LogLevel::INFO, "Logger initialized with file: " + log_file);
 }
 
 void Logger::setLogLevel(LogLevel level) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    log_level_ = level;
+    log_level_.store(level, std::memory_order_relaxed);
+}
+
+LogLevel Logger::getLogLevel() const {
+    return log_level_.load(std::memory_order_relaxed);
+}
+
+bool Logger::tryEnqueue(LogLevel level, std::chrono::system_clock::time_point timestamp, const std::string& message) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+
+    for (;;) {
+        slot = &ring_[pos & (QUEUE_CAPACITY - 1)];
+        size_t sequence = slot->sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    // The slot's string keeps its capacity across laps, so steady-state
+    // logging does not allocate
+    slot->level = level;
+    slot->timestamp = timestamp;
+    slot->message.assign(message);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    if (consumer_waiting_.load(std::memory_order_relaxed)) {
+        queue_cv_.notify_one();
+    }
+    return true;
+}
+
+void Logger::enqueue(LogLevel level, const std::string& message) {
+    auto timestamp = std::chrono::system_clock::now();
+
+    if (should_stop_.load(std::memory_order_acquire)) {
+        writeDirect(level, timestamp, message);
+        return;
+    }
+
+    if (tryEnqueue(level, timestamp, message)) {
+        return;
+    }
+
+    // options_ belongs to the consumer; producers only see the published copies
+    OverflowPolicy policy = level == LogLevel::FATAL ? OverflowPolicy::BLOCK
+                                                     : overflow_policy_.load(std::memory_order_relaxed);
+    if (policy == OverflowPolicy::DROP ||
+        (policy == OverflowPolicy::SAMPLE &&
+         overflow_count_.fetch_add(1, std::memory_order_relaxed) % sample_every_.load(std::memory_order_relaxed) != 0)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    unsigned attempt = 0;
+    while (!tryEnqueue(level, timestamp, message)) {
+        if (should_stop_.load(std::memory_order_acquire)) {
+            writeDirect(level, timestamp, message);
+            return;
+        }
+        queue_cv_.notify_one();
+        backoff(attempt);
+    }
 }
 
 void Logger::log(LogLevel level, const std::string& message) {
-    if (level < log_level_) {
+    if (level < log_level_.load(std::memory_order_relaxed)) {
         return;
     }
-    
+
+    enqueue(level, message);
+}
+
+void Logger::writeDirect(LogLevel level, std::chrono::system_clock::time_point timestamp, const std::string& message) {
+    // Used only once the consumer is gone (shutdown, static destruction)
     std::lock_guard<std::mutex> lock(mutex_);
-    
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-    
-    std::stringstream ss;
-    ss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-    ss << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    
-    std::string timestamp = ss.str();
-    std::string level_str = levelToString(level);
-    std::string log_entry = "[" + timestamp + "] [" + level_str + "] " + message;
-    
-    // Output to console
-    if (level >= LogLevel::ERROR) {
-        std::cerr << log_entry << std::endl;
-    } else {
-        std::cout << log_entry << std::endl;
+
+    std::string line = "[";
+    TimestampFormatter formatter;
+    formatter.append(line, timestamp);
+    line += "] [" + levelToString(level) + "] " + message + "\n";
+
+    if (options_.console_output) {
+        std::fwrite(line.data(), 1, line.size(), level >= LogLevel::ERROR ? stderr : stdout);
+    }
+    if (file_stream_) {
+        file_stream_->write(line.data(), static_cast<std::streamsize>(line.size()));
+        file_stream_->flush();
     }
-    
-    // Output to file if initialized
-    if (initialized_ && !log_file_.empty()) {
-        std::ofstream file(log_file_, std::ios::app);
-        if (file.is_open()) {
-            file << log_entry << std::endl;
+}
+
+size_t Logger::drain() {
+    // Only the consumer thread drains
+    static TimestampFormatter formatter;
+    std::string out_batch;
+    std::string err_batch;
+    std::string file_batch;
+    size_t consumed = 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    bool console = options_.console_output;
+    size_t batch_bytes = options_.batch_bytes;
+
+    auto write_batches = [&]() {
+        if (!out_batch.empty()) {
+            std::fwrite(out_batch.data(), 1, out_batch.size(), stdout);
+            out_batch.clear();
+        }
+        if (!err_batch.empty()) {
+            std::fwrite(err_batch.data(), 1, err_batch.size(), stderr);
+            err_batch.clear();
+        }
+        if (!file_batch.empty()) {
+            if (rotationDue(file_batch.size())) {
+                rotateFile();
+            }
+            if (file_stream_) {
+                file_stream_->write(file_batch.data(), static_cast<std::streamsize>(file_batch.size()));
+                current_file_bytes_ += file_batch.size();
+            }
+            file_batch.clear();
+        }
+    };
+
+    uint64_t total_dropped = dropped_.load(std::memory_order_relaxed);
+    uint64_t dropped = total_dropped - reported_dropped_;
+    reported_dropped_ = total_dropped;
+    if (dropped > 0) {
+        std::string line = "[";
+        formatter.append(line, std::chrono::system_clock::now());
+        line += "] [WARN ] Logger queue overflow: dropped " + std::to_string(dropped) + " messages\n";
+        file_batch += line;
+        if (console) {
+            err_batch += line;
         }
     }
+
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = ring_[pos & (QUEUE_CAPACITY - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != pos + 1) {
+            break;
+        }
+
+        std::string line = "[";
+        formatter.append(line, slot.timestamp);
+        line += "] [";
+        line += levelToString(slot.level);
+        line += "] ";
+        line += slot.message;
+        line += '\n';
+
+        file_batch += line;
+        if (console) {
+            (slot.level >= LogLevel::ERROR ? err_batch : out_batch) += line;
+        }
+
+        slot.sequence.store(pos + QUEUE_CAPACITY, std::memory_order_release);
+        pos++;
+        consumed++;
+        dequeue_pos_.store(pos, std::memory_order_relaxed);
+
+        if (file_batch.size() >= batch_bytes) {
+            write_batches();
+        }
+    }
+
+    write_batches();
+    if (consumed > 0 || dropped > 0) {
+        std::fflush(stdout);
+        if (file_stream_) {
+            file_stream_->flush();
+        }
+    }
+
+    written_pos_.store(pos, std::memory_order_release);
+    return consumed;
+}
+
+bool Logger::rotationDue(size_t pending_bytes) const {
+    if (!file_stream_) {
+        return false;
+    }
+
+    if (options_.max_file_bytes > 0 && current_file_bytes_ > 0 &&
+        current_file_bytes_ + pending_bytes > options_.max_file_bytes) {
+        return true;
+    }
+
+    return options_.rotate_interval.count() > 0 && std::chrono::system_clock::now() >= next_rotation_;
+}
+
+void Logger::rotateFile() {
+    // Runs on the consumer thread only: producers keep enqueuing into the
+    // ring while the file is swapped, so they never see the rotation
+    file_stream_->flush();
+    file_stream_.reset();
+
+    std::string segment = LogArchiver::segmentPath(log_file_);
+
+    // rename(2) is atomic: readers see either the old or the new file
+    std::error_code ec;
+    std::filesystem::rename(log_file_, segment, ec);
+
+    file_stream_ = std::make_unique<std::ofstream>(log_file_, std::ios::app | std::ios::binary);
+    if (!file_stream_->is_open()) {
+        file_stream_.reset();
+    }
+
+    current_file_bytes_ = 0;
+    if (options_.rotate_interval.count() > 0) {
+        next_rotation_ = LogArchiver::nextBoundary(std::chrono::system_clock::now(), options_.rotate_interval);
+    }
+
+    if (!ec) {
+        archiver_.submit(segment);
+    }
+}
+
+void Logger::workerLoop() {
+    while (!should_stop_.load(std::memory_order_acquire)) {
+        if (drain() > 0) {
+            flushed_cv_.notify_all();
+            continue;
+        }
+        flushed_cv_.notify_all();
+
+        std::unique_lock<std::mutex> lock(queue_mutex_);
+        consumer_waiting_.store(true, std::memory_order_relaxed);
+        // Producers notify without the mutex; the timeout bounds a missed wakeup
+        queue_cv_.wait_for(lock, std::chrono::milliseconds(10));
+        consumer_waiting_.store(false, std::memory_order_relaxed);
+    }
+
+    drain();
+    flushed_cv_.notify_all();
+}
+
+void Logger::flush() {
+    size_t target = enqueue_pos_.load(std::memory_order_acquire);
+
+    if (should_stop_.load(std::memory_order_acquire) || !worker_thread_.joinable()) {
+        return;
+    }
+
+    queue_cv_.notify_one();
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    while (written_pos_.load(std::memory_order_acquire) < target &&
+           !should_stop_.load(std::memory_order_acquire)) {
+        flushed_cv_.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
+
+void Logger::shutdown() {
+    if (should_stop_.exchange(true)) {
+        return;
+    }
+
+    queue_cv_.notify_one();
+    if (worker_thread_.joinable()) {
+        worker_thread_.join();
+    }
+
+    archiver_.stop();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_stream_) {
+        file_stream_->flush();
+    }
+}
+
+uint64_t Logger::getDroppedCount() const {
+    return dropped_.load(std::memory_order_relaxed);
 }
 
 std::string Logger::levelToString(LogLevel level) {
     switch (level) {
+        case LogLevel::TRACE: return "TRACE";
         case LogLevel::DEBUG: return "DEBUG";
         case LogLevel::INFO:  return "INFO ";
         case LogLevel::WARN:  return "WARN ";
         case LogLevel::ERROR: return "ERROR";
+        case LogLevel::FATAL: return "FATAL";
         default: return "UNKNOWN";
     }
 }
 
+void Logger::trace(const std::string& message) {
+    getInstance().log(LogLevel::TRACE, message);
+}
+
 void Logger::debug(const std::string& message) {
     getInstance().log(LogLevel::DEBUG, message);
 }
@@ -95,4 +436,10 @@ void Logger::error(const std::string& message) {
     getInstance().log(LogLevel::ERROR, message);
 }
 
+void Logger::fatal(const std::string& message) {
+    Logger& logger = getInstance();
+    logger.log(LogLevel::FATAL, message);
+    logger.flush();
+}
+
 } // namespace QMark
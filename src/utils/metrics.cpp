@@ -0,0 +1,398 @@
+#include "utils/metrics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <stdexcept>
+
+namespace QMark {
+
+namespace metrics {
+
+namespace {
+
+// Prometheus bucket bounds (seconds); HDR buckets are folded into them on scrape
+const double EXPORTED_BOUNDS[] = {
+    0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1.0, 2.5, 5.0, 10.0
+};
+
+const char* const KNOWN_METHODS[] = {
+    "GET", "POST", "PUT", "DELETE", "PATCH", "OPTIONS", "HEAD"
+};
+
+// Registers the shard on first use and folds it into the retired totals on thread exit
+struct ThreadShardHolder {
+    ThreadShard shard;
+
+    ThreadShardHolder() {
+        MetricsRegistry::getInstance().addShard(&shard);
+    }
+
+    ~ThreadShardHolder() {
+        MetricsRegistry::getInstance().retireShard(&shard);
+    }
+};
+
+} // namespace
+
+size_t bucketIndex(uint64_t micros) {
+    if (micros < SUB_BUCKETS) {
+        return static_cast<size_t>(micros);
+    }
+
+    unsigned magnitude = 63u - static_cast<unsigned>(__builtin_clzll(micros));
+    unsigned shift = magnitude - SUB_BUCKET_BITS;
+    size_t sub = static_cast<size_t>((micros >> shift) & (SUB_BUCKETS - 1));
+    size_t index = (magnitude - SUB_BUCKET_BITS + 1) * SUB_BUCKETS + sub;
+    return std::min(index, HISTOGRAM_BUCKETS - 1);
+}
+
+uint64_t bucketUpperBound(size_t index) {
+    if (index < SUB_BUCKETS) {
+        return index + 1;
+    }
+
+    unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+    uint64_t sub = index % SUB_BUCKETS;
+    return (SUB_BUCKETS + sub + 1) << shift;
+}
+
+ThreadShard::~ThreadShard() {
+    for (auto& slot : routes) {
+        delete slot.load(std::memory_order_relaxed);
+    }
+}
+
+RouteStats& ThreadShard::route(uint32_t id) {
+    RouteStats* stats = routes[id].load(std::memory_order_acquire);
+    if (!stats) {
+        // Allocated lazily: most threads only ever see a handful of routes
+        stats = new RouteStats();
+        routes[id].store(stats, std::memory_order_release);
+    }
+    return *stats;
+}
+
+ThreadShard& threadShard() {
+    thread_local ThreadShardHolder holder;
+    return holder.shard;
+}
+
+} // namespace metrics
+
+namespace {
+
+struct RouteTotals {
+    std::array<uint64_t, metrics::STATUS_CLASSES> requests{};
+    uint64_t latency_sum_us = 0;
+    std::array<uint64_t, metrics::HISTOGRAM_BUCKETS> buckets{};
+    bool seen = false;
+};
+
+std::string escapeLabel(const std::string& value) {
+    std::string out;
+    out.reserve(value.size());
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+std::string formatValue(double value) {
+    char buffer[32];
+    if (std::isfinite(value) && value == std::floor(value) && std::fabs(value) < 9.0e15) {
+        std::snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+    } else {
+        std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    }
+    return buffer;
+}
+
+void writeHeader(std::string& out, const std::string& name, const std::string& help, const char* type) {
+    out += "# HELP " + name + " " + help + "\n";
+    out += "# TYPE " + name + " " + type + "\n";
+}
+
+} // namespace
+
+MetricsRegistry& MetricsRegistry::getInstance() {
+    static MetricsRegistry instance;
+    return instance;
+}
+
+MetricsRegistry::MetricsRegistry() : retired_(std::make_unique<metrics::ThreadShard>()) {
+    // Route 0 absorbs everything past MAX_ROUTES
+    routes_.push_back(RouteInfo{"OTHER", "other"});
+}
+
+MetricsRegistry::~MetricsRegistry() = default;
+
+uint32_t MetricsRegistry::registerCounter(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (size_t i = 0; i < counters_.size(); i++) {
+        if (counters_[i].name == name) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+
+    if (counters_.size() >= metrics::MAX_COUNTERS) {
+        throw std::runtime_error("Too many metric counters: " + name);
+    }
+
+    counters_.push_back(CounterInfo{name, help});
+    return static_cast<uint32_t>(counters_.size() - 1);
+}
+
+void MetricsRegistry::registerCallback(const std::string& name, const std::string& help, MetricType type,
+                                       std::function<double()> read) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (auto& callback : callbacks_) {
+        if (callback.name == name) {
+            callback = CallbackInfo{name, help, type, std::move(read)};
+            return;
+        }
+    }
+    callbacks_.push_back(CallbackInfo{name, help, type, std::move(read)});
+}
+
+void MetricsRegistry::removeCallback(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::erase_if(callbacks_, [&](const CallbackInfo& callback) {
+        return callback.name == name;
+    });
+}
+
+void MetricsRegistry::increment(uint32_t counter_id, uint64_t delta) {
+    if (counter_id < metrics::MAX_COUNTERS) {
+        metrics::bump(metrics::threadShard().counters[counter_id], delta);
+    }
+}
+
+uint32_t MetricsRegistry::resolveRoute(const std::string& key, const std::string& method, const std::string& pattern) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = route_ids_.find(key);
+    if (it != route_ids_.end()) {
+        return it->second;
+    }
+
+    if (routes_.size() >= metrics::MAX_ROUTES) {
+        return 0;
+    }
+
+    uint32_t id = static_cast<uint32_t>(routes_.size());
+    routes_.push_back(RouteInfo{method, pattern});
+    route_ids_.emplace(key, id);
+    return id;
+}
+
+void MetricsRegistry::recordRequest(const std::string& method, const std::string& route, int status, uint64_t micros) {
+    metrics::ThreadShard& shard = metrics::threadShard();
+
+    // Client-supplied methods and unmatched paths must not grow the label set
+    const char* method_label = "OTHER";
+    for (const char* known : metrics::KNOWN_METHODS) {
+        if (method == known) {
+            method_label = known;
+            break;
+        }
+    }
+    static const std::string UNMATCHED = "unmatched";
+    const std::string& pattern_label = route.empty() ? UNMATCHED : route;
+
+    // Built in the shard's buffer: no allocation once the route is cached
+    std::string& key = shard.route_key;
+    key.assign(method_label).append(1, ' ').append(pattern_label);
+    uint32_t id;
+    auto cached = shard.route_cache.find(key);
+    if (cached != shard.route_cache.end()) {
+        id = cached->second;
+    } else {
+        id = resolveRoute(key, method_label, pattern_label);
+        shard.route_cache.emplace(key, id);
+    }
+
+    int status_class = status / 100 - 1;
+    if (status_class < 0 || status_class >= static_cast<int>(metrics::STATUS_CLASSES)) {
+        status_class = static_cast<int>(metrics::STATUS_CLASSES) - 1;
+    }
+
+    metrics::RouteStats& stats = shard.route(id);
+    metrics::bump(stats.requests[static_cast<size_t>(status_class)]);
+    metrics::bump(stats.latency_sum_us, micros);
+    metrics::bump(stats.buckets[metrics::bucketIndex(micros)]);
+}
+
+void MetricsRegistry::addShard(metrics::ThreadShard* shard) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shards_.push_back(shard);
+}
+
+void MetricsRegistry::retireShard(metrics::ThreadShard* shard) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    for (size_t r = 0; r < metrics::MAX_ROUTES; r++) {
+        metrics::RouteStats* stats = shard->routes[r].load(std::memory_order_acquire);
+        if (!stats) {
+            continue;
+        }
+
+        metrics::RouteStats& total = retired_->route(static_cast<uint32_t>(r));
+        for (size_t c = 0; c < metrics::STATUS_CLASSES; c++) {
+            metrics::bump(total.requests[c], stats->requests[c].load(std::memory_order_relaxed));
+        }
+        metrics::bump(total.latency_sum_us, stats->latency_sum_us.load(std::memory_order_relaxed));
+        for (size_t b = 0; b < metrics::HISTOGRAM_BUCKETS; b++) {
+            metrics::bump(total.buckets[b], stats->buckets[b].load(std::memory_order_relaxed));
+        }
+    }
+
+    for (size_t c = 0; c < metrics::MAX_COUNTERS; c++) {
+        metrics::bump(retired_->counters[c], shard->counters[c].load(std::memory_order_relaxed));
+    }
+
+    std::erase(shards_, shard);
+}
+
+uint64_t MetricsRegistry::requestsTotal() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    uint64_t total = 0;
+    auto accumulate = [&](const metrics::ThreadShard& shard) {
+        for (const auto& slot : shard.routes) {
+            const metrics::RouteStats* stats = slot.load(std::memory_order_acquire);
+            if (!stats) {
+                continue;
+            }
+            for (const auto& count : stats->requests) {
+                total += count.load(std::memory_order_relaxed);
+            }
+        }
+    };
+
+    for (const metrics::ThreadShard* shard : shards_) {
+        accumulate(*shard);
+    }
+    accumulate(*retired_);
+    return total;
+}
+
+std::string MetricsRegistry::renderPrometheus() const {
+    static const char* const STATUS_LABELS[] = {"1xx", "2xx", "3xx", "4xx", "5xx"};
+
+    std::vector<RouteTotals> routes(metrics::MAX_ROUTES);
+    std::array<uint64_t, metrics::MAX_COUNTERS> counters{};
+    std::vector<RouteInfo> route_info;
+    std::vector<CounterInfo> counter_info;
+    std::vector<CallbackInfo> callbacks;
+
+    {
+        // Merge under the registry lock only; request threads never take it
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        auto merge = [&](const metrics::ThreadShard& shard) {
+            for (size_t r = 0; r < metrics::MAX_ROUTES; r++) {
+                const metrics::RouteStats* stats = shard.routes[r].load(std::memory_order_acquire);
+                if (!stats) {
+                    continue;
+                }
+                RouteTotals& total = routes[r];
+                total.seen = true;
+                for (size_t c = 0; c < metrics::STATUS_CLASSES; c++) {
+                    total.requests[c] += stats->requests[c].load(std::memory_order_relaxed);
+                }
+                total.latency_sum_us += stats->latency_sum_us.load(std::memory_order_relaxed);
+                for (size_t b = 0; b < metrics::HISTOGRAM_BUCKETS; b++) {
+                    total.buckets[b] += stats->buckets[b].load(std::memory_order_relaxed);
+                }
+            }
+            for (size_t c = 0; c < metrics::MAX_COUNTERS; c++) {
+                counters[c] += shard.counters[c].load(std::memory_order_relaxed);
+            }
+        };
+
+        for (const metrics::ThreadShard* shard : shards_) {
+            merge(*shard);
+        }
+        merge(*retired_);
+
+        route_info = routes_;
+        counter_info = counters_;
+        callbacks = callbacks_;
+    }
+
+    std::string out;
+    out.reserve(16 * 1024);
+
+    writeHeader(out, "qmark_http_requests_total", "HTTP requests by route and status class.", "counter");
+    for (size_t r = 0; r < route_info.size(); r++) {
+        if (!routes[r].seen) {
+            continue;
+        }
+        std::string labels = "method=\"" + escapeLabel(route_info[r].method) +
+                             "\",route=\"" + escapeLabel(route_info[r].pattern) + "\"";
+        for (size_t c = 0; c < metrics::STATUS_CLASSES; c++) {
+            if (routes[r].requests[c] == 0) {
+                continue;
+            }
+            out += "qmark_http_requests_total{" + labels + ",status=\"" + STATUS_LABELS[c] + "\"} " +
+                   std::to_string(routes[r].requests[c]) + "\n";
+        }
+    }
+
+    writeHeader(out, "qmark_http_request_duration_seconds", "HTTP request latency by route.", "histogram");
+    for (size_t r = 0; r < route_info.size(); r++) {
+        const RouteTotals& total = routes[r];
+        if (!total.seen) {
+            continue;
+        }
+        std::string labels = "method=\"" + escapeLabel(route_info[r].method) +
+                             "\",route=\"" + escapeLabel(route_info[r].pattern) + "\"";
+
+        // An HDR bucket counts toward a bound once its whole range lies below it
+        uint64_t cumulative = 0;
+        size_t next_bucket = 0;
+        for (double bound : metrics::EXPORTED_BOUNDS) {
+            uint64_t bound_us = static_cast<uint64_t>(bound * 1e6);
+            while (next_bucket < metrics::HISTOGRAM_BUCKETS &&
+                   metrics::bucketUpperBound(next_bucket) <= bound_us) {
+                cumulative += total.buckets[next_bucket++];
+            }
+            out += "qmark_http_request_duration_seconds_bucket{" + labels + ",le=\"" +
+                   formatValue(bound) + "\"} " + std::to_string(cumulative) + "\n";
+        }
+
+        uint64_t count = 0;
+        for (uint64_t bucket : total.buckets) {
+            count += bucket;
+        }
+        out += "qmark_http_request_duration_seconds_bucket{" + labels + ",le=\"+Inf\"} " +
+               std::to_string(count) + "\n";
+        out += "qmark_http_request_duration_seconds_sum{" + labels + "} " +
+               formatValue(static_cast<double>(total.latency_sum_us) / 1e6) + "\n";
+        out += "qmark_http_request_duration_seconds_count{" + labels + "} " + std::to_string(count) + "\n";
+    }
+
+    for (size_t c = 0; c < counter_info.size(); c++) {
+        writeHeader(out, counter_info[c].name, counter_info[c].help, "counter");
+        out += counter_info[c].name + " " + std::to_string(counters[c]) + "\n";
+    }
+
+    // Callbacks run outside the lock: they may take their own subsystem locks
+    for (const auto& callback : callbacks) {
+        writeHeader(out, callback.name, callback.help, callback.type == MetricType::COUNTER ? "counter" : "gauge");
+        out += callback.name + " " + formatValue(callback.read()) + "\n";
+    }
+
+    return out;
+}
+
+} // namespace QMark
@@ -0,0 +1,58 @@
+#include "utils/request_arena.hpp"
+#include "utils/metrics.hpp"
+#include <algorithm>
+#include <bit>
+#include <new>
+
+namespace QMark {
+
+namespace {
+
+uint32_t overflowCounter() {
+    static const uint32_t id = MetricsRegistry::getInstance().registerCounter(
+        "qmark_request_arena_overflows_total",
+        "Per-request allocations that did not fit the worker's arena block.");
+    return id;
+}
+
+} // namespace
+
+void* RequestArena::OverflowResource::do_allocate(size_t size, size_t alignment) {
+    bytes += size;
+    MetricsRegistry::getInstance().increment(overflowCounter());
+    return ::operator new(size, std::align_val_t(alignment));
+}
+
+void RequestArena::OverflowResource::do_deallocate(void* pointer, size_t size, size_t alignment) {
+    ::operator delete(pointer, size, std::align_val_t(alignment));
+}
+
+bool RequestArena::OverflowResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept {
+    return this == &other;
+}
+
+RequestArena::RequestArena()
+    : block_(std::make_unique_for_overwrite<std::byte[]>(INITIAL_BLOCK_BYTES)), block_bytes_(INITIAL_BLOCK_BYTES) {
+    resource_.emplace(block_.get(), block_bytes_, &overflow_);
+}
+
+RequestArena& RequestArena::local() {
+    thread_local RequestArena arena;
+    return arena;
+}
+
+void RequestArena::reset() {
+    // Chunks taken past the block go back to the global allocator here
+    resource_.reset();
+
+    // Sized for the largest request seen, so the next one stays in the block
+    if (overflow_.bytes > 0 && block_bytes_ < MAX_BLOCK_BYTES) {
+        block_bytes_ = std::min(MAX_BLOCK_BYTES, std::bit_ceil(block_bytes_ + overflow_.bytes));
+        block_ = std::make_unique_for_overwrite<std::byte[]>(block_bytes_);
+    }
+    overflow_.bytes = 0;
+
+    resource_.emplace(block_.get(), block_bytes_, &overflow_);
+}
+
+} // namespace QMark
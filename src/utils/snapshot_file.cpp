@@ -0,0 +1,224 @@
+#include "utils/snapshot_file.hpp"
+#include "utils/logger.hpp"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+namespace QMark {
+
+namespace {
+
+// Header: magic, kind[4], u32 version, u64 token, i64 written_at,
+// u64 body bytes, u32 body crc32, u32 crc32 of the preceding header bytes
+constexpr char MAGIC[8] = {'Q', 'M', 'K', 'S', 'N', 'A', 'P', '\n'};
+constexpr size_t HEADER_BYTES = 8 + 4 + 4 + 8 + 8 + 8 + 4 + 4;
+
+uLong crcOf(const char* data, size_t length) {
+    // zlib takes 32-bit lengths
+    uLong crc = crc32(0L, Z_NULL, 0);
+    while (length > 0) {
+        size_t step = std::min<size_t>(length, 1u << 30);
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(data), static_cast<uInt>(step));
+        data += step;
+        length -= step;
+    }
+    return crc;
+}
+
+class HeaderCursor {
+private:
+    char* at_;
+
+public:
+    explicit HeaderCursor(char* at) : at_(at) {}
+
+    template<typename T>
+    void put(const T& value) {
+        std::memcpy(at_, &value, sizeof(T));
+        at_ += sizeof(T);
+    }
+
+    template<typename T>
+    T get() {
+        T value;
+        std::memcpy(&value, at_, sizeof(T));
+        at_ += sizeof(T);
+        return value;
+    }
+};
+
+} // namespace
+
+SnapshotWriter::SnapshotWriter(std::string path, const char* kind, uint32_t version, uint64_t token)
+    : path_(std::move(path)), temporary_(path_ + ".tmp"), version_(version), token_(token), crc_(crc32(0L, Z_NULL, 0)) {
+    std::memcpy(kind_, kind, sizeof(kind_));
+
+    file_ = std::fopen(temporary_.c_str(), "wb");
+    if (!file_) {
+        Logger::error("Failed to create snapshot " + temporary_ + ": " + std::strerror(errno));
+        ok_ = false;
+        return;
+    }
+    // Filled in by commit() once the body size and crc are known
+    char header[HEADER_BYTES] = {};
+    ok_ = std::fwrite(header, 1, sizeof(header), file_) == sizeof(header);
+}
+
+SnapshotWriter::~SnapshotWriter() {
+    if (file_) {
+        std::fclose(file_);
+    }
+    if (!committed_) {
+        std::remove(temporary_.c_str());
+    }
+}
+
+void SnapshotWriter::write(const void* data, size_t length) {
+    if (length == 0 || !ok_) {
+        return;
+    }
+    crc_ = crc32(crc_, static_cast<const Bytef*>(data), static_cast<uInt>(length));
+    body_bytes_ += length;
+    ok_ = std::fwrite(data, 1, length, file_) == length;
+}
+
+void SnapshotWriter::putString(std::string_view value) {
+    put(static_cast<uint32_t>(value.size()));
+    write(value.data(), value.size());
+}
+
+bool SnapshotWriter::commit() {
+    if (!ok_) {
+        Logger::error("Failed to write snapshot " + temporary_ + ": " + std::strerror(errno));
+        return false;
+    }
+
+    char header[HEADER_BYTES];
+    HeaderCursor cursor(header);
+    cursor.put(MAGIC);
+    cursor.put(kind_);
+    cursor.put(version_);
+    cursor.put(token_);
+    cursor.put(static_cast<int64_t>(std::time(nullptr)));
+    cursor.put(body_bytes_);
+    cursor.put(static_cast<uint32_t>(crc_));
+    cursor.put(static_cast<uint32_t>(crcOf(header, HEADER_BYTES - sizeof(uint32_t))));
+
+    bool ok = std::fseek(file_, 0, SEEK_SET) == 0 &&
+              std::fwrite(header, 1, sizeof(header), file_) == sizeof(header) &&
+              std::fflush(file_) == 0 && ::fdatasync(fileno(file_)) == 0;
+    ok = std::fclose(file_) == 0 && ok;
+    file_ = nullptr;
+
+    if (!ok || std::rename(temporary_.c_str(), path_.c_str()) != 0) {
+        Logger::error("Failed to write snapshot " + path_ + ": " + std::strerror(errno));
+        return false;
+    }
+    committed_ = true;
+    return true;
+}
+
+SnapshotReader::~SnapshotReader() {
+    if (mapping_) {
+        ::munmap(mapping_, mapped_bytes_);
+    }
+}
+
+bool SnapshotReader::open(const std::string& path, const char* kind, uint32_t version) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info{};
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < HEADER_BYTES) {
+        ::close(fd);
+        Logger::warn("Ignoring snapshot without a valid header: " + path);
+        return false;
+    }
+
+    mapped_bytes_ = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, mapped_bytes_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        Logger::warn("Failed to map snapshot " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    mapping_ = mapping;
+    // Read front to back exactly once
+    ::madvise(mapping_, mapped_bytes_, MADV_SEQUENTIAL);
+    ::madvise(mapping_, mapped_bytes_, MADV_WILLNEED);
+
+    const char* data = static_cast<const char*>(mapping_);
+    char header[HEADER_BYTES];
+    std::memcpy(header, data, HEADER_BYTES);
+    HeaderCursor cursor(header);
+    auto magic = cursor.get<std::array<char, 8>>();
+    auto file_kind = cursor.get<std::array<char, 4>>();
+    info_.version = cursor.get<uint32_t>();
+    info_.token = cursor.get<uint64_t>();
+    info_.written_at = cursor.get<int64_t>();
+    uint64_t body_bytes = cursor.get<uint64_t>();
+    uint32_t body_crc = cursor.get<uint32_t>();
+    uint32_t header_crc = cursor.get<uint32_t>();
+
+    if (std::memcmp(magic.data(), MAGIC, sizeof(MAGIC)) != 0 || std::memcmp(file_kind.data(), kind, 4) != 0 ||
+        header_crc != static_cast<uint32_t>(crcOf(header, HEADER_BYTES - sizeof(uint32_t)))) {
+        Logger::warn("Ignoring snapshot without a valid header: " + path);
+        return false;
+    }
+    if (info_.version != version) {
+        Logger::warn("Ignoring snapshot " + path + " in format version " + std::to_string(info_.version) +
+                     " (expected " + std::to_string(version) + ")");
+        return false;
+    }
+    // Checked whole before anything is applied
+    if (body_bytes != mapped_bytes_ - HEADER_BYTES ||
+        static_cast<uint32_t>(crcOf(data + HEADER_BYTES, body_bytes)) != body_crc) {
+        Logger::warn("Ignoring corrupt snapshot: " + path);
+        return false;
+    }
+
+    info_.body_bytes = static_cast<size_t>(body_bytes);
+    cursor_ = data + HEADER_BYTES;
+    end_ = cursor_ + body_bytes;
+    return true;
+}
+
+bool SnapshotReader::take(void* out, size_t length) {
+    const char* from = view(length);
+    if (!from) {
+        return false;
+    }
+    std::memcpy(out, from, length);
+    return true;
+}
+
+bool SnapshotReader::getString(std::string& value) {
+    uint32_t length = 0;
+    if (!get(length)) {
+        return false;
+    }
+    const char* from = view(length);
+    if (!from) {
+        return false;
+    }
+    value.assign(from, length);
+    return true;
+}
+
+const char* SnapshotReader::view(size_t length) {
+    if (remaining() < length) {
+        return nullptr;
+    }
+    const char* from = cursor_;
+    cursor_ += length;
+    return from;
+}
+
+} // namespace QMark
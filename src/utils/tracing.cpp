@@ -0,0 +1,220 @@
+#include "utils/tracing.hpp"
+#include <set>
+#include <thread>
+
+namespace QMark {
+
+namespace tracing {
+
+namespace {
+
+std::atomic<uint32_t> next_thread_id{1};
+
+} // namespace
+
+ThreadRing& threadRing() {
+    thread_local ThreadRing ring = [] {
+        ThreadRing initial;
+        initial.thread_id = next_thread_id.fetch_add(1, std::memory_order_relaxed);
+        return initial;
+    }();
+    return ring;
+}
+
+} // namespace tracing
+
+Tracer& Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+Tracer::Tracer()
+    : enabled_(false), next_trace_id_(1), ticks_per_us_(0.0), anchor_tsc_(0), anchor_unix_us_(0) {}
+
+void Tracer::configure(const TracingConfig& config) {
+    if (ticks_per_us_ == 0.0) {
+        // Same calibration as the binary log: TSC ticks against the steady clock
+        auto steady_start = std::chrono::steady_clock::now();
+        uint64_t tsc_start = binlog::readTsc();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        auto steady_end = std::chrono::steady_clock::now();
+        uint64_t tsc_end = binlog::readTsc();
+
+        double elapsed_us = static_cast<double>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(steady_end - steady_start).count()) / 1000.0;
+        ticks_per_us_ = elapsed_us > 0 ? static_cast<double>(tsc_end - tsc_start) / elapsed_us : 1000.0;
+        anchor_tsc_ = binlog::readTsc();
+        anchor_unix_us_ = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(traces_mutex_);
+        config_ = config;
+        while (traces_.size() > config_.max_traces) {
+            traces_.pop_front();
+        }
+    }
+
+    enabled_ = config.sample_every > 0 || config.slow_threshold.count() > 0;
+    Logger::info("Tracing " + std::string(enabled_ ? "enabled" : "disabled") +
+                 " (sample 1/" + std::to_string(config.sample_every) +
+                 ", slow threshold " + std::to_string(config.slow_threshold.count()) + " ms)");
+}
+
+int64_t Tracer::ticksToMicros(uint64_t ticks) const {
+    return static_cast<int64_t>(static_cast<double>(ticks) / ticks_per_us_);
+}
+
+void Tracer::beginRequest() {
+    tracing::ThreadRing& ring = tracing::threadRing();
+    if (!enabled()) {
+        ring.active = false;
+        return;
+    }
+
+    ring.active = true;
+    ring.depth = 0;
+    ring.trace_start = ring.head;
+    ring.request_start_tsc = binlog::readTsc();
+}
+
+void Tracer::endRequest(std::string_view name, int status) {
+    tracing::ThreadRing& ring = tracing::threadRing();
+    if (!ring.active) {
+        return;
+    }
+    ring.active = false;
+
+    uint64_t end_tsc = binlog::readTsc();
+    int64_t duration_us = ticksToMicros(end_tsc - ring.request_start_tsc);
+
+    // Tail-based decision: nothing leaves the ring unless the trace is kept
+    uint32_t sample_every = config_.sample_every;
+    bool sampled = sample_every > 0 && ring.requests++ % sample_every == 0;
+    bool slow = config_.slow_threshold.count() > 0 &&
+                duration_us >= std::chrono::duration_cast<std::chrono::microseconds>(config_.slow_threshold).count();
+    if (!sampled && !slow) {
+        return;
+    }
+
+    Trace trace;
+    trace.id = next_trace_id_.fetch_add(1, std::memory_order_relaxed);
+    trace.name = std::string(name);
+    trace.status = status;
+    trace.thread_id = ring.thread_id;
+    trace.start_unix_us = anchor_unix_us_ + ticksToMicros(ring.request_start_tsc - anchor_tsc_);
+    trace.duration_us = duration_us;
+    trace.slow = slow;
+
+    uint64_t first = ring.trace_start;
+    if (ring.head - first > tracing::RING_CAPACITY) {
+        first = ring.head - tracing::RING_CAPACITY;
+        trace.truncated = true;
+    }
+
+    trace.spans.reserve(static_cast<size_t>(ring.head - first));
+    for (uint64_t i = first; i < ring.head; i++) {
+        const tracing::SpanRecord& record = ring.spans[i & (tracing::RING_CAPACITY - 1)];
+        if (record.end_tsc == 0) {
+            continue;
+        }
+        trace.spans.push_back(Span{
+            record.category,
+            record.name,
+            ticksToMicros(record.start_tsc - ring.request_start_tsc),
+            ticksToMicros(record.end_tsc - record.start_tsc),
+            record.depth
+        });
+    }
+
+    std::lock_guard<std::mutex> lock(traces_mutex_);
+    traces_.push_back(std::move(trace));
+    while (traces_.size() > config_.max_traces) {
+        traces_.pop_front();
+    }
+}
+
+std::vector<Tracer::Trace> Tracer::select(std::optional<uint64_t> id, std::chrono::microseconds min_duration,
+                                          size_t limit) const {
+    std::vector<Trace> selected;
+    std::lock_guard<std::mutex> lock(traces_mutex_);
+
+    // Most recent first
+    for (auto it = traces_.rbegin(); it != traces_.rend() && selected.size() < limit; ++it) {
+        if (id && it->id != *id) {
+            continue;
+        }
+        if (it->duration_us < min_duration.count()) {
+            continue;
+        }
+        selected.push_back(*it);
+    }
+
+    return selected;
+}
+
+void Tracer::writeChromeTrace(JsonWriter& writer, const std::vector<Trace>& traces) {
+    std::set<uint32_t> threads;
+
+    writer.beginObject();
+    writer.key("traceEvents").beginArray();
+
+    for (const auto& trace : traces) {
+        threads.insert(trace.thread_id);
+
+        writer.beginObject()
+            .field("name", trace.name)
+            .field("cat", "http")
+            .field("ph", "X")
+            .field("ts", trace.start_unix_us)
+            .field("dur", trace.duration_us)
+            .field("pid", 1)
+            .field("tid", trace.thread_id);
+        writer.key("args").beginObject()
+            .field("trace_id", trace.id)
+            .field("status", trace.status)
+            .field("slow", trace.slow)
+            .field("truncated", trace.truncated)
+            .endObject();
+        writer.endObject();
+
+        for (const auto& span : trace.spans) {
+            writer.beginObject()
+                .field("name", span.name)
+                .field("cat", span.category)
+                .field("ph", "X")
+                .field("ts", trace.start_unix_us + span.start_us)
+                .field("dur", span.duration_us)
+                .field("pid", 1)
+                .field("tid", trace.thread_id);
+            writer.key("args").beginObject()
+                .field("trace_id", trace.id)
+                .field("depth", span.depth)
+                .endObject();
+            writer.endObject();
+        }
+    }
+
+    for (uint32_t thread : threads) {
+        writer.beginObject()
+            .field("name", "thread_name")
+            .field("ph", "M")
+            .field("pid", 1)
+            .field("tid", thread);
+        writer.key("args").beginObject()
+            .field("name", "worker-" + std::to_string(thread))
+            .endObject();
+        writer.endObject();
+    }
+
+    writer.endArray();
+    writer.field("displayTimeUnit", "ms");
+    writer.key("otherData").beginObject()
+        .field("service", "qmark-server")
+        .field("traces", traces.size())
+        .endObject();
+    writer.endObject();
+}
+
+} // namespace QMark
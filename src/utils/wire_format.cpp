@@ -0,0 +1,538 @@
+#include "utils/wire_format.hpp"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <optional>
+
+namespace QMark {
+
+namespace wire {
+
+namespace {
+
+struct MediaType {
+    std::string_view name;
+    WireFormat format;
+};
+
+// Wildcards resolve to JSON, the format every client understands
+const MediaType MEDIA_TYPES[] = {
+    {"application/json", WireFormat::JSON},
+    {"application/*", WireFormat::JSON},
+    {"*/*", WireFormat::JSON},
+    {"application/msgpack", WireFormat::MSGPACK},
+    {"application/x-msgpack", WireFormat::MSGPACK},
+    {"application/vnd.msgpack", WireFormat::MSGPACK},
+    {"application/cbor", WireFormat::CBOR}
+};
+
+std::string_view trim(std::string_view text) {
+    size_t start = text.find_first_not_of(" \t");
+    if (start == std::string_view::npos) {
+        return {};
+    }
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(start, end - start + 1);
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        char x = a[i] >= 'A' && a[i] <= 'Z' ? static_cast<char>(a[i] + 32) : a[i];
+        if (x != b[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const MediaType* findMediaType(std::string_view name) {
+    for (const auto& media : MEDIA_TYPES) {
+        if (equalsIgnoreCase(name, media.name)) {
+            return &media;
+        }
+    }
+    return nullptr;
+}
+
+// "0.5" -> 0.5; anything unparsable counts as 1 (RFC 9110 default)
+double parseQuality(std::string_view parameters) {
+    size_t pos = 0;
+    while (pos < parameters.size()) {
+        size_t end = parameters.find(';', pos);
+        std::string_view parameter = trim(parameters.substr(pos, end == std::string_view::npos ? end : end - pos));
+        if (parameter.size() > 2 && (parameter[0] == 'q' || parameter[0] == 'Q') && parameter[1] == '=') {
+            char* parse_end = nullptr;
+            std::string value(parameter.substr(2));
+            double quality = std::strtod(value.c_str(), &parse_end);
+            return parse_end != value.c_str() ? quality : 1.0;
+        }
+        if (end == std::string_view::npos) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return 1.0;
+}
+
+class Decoder {
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+    JsonWriter& writer_;
+    std::string& error_;
+    std::string scratch_;
+
+    bool fail(const std::string& message) {
+        error_ = message + " at offset " + std::to_string(pos_);
+        return false;
+    }
+
+    bool readByte(uint8_t& out) {
+        if (pos_ >= size_) {
+            return fail("unexpected end of input");
+        }
+        out = data_[pos_++];
+        return true;
+    }
+
+    bool readBigEndian(size_t bytes, uint64_t& out) {
+        if (size_ - pos_ < bytes) {
+            return fail("unexpected end of input");
+        }
+        out = 0;
+        for (size_t i = 0; i < bytes; i++) {
+            out = (out << 8) | data_[pos_++];
+        }
+        return true;
+    }
+
+    bool readBytes(uint64_t length, std::string_view& out) {
+        if (size_ - pos_ < length) {
+            return fail("unexpected end of input");
+        }
+        out = std::string_view(reinterpret_cast<const char*>(data_ + pos_), static_cast<size_t>(length));
+        pos_ += static_cast<size_t>(length);
+        return true;
+    }
+
+    bool writeFloat(uint64_t bits, size_t bytes) {
+        double number;
+        if (bytes == 4) {
+            uint32_t narrow_bits = static_cast<uint32_t>(bits);
+            float narrow;
+            std::memcpy(&narrow, &narrow_bits, sizeof(narrow));
+            number = narrow;
+        } else {
+            std::memcpy(&number, &bits, sizeof(number));
+        }
+        writer_.value(number);
+        return true;
+    }
+
+    // --- MessagePack ---
+
+    bool msgpackString(uint8_t marker, std::string_view& out) {
+        uint64_t length = 0;
+        if ((marker & 0xE0) == 0xA0) {
+            length = marker & 0x1F;
+        } else if (marker >= 0xD9 && marker <= 0xDB) {
+            if (!readBigEndian(size_t{1} << (marker - 0xD9), length)) {
+                return false;
+            }
+        } else {
+            return fail("map keys must be strings");
+        }
+        return readBytes(length, out);
+    }
+
+    bool msgpackContainer(bool object, uint64_t count, size_t depth) {
+        if (object) {
+            writer_.beginObject();
+        } else {
+            writer_.beginArray();
+        }
+
+        for (uint64_t i = 0; i < count; i++) {
+            if (object) {
+                uint8_t marker = 0;
+                std::string_view key;
+                if (!readByte(marker) || !msgpackString(marker, key)) {
+                    return false;
+                }
+                writer_.key(key);
+            }
+            if (!msgpackItem(depth + 1)) {
+                return false;
+            }
+        }
+
+        if (object) {
+            writer_.endObject();
+        } else {
+            writer_.endArray();
+        }
+        return true;
+    }
+
+    bool msgpackItem(size_t depth) {
+        if (depth >= JsonWriter::MAX_DEPTH) {
+            return fail("nesting too deep");
+        }
+
+        uint8_t marker = 0;
+        if (!readByte(marker)) {
+            return false;
+        }
+
+        uint64_t argument = 0;
+        std::string_view text;
+
+        if (marker <= 0x7F) {
+            writer_.value(static_cast<uint64_t>(marker));
+        } else if (marker <= 0x8F) {
+            return msgpackContainer(true, marker & 0x0F, depth);
+        } else if (marker <= 0x9F) {
+            return msgpackContainer(false, marker & 0x0F, depth);
+        } else if (marker <= 0xBF || (marker >= 0xD9 && marker <= 0xDB)) {
+            if (!msgpackString(marker, text)) {
+                return false;
+            }
+            writer_.value(text);
+        } else if (marker >= 0xE0) {
+            writer_.value(static_cast<int64_t>(static_cast<int8_t>(marker)));
+        } else {
+            switch (marker) {
+                case 0xC0:
+                    writer_.null();
+                    break;
+                case 0xC2:
+                case 0xC3:
+                    writer_.value(marker == 0xC3);
+                    break;
+                case 0xC4: case 0xC5: case 0xC6:
+                    return fail("binary data has no JSON representation");
+                case 0xC7: case 0xC8: case 0xC9:
+                case 0xD4: case 0xD5: case 0xD6: case 0xD7: case 0xD8:
+                    return fail("extension types are not supported");
+                case 0xCA:
+                case 0xCB: {
+                    size_t bytes = marker == 0xCA ? 4 : 8;
+                    return readBigEndian(bytes, argument) && writeFloat(argument, bytes);
+                }
+                case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+                    if (!readBigEndian(size_t{1} << (marker - 0xCC), argument)) {
+                        return false;
+                    }
+                    writer_.value(argument);
+                    break;
+                case 0xD0: case 0xD1: case 0xD2: case 0xD3: {
+                    size_t bytes = size_t{1} << (marker - 0xD0);
+                    if (!readBigEndian(bytes, argument)) {
+                        return false;
+                    }
+                    // Sign-extend from the encoded width
+                    unsigned shift = static_cast<unsigned>(64 - 8 * bytes);
+                    writer_.value(static_cast<int64_t>(argument << shift) >> shift);
+                    break;
+                }
+                case 0xDC: case 0xDD:
+                case 0xDE: case 0xDF: {
+                    bool object = marker >= 0xDE;
+                    if (!readBigEndian((marker & 1) ? 4 : 2, argument)) {
+                        return false;
+                    }
+                    return msgpackContainer(object, argument, depth);
+                }
+                default:
+                    return fail("invalid MessagePack marker");
+            }
+        }
+        return true;
+    }
+
+    // --- CBOR ---
+
+    static constexpr uint8_t INDEFINITE = 31;
+
+    // Argument of a head; an indefinite length (info 31) is left to the caller
+    // so that a full 64-bit argument is never mistaken for it
+    bool cborArgument(uint8_t info, uint64_t& out) {
+        if (info < 24) {
+            out = info;
+            return true;
+        }
+        if (info <= 27) {
+            return readBigEndian(size_t{1} << (info - 24), out);
+        }
+        if (info == INDEFINITE) {
+            out = 0;
+            return true;
+        }
+        return fail("reserved additional information");
+    }
+
+    bool atBreak() {
+        if (pos_ < size_ && data_[pos_] == 0xFF) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    // Text string, definite (view into the input) or chunked (copied into scratch_)
+    bool cborText(uint8_t initial, std::string_view& out) {
+        if ((initial >> 5) != 3) {
+            return fail("map keys must be text strings");
+        }
+
+        if ((initial & 0x1F) != INDEFINITE) {
+            uint64_t length = 0;
+            return cborArgument(initial & 0x1F, length) && readBytes(length, out);
+        }
+
+        scratch_.clear();
+        while (!atBreak()) {
+            uint8_t chunk_initial = 0;
+            std::string_view chunk;
+            if (!readByte(chunk_initial)) {
+                return false;
+            }
+            if ((chunk_initial >> 5) != 3 || (chunk_initial & 0x1F) == INDEFINITE) {
+                return fail("invalid text string chunk");
+            }
+            uint64_t chunk_length = 0;
+            if (!cborArgument(chunk_initial & 0x1F, chunk_length) || !readBytes(chunk_length, chunk)) {
+                return false;
+            }
+            scratch_.append(chunk);
+        }
+        out = scratch_;
+        return true;
+    }
+
+    bool cborContainer(bool object, bool indefinite, uint64_t count, size_t depth) {
+        if (object) {
+            writer_.beginObject();
+        } else {
+            writer_.beginArray();
+        }
+
+        for (uint64_t i = 0; indefinite ? !atBreak() : i < count; i++) {
+            if (object) {
+                uint8_t initial = 0;
+                std::string_view key;
+                if (!readByte(initial) || !cborText(initial, key)) {
+                    return false;
+                }
+                writer_.key(key);
+            }
+            if (!cborItem(depth + 1)) {
+                return false;
+            }
+        }
+
+        if (object) {
+            writer_.endObject();
+        } else {
+            writer_.endArray();
+        }
+        return true;
+    }
+
+    bool cborSimple(uint8_t info) {
+        uint64_t bits = 0;
+        switch (info) {
+            case 20:
+            case 21:
+                writer_.value(info == 21);
+                return true;
+            case 22:
+            case 23:
+                writer_.null();         // null, undefined
+                return true;
+            case 25: {
+                if (!readBigEndian(2, bits)) {
+                    return false;
+                }
+                // IEEE 754 half precision
+                int exponent = static_cast<int>((bits >> 10) & 0x1F);
+                double mantissa = static_cast<double>(bits & 0x3FF);
+                double number;
+                if (exponent == 0) {
+                    number = std::ldexp(mantissa, -24);
+                } else if (exponent != 31) {
+                    number = std::ldexp(mantissa + 1024, exponent - 25);
+                } else {
+                    number = mantissa == 0 ? std::numeric_limits<double>::infinity()
+                                           : std::numeric_limits<double>::quiet_NaN();
+                }
+                writer_.value((bits & 0x8000) ? -number : number);
+                return true;
+            }
+            case 26:
+            case 27: {
+                size_t bytes = info == 26 ? 4 : 8;
+                return readBigEndian(bytes, bits) && writeFloat(bits, bytes);
+            }
+            case 31:
+                return fail("unexpected break");
+            default:
+                return fail("unsupported simple value");
+        }
+    }
+
+    bool cborItem(size_t depth) {
+        if (depth >= JsonWriter::MAX_DEPTH) {
+            return fail("nesting too deep");
+        }
+
+        uint8_t initial = 0;
+        if (!readByte(initial)) {
+            return false;
+        }
+
+        uint8_t major = initial >> 5;
+        uint8_t info = initial & 0x1F;
+
+        if (major == 7) {
+            return cborSimple(info);
+        }
+        if (major == 3) {
+            std::string_view text;
+            if (!cborText(initial, text)) {
+                return false;
+            }
+            writer_.value(text);
+            return true;
+        }
+
+        uint64_t argument = 0;
+        if (!cborArgument(info, argument)) {
+            return false;
+        }
+        bool indefinite = info == INDEFINITE;
+        if (indefinite && major != 4 && major != 5) {
+            return fail("indefinite length not allowed here");
+        }
+
+        switch (major) {
+            case 0:
+                writer_.value(argument);
+                return true;
+            case 1:
+                if (argument > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+                    return fail("negative integer out of range");
+                }
+                writer_.value(-1 - static_cast<int64_t>(argument));
+                return true;
+            case 2:
+                return fail("binary data has no JSON representation");
+            case 4:
+            case 5:
+                return cborContainer(major == 5, indefinite, argument, depth);
+            default:
+                // Tags (major 6) only add semantics: decode the tagged item
+                return cborItem(depth + 1);
+        }
+    }
+
+public:
+    Decoder(std::string_view input, JsonWriter& writer, std::string& error)
+        : data_(reinterpret_cast<const uint8_t*>(input.data())), size_(input.size()),
+          writer_(writer), error_(error) {}
+
+    bool run(WireFormat format) {
+        bool ok = format == WireFormat::CBOR ? cborItem(0) : msgpackItem(0);
+        if (ok && pos_ != size_) {
+            return fail("trailing bytes");
+        }
+        return ok;
+    }
+};
+
+} // namespace
+
+const char* contentType(WireFormat format) {
+    switch (format) {
+        case WireFormat::MSGPACK: return "application/msgpack";
+        case WireFormat::CBOR: return "application/cbor";
+        default: return "application/json";
+    }
+}
+
+const char* formatName(WireFormat format) {
+    switch (format) {
+        case WireFormat::MSGPACK: return "MessagePack";
+        case WireFormat::CBOR: return "CBOR";
+        default: return "JSON";
+    }
+}
+
+WireFormat negotiate(std::string_view accept) {
+    WireFormat best = WireFormat::JSON;
+    double best_quality = 0.0;
+
+    size_t pos = 0;
+    while (pos < accept.size()) {
+        size_t end = accept.find(',', pos);
+        std::string_view range = accept.substr(pos, end == std::string_view::npos ? end : end - pos);
+        pos = end == std::string_view::npos ? accept.size() : end + 1;
+
+        size_t semicolon = range.find(';');
+        const MediaType* media = findMediaType(trim(range.substr(0, semicolon)));
+        if (!media) {
+            continue;
+        }
+
+        // Strictly better only: on ties the earlier range wins
+        double quality = semicolon == std::string_view::npos ? 1.0 : parseQuality(range.substr(semicolon + 1));
+        if (quality > best_quality) {
+            best_quality = quality;
+            best = media->format;
+        }
+    }
+    return best;
+}
+
+bool acceptsEncoding(std::string_view accept_encoding, std::string_view coding) {
+    // The coding's own entry wins over "*"; q=0 refuses it
+    std::optional<bool> wildcard;
+    size_t pos = 0;
+    while (pos < accept_encoding.size()) {
+        size_t end = accept_encoding.find(',', pos);
+        std::string_view item = accept_encoding.substr(pos, end == std::string_view::npos ? end : end - pos);
+        pos = end == std::string_view::npos ? accept_encoding.size() : end + 1;
+
+        size_t semicolon = item.find(';');
+        std::string_view name = trim(item.substr(0, semicolon));
+        bool accepted = semicolon == std::string_view::npos || parseQuality(item.substr(semicolon + 1)) > 0.0;
+        if (equalsIgnoreCase(name, coding)) {
+            return accepted;
+        }
+        if (name == "*") {
+            wildcard = accepted;
+        }
+    }
+    return wildcard.value_or(false);
+}
+
+WireFormat fromContentType(std::string_view content_type) {
+    const MediaType* media = findMediaType(trim(content_type.substr(0, content_type.find(';'))));
+    return media ? media->format : WireFormat::JSON;
+}
+
+bool transcode(WireFormat from, std::string_view input, JsonWriter& writer, std::string& error) {
+    if (from == WireFormat::JSON) {
+        error = "input is already JSON";
+        return false;
+    }
+    return Decoder(input, writer, error).run(from);
+}
+
+} // namespace wire
+
+} // namespace QMark
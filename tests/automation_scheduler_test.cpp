@@ -0,0 +1,243 @@
+#include "test.hpp"
+#include "automation/automation_scheduler.hpp"
+#include "database/database_manager.hpp"
+#include <algorithm>
+#include <map>
+
+using namespace QMark;
+
+namespace {
+
+constexpr int64_t START_MS = int64_t{1716480000} * 1000;
+constexpr int64_t MINUTE_MS = 60 * 1000;
+
+// Due `offset_ms` after START_MS, then every minute
+qmark::Automation makeAutomation(qmark::AutomationId id, qmark::UserId user_id, int64_t offset_ms) {
+    qmark::Automation automation;
+    automation.id = id;
+    automation.user_id = user_id;
+    automation.name = "Relance #" + std::to_string(id);
+    automation.type = "sequence";
+    automation.config = "{\"interval_seconds\":60}";
+    automation.last_run = qmark::Timestamp(std::chrono::milliseconds(START_MS - MINUTE_MS + offset_ms));
+    return automation;
+}
+
+AutomationSchedulerConfig simulatedConfig(std::vector<AutomationRunRecord>& persisted) {
+    AutomationSchedulerConfig config;
+    config.simulated_clock = true;
+    config.simulated_start_ms = START_MS;
+    config.load_from_database = false;
+    config.persist_runs = [&persisted](const std::vector<AutomationRunRecord>& runs) {
+        persisted.insert(persisted.end(), runs.begin(), runs.end());
+        return true;
+    };
+    return config;
+}
+
+// Runs the automations up to `until_ms` and returns the ids in dispatch order
+std::vector<qmark::AutomationId> dispatchOrder(const AutomationSchedulerConfig& config,
+                                               const std::vector<qmark::Automation>& automations, int64_t until_ms) {
+    std::vector<qmark::AutomationId> order;
+
+    auto& scheduler = AutomationScheduler::getInstance();
+    scheduler.start(config);
+    scheduler.registerHandler("sequence", [&](const qmark::Automation& automation, std::string&) {
+        order.push_back(automation.id);
+        return true;
+    });
+    for (const auto& automation : automations) {
+        scheduler.upsert(automation);
+    }
+    scheduler.advanceTo(until_ms);
+    scheduler.stop();
+    return order;
+}
+
+std::string join(const std::vector<qmark::AutomationId>& ids) {
+    std::string out;
+    for (qmark::AutomationId id : ids) {
+        if (!out.empty()) {
+            out += ',';
+        }
+        out += std::to_string(id);
+    }
+    return out;
+}
+
+} // namespace
+
+// Due time first, then id; the same inputs always give the same sequence
+QMARK_TEST(automation_scheduler_dispatch_order) {
+    std::vector<AutomationRunRecord> persisted;
+    AutomationSchedulerConfig config = simulatedConfig(persisted);
+
+    // Upserted out of order, two of them sharing a tick
+    std::vector<qmark::Automation> automations = {
+        makeAutomation(1, 10, 3000),
+        makeAutomation(9, 11, 2000),
+        makeAutomation(5, 12, 1000),
+        makeAutomation(3, 13, 2000),
+    };
+
+    auto order = dispatchOrder(config, automations, START_MS + 2 * MINUTE_MS + 5000);
+    CHECK_EQ(join(order), std::string("5,3,9,1,5,3,9,1,5,3,9,1"));
+
+    std::reverse(automations.begin(), automations.end());
+    CHECK_EQ(join(dispatchOrder(config, automations, START_MS + 2 * MINUTE_MS + 5000)), join(order));
+
+    // Nothing is due before the first slot
+    CHECK(dispatchOrder(config, automations, START_MS + 500).empty());
+}
+
+// A user's runs beyond the cap wait for one of theirs to finish; other users are not held up
+QMARK_TEST(automation_scheduler_per_user_cap) {
+    std::vector<AutomationRunRecord> persisted;
+    AutomationSchedulerConfig config = simulatedConfig(persisted);
+
+    std::vector<qmark::Automation> automations = {
+        makeAutomation(1, 10, 1000),
+        makeAutomation(2, 10, 1000),
+        makeAutomation(3, 10, 1000),
+        makeAutomation(4, 20, 1000),
+    };
+
+    config.per_user_concurrency = 1;
+    CHECK_EQ(join(dispatchOrder(config, automations, START_MS + 1000)), std::string("1,4,2,3"));
+
+    config.per_user_concurrency = 2;
+    CHECK_EQ(join(dispatchOrder(config, automations, START_MS + 1000)), std::string("1,2,4,3"));
+
+    // The cap delays runs but never drops them
+    config.per_user_concurrency = 1;
+    CHECK_EQ(dispatchOrder(config, automations, START_MS + 1000).size(), size_t{4});
+}
+
+// Due runs that find the queue full move to the next tick instead of being lost
+QMARK_TEST(automation_scheduler_deferral) {
+    std::vector<AutomationRunRecord> persisted;
+    AutomationSchedulerConfig config = simulatedConfig(persisted);
+    config.queue_capacity = 2;
+
+    auto& scheduler = AutomationScheduler::getInstance();
+    uint64_t deferred_before = scheduler.stats().deferred;
+
+    std::vector<qmark::Automation> automations = {
+        makeAutomation(1, 10, 1000),
+        makeAutomation(2, 20, 1000),
+        makeAutomation(3, 30, 1000),
+    };
+
+    CHECK_EQ(join(dispatchOrder(config, automations, START_MS + 1000)), std::string("1,2"));
+    CHECK_EQ(scheduler.stats().deferred - deferred_before, uint64_t{1});
+
+    persisted.clear();
+    CHECK_EQ(join(dispatchOrder(config, automations, START_MS + 2000)), std::string("1,2,3"));
+
+    std::map<qmark::AutomationId, int64_t> finished;
+    for (const auto& run : persisted) {
+        finished[run.automation_id] = run.finished_at;
+    }
+    CHECK_EQ(finished[1], (START_MS + 1000) / 1000);
+    CHECK_EQ(finished[2], (START_MS + 1000) / 1000);
+    CHECK_EQ(finished[3], (START_MS + 2000) / 1000);
+}
+
+// Runs reach SQLite in batches; last_run/run_count come out as if written one by one
+QMARK_TEST(automation_scheduler_batched_writes) {
+    auto& db = DatabaseManager::getInstance();
+    CHECK(db.init(test::scratchDirectory("automation_scheduler") + "/qmark.db"));
+    CHECK(db.execute("INSERT INTO users (id, username, email, password_hash) VALUES (1, 'ana', 'ana@example.com', 'x');"));
+
+    std::vector<qmark::AutomationId> ids;
+    for (int64_t offset : {1000, 2000, 3000}) {
+        qmark::Automation automation = makeAutomation(0, 1, offset);
+        CHECK(db.saveAutomation(automation));
+        ids.push_back(automation.id);
+    }
+
+    std::vector<size_t> batches;
+    std::map<qmark::AutomationId, int64_t> last_finished;
+
+    AutomationSchedulerConfig config;
+    config.simulated_clock = true;
+    config.simulated_start_ms = START_MS;
+    config.flush_batch_size = 4;
+    config.flush_interval = std::chrono::minutes(10);
+    config.persist_runs = [&](const std::vector<AutomationRunRecord>& runs) {
+        batches.push_back(runs.size());
+        for (const auto& run : runs) {
+            last_finished[run.automation_id] = std::max(last_finished[run.automation_id], run.finished_at);
+        }
+        return DatabaseManager::getInstance().recordAutomationRuns(runs);
+    };
+
+    auto& scheduler = AutomationScheduler::getInstance();
+    scheduler.start(config);
+    scheduler.registerHandler("sequence", [](const qmark::Automation&, std::string&) { return true; });
+    CHECK_EQ(scheduler.stats().scheduled, size_t{3});
+
+    // Nine runs on nine ticks: a batch goes out every fourth run
+    CHECK_EQ(scheduler.advanceTo(START_MS + 2 * MINUTE_MS + 5000), size_t{9});
+    CHECK_EQ(batches, (std::vector<size_t>{4, 4}));
+
+    // The remainder goes out on stop, before the flush interval
+    scheduler.stop();
+    CHECK_EQ(batches, (std::vector<size_t>{4, 4, 1}));
+
+    for (size_t i = 0; i < ids.size(); i++) {
+        qmark::AutomationId id = ids[i];
+        auto rows = db.query("SELECT last_run, run_count FROM automations WHERE id = " + std::to_string(id) + ";");
+        CHECK_EQ(rows.size(), size_t{1});
+        if (rows.size() == 1) {
+            CHECK_EQ(rows[0].at("run_count"), std::string("3"));
+            CHECK_EQ(rows[0].at("last_run"), std::to_string(last_finished[id]));
+            CHECK_EQ(last_finished[id], (START_MS + static_cast<int64_t>(i + 1) * 1000 + 2 * MINUTE_MS) / 1000);
+        }
+    }
+
+    auto activities = db.query("SELECT COUNT(*) AS count FROM activities WHERE user_id = 1;");
+    CHECK_EQ(activities.empty() ? std::string() : activities[0].at("count"), std::string("9"));
+}
+
+// Due times on a wheel level boundary run on that tick, not the next one
+QMARK_TEST(automation_scheduler_wheel_boundary) {
+    std::vector<AutomationRunRecord> persisted;
+    AutomationSchedulerConfig config = simulatedConfig(persisted);
+    config.simulated_start_ms = 0;
+
+    // Ticks count from zero: due on tick 64 and tick 4096
+    std::vector<qmark::Automation> automations = {
+        makeAutomation(1, 10, 64 * 1000 - START_MS),
+        makeAutomation(2, 20, 4096 * 1000 - START_MS),
+    };
+
+    auto& scheduler = AutomationScheduler::getInstance();
+    std::vector<qmark::AutomationId> order;
+    scheduler.start(config);
+    scheduler.registerHandler("sequence", [&](const qmark::Automation& automation, std::string&) {
+        order.push_back(automation.id);
+        return true;
+    });
+    for (const auto& automation : automations) {
+        scheduler.upsert(automation);
+    }
+
+    CHECK_EQ(scheduler.advanceTo(63 * 1000), size_t{0});
+    CHECK_EQ(scheduler.advanceTo(64 * 1000), size_t{1});
+    CHECK_EQ(join(order), std::string("1"));
+
+    // Automation 1 keeps its minute cadence meanwhile; 2 waits for tick 4096
+    scheduler.advanceTo(4095 * 1000);
+    CHECK(std::find(order.begin(), order.end(), 2) == order.end());
+    scheduler.advanceTo(4096 * 1000);
+    CHECK(!order.empty() && order.back() == 2);
+    scheduler.stop();
+
+    std::map<qmark::AutomationId, std::vector<int64_t>> finished;
+    for (const auto& run : persisted) {
+        finished[run.automation_id].push_back(run.finished_at);
+    }
+    CHECK(!finished[1].empty() && finished[1].front() == 64);
+    CHECK_EQ(finished[2], (std::vector<int64_t>{4096}));
+}
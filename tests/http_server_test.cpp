@@ -0,0 +1,417 @@
+#include "test.hpp"
+#include "server/http_server.hpp"
+#include "server/tls_context.hpp"
+#include <httplib.h>
+#include <netinet/in.h>
+#include <openssl/ocsp.h>
+#include <openssl/pem.h>
+#include <openssl/x509v3.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+
+using namespace QMark;
+
+namespace {
+
+// Spans several sendfile calls (256 KiB each) and ends off any block boundary
+constexpr size_t BIG_FILE_SIZE = 1024 * 1024 + 12345;
+
+int freePort() {
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    ::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    socklen_t length = sizeof(address);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length);
+    ::close(fd);
+    return ntohs(address.sin_port);
+}
+
+void writeFile(const std::string& path, const std::string& content) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+// The server resolves ./public against the working directory: a scratch tree
+// with one large binary file and one small text file
+class StaticTree {
+private:
+    std::filesystem::path previous_;
+
+public:
+    std::string big;
+    std::string small = "hello from /static\n";
+
+    explicit StaticTree(const std::string& name) : previous_(std::filesystem::current_path()) {
+        std::string root = test::scratchDirectory(name);
+        std::filesystem::create_directories(root + "/public/docs");
+
+        std::mt19937 random(48);
+        big.resize(BIG_FILE_SIZE);
+        for (auto& byte : big) {
+            byte = static_cast<char>(random());
+        }
+        writeFile(root + "/public/big.bin", big);
+        writeFile(root + "/public/docs/index.html", small);
+        std::filesystem::current_path(root);
+    }
+
+    ~StaticTree() {
+        std::filesystem::current_path(previous_);
+    }
+};
+
+// Content-Range and data of each part of a multipart/byteranges body
+std::vector<std::pair<std::string, std::string>> byteRangeParts(const std::string& content_type,
+                                                                  const std::string& body) {
+    std::vector<std::pair<std::string, std::string>> parts;
+    size_t boundary_at = content_type.find("boundary=");
+    if (boundary_at == std::string::npos) {
+        return parts;
+    }
+    std::string delimiter = "--" + content_type.substr(boundary_at + 9);
+
+    size_t pos = 0;
+    while (body.compare(pos, delimiter.size() + 2, delimiter + "\r\n") == 0) {
+        size_t head_end = body.find("\r\n\r\n", pos);
+        std::string head = body.substr(pos, head_end - pos);
+        size_t range_at = head.find("Content-Range: ");
+        if (head_end == std::string::npos || range_at == std::string::npos) {
+            break;
+        }
+        std::string range = head.substr(range_at + 15, head.find("\r\n", range_at) - range_at - 15);
+
+        size_t first = 0;
+        size_t last = 0;
+        if (std::sscanf(range.c_str(), "bytes %zu-%zu/", &first, &last) != 2) {
+            break;
+        }
+        parts.emplace_back(range, body.substr(head_end + 4, last - first + 1));
+        pos = head_end + 4 + (last - first + 1);
+        if (body.compare(pos, 2, "\r\n") != 0) {
+            break;
+        }
+        pos += 2;
+    }
+    // Closing delimiter, with or without a final CRLF (httplib sends none)
+    std::string rest = body.substr(pos);
+    if (rest != delimiter + "--" && rest != delimiter + "--\r\n") {
+        parts.clear();
+    }
+    return parts;
+}
+
+// --- Certificates and OCSP responses generated for the stapling tests ---
+
+using KeyPtr = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+using CertificatePtr = std::unique_ptr<X509, decltype(&X509_free)>;
+
+KeyPtr makeKey() {
+    return KeyPtr(EVP_EC_gen("P-256"), EVP_PKEY_free);
+}
+
+// Self-signed when issuer is null
+CertificatePtr makeCertificate(const char* name, EVP_PKEY* key, X509* issuer, EVP_PKEY* issuer_key, long serial) {
+    CertificatePtr certificate(X509_new(), X509_free);
+    X509* cert = certificate.get();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), serial);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -3600);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 86400);
+    X509_NAME_add_entry_by_txt(X509_get_subject_name(cert), "CN", MBSTRING_ASC,
+                               reinterpret_cast<const unsigned char*>(name), -1, -1, 0);
+    X509_set_issuer_name(cert, issuer ? X509_get_subject_name(issuer) : X509_get_subject_name(cert));
+    X509_set_pubkey(cert, key);
+
+    X509V3_CTX context;
+    X509V3_set_ctx_nodb(&context);
+    X509V3_set_ctx(&context, issuer ? issuer : cert, cert, nullptr, nullptr, 0);
+    X509_EXTENSION* constraints = X509V3_EXT_conf_nid(nullptr, &context, NID_basic_constraints,
+                                                      issuer ? "critical,CA:FALSE" : "critical,CA:TRUE");
+    X509_add_ext(cert, constraints, -1);
+    X509_EXTENSION_free(constraints);
+
+    X509_sign(cert, issuer_key ? issuer_key : key, EVP_sha256());
+    return certificate;
+}
+
+// DER OCSP response for `leaf`, signed by `signer`, valid from
+// now + this_update to now + next_update (seconds)
+std::string makeOcspResponse(X509* leaf, X509* issuer, X509* signer, EVP_PKEY* signer_key, int status,
+                             long this_update = -60, long next_update = 3600) {
+    OCSP_BASICRESP* basic = OCSP_BASICRESP_new();
+    OCSP_CERTID* id = OCSP_cert_to_id(EVP_sha1(), leaf, issuer);
+    ASN1_TIME* this_time = X509_gmtime_adj(nullptr, this_update);
+    ASN1_TIME* next_time = X509_gmtime_adj(nullptr, next_update);
+    ASN1_TIME* revoked_time = status == V_OCSP_CERTSTATUS_REVOKED ? X509_gmtime_adj(nullptr, -7200) : nullptr;
+
+    OCSP_basic_add1_status(basic, id, status, OCSP_REVOKED_STATUS_KEYCOMPROMISE, revoked_time, this_time, next_time);
+    OCSP_basic_sign(basic, signer, signer_key, EVP_sha256(), nullptr, 0);
+    OCSP_RESPONSE* response = OCSP_response_create(OCSP_RESPONSE_STATUS_SUCCESSFUL, basic);
+
+    unsigned char* der = nullptr;
+    int length = i2d_OCSP_RESPONSE(response, &der);
+    std::string out(reinterpret_cast<char*>(der), static_cast<size_t>(std::max(length, 0)));
+
+    OPENSSL_free(der);
+    OCSP_RESPONSE_free(response);
+    ASN1_TIME_free(revoked_time);
+    ASN1_TIME_free(next_time);
+    ASN1_TIME_free(this_time);
+    OCSP_CERTID_free(id);
+    OCSP_BASICRESP_free(basic);
+    return out;
+}
+
+// A CA, a leaf it issued (chain file: leaf then CA) and the leaf's key on disk
+struct Pki {
+    KeyPtr ca_key = makeKey();
+    CertificatePtr ca = makeCertificate("qmark test CA", ca_key.get(), nullptr, nullptr, 1);
+    KeyPtr leaf_key = makeKey();
+    CertificatePtr leaf = makeCertificate("localhost", leaf_key.get(), ca.get(), ca_key.get(), 2);
+    std::string cert_path;
+    std::string key_path;
+
+    explicit Pki(const std::string& directory)
+        : cert_path(directory + "/chain.pem"), key_path(directory + "/key.pem") {
+        BIO* chain = BIO_new_file(cert_path.c_str(), "w");
+        PEM_write_bio_X509(chain, leaf.get());
+        PEM_write_bio_X509(chain, ca.get());
+        BIO_free(chain);
+
+        BIO* key = BIO_new_file(key_path.c_str(), "w");
+        PEM_write_bio_PrivateKey(key, leaf_key.get(), nullptr, nullptr, 0, nullptr, nullptr);
+        BIO_free(key);
+    }
+
+    TlsConfig config(const std::string& ocsp_path) const {
+        TlsConfig config;
+        config.cert_path = cert_path;
+        config.key_path = key_path;
+        config.ocsp_response_path = ocsp_path;
+        return config;
+    }
+};
+
+struct TlsExchange {
+    bool connected = false;
+    std::string stapled;        // OCSP response the server sent, empty if none
+    std::string response;       // raw HTTP response
+};
+
+// One request over a fresh TLS connection that asks for certificate status
+TlsExchange tlsRequest(int port, const std::string& request) {
+    TlsExchange exchange;
+    int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        ::close(fd);
+        return exchange;
+    }
+
+    SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+    SSL* ssl = SSL_new(context);
+    SSL_set_fd(ssl, fd);
+    SSL_set_tlsext_host_name(ssl, "localhost");
+    SSL_set_tlsext_status_type(ssl, TLSEXT_STATUSTYPE_ocsp);
+
+    if (SSL_connect(ssl) == 1) {
+        exchange.connected = true;
+        const unsigned char* der = nullptr;
+        long length = SSL_get_tlsext_status_ocsp_resp(ssl, &der);
+        if (der && length > 0) {
+            exchange.stapled.assign(reinterpret_cast<const char*>(der), static_cast<size_t>(length));
+        }
+
+        SSL_write(ssl, request.data(), static_cast<int>(request.size()));
+        char buffer[64 * 1024];
+        int got;
+        while ((got = SSL_read(ssl, buffer, sizeof(buffer))) > 0) {
+            exchange.response.append(buffer, static_cast<size_t>(got));
+        }
+    }
+
+    SSL_free(ssl);
+    SSL_CTX_free(context);
+    ::close(fd);
+    return exchange;
+}
+
+} // namespace
+
+// Static files leave through sendfile on plain HTTP: whole, single and
+// multiple ranges, byte for byte, on one kept-alive connection
+QMARK_TEST(http_server_static_sendfile) {
+    StaticTree tree("http_server_static_sendfile");
+    const std::string& big = tree.big;
+
+    HttpServer server;
+    server.setupRoutes();
+    int port = freePort();
+    CHECK(server.start("127.0.0.1", port));
+
+    httplib::Client client("127.0.0.1", port);
+    client.set_keep_alive(true);
+
+    auto whole = client.Get("/static/big.bin");
+    CHECK(whole && whole->status == 200);
+    if (whole) {
+        CHECK_EQ(whole->get_header_value("Content-Type"), std::string("application/octet-stream"));
+        CHECK_EQ(whole->body.size(), big.size());
+        CHECK(whole->body == big);
+    }
+
+    // One range across sendfile chunks, then open-ended and suffix ranges
+    const std::vector<std::tuple<std::string, size_t, size_t>> single = {
+        {"bytes=262000-600000", 262000, 600000},
+        {"bytes=5-5", 5, 5},
+        {"bytes=1000000-", 1000000, BIG_FILE_SIZE - 1},
+        {"bytes=-1000", BIG_FILE_SIZE - 1000, BIG_FILE_SIZE - 1}
+    };
+    for (const auto& [range, first, last] : single) {
+        auto res = client.Get("/static/big.bin", {{"Range", range}});
+        CHECK(res && res->status == 206);
+        if (!res) {
+            continue;
+        }
+        CHECK_EQ(res->get_header_value("Content-Range"), "bytes " + std::to_string(first) + "-" +
+                 std::to_string(last) + "/" + std::to_string(BIG_FILE_SIZE));
+        CHECK(res->body == big.substr(first, last - first + 1));
+    }
+
+    // Boundaries and part headers are written between sendfile calls: each
+    // part's bytes must land right after its own header
+    auto multi = client.Get("/static/big.bin", {{"Range", "bytes=0-99,262100-262200,300000-900000,-10"}});
+    CHECK(multi && multi->status == 206);
+    if (multi) {
+        auto parts = byteRangeParts(multi->get_header_value("Content-Type"), multi->body);
+        const std::vector<std::pair<size_t, size_t>> expected = {
+            {0, 99}, {262100, 262200}, {300000, 900000}, {BIG_FILE_SIZE - 10, BIG_FILE_SIZE - 1}
+        };
+        CHECK_EQ(parts.size(), expected.size());
+        for (size_t i = 0; i < std::min(parts.size(), expected.size()); i++) {
+            auto [first, last] = expected[i];
+            CHECK_EQ(parts[i].first, "bytes " + std::to_string(first) + "-" + std::to_string(last) + "/" +
+                     std::to_string(BIG_FILE_SIZE));
+            CHECK(parts[i].second == big.substr(first, last - first + 1));
+        }
+    }
+
+    // Nothing sent ahead leaks into the next response on the connection
+    auto index = client.Get("/static/docs/");
+    CHECK(index && index->status == 200);
+    if (index) {
+        CHECK_EQ(index->body, tree.small);
+        CHECK_EQ(index->get_header_value("Content-Type"), std::string("text/html"));
+    }
+
+    auto redirect = client.Get("/static/docs");
+    CHECK(redirect && redirect->status == 301);
+    auto unsatisfiable = client.Get("/static/big.bin", {{"Range", "bytes=" + std::to_string(BIG_FILE_SIZE) + "-"}});
+    CHECK(unsatisfiable && unsatisfiable->status == 416);
+    auto missing = client.Get("/static/missing.bin");
+    CHECK(missing && missing->status == 404);
+    auto escaping = client.Get("/static/../CMakeLists.txt");
+    CHECK(escaping && escaping->status == 404);
+
+    server.stop();
+}
+
+// Only a current GOOD response for the loaded leaf, signed by its issuer, is kept
+QMARK_TEST(http_server_ocsp_checks) {
+    std::string directory = test::scratchDirectory("http_server_ocsp_checks");
+    Pki pki(directory);
+    std::string ocsp_path = directory + "/ocsp.der";
+
+    KeyPtr other_key = makeKey();
+    CertificatePtr other_leaf = makeCertificate("other", other_key.get(), pki.ca.get(), pki.ca_key.get(), 3);
+    KeyPtr rogue_key = makeKey();
+    CertificatePtr rogue_ca = makeCertificate("qmark test CA", rogue_key.get(), nullptr, nullptr, 1);
+
+    auto loaded = [&](const std::string& der) {
+        writeFile(ocsp_path, der);
+        TlsContext tls;
+        return tls.init(pki.config(ocsp_path)) && tls.stats().ocsp_loaded;
+    };
+
+    CHECK(loaded(makeOcspResponse(pki.leaf.get(), pki.ca.get(), pki.ca.get(), pki.ca_key.get(),
+                                  V_OCSP_CERTSTATUS_GOOD)));
+    // Revoked, unknown, for another certificate, signed by a stranger, expired
+    CHECK(!loaded(makeOcspResponse(pki.leaf.get(), pki.ca.get(), pki.ca.get(), pki.ca_key.get(),
+                                   V_OCSP_CERTSTATUS_REVOKED)));
+    CHECK(!loaded(makeOcspResponse(pki.leaf.get(), pki.ca.get(), pki.ca.get(), pki.ca_key.get(),
+                                   V_OCSP_CERTSTATUS_UNKNOWN)));
+    CHECK(!loaded(makeOcspResponse(other_leaf.get(), pki.ca.get(), pki.ca.get(), pki.ca_key.get(),
+                                   V_OCSP_CERTSTATUS_GOOD)));
+    CHECK(!loaded(makeOcspResponse(pki.leaf.get(), pki.ca.get(), rogue_ca.get(), rogue_key.get(),
+                                   V_OCSP_CERTSTATUS_GOOD)));
+    CHECK(!loaded(makeOcspResponse(pki.leaf.get(), pki.ca.get(), pki.ca.get(), pki.ca_key.get(),
+                                   V_OCSP_CERTSTATUS_GOOD, -7200, -3600)));
+    CHECK(!loaded("not an OCSP response"));
+
+    // A missing file only disables stapling
+    std::filesystem::remove(ocsp_path);
+    TlsContext tls;
+    CHECK(tls.init(pki.config(ocsp_path)));
+    CHECK(!tls.stats().ocsp_loaded);
+}
+
+// The server staples the response file in the handshake and serves static
+// files over TLS (SSL_sendfile under kTLS, user-space copies otherwise)
+QMARK_TEST(http_server_ocsp_stapling) {
+    StaticTree tree("http_server_ocsp_stapling");
+    std::string directory = std::filesystem::current_path().string();
+    Pki pki(directory);
+    std::string ocsp_path = directory + "/ocsp.der";
+    std::string ocsp = makeOcspResponse(pki.leaf.get(), pki.ca.get(), pki.ca.get(), pki.ca_key.get(),
+                                        V_OCSP_CERTSTATUS_GOOD);
+    writeFile(ocsp_path, ocsp);
+    CHECK(!ocsp.empty() && readFile(ocsp_path) == ocsp);
+
+    HttpServer server;
+    CHECK(server.enableTls(pki.config(ocsp_path)));
+    server.setupRoutes();
+    int port = freePort();
+    CHECK(server.start("127.0.0.1", port));
+
+    TlsExchange exchange = tlsRequest(port, "GET /static/big.bin HTTP/1.1\r\nHost: localhost\r\n"
+                                            "Range: bytes=100-300000\r\nConnection: close\r\n\r\n");
+    CHECK(exchange.connected);
+    CHECK(exchange.stapled == ocsp);
+
+    size_t head_end = exchange.response.find("\r\n\r\n");
+    CHECK(exchange.response.starts_with("HTTP/1.1 206"));
+    CHECK(head_end != std::string::npos &&
+          exchange.response.substr(head_end + 4) == tree.big.substr(100, 300000 - 100 + 1));
+
+    // Without a usable response the handshake simply carries no status
+    writeFile(ocsp_path, makeOcspResponse(pki.leaf.get(), pki.ca.get(), pki.ca.get(), pki.ca_key.get(),
+                                          V_OCSP_CERTSTATUS_REVOKED));
+    HttpServer unstapled;
+    CHECK(unstapled.enableTls(pki.config(ocsp_path)));
+    unstapled.setupRoutes();
+    int unstapled_port = freePort();
+    CHECK(unstapled.start("127.0.0.1", unstapled_port));
+    TlsExchange plain = tlsRequest(unstapled_port, "GET /static/docs/ HTTP/1.1\r\nHost: localhost\r\n"
+                                                   "Connection: close\r\n\r\n");
+    CHECK(plain.connected);
+    CHECK(plain.stapled.empty());
+    CHECK(plain.response.ends_with("\r\n\r\n" + tree.small));
+
+    unstapled.stop();
+    server.stop();
+}
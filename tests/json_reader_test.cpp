@@ -0,0 +1,303 @@
+#include "test.hpp"
+#include "utils/json_reader.hpp"
+#include "utils/json_schema.hpp"
+#include <random>
+
+using namespace QMark;
+
+namespace {
+
+std::string parseError(std::string_view input) {
+    JsonReader reader;
+    if (reader.parse(input)) {
+        return "";
+    }
+    return reader.error();
+}
+
+bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Straightforward UTF-8 decoder the vector validation is compared against
+bool referenceUtf8(std::string_view text) {
+    size_t i = 0;
+    while (i < text.size()) {
+        uint8_t lead = static_cast<uint8_t>(text[i]);
+        size_t length = lead < 0x80 ? 1 : lead >= 0xC2 && lead <= 0xDF ? 2 : lead >= 0xE0 && lead <= 0xEF ? 3
+                      : lead >= 0xF0 && lead <= 0xF4 ? 4 : 0;
+        if (length == 0 || i + length > text.size()) {
+            return false;
+        }
+
+        uint32_t code = length == 1 ? lead : lead & (0xFF >> (length + 1));
+        for (size_t j = 1; j < length; j++) {
+            uint8_t next = static_cast<uint8_t>(text[i + j]);
+            if ((next & 0xC0) != 0x80) {
+                return false;
+            }
+            code = (code << 6) | (next & 0x3F);
+        }
+        static const uint32_t MIN_CODE[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (code < MIN_CODE[length] || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF)) {
+            return false;
+        }
+        i += length;
+    }
+    return true;
+}
+
+std::vector<std::string> schemaErrors(const JsonSchema& schema, std::string_view body) {
+    JsonReader reader;
+    std::vector<std::string> errors;
+    if (!reader.parse(body)) {
+        errors.push_back("parse: " + reader.error());
+        return errors;
+    }
+    schema.validate(reader, errors);
+    return errors;
+}
+
+} // namespace
+
+// Types, fields and on-demand walks over a valid document
+QMARK_TEST(json_reader_valid) {
+    JsonReader reader;
+    const std::string document =
+        " { \"name\" : \"Ana \\\"A\\\" \\u00e9\\ud83d\\ude00\", \"count\": -12, \"ratio\": 1.5e3,\n"
+        "   \"ok\": true, \"none\": null, \"empty\": {}, \"list\": [ [], {\"a\": [1, {\"b\": []}]}, \"x\" ],\n"
+        "   \"count\": 7 } ";
+    CHECK(reader.parse(document));
+    CHECK(reader.root().type == JsonType::OBJECT);
+    CHECK_EQ(reader.fields().size(), size_t{8});
+
+    std::string name;
+    CHECK(JsonReader::getString(*reader.find("name"), name));
+    CHECK_EQ(name, std::string("Ana \"A\" \xC3\xA9\xF0\x9F\x98\x80"));
+    CHECK_EQ(JsonReader::codePointCount(*reader.find("name")), size_t{10});
+
+    // Last occurrence wins
+    int64_t count = 0;
+    CHECK(JsonReader::getInt64(*reader.find("count"), count));
+    CHECK_EQ(count, int64_t{7});
+
+    double ratio = 0;
+    CHECK(reader.find("ratio")->type == JsonType::NUMBER);
+    CHECK(JsonReader::getDouble(*reader.find("ratio"), ratio));
+    CHECK_EQ(ratio, 1500.0);
+    CHECK(!JsonReader::getInt64(*reader.find("ratio"), count));
+
+    bool ok = false;
+    CHECK(JsonReader::getBool(*reader.find("ok"), ok) && ok);
+    CHECK(reader.find("none")->type == JsonType::NULL_VALUE);
+    CHECK(reader.find("missing") == nullptr);
+
+    // Nested containers are skipped whole, empty ones yield nothing
+    size_t members = 0;
+    reader.forEachMember(*reader.find("empty"), [&](std::string_view, const JsonReader::Value&) { members++; });
+    CHECK_EQ(members, size_t{0});
+
+    const JsonReader::Value& list = *reader.find("list");
+    CHECK_EQ(reader.elementCount(list), size_t{3});
+    std::vector<std::string> raw;
+    reader.forEachElement(list, [&](const JsonReader::Value& value) { raw.emplace_back(value.raw); });
+    CHECK_EQ(raw, (std::vector<std::string>{"[]", "{\"a\": [1, {\"b\": []}]}", "\"x\""}));
+
+    std::string keys;
+    reader.forEachElement(list, [&](const JsonReader::Value& value) {
+        reader.forEachMember(value, [&](std::string_view key, const JsonReader::Value& inner) {
+            keys += std::string(key) + "=" + std::to_string(reader.elementCount(inner)) + ";";
+        });
+    });
+    CHECK_EQ(keys, std::string("a=2;"));
+
+    // Scalar roots and documents spanning several 64-byte blocks
+    CHECK(reader.parse("  42 "));
+    CHECK(reader.root().type == JsonType::INTEGER && reader.fields().empty());
+    std::string long_array = "[";
+    for (int i = 0; i < 500; i++) {
+        long_array += (i ? ", " : "") + std::string("{\"i\": ") + std::to_string(i) + ", \"s\": \"\\\\\\\"\"}";
+    }
+    long_array += "]";
+    CHECK(reader.parse(long_array));
+    int64_t sum = 0;
+    reader.forEachElement(reader.root(), [&](const JsonReader::Value& item) {
+        reader.forEachMember(item, [&](std::string_view key, const JsonReader::Value& value) {
+            int64_t i = 0;
+            if (key == "i" && JsonReader::getInt64(value, i)) {
+                sum += i;
+            }
+        });
+    });
+    CHECK_EQ(sum, int64_t{499 * 500 / 2});
+}
+
+// Malformed documents are refused with the failing offset
+QMARK_TEST(json_reader_malformed) {
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        {"", "unexpected end of input"},
+        {"   ", "unexpected end of input"},
+        {"{", "expected string key"},
+        {"[", "unexpected end of input"},
+        {"[1,]", "invalid value"},
+        {"[1 2]", "invalid value"},
+        {"[\"a\" \"b\"]", "expected ',' or ']'"},
+        {"{\"a\" 1}", "expected ':'"},
+        {"{\"a\":}", "invalid value"},
+        {"{a:1}", "expected string key"},
+        {"{\"a\":1,}", "expected string key"},
+        {"{\"a\":1]", "expected ',' or '}'"},
+        {"[1}", "expected ',' or ']'"},
+        {"[1]]", "trailing characters"},
+        {"{} x", "trailing characters"},
+        {"tru", "invalid value"},
+        {"nul", "invalid value"},
+        {"01", "invalid value"},
+        {"1.", "invalid value"},
+        {"-", "invalid value"},
+        {"1e", "invalid value"},
+        {"+1", "invalid value"},
+        {"]", "invalid value"},
+        {"\"abc", "unterminated string"},
+        {"\"a\x01\"", "control character in string"},
+        {"\"a\tb\"", "control character in string"},
+        {"\"\\x\"", "invalid escape sequence"},
+        {"\"\\u12G4\"", "invalid escape sequence"},
+        {"\"\\u12\"", "invalid escape sequence"},
+        {std::string("[1,\0]", 5), "invalid value"},
+    };
+
+    for (const auto& [input, expected] : cases) {
+        std::string error = parseError(input);
+        if (!startsWith(error, expected)) {
+            test::fail(__FILE__, __LINE__, "'" + input + "': got '" + error + "', expected '" + expected + "'");
+        }
+    }
+
+    CHECK_EQ(parseError("{\"a\":1,  \"b\" 2}"), std::string("expected ':' at offset 13"));
+    CHECK_EQ(parseError("[1, 2, 3, x]"), std::string("invalid value at offset 10"));
+
+    // A reader reused after a failure starts clean
+    JsonReader reader;
+    CHECK(!reader.parse("[1,"));
+    CHECK(reader.parse("{\"a\":[1]}"));
+    CHECK(reader.error().empty());
+    CHECK_EQ(reader.fields().size(), size_t{1});
+}
+
+// Nesting is bounded without recursion, whatever the input
+QMARK_TEST(json_reader_depth) {
+    auto nested = [](size_t levels, const std::string& inner) {
+        return std::string(levels, '[') + inner + std::string(levels, ']');
+    };
+
+    // MAX_DEPTH + 1 containers: the innermost sits at depth MAX_DEPTH
+    CHECK_EQ(parseError(nested(JsonReader::MAX_DEPTH + 1, "")), std::string());
+    CHECK_EQ(parseError(nested(JsonReader::MAX_DEPTH, "1")), std::string());
+    CHECK(startsWith(parseError(nested(JsonReader::MAX_DEPTH + 1, "1")), "nesting too deep"));
+    CHECK(startsWith(parseError(nested(JsonReader::MAX_DEPTH + 2, "")), "nesting too deep"));
+
+    std::string objects;
+    for (size_t i = 0; i <= JsonReader::MAX_DEPTH; i++) {
+        objects += "{\"a\":";
+    }
+    objects += "1" + std::string(JsonReader::MAX_DEPTH + 1, '}');
+    CHECK(startsWith(parseError(objects), "nesting too deep"));
+
+    // Far deeper than any stack would allow
+    CHECK(startsWith(parseError(std::string(1000000, '[')), "nesting too deep"));
+}
+
+// UTF-8 is validated inside and outside strings, across 64-byte blocks
+QMARK_TEST(json_reader_utf8) {
+    CHECK_EQ(parseError("[\"caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 \xF4\x8F\xBF\xBF\"]"), std::string());
+
+    // Bad sequence and where, relative to its start, the error is reported
+    const std::vector<std::pair<std::string, size_t>> invalid = {
+        {"\x80", 0},                   // lone continuation
+        {"\xC0\xAF", 0},               // overlong 2-byte
+        {"\xC1\xBF", 0},
+        {"\xE0\x80\xAF", 0},           // overlong 3-byte
+        {"\xF0\x80\x80\xAF", 0},       // overlong 4-byte
+        {"\xED\xA0\x80", 0},           // surrogate
+        {"\xF4\x90\x80\x80", 0},       // above U+10FFFF
+        {"\xF5\x80\x80\x80", 0},
+        {"\xFF", 0},
+        {"\xC3", 0},                   // truncated
+        {"\xE2\x82", 0},
+        {"\xF0\x9F\x98", 0},
+        {"\xE2\x28\xA1", 0},
+        {"\xC3\xA9\xA9", 2},           // extra continuation
+    };
+
+    // At offsets around block boundaries
+    for (const auto& [bytes, position] : invalid) {
+        for (size_t offset : {size_t{1}, size_t{30}, size_t{61}, size_t{62}, size_t{63}, size_t{64}, size_t{127}}) {
+            std::string document = "\"";
+            document.append(offset - 1, 'a');
+            document += bytes;
+            document += "\"";
+            document.append(100, ' ');
+
+            std::string error = parseError(document);
+            std::string expected = "invalid UTF-8 at offset " + std::to_string(offset + position);
+            if (error != expected) {
+                test::fail(__FILE__, __LINE__, "offset " + std::to_string(offset) + ": got '" + error + "'");
+            }
+        }
+    }
+
+    // Outside strings too, and truncated at the very end of the input
+    CHECK_EQ(parseError("[1, \xC3\xA9]"), std::string("invalid value at offset 4"));
+    CHECK(startsWith(parseError(std::string("\"") + std::string(62, 'a') + "\xE2"), "unterminated string"));
+
+    // Random mixes of leads and continuations agree with a plain decoder
+    const uint8_t ALPHABET[] = {'a', ' ', 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xC2, 0xDF,
+                                0xE0, 0xE1, 0xED, 0xEF, 0xF0, 0xF4, 0xF5, 0xFF};
+    std::mt19937 random(1234);
+    size_t mismatches = 0;
+    size_t valid = 0;
+    for (int round = 0; round < 20000; round++) {
+        std::string content;
+        size_t length = random() % 150;
+        for (size_t i = 0; i < length; i++) {
+            content += static_cast<char>(ALPHABET[random() % sizeof(ALPHABET)]);
+        }
+        bool expected = referenceUtf8(content);
+        bool actual = parseError("\"" + content + "\"").empty();
+        mismatches += expected != actual;
+        valid += expected;
+    }
+    CHECK_EQ(mismatches, size_t{0});
+    CHECK(valid > 100);
+}
+
+// Required fields, accepted types and length limits, all reported in one pass
+QMARK_TEST(json_schema_rules) {
+    const JsonSchema schema{
+        {"name", json_types::STRING, true, 5},
+        {"value", json_types::NUMBER, true},
+        {"tags", json_types::ARRAY, false, 2},
+        {"note", json_types::STRING | json_types::NULL_VALUE, false},
+    };
+
+    CHECK(schemaErrors(schema, "{\"name\":\"abc\",\"value\":1}").empty());
+    CHECK(schemaErrors(schema, "{\"name\":\"\xC3\xA9t\xC3\xA9s!\",\"value\":1.5,\"tags\":[1,2],\"note\":null}").empty());
+
+    CHECK_EQ(schemaErrors(schema, "{}"), (std::vector<std::string>{"name: required", "value: required"}));
+    CHECK_EQ(schemaErrors(schema, "{\"name\":7,\"value\":\"1\",\"note\":true}"),
+             (std::vector<std::string>{"name: expected string, got integer",
+                                       "value: expected number, got string",
+                                       "note: expected string or null, got boolean"}));
+    CHECK_EQ(schemaErrors(schema, "{\"name\":\"abcdef\",\"value\":0,\"tags\":[1,[2,3],{}]}"),
+             (std::vector<std::string>{"name: longer than 5 characters", "tags: more than 2 elements"}));
+
+    // Length counts code points after unescaping
+    CHECK(schemaErrors(schema, "{\"name\":\"\\u00e9\\u00e9\\u00e9\\u00e9\\u00e9\",\"value\":0}").empty());
+
+    CHECK_EQ(schemaErrors(schema, "[1]"), (std::vector<std::string>{"body: expected object, got array"}));
+
+    const JsonSchema strict({{"name", json_types::STRING, true, 0}}, false);
+    CHECK_EQ(schemaErrors(strict, "{\"name\":\"a\",\"extra\":1,\"nested\":{\"name\":2}}"),
+             (std::vector<std::string>{"extra: unknown field", "nested: unknown field"}));
+}
@@ -0,0 +1,331 @@
+#include "test.hpp"
+#include "outbound/http_client.hpp"
+#include <httplib.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <latch>
+#include <thread>
+
+using namespace QMark;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Local stand-in provider on an ephemeral port
+class StandIn {
+private:
+    httplib::Server server_;
+    std::thread thread_;
+    int port_ = 0;
+
+public:
+    std::atomic<int> hits{0};
+    std::atomic<int> in_flight{0};
+    std::atomic<int> max_in_flight{0};
+
+    StandIn() {
+        server_.set_tcp_nodelay(true);
+        server_.Get("/ok", [this](const httplib::Request&, httplib::Response& res) {
+            hits++;
+            res.set_content("ok", "text/plain");
+        });
+        server_.Get("/fail", [this](const httplib::Request&, httplib::Response& res) {
+            hits++;
+            res.status = 503;
+        });
+
+        // Long enough for concurrent callers to overlap; echoes the credentials it saw
+        auto slow = [this](const httplib::Request& req, httplib::Response& res) {
+            hits++;
+            int now = ++in_flight;
+            int seen = max_in_flight.load();
+            while (now > seen && !max_in_flight.compare_exchange_weak(seen, now)) {}
+            std::this_thread::sleep_for(300ms);
+            in_flight--;
+            res.set_content(req.get_header_value("Authorization"), "text/plain");
+        };
+        server_.Get("/slow", slow);
+        server_.Post("/slow", slow);
+
+        port_ = server_.bind_to_any_port("127.0.0.1");
+        thread_ = std::thread([this]() { server_.listen_after_bind(); });
+        server_.wait_until_ready();
+    }
+
+    ~StandIn() {
+        server_.stop();
+        thread_.join();
+    }
+
+    std::string origin() const { return "http://127.0.0.1:" + std::to_string(port_); }
+};
+
+// Answers the first request of each connection, then closes the socket when
+// the next one arrives: a peer that dropped a kept-alive connection just
+// after the client found it alive
+class ClosingStandIn {
+private:
+    int listener_ = -1;
+    int port_ = 0;
+    std::thread thread_;
+
+    static bool readRequest(int fd) {
+        std::string data;
+        char buffer[1024];
+        while (data.find("\r\n\r\n") == std::string::npos) {
+            ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                return false;
+            }
+            data.append(buffer, static_cast<size_t>(n));
+        }
+        // Request bodies are not read: the stand-in only ever sees short ones
+        return true;
+    }
+
+public:
+    std::atomic<int> connections{0};
+    std::atomic<int> requests{0};
+    std::atomic<int> answered{0};
+
+    ClosingStandIn() {
+        listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        ::listen(listener_, 16);
+        socklen_t length = sizeof(address);
+        ::getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length);
+        port_ = ntohs(address.sin_port);
+
+        thread_ = std::thread([this]() {
+            for (;;) {
+                int fd = ::accept(listener_, nullptr, nullptr);
+                if (fd < 0) {
+                    return;
+                }
+                connections++;
+                if (readRequest(fd)) {
+                    requests++;
+                    static const char RESPONSE[] =
+                        "HTTP/1.1 200 OK\r\nContent-Length: 2\r\nConnection: keep-alive\r\n\r\nok";
+                    ::send(fd, RESPONSE, sizeof(RESPONSE) - 1, MSG_NOSIGNAL);
+                    answered++;
+                    if (readRequest(fd)) {
+                        requests++;
+                    }
+                }
+                ::close(fd);
+            }
+        });
+    }
+
+    ~ClosingStandIn() {
+        ::shutdown(listener_, SHUT_RDWR);
+        ::close(listener_);
+        thread_.join();
+    }
+
+    std::string origin() const { return "http://127.0.0.1:" + std::to_string(port_); }
+};
+
+// Runs `count` calls at once and returns their responses in call order
+template<typename Call>
+std::vector<OutboundResponse> concurrently(size_t count, Call call) {
+    std::vector<OutboundResponse> responses(count);
+    std::vector<std::thread> threads;
+    std::latch start(static_cast<std::ptrdiff_t>(count));
+
+    for (size_t i = 0; i < count; i++) {
+        threads.emplace_back([&, i]() {
+            start.arrive_and_wait();
+            responses[i] = call(i);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    return responses;
+}
+
+} // namespace
+
+// Closed -> open after N failures -> half-open probe; a failed probe doubles the open time
+QMARK_TEST(outbound_circuit_breaker) {
+    CircuitBreakerConfig config;
+    config.failure_threshold = 3;
+    config.open_duration = 100ms;
+    config.max_open_duration = 300ms;
+    config.half_open_probes = 1;
+
+    CircuitBreaker breaker(config);
+    auto t = CircuitBreaker::Clock::now();
+
+    // A success clears the failure streak
+    for (int i = 0; i < 2; i++) {
+        CHECK(breaker.allow(t));
+        breaker.onFailure(t);
+    }
+    CHECK(breaker.allow(t));
+    breaker.onSuccess();
+    for (int i = 0; i < 2; i++) {
+        CHECK(breaker.allow(t));
+        breaker.onFailure(t);
+    }
+    CHECK(breaker.state() == CircuitBreaker::State::CLOSED);
+
+    CHECK(breaker.allow(t));
+    breaker.onFailure(t);
+    CHECK(breaker.state() == CircuitBreaker::State::OPEN);
+    CHECK(!breaker.allow(t + 99ms));
+    CHECK_EQ(breaker.rejected(), uint64_t{1});
+
+    // One probe at a time; an abandoned probe frees its slot without a verdict
+    CHECK(breaker.allow(t + 100ms));
+    CHECK(breaker.state() == CircuitBreaker::State::HALF_OPEN);
+    CHECK(!breaker.allow(t + 100ms));
+    breaker.onAbandon();
+    CHECK(breaker.allow(t + 100ms));
+
+    // Failed probe: open for 200 ms, then 300 ms (capped)
+    breaker.onFailure(t + 100ms);
+    CHECK(breaker.state() == CircuitBreaker::State::OPEN);
+    CHECK(!breaker.allow(t + 299ms));
+    CHECK(breaker.allow(t + 300ms));
+    breaker.onFailure(t + 300ms);
+    CHECK(!breaker.allow(t + 599ms));
+    CHECK(breaker.allow(t + 600ms));
+
+    // Successful probe closes the circuit and resets the open time
+    breaker.onSuccess();
+    CHECK(breaker.state() == CircuitBreaker::State::CLOSED);
+    for (int i = 0; i < 3; i++) {
+        CHECK(breaker.allow(t + 1000ms));
+        breaker.onFailure(t + 1000ms);
+    }
+    CHECK(!breaker.allow(t + 1099ms));
+    CHECK(breaker.allow(t + 1100ms));
+}
+
+// The client stops calling a failing provider, then probes it again
+QMARK_TEST(outbound_circuit_breaker_client) {
+    StandIn provider;
+
+    OutboundHostConfig config;
+    config.breaker.failure_threshold = 3;
+    config.breaker.open_duration = 200ms;
+    auto& client = OutboundClient::getInstance();
+    client.configureHost(provider.origin(), config);
+
+    for (int i = 0; i < 3; i++) {
+        CHECK_EQ(client.get(provider.origin(), "/fail").status, 503);
+    }
+    CHECK(client.hostStats(provider.origin()).circuit == CircuitBreaker::State::OPEN);
+
+    OutboundResponse rejected = client.get(provider.origin(), "/ok");
+    CHECK_EQ(rejected.status, 0);
+    CHECK(rejected.error.find("Circuit open") != std::string::npos);
+    CHECK_EQ(provider.hits.load(), 3);
+
+    std::this_thread::sleep_for(250ms);
+    CHECK_EQ(client.get(provider.origin(), "/ok").status, 200);
+    CHECK(client.hostStats(provider.origin()).circuit == CircuitBreaker::State::CLOSED);
+}
+
+// Identical concurrent GETs share one upstream request; different credentials never do
+QMARK_TEST(outbound_coalescing) {
+    StandIn provider;
+    auto& client = OutboundClient::getInstance();
+    client.configureHost(provider.origin(), OutboundHostConfig{});
+
+    auto shared = concurrently(4, [&](size_t) {
+        return client.get(provider.origin(), "/slow", {{"Authorization", "Bearer a"}});
+    });
+    CHECK_EQ(provider.hits.load(), 1);
+    CHECK_EQ(std::count_if(shared.begin(), shared.end(), [](const OutboundResponse& r) { return r.coalesced; }), 3);
+    for (const auto& response : shared) {
+        CHECK_EQ(response.status, 200);
+        CHECK_EQ(response.body, std::string("Bearer a"));
+    }
+
+    provider.hits = 0;
+    provider.max_in_flight = 0;
+    auto separate = concurrently(2, [&](size_t i) {
+        return client.get(provider.origin(), "/slow", {{"Authorization", i == 0 ? "Bearer a" : "Bearer b"}});
+    });
+    CHECK_EQ(provider.hits.load(), 2);
+    CHECK_EQ(provider.max_in_flight.load(), 2);
+    CHECK(!separate[0].coalesced && !separate[1].coalesced);
+    CHECK_EQ(separate[0].body, std::string("Bearer a"));
+    CHECK_EQ(separate[1].body, std::string("Bearer b"));
+}
+
+// At most max_connections requests reach a host; a caller that cannot get one in time gives up
+QMARK_TEST(outbound_pool_cap) {
+    StandIn provider;
+    auto& client = OutboundClient::getInstance();
+
+    OutboundHostConfig config;
+    config.max_connections = 2;
+    config.acquire_timeout = 2000ms;
+    client.configureHost(provider.origin(), config);
+
+    // POSTs are never coalesced: every call needs its own connection
+    auto queued = concurrently(4, [&](size_t) {
+        return client.post(provider.origin(), "/slow", "{}", "application/json");
+    });
+    for (const auto& response : queued) {
+        CHECK_EQ(response.status, 200);
+    }
+    CHECK_EQ(provider.max_in_flight.load(), 2);
+    CHECK(client.hostStats(provider.origin()).connections_opened <= 2);
+
+    config.acquire_timeout = 100ms;
+    client.configureHost(provider.origin(), config);
+    provider.max_in_flight = 0;
+
+    auto timed_out = concurrently(3, [&](size_t) {
+        return client.post(provider.origin(), "/slow", "{}", "application/json");
+    });
+    size_t ok = 0;
+    size_t refused = 0;
+    for (const auto& response : timed_out) {
+        if (response.ok()) {
+            ok++;
+        } else if (response.status == 0 && response.error.find("available within 100 ms") != std::string::npos) {
+            refused++;
+        }
+    }
+    CHECK_EQ(ok, size_t{2});
+    CHECK_EQ(refused, size_t{1});
+    CHECK_EQ(provider.max_in_flight.load(), 2);
+
+    // A refused acquire is not the provider's fault
+    CHECK(client.hostStats(provider.origin()).circuit == CircuitBreaker::State::CLOSED);
+}
+
+// An idempotent request on a socket the peer just dropped is retried once on a new one
+QMARK_TEST(outbound_stale_socket_retry) {
+    ClosingStandIn provider;
+    auto& client = OutboundClient::getInstance();
+    client.configureHost(provider.origin(), OutboundHostConfig{});
+
+    CHECK_EQ(client.get(provider.origin(), "/first").status, 200);
+    OutboundResponse retried = client.get(provider.origin(), "/second");
+    CHECK_EQ(retried.status, 200);
+    CHECK_EQ(retried.body, std::string("ok"));
+    CHECK_EQ(provider.connections.load(), 2);
+    CHECK_EQ(provider.requests.load(), 3);
+    CHECK_EQ(provider.answered.load(), 2);
+    CHECK_EQ(client.hostStats(provider.origin()).connections_opened, uint64_t{2});
+
+    // A POST might have been processed: it is not replayed
+    OutboundResponse not_replayed = client.post(provider.origin(), "/third", "{}", "application/json");
+    CHECK_EQ(not_replayed.status, 0);
+    CHECK(!not_replayed.error.empty());
+    CHECK_EQ(provider.requests.load(), 4);
+    CHECK_EQ(provider.answered.load(), 2);
+}
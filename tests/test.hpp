@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace QMark::test {
+
+    // Échec d'une vérification : la suite continue, le programme sort en erreur
+    void fail(const char* file, int line, const std::string& message);
+
+    // Enregistrement statique des suites de tests
+    struct Registration {
+        Registration(const char* name, void (*run)());
+    };
+
+    struct Suite {
+        const char* name;
+        void (*run)();
+    };
+
+    std::vector<Suite>& registry();
+
+    // Répertoire temporaire vidé, propre à la suite en cours
+    std::string scratchDirectory(const std::string& name);
+
+    template<typename T>
+    void printValue(std::ostream& out, const T& value) {
+        out << value;
+    }
+
+    template<typename T>
+    void printValue(std::ostream& out, const std::vector<T>& values) {
+        out << '[';
+        for (size_t i = 0; i < values.size(); i++) {
+            out << (i ? "," : "");
+            printValue(out, values[i]);
+        }
+        out << ']';
+    }
+
+    template<typename A, typename B>
+    void checkEqual(const A& actual, const B& expected, const char* actual_text, const char* expected_text,
+                    const char* file, int line) {
+        if (!(actual == expected)) {
+            std::ostringstream message;
+            message << actual_text << " == " << expected_text << " (got ";
+            printValue(message, actual);
+            message << ", expected ";
+            printValue(message, expected);
+            message << ")";
+            fail(file, line, message.str());
+        }
+    }
+}
+
+#define QMARK_TEST(name) \
+    static void qmark_test_##name(); \
+    static QMark::test::Registration qmark_test_##name##_registration(#name, qmark_test_##name); \
+    static void qmark_test_##name()
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            QMark::test::fail(__FILE__, __LINE__, #condition); \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    QMark::test::checkEqual((actual), (expected), #actual, #expected, __FILE__, __LINE__)
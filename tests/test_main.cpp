@@ -0,0 +1,62 @@
+#include "test.hpp"
+#include "utils/logger.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+namespace QMark::test {
+
+namespace {
+
+size_t failures = 0;
+
+} // namespace
+
+std::vector<Suite>& registry() {
+    static std::vector<Suite> suites;
+    return suites;
+}
+
+Registration::Registration(const char* name, void (*run)()) {
+    registry().push_back(Suite{name, run});
+}
+
+void fail(const char* file, int line, const std::string& message) {
+    failures++;
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, message.c_str());
+}
+
+std::string scratchDirectory(const std::string& name) {
+    auto directory = std::filesystem::temp_directory_path() / "qmark-tests" / name;
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    return directory.string();
+}
+
+} // namespace QMark::test
+
+int main(int argc, char** argv) {
+    // Usage: qmark-tests [filter]  (runs suites whose name contains filter,
+    // exits non-zero if any check failed)
+    const char* filter = argc > 1 ? argv[1] : "";
+
+    // Only problems reach the console; the suites check behaviour, not log lines
+    QMark::Logger::getInstance().setLogLevel(QMark::LogLevel::ERROR);
+
+    size_t ran = 0;
+    for (const auto& suite : QMark::test::registry()) {
+        if (std::strstr(suite.name, filter) == nullptr) {
+            continue;
+        }
+        size_t before = QMark::test::failures;
+        suite.run();
+        std::printf("%s %s\n", QMark::test::failures == before ? "PASS" : "FAIL", suite.name);
+        ran++;
+    }
+
+    if (ran == 0) {
+        std::fprintf(stderr, "No test suite matches '%s'\n", filter);
+        return 1;
+    }
+    return QMark::test::failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,98 @@
+#include "test.hpp"
+#include "utils/timing_wheel.hpp"
+#include <map>
+
+using namespace QMark;
+
+namespace {
+
+// Advances one tick at a time and returns the tick each value fired on
+std::map<uint64_t, uint64_t> firingTicks(uint64_t start, const std::vector<uint64_t>& deadlines, uint64_t until) {
+    TimingWheel<uint64_t> wheel(start);
+    for (uint64_t deadline : deadlines) {
+        wheel.schedule(deadline, deadline);
+    }
+
+    std::map<uint64_t, uint64_t> fired;
+    for (uint64_t tick = start + 1; tick <= until; tick++) {
+        wheel.advance(tick, [&](uint64_t&& deadline) { fired[deadline] = tick; });
+    }
+    return fired;
+}
+
+} // namespace
+
+// Deadlines on either side of a level boundary fire on their own tick
+QMARK_TEST(timing_wheel_level_boundaries) {
+    const std::vector<uint64_t> deadlines = {63, 64, 65, 4095, 4096, 4097};
+
+    auto fired = firingTicks(0, deadlines, 5000);
+    CHECK_EQ(fired.size(), deadlines.size());
+    for (uint64_t deadline : deadlines) {
+        CHECK_EQ(fired[deadline], deadline);
+    }
+
+    // Same from a start that is not aligned, and across the top level
+    const uint64_t start = 1716480017;
+    const uint64_t span = uint64_t{1} << 24;
+    std::vector<uint64_t> shifted;
+    for (uint64_t deadline : deadlines) {
+        shifted.push_back((start / 4096 + 1) * 4096 + deadline);
+    }
+    shifted.push_back((start / span + 1) * span);
+    shifted.push_back((start / span + 1) * span + 1);
+
+    fired = firingTicks(start, shifted, shifted.back());
+    CHECK_EQ(fired.size(), shifted.size());
+    for (uint64_t deadline : shifted) {
+        CHECK_EQ(fired[deadline], deadline);
+    }
+}
+
+// A single advance() over many ticks fires everything due, in tick order
+QMARK_TEST(timing_wheel_jump) {
+    TimingWheel<uint64_t> wheel(0);
+    for (uint64_t deadline : {4097, 64, 4096, 65, 63, 4095}) {
+        wheel.schedule(deadline, deadline);
+    }
+
+    std::vector<uint64_t> order;
+    CHECK_EQ(wheel.advance(4097, [&](uint64_t&& deadline) { order.push_back(deadline); }), size_t{6});
+    CHECK_EQ(order, (std::vector<uint64_t>{63, 64, 65, 4095, 4096, 4097}));
+    CHECK(wheel.empty());
+}
+
+// nextWakeTick() names a tick on which advance() actually fires the entry
+QMARK_TEST(timing_wheel_next_wake) {
+    for (uint64_t deadline : {63, 64, 65, 4095, 4096, 4097}) {
+        TimingWheel<uint64_t> wheel(0);
+        wheel.schedule(deadline, deadline);
+
+        size_t fired = 0;
+        while (fired == 0) {
+            uint64_t wake = wheel.nextWakeTick();
+            CHECK(wake <= deadline);
+            if (wake > deadline) {
+                break;
+            }
+            fired = wheel.advance(wake, [](uint64_t&&) {});
+            if (fired) {
+                CHECK_EQ(wake, deadline);
+            }
+        }
+    }
+
+    // A cascade due before the nearest level-0 entry is not skipped
+    TimingWheel<uint64_t> mixed(0);
+    mixed.schedule(4096, 4096);
+    mixed.advance(4080, [](uint64_t&&) {});
+    mixed.schedule(4140, 4140);
+    CHECK_EQ(mixed.nextWakeTick(), uint64_t{4096});
+
+    // Past or current deadlines are pushed to the next tick, never dropped
+    TimingWheel<uint64_t> wheel(100);
+    wheel.schedule(1, 50);
+    wheel.schedule(2, 100);
+    CHECK_EQ(wheel.nextWakeTick(), uint64_t{101});
+    CHECK_EQ(wheel.advance(101, [](uint64_t&&) {}), size_t{2});
+}
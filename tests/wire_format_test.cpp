@@ -0,0 +1,283 @@
+#include "test.hpp"
+#include "utils/wire_format.hpp"
+#include <initializer_list>
+#include <limits>
+
+using namespace QMark;
+
+namespace {
+
+std::string bytes(std::initializer_list<int> values) {
+    std::string out;
+    for (int value : values) {
+        out += static_cast<char>(value);
+    }
+    return out;
+}
+
+// Decoded document, or "" with the decoder's message in `error`
+std::string decode(WireFormat from, const std::string& input, std::string& error,
+                   WireFormat to = WireFormat::JSON) {
+    std::string out;
+    JsonWriter writer(out, to);
+    error.clear();
+    if (!wire::transcode(from, input, writer, error)) {
+        return "";
+    }
+    return out;
+}
+
+std::string decodeError(WireFormat from, const std::string& input) {
+    std::string error;
+    decode(from, input, error);
+    return error;
+}
+
+bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+// Exercises every encoding branch of the writer: fix/8/16/32-bit headers,
+// both integer signs, single and double precision, long strings
+void writeSample(JsonWriter& writer) {
+    writer.beginObject();
+    writer.field("id", int64_t{1234567});
+    writer.field("neg", int64_t{-40000});
+    writer.field("small", -5);
+    writer.field("byte", uint64_t{200});
+    writer.field("max", std::numeric_limits<uint64_t>::max());
+    writer.field("min", std::numeric_limits<int64_t>::min());
+    writer.field("ratio", 0.1);
+    writer.field("half", 1.5);
+    writer.field("ok", true);
+    writer.field("off", false);
+    writer.key("none").null();
+    writer.field("name", "Ana \"A\" \xC3\xA9\xF0\x9F\x98\x80");
+    writer.field("long", std::string(300, 'x'));
+    writer.key("tags").beginArray();
+    for (int i = 0; i < 20; i++) {
+        writer.value(i * 1000);
+    }
+    writer.endArray();
+    writer.key("wide").beginArray();
+    for (int i = 0; i < 70000; i++) {
+        writer.value(i & 1);
+    }
+    writer.endArray();
+    writer.key("nested");
+    for (int i = 0; i < 10; i++) {
+        writer.beginArray();
+    }
+    writer.beginObject().endObject();
+    for (int i = 0; i < 10; i++) {
+        writer.endArray();
+    }
+    writer.key("empty").beginArray().endArray();
+    writer.endObject();
+}
+
+std::string sample(WireFormat format) {
+    std::string out;
+    JsonWriter writer(out, format);
+    writeSample(writer);
+    return out;
+}
+
+} // namespace
+
+// Writer output decodes back to the JSON the writer produces for the same calls
+QMARK_TEST(wire_format_round_trip) {
+    const std::string json = sample(WireFormat::JSON);
+
+    for (WireFormat format : {WireFormat::MSGPACK, WireFormat::CBOR}) {
+        const std::string encoded = sample(format);
+        std::string error;
+
+        std::string decoded = decode(format, encoded, error);
+        CHECK_EQ(error, std::string());
+        CHECK(decoded == json);
+
+        // Re-encoding into the same format reproduces the bytes
+        std::string reencoded = decode(format, encoded, error, format);
+        CHECK_EQ(error, std::string());
+        CHECK(reencoded == encoded);
+
+        // Pre-serialized JSON fragments transcode to the same encoding
+        std::string from_raw;
+        JsonWriter raw_writer(from_raw, format);
+        raw_writer.raw(json);
+        CHECK(from_raw == encoded);
+    }
+
+    std::string error;
+    CHECK_EQ(decode(WireFormat::MSGPACK, bytes({0x93, 0x01, 0xFF, 0xA1, 'a'}), error), std::string("[1,-1,\"a\"]"));
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0x83, 0x01, 0x20, 0x61, 'a'}), error), std::string("[1,-1,\"a\"]"));
+    // CBOR half precision
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0xF9, 0x3E, 0x00}), error), std::string("1.5"));
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0xF9, 0x80, 0x01}), error), std::string("-5.960464477539063e-08"));
+    // Tags only add semantics
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0xC1, 0x1A, 0x65, 0x53, 0xF1, 0x00}), error), std::string("1700000000"));
+
+    CHECK_EQ(decodeError(WireFormat::JSON, "{}"), std::string("input is already JSON"));
+}
+
+// Every proper prefix of a valid document is refused, never read past its end
+QMARK_TEST(wire_format_truncated) {
+    for (WireFormat format : {WireFormat::MSGPACK, WireFormat::CBOR}) {
+        const std::string encoded = sample(format);
+        size_t refused = 0;
+        for (size_t length = 0; length < encoded.size(); length += length < 4096 ? 1 : 997) {
+            std::string error = decodeError(format, encoded.substr(0, length));
+            if (startsWith(error, "unexpected end of input")) {
+                refused++;
+            } else {
+                QMark::test::fail(__FILE__, __LINE__, std::string(wire::formatName(format)) + " prefix of "
+                                  + std::to_string(length) + " bytes: '" + error + "'");
+            }
+        }
+        CHECK(refused > 4096);
+    }
+
+    CHECK_EQ(decodeError(WireFormat::MSGPACK, bytes({0xCD, 0x01})), std::string("unexpected end of input at offset 1"));
+    CHECK_EQ(decodeError(WireFormat::CBOR, bytes({0x19, 0x01})), std::string("unexpected end of input at offset 1"));
+    CHECK_EQ(decodeError(WireFormat::MSGPACK, bytes({0x01, 0x02})), std::string("trailing bytes at offset 1"));
+    CHECK_EQ(decodeError(WireFormat::CBOR, bytes({0x01, 0x02})), std::string("trailing bytes at offset 1"));
+}
+
+// Length prefixes larger than the input fail before anything is read or reserved
+QMARK_TEST(wire_format_oversized_lengths) {
+    const std::vector<std::string> msgpack = {
+        bytes({0xD9, 0x05, 'a', 'b'}),                          // str8
+        bytes({0xDA, 0xFF, 0xFF, 'a'}),                         // str16
+        bytes({0xDB, 0xFF, 0xFF, 0xFF, 0xFF, 'a'}),             // str32
+        bytes({0xDC, 0xFF, 0xFF, 0x01}),                        // array16
+        bytes({0xDD, 0xFF, 0xFF, 0xFF, 0xFF, 0x01}),            // array32
+        bytes({0xDF, 0xFF, 0xFF, 0xFF, 0xFF, 0xA1, 'k', 0x01}), // map32
+        bytes({0x81, 0xDB, 0x7F, 0xFF, 0xFF, 0xFF, 'k'})        // key str32
+    };
+    for (const auto& input : msgpack) {
+        CHECK(startsWith(decodeError(WireFormat::MSGPACK, input), "unexpected end of input"));
+    }
+
+    const std::vector<std::string> cbor = {
+        bytes({0x78, 0x05, 'a', 'b'}),
+        bytes({0x7A, 0x7F, 0xFF, 0xFF, 0xFF, 'a'}),
+        // A full 64-bit length is a length, not an indefinite marker
+        bytes({0x7B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}),
+        bytes({0x9B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01}),
+        bytes({0xBB, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x61, 'k', 0x01}),
+        bytes({0x9A, 0xFF, 0xFF, 0xFF, 0xFF, 0x01}),
+        bytes({0xA1, 0x7B, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 'k'})
+    };
+    for (const auto& input : cbor) {
+        CHECK(startsWith(decodeError(WireFormat::CBOR, input), "unexpected end of input"));
+    }
+
+    // ... so a break after it is an error, not the end of an empty container
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x9B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF})),
+                     "unexpected break"));
+
+    // The largest 64-bit arguments remain valid values
+    std::string error;
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0x1B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}), error),
+             std::string("18446744073709551615"));
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0x3B, 0x7F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}), error),
+             std::string("-9223372036854775808"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x3B, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF})),
+                     "negative integer out of range"));
+    CHECK_EQ(decode(WireFormat::MSGPACK, bytes({0xCF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}), error),
+             std::string("18446744073709551615"));
+}
+
+// Indefinite-length CBOR containers and chunked text strings
+QMARK_TEST(wire_format_cbor_indefinite) {
+    std::string error;
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0x9F, 0x01, 0x9F, 0xFF, 0x82, 0x02, 0x03, 0xFF}), error),
+             std::string("[1,[],[2,3]]"));
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0xBF, 0x61, 'a', 0x01, 0x61, 'b', 0xBF, 0xFF, 0xFF}), error),
+             std::string("{\"a\":1,\"b\":{}}"));
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0x7F, 0x62, 'a', 'b', 0x60, 0x61, 'c', 0xFF}), error),
+             std::string("\"abc\""));
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0x7F, 0xFF}), error), std::string("\"\""));
+    // Chunked keys, and a chunked value right after one (shared scratch buffer)
+    CHECK_EQ(decode(WireFormat::CBOR, bytes({0xBF, 0x7F, 0x61, 'k', 0x61, '1', 0xFF,
+                                             0x7F, 0x61, 'v', 0xFF, 0xFF}), error),
+             std::string("{\"k1\":\"v\"}"));
+
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x9F, 0x01})), "unexpected end of input"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x7F, 0x61, 'a'})), "unexpected end of input"));
+    CHECK_EQ(decodeError(WireFormat::CBOR, bytes({0x7F, 0x41, 'a', 0xFF})),
+             std::string("invalid text string chunk at offset 2"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x7F, 0x7F, 0xFF, 0xFF})), "invalid text string chunk"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x1F})), "indefinite length not allowed here"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x3F})), "indefinite length not allowed here"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x5F, 0xFF})), "indefinite length not allowed here"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0xDF, 0x01})), "indefinite length not allowed here"));
+
+    // A break outside an indefinite container, or where a map value is due
+    CHECK_EQ(decodeError(WireFormat::CBOR, bytes({0xFF})), std::string("unexpected break at offset 1"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x82, 0x01, 0xFF})), "unexpected break"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0xBF, 0x61, 'a', 0xFF})), "unexpected break"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x1C})), "reserved additional information"));
+}
+
+// Nesting is bounded by the writer's depth, without recursing past it
+QMARK_TEST(wire_format_depth) {
+    for (WireFormat format : {WireFormat::MSGPACK, WireFormat::CBOR}) {
+        char open_array = static_cast<char>(format == WireFormat::CBOR ? 0x81 : 0x91);
+        char null_value = static_cast<char>(format == WireFormat::CBOR ? 0xF6 : 0xC0);
+        size_t limit = JsonWriter::MAX_DEPTH - 1;
+
+        std::string error;
+        std::string deepest = std::string(limit, open_array) + null_value;
+        CHECK_EQ(decode(format, deepest, error), std::string(limit, '[') + "null" + std::string(limit, ']'));
+        CHECK_EQ(error, std::string());
+
+        std::string too_deep = std::string(limit + 1, open_array) + null_value;
+        CHECK_EQ(decodeError(format, too_deep), "nesting too deep at offset " + std::to_string(limit + 1));
+        CHECK(startsWith(decodeError(format, std::string(1000000, open_array)), "nesting too deep"));
+    }
+
+    // Each CBOR tag counts as one level
+    std::string error;
+    std::string tagged = std::string(JsonWriter::MAX_DEPTH - 1, static_cast<char>(0xC0)) + bytes({0x07});
+    CHECK_EQ(decode(WireFormat::CBOR, tagged, error), std::string("7"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, static_cast<char>(0xC0) + tagged), "nesting too deep"));
+
+    // Maps nest the same way
+    std::string maps;
+    for (size_t i = 0; i < JsonWriter::MAX_DEPTH; i++) {
+        maps += bytes({0x81, 0xA1, 'k'});
+    }
+    CHECK(startsWith(decodeError(WireFormat::MSGPACK, maps + bytes({0x01})), "nesting too deep"));
+}
+
+// Map keys must be text; values JSON cannot hold are refused
+QMARK_TEST(wire_format_invalid_keys) {
+    CHECK_EQ(decodeError(WireFormat::MSGPACK, bytes({0x81, 0x01, 0x02})),
+             std::string("map keys must be strings at offset 2"));
+    for (const auto& key : {bytes({0xC0}), bytes({0xC3}), bytes({0xC4, 0x01, 'k'}), bytes({0x90}), bytes({0x80}),
+                            bytes({0xCB, 0, 0, 0, 0, 0, 0, 0, 0})}) {
+        CHECK(startsWith(decodeError(WireFormat::MSGPACK, bytes({0x81}) + key + bytes({0x02})),
+                         "map keys must be strings"));
+    }
+    // The error is raised at the offending key, after earlier members
+    CHECK_EQ(decodeError(WireFormat::MSGPACK, bytes({0x82, 0xA1, 'a', 0x01, 0x05, 0x02})),
+             std::string("map keys must be strings at offset 5"));
+
+    CHECK_EQ(decodeError(WireFormat::CBOR, bytes({0xA1, 0x01, 0x02})),
+             std::string("map keys must be text strings at offset 2"));
+    for (const auto& key : {bytes({0x20}), bytes({0x41, 'k'}), bytes({0x5F, 0xFF}), bytes({0x80}), bytes({0xA0}),
+                            bytes({0xF6}), bytes({0xC0, 0x61, 'k'})}) {
+        CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0xA1}) + key + bytes({0x02})),
+                         "map keys must be text strings"));
+        CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0xBF}) + key + bytes({0x02, 0xFF})),
+                         "map keys must be text strings"));
+    }
+
+    CHECK(startsWith(decodeError(WireFormat::MSGPACK, bytes({0xC4, 0x01, 'b'})), "binary data has no JSON representation"));
+    CHECK(startsWith(decodeError(WireFormat::MSGPACK, bytes({0xD4, 0x01, 0x00})), "extension types are not supported"));
+    CHECK(startsWith(decodeError(WireFormat::MSGPACK, bytes({0xC1})), "invalid MessagePack marker"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0x41, 'b'})), "binary data has no JSON representation"));
+    CHECK(startsWith(decodeError(WireFormat::CBOR, bytes({0xF8, 0x20})), "unsupported simple value"));
+}
@@ -0,0 +1,338 @@
+// Open-loop load generator for a local qmark-server.
+//
+// Requests are scheduled at a constant arrival rate, independently of how
+// fast the server answers: request i is due at start + i / rate. Latency is
+// measured from that due time, not from when a connection was free to send
+// it, so a stalled server shows up as queueing delay in the percentiles
+// instead of silently lowering the offered load (coordinated omission).
+#include <httplib.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Log-linear histogram in the HDR style: 64 linear sub-buckets per power of
+// two, so any recorded value is known within 1.6%, from 1 us to hours
+class Histogram {
+private:
+    static constexpr int SUB_BITS = 7;
+    static constexpr uint64_t SUB_COUNT = 1ULL << SUB_BITS;
+    static constexpr uint64_t HALF_COUNT = SUB_COUNT / 2;
+
+    std::vector<uint64_t> counts_ = std::vector<uint64_t>((64 - SUB_BITS + 2) * HALF_COUNT, 0);
+    uint64_t total_ = 0;
+    uint64_t max_ = 0;
+
+    static size_t indexOf(uint64_t value) {
+        if (value < SUB_COUNT) {
+            return static_cast<size_t>(value);
+        }
+        int shift = 64 - __builtin_clzll(value) - SUB_BITS;
+        return static_cast<size_t>(static_cast<uint64_t>(shift) * HALF_COUNT + (value >> shift));
+    }
+
+    // Highest value that lands in the bucket
+    static uint64_t upperBound(size_t index) {
+        if (index < SUB_COUNT) {
+            return index;
+        }
+        uint64_t shift = index / HALF_COUNT - 1;
+        uint64_t mantissa = index - shift * HALF_COUNT;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+public:
+    void record(uint64_t value) {
+        counts_[indexOf(value)]++;
+        total_++;
+        max_ = std::max(max_, value);
+    }
+
+    void merge(const Histogram& other) {
+        for (size_t i = 0; i < counts_.size(); i++) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        max_ = std::max(max_, other.max_);
+    }
+
+    uint64_t count() const { return total_; }
+    uint64_t max() const { return max_; }
+
+    uint64_t percentile(double percent) const {
+        if (total_ == 0) {
+            return 0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(percent / 100.0 * static_cast<double>(total_) + 0.5));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < counts_.size(); i++) {
+            seen += counts_[i];
+            if (seen >= rank) {
+                return std::min(upperBound(i), max_);
+            }
+        }
+        return max_;
+    }
+};
+
+struct Route {
+    std::string method;
+    std::string path;
+    uint32_t weight = 1;
+    std::string body;
+    std::string content_type = "application/json";
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 8080;
+    double rate = 1000.0;               // requests per second, all routes together
+    double duration = 10.0;             // seconds of measured load
+    double warmup = 2.0;                // seconds at the same rate, not recorded
+    size_t connections = 16;            // keep-alive connections, one per sender thread
+    std::chrono::milliseconds timeout{5000};
+    std::vector<Route> routes;
+    httplib::Headers headers;
+};
+
+struct RouteStats {
+    Histogram latency;                  // microseconds from the scheduled time
+    uint64_t errors = 0;                // transport failures and 5xx
+    uint64_t status_4xx = 0;
+};
+
+// Spread of routes over the schedule: request i uses slots[i % slots.size()]
+std::vector<size_t> routeSlots(const std::vector<Route>& routes) {
+    std::vector<size_t> slots;
+    uint32_t total = 0;
+    for (const auto& route : routes) {
+        total += route.weight;
+    }
+    // Interleaved rather than in runs, so a short test still sees the mix
+    std::vector<double> credit(routes.size(), 0.0);
+    for (uint32_t i = 0; i < total; i++) {
+        size_t best = 0;
+        for (size_t r = 0; r < routes.size(); r++) {
+            credit[r] += static_cast<double>(routes[r].weight) / total;
+            if (credit[r] > credit[best]) {
+                best = r;
+            }
+        }
+        credit[best] -= 1.0;
+        slots.push_back(best);
+    }
+    return slots;
+}
+
+bool parseRoute(const std::string& spec, Route& route) {
+    // "METHOD PATH [WEIGHT] [@body-file]"
+    std::istringstream in(spec);
+    if (!(in >> route.method >> route.path)) {
+        return false;
+    }
+    std::string token;
+    while (in >> token) {
+        if (token[0] == '@') {
+            std::ifstream file(token.substr(1), std::ios::binary);
+            if (!file) {
+                std::cerr << "Cannot read body file " << token.substr(1) << "\n";
+                return false;
+            }
+            route.body.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        } else {
+            route.weight = static_cast<uint32_t>(std::stoul(token));
+        }
+    }
+    return route.method == "GET" || route.method == "POST" || route.method == "DELETE";
+}
+
+void usage() {
+    std::cerr <<
+        "Usage: qmark-loadgen [options]\n"
+        "  --host HOST            server address (127.0.0.1)\n"
+        "  --port PORT            server port (8080)\n"
+        "  --rate N               requests per second across all routes (1000)\n"
+        "  --duration S           measured seconds (10)\n"
+        "  --warmup S             unrecorded seconds before measuring (2)\n"
+        "  --connections N        keep-alive connections (16)\n"
+        "  --timeout MS           per-request timeout (5000)\n"
+        "  --route 'METHOD PATH [WEIGHT] [@body.json]'   repeatable (GET /health)\n"
+        "  --header 'Name: value' repeatable, e.g. a session cookie\n"
+        "Prints one JSON line per route and one for the total.\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* {
+            return i + 1 < argc ? argv[++i] : nullptr;
+        };
+        const char* value = nullptr;
+        if (arg == "--help" || arg == "-h" || !(value = next())) {
+            return false;
+        }
+        try {
+            if (arg == "--host") {
+                options.host = value;
+            } else if (arg == "--port") {
+                options.port = std::stoi(value);
+            } else if (arg == "--rate") {
+                options.rate = std::stod(value);
+            } else if (arg == "--duration") {
+                options.duration = std::stod(value);
+            } else if (arg == "--warmup") {
+                options.warmup = std::stod(value);
+            } else if (arg == "--connections") {
+                options.connections = std::stoul(value);
+            } else if (arg == "--timeout") {
+                options.timeout = std::chrono::milliseconds(std::stoll(value));
+            } else if (arg == "--route") {
+                Route route;
+                if (!parseRoute(value, route)) {
+                    std::cerr << "Invalid route: " << value << "\n";
+                    return false;
+                }
+                options.routes.push_back(std::move(route));
+            } else if (arg == "--header") {
+                const char* colon = std::strchr(value, ':');
+                if (!colon) {
+                    return false;
+                }
+                std::string header_value = colon + 1;
+                header_value.erase(0, header_value.find_first_not_of(' '));
+                options.headers.emplace(std::string(value, colon), header_value);
+            } else {
+                std::cerr << "Unknown option " << arg << "\n";
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Invalid value for " << arg << ": " << value << "\n";
+            return false;
+        }
+    }
+
+    if (options.routes.empty()) {
+        Route health;
+        health.method = "GET";
+        health.path = "/health";
+        options.routes.push_back(std::move(health));
+    }
+    return options.rate > 0 && options.duration > 0 && options.connections > 0;
+}
+
+void printStats(const std::string& name, const RouteStats& stats, double seconds) {
+    const Histogram& h = stats.latency;
+    std::printf("{\"loadgen\":\"%s\",\"requests\":%llu,\"errors\":%llu,\"status_4xx\":%llu,\"rps\":%.1f,"
+                "\"p50_us\":%llu,\"p90_us\":%llu,\"p99_us\":%llu,\"p999_us\":%llu,\"p9999_us\":%llu,\"max_us\":%llu}\n",
+                name.c_str(), static_cast<unsigned long long>(h.count()),
+                static_cast<unsigned long long>(stats.errors), static_cast<unsigned long long>(stats.status_4xx),
+                static_cast<double>(h.count()) / seconds,
+                static_cast<unsigned long long>(h.percentile(50)), static_cast<unsigned long long>(h.percentile(90)),
+                static_cast<unsigned long long>(h.percentile(99)), static_cast<unsigned long long>(h.percentile(99.9)),
+                static_cast<unsigned long long>(h.percentile(99.99)), static_cast<unsigned long long>(h.max()));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage();
+        return 2;
+    }
+
+    const std::vector<size_t> slots = routeSlots(options.routes);
+    const auto interval = std::chrono::duration<double>(1.0 / options.rate);
+    const uint64_t warmup_requests = static_cast<uint64_t>(options.warmup * options.rate);
+    const uint64_t total_requests = warmup_requests + static_cast<uint64_t>(options.duration * options.rate);
+
+    // Each sender owns one connection and claims the next scheduled request
+    // when it is free; if all are busy, due requests wait and that wait counts
+    std::atomic<uint64_t> next_request{0};
+    std::vector<std::vector<RouteStats>> per_thread(options.connections, std::vector<RouteStats>(options.routes.size()));
+    std::atomic<uint64_t> late_starts{0};
+    const Clock::time_point start = Clock::now() + std::chrono::milliseconds(100);
+
+    std::vector<std::thread> senders;
+    for (size_t t = 0; t < options.connections; t++) {
+        senders.emplace_back([&, t]() {
+            httplib::Client client(options.host, options.port);
+            client.set_keep_alive(true);
+            client.set_tcp_nodelay(true);
+            client.set_connection_timeout(options.timeout);
+            client.set_read_timeout(options.timeout);
+            client.set_write_timeout(options.timeout);
+            client.set_default_headers(options.headers);
+
+            auto& stats = per_thread[t];
+            while (true) {
+                uint64_t i = next_request.fetch_add(1, std::memory_order_relaxed);
+                if (i >= total_requests) {
+                    break;
+                }
+                auto due = start + std::chrono::duration_cast<Clock::duration>(interval * static_cast<double>(i));
+                auto now = Clock::now();
+                if (now < due) {
+                    std::this_thread::sleep_until(due);
+                } else if (now - due > std::chrono::milliseconds(1)) {
+                    late_starts.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                const Route& route = options.routes[slots[i % slots.size()]];
+                httplib::Result result = route.method == "GET" ? client.Get(route.path)
+                                       : route.method == "POST" ? client.Post(route.path, route.body, route.content_type)
+                                       : client.Delete(route.path);
+                auto latency = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - due);
+
+                if (i < warmup_requests) {
+                    continue;
+                }
+                RouteStats& route_stats = stats[slots[i % slots.size()]];
+                route_stats.latency.record(static_cast<uint64_t>(std::max<int64_t>(0, latency.count())));
+                if (!result || result->status >= 500) {
+                    route_stats.errors++;
+                } else if (result->status >= 400) {
+                    route_stats.status_4xx++;
+                }
+            }
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+    double elapsed = std::chrono::duration<double>(Clock::now() - start).count() - options.warmup;
+
+    RouteStats total;
+    for (size_t r = 0; r < options.routes.size(); r++) {
+        RouteStats route_total;
+        for (const auto& stats : per_thread) {
+            route_total.latency.merge(stats[r].latency);
+            route_total.errors += stats[r].errors;
+            route_total.status_4xx += stats[r].status_4xx;
+        }
+        printStats(options.routes[r].method + " " + options.routes[r].path, route_total, elapsed);
+        total.latency.merge(route_total.latency);
+        total.errors += route_total.errors;
+        total.status_4xx += route_total.status_4xx;
+    }
+    printStats("total", total, elapsed);
+
+    // Senders that could not keep up: latencies above already include the wait
+    if (late_starts > total_requests / 100) {
+        std::fprintf(stderr, "%llu of %llu requests started more than 1 ms late: the server (or --connections) "
+                     "did not keep up with %.0f req/s\n", static_cast<unsigned long long>(late_starts.load()),
+                     static_cast<unsigned long long>(total_requests), options.rate);
+    }
+    return total.errors > 0 ? 1 : 0;
+}
@@ -0,0 +1,285 @@
+#include "utils/binary_log.hpp"
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using json = nlohmann::json;
+using namespace QMark;
+
+namespace {
+
+struct SiteInfo {
+    LogLevel level = LogLevel::INFO;
+    uint32_t line = 0;
+    std::string file;
+    std::string format;
+    std::vector<uint8_t> types;
+};
+
+class Reader {
+private:
+    const std::vector<uint8_t>& data_;
+    size_t pos_ = 0;
+
+public:
+    explicit Reader(const std::vector<uint8_t>& data) : data_(data) {}
+
+    bool remaining(size_t n) const { return pos_ + n <= data_.size(); }
+    bool done() const { return pos_ >= data_.size(); }
+    size_t position() const { return pos_; }
+
+    template<typename T>
+    T read() {
+        if (!remaining(sizeof(T))) {
+            throw std::runtime_error("truncated record");
+        }
+        T value;
+        std::memcpy(&value, data_.data() + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return value;
+    }
+
+    std::string readBytes(size_t n) {
+        if (!remaining(n)) {
+            throw std::runtime_error("truncated record");
+        }
+        std::string value(reinterpret_cast<const char*>(data_.data() + pos_), n);
+        pos_ += n;
+        return value;
+    }
+};
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::TRACE: return "TRACE";
+        case LogLevel::DEBUG: return "DEBUG";
+        case LogLevel::INFO:  return "INFO ";
+        case LogLevel::WARN:  return "WARN ";
+        case LogLevel::ERROR: return "ERROR";
+        case LogLevel::FATAL: return "FATAL";
+        default: return "UNKNOWN";
+    }
+}
+
+std::string formatTimestamp(int64_t unix_ns) {
+    std::time_t seconds = static_cast<std::time_t>(unix_ns / 1000000000);
+    std::tm local{};
+    localtime_r(&seconds, &local);
+
+    char prefix[32];
+    std::strftime(prefix, sizeof(prefix), "%Y-%m-%d %H:%M:%S", &local);
+
+    char micros[16];
+    std::snprintf(micros, sizeof(micros), ".%06lld", static_cast<long long>((unix_ns / 1000) % 1000000));
+    return std::string(prefix) + micros;
+}
+
+// Decodes the raw arguments of one event into strings and JSON values
+void decodeArgs(Reader& payload, const SiteInfo& site, std::vector<std::string>& text, json& values) {
+    for (uint8_t type : site.types) {
+        switch (type) {
+            case binlog::ARG_INT64: {
+                int64_t v = payload.read<int64_t>();
+                text.push_back(std::to_string(v));
+                values.push_back(v);
+                break;
+            }
+            case binlog::ARG_UINT64: {
+                uint64_t v = payload.read<uint64_t>();
+                text.push_back(std::to_string(v));
+                values.push_back(v);
+                break;
+            }
+            case binlog::ARG_DOUBLE: {
+                double v = payload.read<double>();
+                std::ostringstream oss;
+                oss << v;
+                text.push_back(oss.str());
+                values.push_back(v);
+                break;
+            }
+            case binlog::ARG_BOOL: {
+                bool v = payload.read<uint8_t>() != 0;
+                text.push_back(v ? "1" : "0");
+                values.push_back(v);
+                break;
+            }
+            case binlog::ARG_CHAR: {
+                char v = static_cast<char>(payload.read<uint8_t>());
+                text.push_back(std::string(1, v));
+                values.push_back(std::string(1, v));
+                break;
+            }
+            case binlog::ARG_STRING: {
+                uint32_t length = payload.read<uint32_t>();
+                std::string v = payload.readBytes(length);
+                text.push_back(v);
+                values.push_back(v);
+                break;
+            }
+            default:
+                throw std::runtime_error("unknown argument type " + std::to_string(type));
+        }
+    }
+}
+
+std::string render(const std::string& format, const std::vector<std::string>& args) {
+    std::string out;
+    size_t next = 0;
+
+    for (size_t i = 0; i < format.size(); i++) {
+        if (format[i] == '{' && i + 1 < format.size() && format[i + 1] == '}' && next < args.size()) {
+            out += args[next++];
+            i++;
+        } else {
+            out += format[i];
+        }
+    }
+
+    return out;
+}
+
+int usage() {
+    std::cerr << "Usage: qmark-logdecode [--json] <file.blog>" << std::endl;
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool as_json = false;
+    std::string path;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--json") {
+            as_json = true;
+        } else if (path.empty()) {
+            path = arg;
+        } else {
+            return usage();
+        }
+    }
+
+    if (path.empty()) {
+        return usage();
+    }
+
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        std::cerr << "Cannot open " << path << std::endl;
+        return 1;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+
+    if (data.size() < sizeof(binlog::FileHeader)) {
+        std::cerr << "Not a qmark binary log: " << path << std::endl;
+        return 1;
+    }
+
+    binlog::FileHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, binlog::FILE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != binlog::FILE_VERSION) {
+        std::cerr << "Not a qmark binary log (or unsupported version): " << path << std::endl;
+        return 1;
+    }
+
+    std::unordered_map<uint32_t, SiteInfo> sites;
+    uint64_t sync_tsc = header.anchor_tsc;
+    int64_t sync_unix_ns = header.anchor_unix_ns;
+    double ticks_per_ns = header.tsc_ticks_per_ns > 0 ? header.tsc_ticks_per_ns : 1.0;
+
+    Reader reader(data);
+    reader.readBytes(sizeof(header));
+
+    try {
+        while (!reader.done()) {
+            uint8_t kind = reader.read<uint8_t>();
+
+            if (kind == binlog::RECORD_SITE) {
+                uint32_t id = reader.read<uint32_t>();
+                SiteInfo site;
+                site.level = static_cast<LogLevel>(reader.read<uint8_t>());
+                site.line = reader.read<uint32_t>();
+                site.file = reader.readBytes(reader.read<uint16_t>());
+                site.format = reader.readBytes(reader.read<uint16_t>());
+                std::string types = reader.readBytes(reader.read<uint8_t>());
+                site.types.assign(types.begin(), types.end());
+                sites[id] = std::move(site);
+
+            } else if (kind == binlog::RECORD_SYNC) {
+                sync_tsc = reader.read<uint64_t>();
+                sync_unix_ns = reader.read<int64_t>();
+
+            } else if (kind == binlog::RECORD_DROPPED) {
+                uint32_t thread = reader.read<uint32_t>();
+                uint64_t count = reader.read<uint64_t>();
+                if (as_json) {
+                    std::cout << json{{"dropped", count}, {"thread", thread}}.dump() << '\n';
+                } else {
+                    std::cout << "[binary log] thread " << thread << " dropped " << count << " records\n";
+                }
+
+            } else if (kind == binlog::RECORD_EVENT) {
+                uint32_t id = reader.read<uint32_t>();
+                uint64_t tsc = reader.read<uint64_t>();
+                uint32_t thread = reader.read<uint32_t>();
+                std::string payload_bytes = reader.readBytes(reader.read<uint32_t>());
+
+                auto site_it = sites.find(id);
+                if (site_it == sites.end()) {
+                    std::cerr << "Event references unknown site " << id << std::endl;
+                    continue;
+                }
+                const SiteInfo& site = site_it->second;
+
+                double delta_ns = (static_cast<double>(tsc) - static_cast<double>(sync_tsc)) / ticks_per_ns;
+                int64_t unix_ns = sync_unix_ns + static_cast<int64_t>(delta_ns);
+
+                std::vector<uint8_t> payload_data(payload_bytes.begin(), payload_bytes.end());
+                Reader payload(payload_data);
+                std::vector<std::string> text;
+                json values = json::array();
+                decodeArgs(payload, site, text, values);
+                std::string message = render(site.format, text);
+
+                if (as_json) {
+                    std::string level = levelName(site.level);
+                    level.erase(level.find_last_not_of(' ') + 1);
+                    json record = {
+                        {"timestamp_ns", unix_ns},
+                        {"time", formatTimestamp(unix_ns)},
+                        {"level", level},
+                        {"thread", thread},
+                        {"file", site.file},
+                        {"line", site.line},
+                        {"format", site.format},
+                        {"args", values},
+                        {"message", message}
+                    };
+                    std::cout << record.dump() << '\n';
+                } else {
+                    std::cout << "[" << formatTimestamp(unix_ns) << "] [" << levelName(site.level) << "] [T"
+                              << thread << "] " << message << '\n';
+                }
+
+            } else {
+                throw std::runtime_error("unknown record kind " + std::to_string(kind));
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Decode error at offset " << reader.position() << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
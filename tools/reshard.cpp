@@ -0,0 +1,297 @@
+#include "database/database_manager.hpp"
+#include <sqlite3.h>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace QMark;
+
+namespace {
+
+// Tables whose rows belong to one user, routed by user_id
+struct TenantTable {
+    const char* name;
+    bool keep_ids;      // false: ids are local to a shard, the target numbers them again
+};
+
+const TenantTable TENANT_TABLES[] = {
+    {"sessions", true},
+    {"oauth_connections", true},
+    {"automations", true},
+    {"activities", false},
+    {"leads", true},
+    {"metrics", true}
+};
+
+// Tables with ids that other components hold on to: unique across shards
+const char* const GLOBAL_ID_TABLES[] = {"oauth_connections", "automations", "leads"};
+
+// Shared by every layout
+const char* const CATALOG_TABLES[] = {"users", "data"};
+
+class Database {
+private:
+    sqlite3* db_ = nullptr;
+    std::string path_;
+
+public:
+    Database(const std::string& path, int flags) : path_(path) {
+        if (sqlite3_open_v2(path.c_str(), &db_, flags | SQLITE_OPEN_URI, nullptr) != SQLITE_OK) {
+            std::string error = db_ ? sqlite3_errmsg(db_) : "out of memory";
+            sqlite3_close(db_);
+            throw std::runtime_error("cannot open " + path + ": " + error);
+        }
+    }
+    ~Database() { sqlite3_close(db_); }
+
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+
+    sqlite3* handle() const { return db_; }
+    const std::string& path() const { return path_; }
+
+    void exec(const std::string& sql) {
+        char* error = nullptr;
+        if (sqlite3_exec(db_, sql.c_str(), nullptr, nullptr, &error) != SQLITE_OK) {
+            std::string message = error ? error : sqlite3_errmsg(db_);
+            sqlite3_free(error);
+            throw std::runtime_error(path_ + ": " + message + "\n  in: " + sql);
+        }
+    }
+
+    int64_t scalar(const std::string& sql) {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(path_ + ": " + sqlite3_errmsg(db_) + "\n  in: " + sql);
+        }
+        int64_t value = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int64(stmt, 0) : 0;
+        sqlite3_finalize(stmt);
+        return value;
+    }
+
+    // Column names as the target schema declares them
+    std::vector<std::string> columns(const std::string& table) {
+        sqlite3_stmt* stmt;
+        std::string sql = "PRAGMA main.table_info(" + table + ");";
+        if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+            throw std::runtime_error(path_ + ": " + sqlite3_errmsg(db_));
+        }
+        std::vector<std::string> names;
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            names.emplace_back(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)));
+        }
+        sqlite3_finalize(stmt);
+        return names;
+    }
+};
+
+// qmark_shard(user_id, shard_count): the placement DatabaseManager routes with
+void shardFunction(sqlite3_context* context, int, sqlite3_value** argv) {
+    sqlite3_result_int64(context, static_cast<sqlite3_int64>(DatabaseManager::shardOf(
+        sqlite3_value_int64(argv[0]), static_cast<size_t>(sqlite3_value_int64(argv[1])))));
+}
+
+std::string quoteLiteral(const std::string& text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        quoted += c;
+        if (c == '\'') {
+            quoted += '\'';
+        }
+    }
+    return quoted + "'";
+}
+
+std::string readOnlyUri(const std::string& path) {
+    std::string uri = "file:";
+    for (char c : path) {
+        // Characters with a meaning in URIs
+        if (c == '?' || c == '#' || c == '%') {
+            char escaped[4];
+            std::snprintf(escaped, sizeof(escaped), "%%%02X", static_cast<unsigned char>(c));
+            uri += escaped;
+        } else {
+            uri += c;
+        }
+    }
+    return uri + "?mode=ro";
+}
+
+std::string joined(const std::vector<std::string>& names, bool skip_id) {
+    std::string list;
+    for (const auto& name : names) {
+        if (skip_id && name == "id") {
+            continue;
+        }
+        if (!list.empty()) {
+            list += ", ";
+        }
+        list += name;
+    }
+    return list;
+}
+
+void copyTable(Database& target, const std::string& table, bool keep_ids, const std::string& where) {
+    std::string columns = joined(target.columns(table), !keep_ids);
+    target.exec("INSERT INTO main." + table + " (" + columns + ") SELECT " + columns + " FROM src." + table +
+                where + " ORDER BY rowid;");
+}
+
+int64_t countRows(const std::vector<std::string>& files, const std::string& table) {
+    int64_t rows = 0;
+    for (const auto& file : files) {
+        Database db(readOnlyUri(file), SQLITE_OPEN_READONLY);
+        rows += db.scalar("SELECT COUNT(*) FROM " + table + ";");
+    }
+    return rows;
+}
+
+void usage() {
+    std::cerr << "Usage: qmark-reshard <source catalog> <target catalog> <shards>\n"
+                 "Copies a stopped QMARK database into a new layout of <shards> files\n"
+                 "(1 = a single file). The source is only read; the target must not exist.\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 4) {
+        usage();
+        return 2;
+    }
+
+    const std::string source = argv[1];
+    const std::string target = argv[2];
+    size_t shard_count = 0;
+    try {
+        shard_count = std::stoul(argv[3]);
+    } catch (const std::exception&) {
+    }
+    if (shard_count == 0 || shard_count > 256) {
+        std::cerr << "Shard count must be between 1 and 256\n";
+        return 2;
+    }
+
+    auto started = std::chrono::steady_clock::now();
+
+    try {
+        if (!std::filesystem::exists(source)) {
+            throw std::runtime_error("source database not found: " + source);
+        }
+
+        // Source layout, as the server would open it
+        std::vector<std::string> source_files;
+        int64_t id_floor = 0;
+        {
+            Database catalog(readOnlyUri(source), SQLITE_OPEN_READONLY);
+            size_t source_shards = 1;
+            if (catalog.scalar("SELECT COUNT(*) FROM sqlite_master WHERE type = 'table' AND name = 'shard_layout';") > 0) {
+                source_shards = std::max<int64_t>(1, catalog.scalar("SELECT COALESCE(MAX(shard_count), 1) FROM shard_layout;"));
+                id_floor = catalog.scalar("SELECT COALESCE(MAX(id_floor), 0) FROM shard_layout;");
+            }
+            if (source_shards == 1) {
+                source_files.push_back(source);
+            } else {
+                for (size_t i = 0; i < source_shards; i++) {
+                    source_files.push_back(DatabaseManager::shardPath(source, i));
+                }
+            }
+        }
+
+        std::vector<std::string> target_files;
+        if (shard_count == 1) {
+            target_files.push_back(target);
+        } else {
+            for (size_t i = 0; i < shard_count; i++) {
+                target_files.push_back(DatabaseManager::shardPath(target, i));
+            }
+        }
+        if (std::filesystem::exists(target)) {
+            throw std::runtime_error("target already exists: " + target);
+        }
+        for (const auto& path : target_files) {
+            if (std::filesystem::exists(path)) {
+                throw std::runtime_error("target already exists: " + path);
+            }
+        }
+        std::filesystem::path target_directory = std::filesystem::path(target).parent_path();
+        if (!target_directory.empty()) {
+            std::filesystem::create_directories(target_directory);
+        }
+
+        // New ids must stay above every id the source layout handed out
+        for (const auto& file : source_files) {
+            Database db(readOnlyUri(file), SQLITE_OPEN_READONLY);
+            for (const char* table : GLOBAL_ID_TABLES) {
+                id_floor = std::max(id_floor, db.scalar(std::string("SELECT COALESCE(MAX(id), 0) FROM ") + table + ";"));
+            }
+        }
+
+        // Catalog: users and global data, then the layout itself
+        {
+            Database catalog(target, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+            if (!DatabaseManager::createTables(catalog.handle())) {
+                throw std::runtime_error("cannot create schema in " + target);
+            }
+            catalog.exec("ATTACH DATABASE " + quoteLiteral(readOnlyUri(source)) + " AS src;");
+            catalog.exec("BEGIN;");
+            for (const char* table : CATALOG_TABLES) {
+                copyTable(catalog, table, true, "");
+            }
+            catalog.exec("INSERT INTO shard_layout (shard_count, id_floor) VALUES (" + std::to_string(shard_count) +
+                         ", " + std::to_string(id_floor) + ");");
+            catalog.exec("COMMIT;");
+            catalog.exec("DETACH DATABASE src;");
+        }
+
+        // Tenant tables: every source file is scanned once per target file
+        for (size_t shard = 0; shard < target_files.size(); shard++) {
+            Database db(target_files[shard], SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE);
+            if (!DatabaseManager::createTables(db.handle())) {
+                throw std::runtime_error("cannot create schema in " + target_files[shard]);
+            }
+            sqlite3_create_function(db.handle(), "qmark_shard", 2, SQLITE_UTF8 | SQLITE_DETERMINISTIC,
+                                    nullptr, shardFunction, nullptr, nullptr);
+
+            std::string where = shard_count == 1 ? "" :
+                " WHERE qmark_shard(user_id, " + std::to_string(shard_count) + ") = " + std::to_string(shard);
+            for (const auto& file : source_files) {
+                db.exec("ATTACH DATABASE " + quoteLiteral(readOnlyUri(file)) + " AS src;");
+                db.exec("BEGIN;");
+                for (const auto& table : TENANT_TABLES) {
+                    copyTable(db, table.name, table.keep_ids, where);
+                }
+                db.exec("COMMIT;");
+                db.exec("DETACH DATABASE src;");
+            }
+            std::cout << "wrote " << target_files[shard] << "\n";
+        }
+
+        // Every row landed exactly once
+        bool complete = true;
+        for (const auto& table : TENANT_TABLES) {
+            int64_t before = countRows(source_files, table.name);
+            int64_t after = countRows(target_files, table.name);
+            std::printf("%-18s %12lld -> %12lld%s\n", table.name, static_cast<long long>(before),
+                        static_cast<long long>(after), before == after ? "" : "  MISMATCH");
+            complete = complete && before == after;
+        }
+        if (!complete) {
+            throw std::runtime_error("row counts differ, target left in place for inspection");
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started);
+        std::cout << "Resharded " << source_files.size() << " -> " << shard_count << " files in "
+                  << elapsed.count() << " ms (id floor " << id_floor << ").\n"
+                  << "Point the server at " << target << " once the old layout is archived.\n";
+        return 0;
+
+    } catch (const std::exception& e) {
+        std::cerr << "qmark-reshard: " << e.what() << "\n";
+        return 1;
+    }
+}